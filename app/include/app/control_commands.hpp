@@ -14,6 +14,7 @@ Commands:
 - !join [channel]     - join and persist intent
 - !leave [channel]    - part and clear persisted intent
 - !channels           - list persisted channels
+- !joins              - JOIN progress (confirmed, pending, failed)
 */
 
 // Core
@@ -24,12 +24,29 @@ Notes:
 #include <system_error>
 #include <utility>
 
+// GSL
+#include <gsl/gsl>
+
 // Toml++
 #include <toml++/toml.hpp>
 
+// Core
+#include <tb/utils/activity.hpp>
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/timer.hpp>
+
 // App
 #include <app/app_channel_store.hpp>
 
+namespace
+{
+    tb::metrics::Histogram& save_time()
+    {
+        static auto& h = tb::metrics::registry().histogram("tb_channel_store_save_seconds", "Channel store write time", { { "store", "app_channels" } });
+        return h;
+    }
+} // namespace
+
 namespace app
 {
 
@@ -79,6 +96,10 @@ namespace app
 
     void AppChannelStore::save() const noexcept
     {
+        const tb::activity::Scope activity{ "app_channel_store.save" };
+        const Timer timer;
+        auto record = gsl::finally([&] { save_time().observe(timer.elapsed()); });
+
         toml::table chs;
         for (const auto& [chan, value] : per_channel_)
         {
@@ -22,10 +22,18 @@ Notes:
 // C++ Standard Library
 #include <fstream>
 #include <future>
-#include <iostream>
 #include <sstream>
 #include <system_error>
 
+// GSL
+#include <gsl/gsl>
+
+// Core
+#include <tb/utils/activity.hpp>
+#include <tb/utils/log.hpp>
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/timer.hpp>
+
 // App
 #include <app/channel_store.hpp>
 
@@ -33,6 +41,12 @@ namespace
 {
     // Write-back debounce interval.
     inline constexpr std::chrono::seconds kSaveDelay{ 5 };
+
+    tb::metrics::Histogram& save_time()
+    {
+        static auto& h = tb::metrics::registry().histogram("tb_channel_store_save_seconds", "Channel store write time", { { "store", "channels" } });
+        return h;
+    }
 } // namespace
 
 namespace app
@@ -54,11 +68,11 @@ namespace app
         }
         catch (const std::exception& ex)
         {
-            std::cerr << "[ChannelStore::~ChannelStore] exception: " << ex.what() << '\n';
+            TB_LOG_ERROR("channel_store", "~ChannelStore exception: {}", ex.what());
         }
         catch (...)
         {
-            std::cerr << "[ChannelStore::~ChannelStore] unknown exception\n";
+            TB_LOG_ERROR("channel_store", "~ChannelStore unknown exception");
         }
     }
 
@@ -76,12 +90,12 @@ namespace app
         }
         catch (const toml::parse_error& e)
         {
-            std::cerr << "[ChannelStore] parse error: " << e << '\n';
+            TB_LOG_ERROR("channel_store", "parse error at line {}: {}", e.source().begin.line, e.description());
             return;
         }
         catch (const std::filesystem::filesystem_error& e)
         {
-            std::cerr << "[ChannelStore] fs error: " << e.what() << '\n';
+            TB_LOG_ERROR("channel_store", "fs error: {}", e.what());
             return;
         }
 
@@ -128,6 +142,10 @@ namespace app
 
     void ChannelStore::perform_save() const noexcept
     {
+        const tb::activity::Scope activity{ "channel_store.save" };
+        const Timer timer;
+        auto record = gsl::finally([&] { save_time().observe(timer.elapsed()); });
+
         toml::table tbl = build_table();
 
         // Atomic write: write to temp then rename into place.
@@ -136,7 +154,7 @@ namespace app
             std::ofstream out{ tmp, std::ios::trunc | std::ios::binary };
             if (!out)
             {
-                std::cerr << "[ChannelStore] cannot open " << tmp << '\n';
+                TB_LOG_ERROR("channel_store", "cannot open {}", tmp);
                 return;
             }
 
@@ -146,7 +164,7 @@ namespace app
             out.write(data.data(), static_cast<std::streamsize>(data.size()));
             if (!out)
             {
-                std::cerr << "[ChannelStore] write failed: " << tmp << '\n';
+                TB_LOG_ERROR("channel_store", "write failed: {}", tmp);
                 return;
             }
         }
@@ -155,7 +173,7 @@ namespace app
         std::filesystem::rename(tmp, filename_, ec);
         if (ec)
         {
-            std::cerr << "[ChannelStore] rename failed: " << ec.message() << '\n';
+            TB_LOG_ERROR("channel_store", "rename failed: {}", ec.message());
             std::filesystem::remove(tmp, ec);
         }
     }
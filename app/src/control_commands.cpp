@@ -6,6 +6,8 @@ Purpose:
     !join [channel]     -> add to persisted set and JOIN
     !leave [channel]    -> remove from set and PART
     !channels           -> list all channels currently persisted
+    !joins              -> JOIN progress (confirmed, pending, failed)
+    !trace              -> dump recent hot-path spans as Chrome trace JSON (mods)
 - Provide simple operational controls from the control channel.
 
 Why:
@@ -26,10 +28,14 @@ Notes:
 // C++ Standard Library
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <string>
 #include <string_view>
 #include <vector>
 
+// Core
+#include <tb/utils/trace.hpp>
+
 // App
 #include <app/control_commands.hpp>
 
@@ -63,9 +69,9 @@ namespace app
         // ---------- !join ---------------------------------------------------------
         dispatcher_.register_command(
             "join", [&bot, &store](IrcMessage msg) noexcept -> boost::asio::awaitable<void> {
-                const auto channel = msg.params[0]; // control channel (no '#')
-                const auto user = msg.prefix; // login part of prefix
-                const auto args = msg.trailing; // optional explicit target
+                const auto channel = msg.param(0); // control channel (no '#')
+                const auto user = msg.prefix(); // login part of prefix
+                const auto args = msg.trailing(); // optional explicit target
                 const std::string_view parent_id = msg.get_tag("id");
 
                 // Only handle requests coming from the configured control channel.
@@ -102,16 +108,20 @@ namespace app
                 store.save();
                 co_await bot.join_channel(target);
 
-                std::string ack = "Joined " + target;
+                // JOINs are paced and confirmed asynchronously; see !joins.
+                std::string ack = "Joining " + target;
                 co_await bot.reply(channel, parent_id, ack);
-            });
+            },
+            {},
+            // Each !join saves the store and replies; one user cannot loop it.
+            { .per_user = std::chrono::seconds{ 10 }, .user_burst = 2 });
 
         // ---------- !leave --------------------------------------------------------
         dispatcher_.register_command(
             "leave", [&bot, &store](IrcMessage msg) noexcept -> boost::asio::awaitable<void> {
-                const auto channel = msg.params[0];
-                const auto user = msg.prefix;
-                const auto args = msg.trailing;
+                const auto channel = msg.param(0);
+                const auto user = msg.prefix();
+                const auto args = msg.trailing();
                 const std::string_view parent_id = msg.get_tag("id");
 
                 // Only handle requests coming from the configured control channel.
@@ -150,12 +160,13 @@ namespace app
 
                 std::string ack = "Left " + target;
                 co_await bot.reply(channel, parent_id, ack);
-            });
+            },
+            { "part" });
 
         // ---------- !channels -----------------------------------------------------
         dispatcher_.register_command(
             "channels", [&bot, &store](IrcMessage msg) noexcept -> boost::asio::awaitable<void> {
-                const auto channel = msg.params[0];
+                const auto channel = msg.param(0);
 
                 // Only respond in the control channel to avoid spam elsewhere.
                 if (channel != bot.control_channel())
@@ -184,6 +195,46 @@ namespace app
 
                 co_await bot.say(channel, "Currently in channels: " + list);
             });
+
+        // ---------- !joins --------------------------------------------------------
+        dispatcher_.register_command(
+            "joins", [&bot](IrcMessage msg) noexcept -> boost::asio::awaitable<void> {
+                const auto channel = msg.param(0);
+
+                // Only respond in the control channel to avoid spam elsewhere.
+                if (channel != bot.control_channel())
+                {
+                    co_return;
+                }
+
+                const auto p = bot.join_progress();
+                std::string s = "Joins: " + std::to_string(p.confirmed) + " confirmed, " + std::to_string(p.pending) + " pending, " + std::to_string(p.failed) + " failed (last settle " + std::to_string(p.last_settle.count()) + "ms)";
+                co_await bot.say(channel, s);
+            });
+
+        // ---------- !trace --------------------------------------------------------
+        dispatcher_.register_command(
+            "trace", [&bot](IrcMessage msg) noexcept -> boost::asio::awaitable<void> {
+                const auto channel = msg.param(0);
+                const std::string_view parent_id = msg.get_tag("id");
+
+                // Dumps reveal timing of other channels' traffic; mods only, control channel only.
+                if (channel != bot.control_channel() || !bot.is_privileged(msg))
+                {
+                    co_return;
+                }
+                if (!tb::trace::compiled_in())
+                {
+                    co_await bot.reply(channel, parent_id, "Tracing is not compiled into this build");
+                    co_return;
+                }
+
+                // Written on a throwaway thread; the result is logged.
+                auto path = tb::trace::default_dump_path();
+                std::string ack = "Writing trace to " + path.string();
+                tb::trace::dump_detached(std::move(path));
+                co_await bot.reply(channel, parent_id, ack);
+            });
     }
 
 } // namespace app
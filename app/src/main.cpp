@@ -15,6 +15,9 @@ Notes:
   (best-effort; failure is non-fatal).
 - Channel membership is loaded from channels.toml and applied before connect.
 - App-layer commands are registered from control_commands and register_integrations.
+- With [metrics] port set, Prometheus metrics are served from a private listener thread.
+- The stall watchdog probes the bot strand and every dispatcher lane unless [watchdog] threshold_ms = 0.
+- SIGUSR1 (or !trace) writes recent trace spans to trace-<unix time>.json.
 - bot.run() blocks until the underlying IO context stops.
 - In debug builds, we pause for Enter to keep console output visible.
 */
@@ -23,10 +26,22 @@ Notes:
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <optional>
+
+// Boost.Asio
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/use_awaitable.hpp>
 
 // Core
+#include <tb/net/http/metrics_server.hpp>
+#include <tb/net/tls/tls_context.hpp>
 #include <tb/twitch/config.hpp>
 #include <tb/twitch/twitch_bot.hpp>
+#include <tb/utils/log.hpp>
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/trace.hpp>
 
 // App
 #include <app/app_channel_store.hpp>
@@ -43,13 +58,30 @@ int main()
         const auto cfg = env::Config::load();
         const auto config_path = cfg.path();
 
+        tb::log::set_level(tb::log::parse_level(cfg.log().level, tb::log::Level::info));
+        tb::log::set_raw_sample_every(cfg.log().raw_sample_every);
+
+        // Parse the trust store once, before any connection; every TLS client shares it.
+        tb::net::TlsContextFactory::configure(tb::net::TlsOptions{ .ca_file = TB_CACERT_PEM_PATH });
+        (void)tb::net::TlsContextFactory::process();
+
         // 2) Construct the bot with initial credentials.
+        twitch_bot::RuntimeOptions runtime{
+            .mode = cfg.runtime().per_core ? twitch_bot::ExecutionMode::per_core : twitch_bot::ExecutionMode::shared_pool,
+            .pin_threads = cfg.runtime().pin,
+        };
+        if (cfg.runtime().threads != 0)
+        {
+            runtime.threads = cfg.runtime().threads;
+        }
         twitch_bot::TwitchBot bot{
             cfg.auth().access_token,
             cfg.auth().refresh_token,
             cfg.app().client_id,
             cfg.app().client_secret,
-            cfg.bot().control_channel
+            cfg.bot().control_channel,
+            twitch_bot::IrcPoolOptions{ .anonymous = cfg.bot().anonymous_ingest },
+            runtime
         };
 
         // 3) Persist refreshed access tokens back to config (best-effort, non-fatal).
@@ -74,8 +106,42 @@ int main()
         app::AppChannelStore app_chan_store{ "app_channels.toml" };
         app_chan_store.load();
         app::register_integrations(bot, integrations, app_chan_store);
+        bot.dispatcher().freeze(cfg.bot().case_insensitive_commands ? twitch_bot::CommandMatch::ascii_case_insensitive
+                                                                    : twitch_bot::CommandMatch::exact);
+
+        // 7) Metrics endpoint on its own thread, so scrapes never run on a bot executor.
+        std::optional<tb::net::MetricsServer> metrics;
+        if (cfg.metrics().port != 0)
+        {
+            metrics.emplace(tb::net::MetricsServerOptions{ .address = cfg.metrics().address, .port = cfg.metrics().port },
+                            tb::metrics::registry());
+            metrics->start();
+        }
+
+        // 8) Stall watchdog; lag histograms land in the same registry.
+        if (const auto& wd = cfg.watchdog(); wd.threshold_ms != 0)
+        {
+            bot.start_watchdog({ .interval = std::chrono::milliseconds{ wd.interval_ms },
+                                 .threshold = std::chrono::milliseconds{ wd.threshold_ms },
+                                 .stack_samples = wd.stack_samples });
+        }
+
+#if !defined(_WIN32)
+        // 9) SIGUSR1 dumps the trace rings (no-op unless built with ENABLE_TRACING).
+        boost::asio::signal_set trace_signal{ bot.executor(), SIGUSR1 };
+        boost::asio::co_spawn(
+            bot.executor(),
+            [&trace_signal]() -> boost::asio::awaitable<void> {
+                for (;;)
+                {
+                    co_await trace_signal.async_wait(boost::asio::use_awaitable);
+                    tb::trace::dump_detached(tb::trace::default_dump_path());
+                }
+            },
+            boost::asio::detached);
+#endif
 
-        // 7) Hand control to the bot: blocks until IO stops.
+        // 10) Hand control to the bot: blocks until IO stops.
         bot.run();
     }
     catch (const env::EnvError& e)
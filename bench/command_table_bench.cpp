@@ -0,0 +1,99 @@
+/*
+Module Name:
+- command_table_bench.cpp
+
+Abstract:
+- Lookup latency of twitch_bot::CommandTable for hits and misses, exact and case-insensitive, against
+  the unordered_map it replaced (with a lowered copy of the name for the case-insensitive case).
+- Arg: number of registered names.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// Core
+#include <tb/twitch/command_dispatcher.hpp>
+#include <tb/twitch/command_table.hpp>
+#include <tb/utils/transparent_string_hash.hpp>
+
+namespace
+{
+    using twitch_bot::CommandEntry;
+    using twitch_bot::CommandMatch;
+    using twitch_bot::CommandTable;
+
+    struct Fixture
+    {
+        explicit Fixture(std::size_t count)
+        {
+            static constexpr const char* stems[] = { "join", "part", "uptime", "so", "clip", "followage", "title", "game", "song", "quote" };
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto e = std::make_shared<CommandEntry>();
+                e->name = stems[i % std::size(stems)] + (i < std::size(stems) ? std::string{} : std::to_string(i));
+                entries.push_back(e);
+                map.emplace(e->name, e);
+                // Chat types commands in whatever case it likes.
+                auto typed = e->name;
+                typed[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(typed[0])));
+                hits.push_back(std::move(typed));
+                misses.push_back("x" + e->name);
+            }
+        }
+
+        [[nodiscard]] std::unique_ptr<const CommandTable> table(CommandMatch match) const
+        {
+            std::vector<CommandTable::Key> keys;
+            for (const auto& e : entries)
+            {
+                keys.push_back({ e->name, e });
+            }
+            return CommandTable::build(std::move(keys), match);
+        }
+
+        std::vector<std::shared_ptr<const CommandEntry>> entries;
+        std::unordered_map<std::string, std::shared_ptr<const CommandEntry>, TransparentBasicStringHash<char>, TransparentBasicStringEq<char>> map;
+        std::vector<std::string> hits; // first letter upper-cased
+        std::vector<std::string> misses;
+    };
+
+    void BM_CommandTable(benchmark::State& state, bool hit)
+    {
+        const Fixture f{ static_cast<std::size_t>(state.range(0)) };
+        const auto table = f.table(CommandMatch::ascii_case_insensitive);
+        const auto& names = hit ? f.hits : f.misses;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(table->find(names[i]));
+            i = i + 1 == names.size() ? 0 : i + 1;
+        }
+    }
+
+    void BM_LoweredMapLookup(benchmark::State& state, bool hit)
+    {
+        const Fixture f{ static_cast<std::size_t>(state.range(0)) };
+        const auto& names = hit ? f.hits : f.misses;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            std::string lowered{ names[i] };
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            benchmark::DoNotOptimize(f.map.find(lowered));
+            i = i + 1 == names.size() ? 0 : i + 1;
+        }
+    }
+} // namespace
+
+BENCHMARK_CAPTURE(BM_CommandTable, hit, true)->Arg(10)->Arg(100)->Arg(1'000);
+BENCHMARK_CAPTURE(BM_CommandTable, miss, false)->Arg(10)->Arg(100)->Arg(1'000);
+BENCHMARK_CAPTURE(BM_LoweredMapLookup, hit, true)->Arg(10)->Arg(100)->Arg(1'000);
+BENCHMARK_CAPTURE(BM_LoweredMapLookup, miss, false)->Arg(10)->Arg(100)->Arg(1'000);
@@ -0,0 +1,174 @@
+/*
+Module Name:
+- irc_message_parser_bench.cpp
+
+Abstract:
+- parse_irc_line throughput over a replay of typical Twitch lines (tagged PRIVMSG, USERNOTICE, PING,
+  JOIN), in bytes and lines per second.
+- Parse plus hand-off: each parsed message is copied into a ring of 256 slots, the way dispatch copies
+  it into a handler frame. ViewMessage has the layout IrcMessage had before it moved to 16-bit offsets,
+  so the two hand-off runs compare the copy cost before and after.
+- For L1 misses, run with --benchmark_perf_counters=L1-dcache-load-misses,INSTRUCTIONS on a
+  Google Benchmark built with libpfm.
+*/
+
+// C++ Standard Library
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// Core
+#include <tb/parser/irc_message_parser.hpp>
+
+namespace
+{
+    using twitch_bot::IrcMessage;
+    using twitch_bot::parse_irc_line;
+
+    // The pre-offset layout: a view per field.
+    struct ViewMessage
+    {
+        std::string_view raw_tags;
+        std::string_view prefix;
+        std::string_view command;
+        std::string_view trailing;
+        std::array<std::string_view, IrcMessage::max_params> params{};
+        std::size_t param_count = 0;
+        std::uint8_t is_moderator = 0;
+        std::uint8_t is_broadcaster = 0;
+    };
+
+    ViewMessage to_views(const IrcMessage& m) noexcept
+    {
+        ViewMessage v{ m.raw_tags(), m.prefix(), m.command(), m.trailing() };
+        for (std::size_t i = 0; i < m.param_count(); ++i)
+        {
+            v.params[i] = m.param(i);
+        }
+        v.param_count = m.param_count();
+        v.is_moderator = m.is_moderator;
+        v.is_broadcaster = m.is_broadcaster;
+        return v;
+    }
+
+    const std::vector<std::string>& replay()
+    {
+        static const std::vector<std::string> lines = [] {
+            const std::array<std::string, 6> kinds{
+                "@badge-info=subscriber/14;badges=subscriber/12,premium/1;client-nonce=9f2c2a6c0c7c4a3b8f0f2c1a;color=#1E90FF;"
+                "display-name=SomeViewer;emotes=;first-msg=0;flags=;id=5f1b6a4e-2d7c-4c3e-9b0f-8f1c2d3e4a5b;mod=0;"
+                "returning-chatter=0;room-id=12345678;subscriber=1;tmi-sent-ts=1700000000000;turbo=0;user-id=87654321;"
+                "user-type= :someviewer!someviewer@someviewer.tmi.twitch.tv PRIVMSG #bigchannel :that play was insane LUL",
+                "@badge-info=;badges=moderator/1;color=;display-name=ModUser;emotes=25:0-4;flags=;id=0a1b2c3d;mod=1;"
+                "room-id=12345678;subscriber=0;tmi-sent-ts=1700000000001;turbo=0;user-id=1111;user-type=mod "
+                ":moduser!moduser@moduser.tmi.twitch.tv PRIVMSG #bigchannel :Kappa !uptime",
+                "@badge-info=;badges=broadcaster/1;color=#FF4500;display-name=Streamer;emotes=;flags=;id=abc;mod=0;"
+                "room-id=12345678;subscriber=0;tmi-sent-ts=1700000000002;turbo=0;user-id=12345678;user-type= "
+                ":streamer!streamer@streamer.tmi.twitch.tv PRIVMSG #bigchannel :thanks for the raid everyone",
+                "@badge-info=subscriber/1;badges=subscriber/0;color=;display-name=NewSub;emotes=;flags=;id=def;"
+                "login=newsub;mod=0;msg-id=sub;msg-param-cumulative-months=1;msg-param-sub-plan=1000;room-id=12345678;"
+                "subscriber=1;system-msg=NewSub\\ssubscribed\\sat\\sTier\\s1.;tmi-sent-ts=1700000000003;user-id=2222;"
+                "user-type= :tmi.twitch.tv USERNOTICE #bigchannel",
+                "PING :tmi.twitch.tv",
+                ":someone!someone@someone.tmi.twitch.tv JOIN #bigchannel",
+            };
+            // Mostly chat, as on a busy channel.
+            constexpr std::array<std::size_t, 16> mix{ 0, 0, 0, 1, 0, 0, 2, 0, 0, 0, 3, 0, 0, 1, 4, 5 };
+            std::vector<std::string> out;
+            for (int round = 0; round < 256; ++round)
+            {
+                for (auto k : mix)
+                {
+                    out.push_back(kinds[k]);
+                }
+            }
+            return out;
+        }();
+        return lines;
+    }
+
+    std::int64_t replay_bytes()
+    {
+        std::int64_t n = 0;
+        for (const auto& l : replay())
+        {
+            n += static_cast<std::int64_t>(l.size());
+        }
+        return n;
+    }
+
+    void finish(benchmark::State& state)
+    {
+        state.SetBytesProcessed(state.iterations() * replay_bytes());
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(replay().size()));
+    }
+
+    void BM_Parse(benchmark::State& state)
+    {
+        const auto& lines = replay();
+        for (auto _ : state)
+        {
+            for (const auto& l : lines)
+            {
+                auto m = parse_irc_line(l);
+                benchmark::DoNotOptimize(m);
+            }
+        }
+        finish(state);
+    }
+
+    void BM_ParseAndHandOff(benchmark::State& state)
+    {
+        const auto& lines = replay();
+        std::vector<IrcMessage> ring(256);
+        std::size_t slot = 0;
+        for (auto _ : state)
+        {
+            for (const auto& l : lines)
+            {
+                ring[slot] = parse_irc_line(l);
+                slot = (slot + 1) & 255;
+            }
+            benchmark::ClobberMemory();
+        }
+        finish(state);
+        state.counters["message_bytes"] = sizeof(IrcMessage);
+    }
+
+    void BM_ParseAndHandOffViews(benchmark::State& state)
+    {
+        const auto& lines = replay();
+        std::vector<ViewMessage> ring(256);
+        std::size_t slot = 0;
+        for (auto _ : state)
+        {
+            for (const auto& l : lines)
+            {
+                ring[slot] = to_views(parse_irc_line(l));
+                slot = (slot + 1) & 255;
+            }
+            benchmark::ClobberMemory();
+        }
+        finish(state);
+        state.counters["message_bytes"] = sizeof(ViewMessage);
+    }
+
+    void BM_GetTag(benchmark::State& state)
+    {
+        const auto m = parse_irc_line(replay().front());
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(m.get_tag("user-id"));
+        }
+    }
+} // namespace
+
+BENCHMARK(BM_Parse);
+BENCHMARK(BM_ParseAndHandOff);
+BENCHMARK(BM_ParseAndHandOffViews);
+BENCHMARK(BM_GetTag);
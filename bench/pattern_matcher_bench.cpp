@@ -0,0 +1,138 @@
+/*
+Module Name:
+- pattern_matcher_bench.cpp
+
+Abstract:
+- Throughput of tb::match::Matcher over chat-like text, in bytes per second, for sets below and above
+  the 64-pattern prefilter limit. Baseline: one std::string_view::find per pattern, as before triggers.
+- Arg: pattern count. A few lines in the corpus hit; most of it matches nothing, as in real chat.
+*/
+
+// C++ Standard Library
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// Core
+#include <tb/utils/pattern_matcher.hpp>
+
+namespace
+{
+    constexpr std::size_t k_corpus_bytes = 1 << 20;
+
+    std::vector<std::string> make_patterns(std::size_t count)
+    {
+        std::mt19937 rng{ 7 };
+        std::uniform_int_distribution<int> letter{ 'a', 'z' };
+        std::uniform_int_distribution<std::size_t> length{ 4, 10 };
+        std::vector<std::string> out;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::string p(length(rng), 'a');
+            for (auto& c : p)
+            {
+                c = static_cast<char>(letter(rng));
+            }
+            out.push_back(std::move(p));
+        }
+        return out;
+    }
+
+    // Lines of short words, about 1 in 50 carrying one of the patterns.
+    std::vector<std::string> make_lines(const std::vector<std::string>& patterns)
+    {
+        static constexpr std::string_view words[] = { "pog", "lol", "gg", "kappa", "wp", "nice", "what", "the", "chat", "is", "so", "hype", "LUL", "monkaS", "1234" };
+        std::mt19937 rng{ 11 };
+        std::uniform_int_distribution<std::size_t> word{ 0, std::size(words) - 1 };
+        std::uniform_int_distribution<std::size_t> count{ 3, 20 };
+        std::uniform_int_distribution<std::size_t> pick{ 0, patterns.size() - 1 };
+        std::uniform_int_distribution<int> hit{ 0, 49 };
+
+        std::vector<std::string> lines;
+        std::size_t total = 0;
+        while (total < k_corpus_bytes)
+        {
+            std::string line;
+            for (auto n = count(rng); n > 0; --n)
+            {
+                line += words[word(rng)];
+                line += ' ';
+            }
+            if (hit(rng) == 0)
+            {
+                line += patterns[pick(rng)];
+            }
+            total += line.size();
+            lines.push_back(std::move(line));
+        }
+        return lines;
+    }
+
+    std::int64_t bytes_of(const std::vector<std::string>& lines)
+    {
+        std::int64_t n = 0;
+        for (const auto& l : lines)
+        {
+            n += static_cast<std::int64_t>(l.size());
+        }
+        return n;
+    }
+
+    void BM_Matcher(benchmark::State& state)
+    {
+        const auto patterns = make_patterns(static_cast<std::size_t>(state.range(0)));
+        const auto lines = make_lines(patterns);
+        tb::match::PatternSet set;
+        for (std::uint32_t i = 0; i < patterns.size(); ++i)
+        {
+            set.add(patterns[i], i);
+        }
+        const auto matcher = set.compile();
+
+        std::size_t hits = 0;
+        for (auto _ : state)
+        {
+            for (const auto& line : lines)
+            {
+                matcher->for_each(line, [&hits](const tb::match::Match&) {
+                    ++hits;
+                    return true;
+                });
+            }
+            benchmark::DoNotOptimize(hits);
+        }
+        state.SetBytesProcessed(state.iterations() * bytes_of(lines));
+        state.counters["prefiltered"] = matcher->prefiltered() ? 1 : 0;
+    }
+
+    void BM_FindPerPattern(benchmark::State& state)
+    {
+        const auto patterns = make_patterns(static_cast<std::size_t>(state.range(0)));
+        const auto lines = make_lines(patterns);
+
+        std::size_t hits = 0;
+        for (auto _ : state)
+        {
+            for (const auto& line : lines)
+            {
+                for (const auto& p : patterns)
+                {
+                    if (std::string_view{ line }.find(p) != std::string_view::npos)
+                    {
+                        ++hits;
+                    }
+                }
+            }
+            benchmark::DoNotOptimize(hits);
+        }
+        state.SetBytesProcessed(state.iterations() * bytes_of(lines));
+    }
+} // namespace
+
+BENCHMARK(BM_Matcher)->Arg(1)->Arg(8)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FindPerPattern)->Arg(1)->Arg(8)->Arg(64)->Unit(benchmark::kMillisecond);
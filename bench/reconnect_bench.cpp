@@ -0,0 +1,251 @@
+/*
+Module Name:
+- reconnect_bench.cpp
+
+Abstract:
+- The IrcClient reconnect path against a local TLS stand-in on 127.0.0.1: resolve, TCP connect and
+  TLS handshake, with DNS from ConnectCache or the resolver and a fresh or resumed TLS session.
+- The stand-in uses a self-signed P-256 certificate made at startup and trusted through the factory's
+  store, so verification and SNI run as they do against Twitch. It sends one byte after the handshake;
+  reading it lets the client pick up the TLS 1.3 ticket, as the first IRC read does.
+- Args: DNS cached and TLS resumed. Counters are the per-phase means in microseconds.
+- Loopback hides network round trips, so this measures the CPU side of each phase; on a real link a
+  resumed handshake also saves the certificate bytes.
+*/
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+// Boost.Asio
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/write.hpp>
+
+// OpenSSL
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// Core
+#include <tb/net/tls/tls_context.hpp>
+#include <tb/twitch/connect_cache.hpp>
+
+namespace
+{
+    namespace asio = boost::asio;
+    using asio::ip::tcp;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr const char* k_host = "localhost";
+
+    struct KeyFree
+    {
+        void operator()(EVP_PKEY* p) const noexcept
+        {
+            ::EVP_PKEY_free(p);
+        }
+    };
+    struct CertFree
+    {
+        void operator()(X509* p) const noexcept
+        {
+            ::X509_free(p);
+        }
+    };
+
+    // Self-signed certificate for k_host, valid for a day.
+    struct Identity
+    {
+        std::unique_ptr<EVP_PKEY, KeyFree> key{ ::EVP_EC_gen("P-256") };
+        std::unique_ptr<X509, CertFree> cert{ ::X509_new() };
+
+        Identity()
+        {
+            X509* x = cert.get();
+            ::X509_set_version(x, 2);
+            ::ASN1_INTEGER_set(::X509_get_serialNumber(x), 1);
+            ::X509_gmtime_adj(::X509_getm_notBefore(x), -60);
+            ::X509_gmtime_adj(::X509_getm_notAfter(x), 24 * 60 * 60);
+            ::X509_set_pubkey(x, key.get());
+
+            X509_NAME* name = ::X509_get_subject_name(x);
+            ::X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>(k_host), -1, -1, 0);
+            ::X509_set_issuer_name(x, name);
+
+            X509_EXTENSION* san = ::X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name, "DNS:localhost");
+            ::X509_add_ext(x, san, -1);
+            ::X509_EXTENSION_free(san);
+
+            ::X509_sign(x, key.get(), ::EVP_sha256());
+        }
+    };
+
+    const Identity& identity()
+    {
+        static const Identity id;
+        return id;
+    }
+
+    // Blocking TLS server on its own thread: accept, handshake, send one byte, shut down.
+    class StandIn
+    {
+    public:
+        StandIn() :
+            ctx_{ asio::ssl::context::tls_server }, acceptor_{ io_, { asio::ip::address_v4::loopback(), 0 } }
+        {
+            ::SSL_CTX_use_certificate(ctx_.native_handle(), identity().cert.get());
+            ::SSL_CTX_use_PrivateKey(ctx_.native_handle(), identity().key.get());
+            thread_ = std::thread([this] { serve(); });
+        }
+
+        ~StandIn()
+        {
+            stop_.store(true, std::memory_order_relaxed);
+            boost::system::error_code ec;
+            tcp::socket wake{ io_ };
+            wake.connect(acceptor_.local_endpoint(), ec); // unblocks accept
+            thread_.join();
+        }
+
+        StandIn(const StandIn&) = delete;
+        StandIn& operator=(const StandIn&) = delete;
+
+        [[nodiscard]] std::string port() const
+        {
+            return std::to_string(acceptor_.local_endpoint().port());
+        }
+
+    private:
+        void serve()
+        {
+            while (!stop_.load(std::memory_order_relaxed))
+            {
+                asio::ssl::stream<tcp::socket> s{ io_, ctx_ };
+                boost::system::error_code ec;
+                acceptor_.accept(s.next_layer(), ec);
+                if (ec || stop_.load(std::memory_order_relaxed))
+                {
+                    continue;
+                }
+                s.next_layer().set_option(tcp::no_delay(true), ec);
+                s.handshake(asio::ssl::stream_base::server, ec);
+                if (!ec)
+                {
+                    asio::write(s, asio::buffer("+", 1), ec);
+                    s.shutdown(ec);
+                }
+            }
+        }
+
+        asio::io_context io_;
+        asio::ssl::context ctx_;
+        tcp::acceptor acceptor_;
+        std::atomic<bool> stop_{ false };
+        std::thread thread_;
+    };
+
+    double micros(clock_type::duration d)
+    {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    void BM_Reconnect(benchmark::State& state)
+    {
+        const bool dns_cached = state.range(0) != 0;
+        const bool tls_resume = state.range(1) != 0;
+
+        StandIn server;
+        const auto port = server.port();
+
+        tb::net::TlsOptions options;
+        options.platform_store = false; // trust only the stand-in
+        tb::net::TlsContextFactory tls{ std::move(options) };
+        ::X509_STORE_add_cert(::SSL_CTX_get_cert_store(tls.context().native_handle()), identity().cert.get());
+
+        twitch_bot::ConnectCache cache;
+        asio::io_context io;
+        tcp::resolver resolver{ io };
+        cache.store_endpoints(k_host, resolver.resolve(tcp::v4(), k_host, port));
+
+        double dns_us = 0;
+        double tcp_us = 0;
+        double tls_us = 0;
+        std::int64_t resumed = 0;
+
+        for (auto _ : state)
+        {
+            if (!tls_resume)
+            {
+                tls.forget_session(k_host);
+            }
+            auto mark = clock_type::now();
+            const auto lap = [&mark] {
+                const auto now = clock_type::now();
+                const auto d = now - mark;
+                mark = now;
+                return micros(d);
+            };
+
+            // DNS
+            twitch_bot::ConnectCache::results_type results;
+            if (auto cached = dns_cached ? cache.endpoints(k_host) : std::nullopt)
+            {
+                results = std::move(*cached);
+            }
+            else
+            {
+                results = resolver.resolve(tcp::v4(), k_host, port);
+            }
+            dns_us += lap();
+
+            // TCP: one loopback address, so there is nothing to race.
+            asio::ssl::stream<tcp::socket> stream{ io, tls.context() };
+            asio::connect(stream.next_layer(), results);
+            stream.next_layer().set_option(tcp::no_delay(true));
+            tcp_us += lap();
+
+            // TLS, then the first read that carries the ticket.
+            tls.prepare(stream.native_handle(), k_host);
+            stream.handshake(asio::ssl::stream_base::client);
+            char byte = 0;
+            asio::read(stream, asio::buffer(&byte, 1));
+            tls_us += lap();
+
+            if (::SSL_session_reused(stream.native_handle()) == 1)
+            {
+                ++resumed;
+            }
+            benchmark::DoNotOptimize(byte);
+
+            // Clean close, as the websocket close does; OpenSSL will not resume a session cut off without close_notify.
+            boost::system::error_code ec;
+            stream.shutdown(ec);
+        }
+
+        using benchmark::Counter;
+        state.counters["dns_us"] = Counter(dns_us, Counter::kAvgIterations);
+        state.counters["tcp_us"] = Counter(tcp_us, Counter::kAvgIterations);
+        state.counters["tls_us"] = Counter(tls_us, Counter::kAvgIterations);
+        state.counters["resumed"] = Counter(static_cast<double>(resumed), Counter::kAvgIterations);
+    }
+} // namespace
+
+BENCHMARK(BM_Reconnect)
+    ->ArgNames({ "dns_cached", "tls_resumed" })
+    ->ArgsProduct({ { 0, 1 }, { 0, 1 } })
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,116 @@
+/*
+Module Name:
+- runtime_bench.cpp
+
+Abstract:
+- Per-core runtime against the shared pool, on a replayed routing workload: a reader thread posts each
+  chat line to its channel's lane, and the lane parses it and counts it, as route_text does before a
+  handler. Items per second is lines through the lanes.
+- Args: execution mode (0 shared pool, 1 per core) and thread count.
+*/
+
+// C++ Standard Library
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// Core
+#include <tb/parser/irc_message_parser.hpp>
+#include <tb/twitch/runtime.hpp>
+
+namespace
+{
+    using twitch_bot::ExecutionMode;
+    using twitch_bot::HomeExecutor;
+    using twitch_bot::Runtime;
+
+    constexpr std::size_t k_channels = 256;
+    constexpr std::size_t k_lines = 1 << 16; // per iteration
+
+    struct Line
+    {
+        std::string text;
+        std::size_t channel;
+    };
+
+    std::vector<Line> make_replay()
+    {
+        std::vector<Line> out;
+        out.reserve(k_lines);
+        std::uint64_t x = 88172645463325252ull;
+        for (std::size_t i = 0; i < k_lines; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            // Skewed like real traffic: a few channels carry most lines.
+            const auto channel = (x % 4 == 0) ? x % k_channels : x % 8;
+            out.push_back({ "@badges=subscriber/12;color=#1E90FF;display-name=Viewer;mod=0;user-id=87654321 "
+                            ":viewer!viewer@viewer.tmi.twitch.tv PRIVMSG #channel" +
+                                std::to_string(channel) + " :message number " + std::to_string(i),
+                            channel });
+        }
+        return out;
+    }
+
+    void BM_RouteLines(benchmark::State& state)
+    {
+        const auto mode = state.range(0) == 0 ? ExecutionMode::shared_pool : ExecutionMode::per_core;
+        const auto threads = static_cast<std::size_t>(state.range(1));
+        static const auto replay = make_replay();
+
+        Runtime runtime{ { .mode = mode, .threads = threads, .pin_threads = true } };
+        std::vector<HomeExecutor> lanes;
+        const auto lane_count = runtime.homes_are_serial() ? runtime.homes() : threads;
+        for (std::size_t i = 0; i < lane_count; ++i)
+        {
+            lanes.push_back(runtime.serial_executor(i));
+        }
+
+        std::atomic<std::size_t> routed{ 0 };
+        std::array<std::size_t, k_channels> per_channel{}; // each slot only touched by its lane
+        std::thread driver;
+        if (runtime.homes_are_serial()) // per-core, or one thread in either mode; pool threads drive themselves
+        {
+            driver = std::thread([&] { runtime.run(); });
+        }
+
+        std::size_t target = 0;
+        for (auto _ : state)
+        {
+            for (const auto& line : replay)
+            {
+                runtime.post(lanes[line.channel % lanes.size()], [&] {
+                    const auto msg = twitch_bot::parse_irc_line(line.text);
+                    per_channel[line.channel] += msg.trailing().size();
+                    routed.fetch_add(1, std::memory_order_release);
+                });
+            }
+            target += replay.size();
+            while (routed.load(std::memory_order_acquire) < target)
+            {
+                std::this_thread::yield();
+            }
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(target));
+
+        runtime.stop();
+        if (driver.joinable())
+        {
+            driver.join();
+        }
+        benchmark::DoNotOptimize(per_channel);
+    }
+} // namespace
+
+BENCHMARK(BM_RouteLines)
+    ->ArgNames({ "per_core", "threads" })
+    ->ArgsProduct({ { 0, 1 }, { 1, 2, 4, 8 } })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -138,6 +138,10 @@ function(project_enable_sanitisers target)
         $<${_dbg}:-fsanitize=${_san_csv}>
         $<${_dbg}:-fno-omit-frame-pointer>)
       target_link_options(${target} ${_scope} $<${_dbg}:-fsanitize=${_san_csv}>)
+      if(SANITISE_THREAD AND CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # GCC 12+ warns on every atomic_thread_fence (EpochDomain pins with one); keep -Werror builds going.
+        target_compile_options(${target} ${_scope} $<${_dbg}:-Wno-tsan>)
+      endif()
       set(_san_enabled TRUE)
     endif()
   endif()
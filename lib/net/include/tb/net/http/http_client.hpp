@@ -5,6 +5,7 @@ Module Name:
 Abstract:
 - Asynchronous HTTP/HTTPS client built on Boost.Asio/Beast with connection pooling.
 - Coroutine API for GET/POST, optional retries, metrics, and cookie support.
+- get_with_meta also returns the final response's status and headers, even when the status throws.
 - stream_get consumes HTTP chunked transfer and calls a user handler per chunk.
 - Streaming uses identity encoding on purpose to avoid on-the-fly decompression.
 */
@@ -18,6 +19,7 @@ Abstract:
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // Boost.Asio
@@ -52,6 +54,8 @@ Abstract:
 #include "cookie_jar.hpp"
 #include "redirect_policy.hpp"
 #include "url.hpp"
+#include <tb/net/tcp/happy_eyeballs.hpp>
+#include <tb/net/tls/tls_context.hpp>
 #include <tb/utils/attributes.hpp>
 #include <tb/utils/transparent_string_hash.hpp>
 
@@ -175,6 +179,27 @@ namespace http_client
 
         using MetricsCallback = std::function<void(const RequestMetrics&)>;
 
+        // Status and headers of the final response. Filled before a non-2xx status throws, so callers
+        // can read rate-limit and retry hints from error responses too.
+        struct ResponseMeta
+        {
+            int status{ 0 }; // 0 when no response arrived
+            std::vector<std::pair<std::string, std::string>> headers;
+
+            // Case-insensitive. Empty when absent.
+            [[nodiscard]] std::string_view header(std::string_view name) const noexcept
+            {
+                for (const auto& [k, v] : headers)
+                {
+                    if (boost::beast::iequals(k, name))
+                    {
+                        return v;
+                    }
+                }
+                return {};
+            }
+        };
+
         struct RequestOptions
         {
             std::chrono::steady_clock::duration tcp_connect_timeout{};
@@ -211,6 +236,12 @@ namespace http_client
                std::size_t expected_hosts = k_default_expected_hosts,
                std::size_t expected_conns_per_host = k_default_connections_per_host) noexcept;
 
+        // Preferred: shared trust store and policy, hostname verification and session resumption.
+        client(boost::asio::any_io_executor executor,
+               tb::net::TlsContextFactory& tls,
+               std::size_t expected_hosts = k_default_expected_hosts,
+               std::size_t expected_conns_per_host = k_default_connections_per_host) noexcept;
+
         [[nodiscard]] allocator_type get_allocator() const noexcept;
 
         [[nodiscard]]
@@ -241,6 +272,14 @@ namespace http_client
                                                       http_headers headers,
                                                       const RequestOptions& opts);
 
+        [[nodiscard]]
+        boost::asio::awaitable<result> get_with_meta(std::string_view host,
+                                                     std::string_view port,
+                                                     std::string_view target,
+                                                     http_headers headers,
+                                                     ResponseMeta& meta,
+                                                     const RequestOptions* opts = nullptr);
+
         [[nodiscard]]
         boost::asio::awaitable<result> get_with_retry(std::string_view host,
                                                       std::string_view port,
@@ -327,7 +366,8 @@ namespace http_client
                                                std::string_view body,
                                                http_headers headers,
                                                const RequestOptions* opts,
-                                               RequestMetrics* out_metrics);
+                                               RequestMetrics* out_metrics,
+                                               ResponseMeta* out_meta = nullptr);
 
         // Zero means use the library default; keeps public options terse.
         static inline std::chrono::steady_clock::duration
@@ -339,7 +379,12 @@ namespace http_client
 
         boost::asio::any_io_executor executor_;
         boost::asio::ssl::context* ssl_context_;
+        tb::net::TlsContextFactory* tls_ = nullptr; // set by the factory constructor
+
+        // SNI, plus hostname check and session offer when built from a factory.
+        void prepare_tls(SSL* ssl, const std::string& host) const;
         boost::asio::ip::tcp::resolver resolver_;
+        tb::net::EndpointHistory endpoint_history_; // addresses that failed recently are raced last
         boost::asio::strand<boost::asio::any_io_executor> strand_;
 
         // PMR buffer used for handler allocations bound into coroutines.
@@ -401,20 +446,13 @@ namespace http_client
         {
             auto endpoints = co_await resolver_.async_resolve(host, port, tok);
 
-            beast::tcp_stream tcp(executor_);
-            beast::get_lowest_layer(tcp).expires_after(k_tcp_connect_timeout);
-            co_await tcp.async_connect(endpoints, tok);
+            beast::tcp_stream tcp(co_await tb::net::happy_eyeballs_connect(
+                executor_, endpoints, &endpoint_history_, { .timeout = k_tcp_connect_timeout }));
 
             beast::get_lowest_layer(tcp).socket().set_option(asio::ip::tcp::no_delay{ true });
 
             typename connection::ssl_stream ssl{ std::move(tcp), *ssl_context_ };
-            const std::string host_sni{ host };
-            if (!::SSL_set_tlsext_host_name(ssl.native_handle(), host_sni.c_str()))
-            {
-                throw std::system_error{ static_cast<int>(::ERR_get_error()),
-                                         asio::error::get_ssl_category(),
-                                         "SNI failure" };
-            }
+            prepare_tls(ssl.native_handle(), std::string{ host });
             beast::get_lowest_layer(ssl).expires_after(k_handshake_timeout);
             co_await ssl.async_handshake(asio::ssl::stream_base::client, tok);
 
@@ -0,0 +1,70 @@
+/*
+Module Name:
+- metrics_server.hpp
+
+Abstract:
+- Minimal HTTP/1.1 listener serving GET /metrics from a tb::metrics::Registry in Prometheus text format.
+- Runs on its own io_context and thread; plain TCP, meant for a loopback or private address.
+
+Why:
+- A scrape renders every metric; doing that on the bot's executors would queue chat behind it.
+  A private thread keeps the hot path down to the atomics it already updates.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+// Core
+#include <tb/utils/metrics.hpp>
+
+namespace tb::net
+{
+
+    struct MetricsServerOptions
+    {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 9464;
+    };
+
+    class MetricsServer
+    {
+    public:
+        // Binds immediately. Throws boost::system::system_error if the address is unusable.
+        MetricsServer(MetricsServerOptions options, tb::metrics::Registry& registry);
+        ~MetricsServer() noexcept;
+
+        MetricsServer(const MetricsServer&) = delete;
+        MetricsServer& operator=(const MetricsServer&) = delete;
+
+        // Starts the listener thread. Idempotent.
+        void start();
+
+        // Closes the listener and joins the thread. Idempotent.
+        void stop() noexcept;
+
+        // Bound port; useful when options.port was 0.
+        [[nodiscard]] std::uint16_t port() const noexcept
+        {
+            return port_;
+        }
+
+    private:
+        boost::asio::awaitable<void> accept_loop();
+        boost::asio::awaitable<void> serve(boost::asio::ip::tcp::socket socket);
+
+        tb::metrics::Registry& registry_;
+        boost::asio::io_context io_{ 1 };
+        boost::asio::ip::tcp::acceptor acceptor_;
+        std::uint16_t port_ = 0;
+        std::thread thread_;
+    };
+
+} // namespace tb::net
@@ -0,0 +1,80 @@
+/*
+Module Name:
+- happy_eyeballs.hpp
+
+Abstract:
+- RFC 8305 style TCP connect: endpoints are raced with staggered starts, the first established socket wins
+  and the others are closed.
+- EndpointHistory remembers addresses that recently failed so later races try them last.
+
+Why:
+- asio::async_connect walks the resolver result one endpoint at a time under a single deadline; one
+  blackholed IPv6 address ate the whole budget before IPv4 was ever tried.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace tb::net
+{
+
+    struct HappyEyeballsOptions
+    {
+        std::chrono::milliseconds attempt_delay{ 250 }; // RFC 8305 "Connection Attempt Delay"
+        std::chrono::steady_clock::duration timeout = std::chrono::seconds(30); // whole race
+    };
+
+    // Thread-safety: all members may be called from any thread.
+    class EndpointHistory
+    {
+    public:
+        using endpoint_type = boost::asio::ip::tcp::endpoint;
+
+        explicit EndpointHistory(std::chrono::seconds penalty = std::chrono::minutes(10)) noexcept;
+
+        EndpointHistory(const EndpointHistory&) = delete;
+        EndpointHistory& operator=(const EndpointHistory&) = delete;
+
+        void record_failure(const endpoint_type& ep);
+        void record_success(const endpoint_type& ep);
+
+        // Race order: address families interleaved starting with the resolver's first answer,
+        // then endpoints that failed within the penalty window, fewest failures first.
+        [[nodiscard]] std::vector<endpoint_type> order(const boost::asio::ip::tcp::resolver::results_type& results) const;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            std::uint32_t failures = 0;
+            clock::time_point last_failure;
+        };
+
+        static constexpr std::size_t k_max_entries = 256;
+
+        const std::chrono::seconds penalty_;
+
+        mutable std::mutex mutex_;
+        std::map<endpoint_type, Entry> failed_;
+    };
+
+    // Connects a socket on executor to one of results. Throws boost::system::system_error with the
+    // last connect error, or timed_out if options.timeout passed first. history is optional.
+    boost::asio::awaitable<boost::asio::ip::tcp::socket>
+    happy_eyeballs_connect(boost::asio::any_io_executor executor,
+                           const boost::asio::ip::tcp::resolver::results_type& results,
+                           EndpointHistory* history = nullptr,
+                           HappyEyeballsOptions options = {});
+
+} // namespace tb::net
@@ -0,0 +1,89 @@
+/*
+Module Name:
+- tls_context.hpp
+
+Abstract:
+- One client TLS configuration for the process: trust store, protocol floor, cipher preferences and
+  a per-host session cache, set up once at startup and shared by IRC, HTTP and integrations.
+- prepare() does the per-connection part (SNI, hostname check, session offer) the same way for every client.
+
+Why:
+- Parsing cacert.pem on every connect cost more than the handshake it protected, and reconnect storms
+  across shards multiplied it.
+- TLS settings spread over call sites drift; one factory keeps every client on the same policy.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Boost.Asio
+#include <boost/asio/ssl/context.hpp>
+
+// OpenSSL
+#include <openssl/ssl.h>
+
+namespace tb::net
+{
+
+    struct TlsOptions
+    {
+        std::string ca_file; // PEM bundle; empty uses only the platform store
+        bool platform_store = true; // also trust the OS default verify paths
+        bool tls13_only = false; // otherwise TLS 1.2 is the floor
+
+        // TLS 1.2 list, then TLS 1.3 suites. AEAD only, forward secret only.
+        std::string cipher_list = "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                                  "ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-RSA-CHACHA20-POLY1305:"
+                                  "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384";
+        std::string ciphersuites = "TLS_AES_128_GCM_SHA256:TLS_CHACHA20_POLY1305_SHA256:TLS_AES_256_GCM_SHA384";
+    };
+
+    // Thread-safety: all members may be called from any thread.
+    class TlsContextFactory
+    {
+    public:
+        // Loads the trust store once. Throws std::system_error if ca_file cannot be read.
+        explicit TlsContextFactory(TlsOptions options = {});
+        ~TlsContextFactory() noexcept;
+
+        TlsContextFactory(const TlsContextFactory&) = delete;
+        TlsContextFactory& operator=(const TlsContextFactory&) = delete;
+
+        // Shared client context. Streams built on it inherit the policy and the session cache.
+        [[nodiscard]] boost::asio::ssl::context& context() noexcept
+        {
+            return ctx_;
+        }
+
+        // A separate context (e.g. for custom ALPN) with the same policy and the same X509_STORE.
+        [[nodiscard]] std::unique_ptr<boost::asio::ssl::context> make_context();
+
+        // Per connection, before the handshake: SNI, hostname verification and the cached session for host.
+        // Returns true if a session was offered. Throws std::system_error on SNI failure.
+        bool prepare(SSL* ssl, std::string_view host);
+
+        // Drop the cached session for host, e.g. after a failed resumed handshake.
+        void forget_session(std::string_view host);
+
+        // Process-wide factory. The first configure() call wins; later calls and calls after the
+        // first process() return false. Without configure(), defaults are used.
+        static bool configure(TlsOptions options);
+        [[nodiscard]] static TlsContextFactory& process();
+
+    private:
+        static int on_new_session(SSL* ssl, SSL_SESSION* session);
+        void apply_policy(SSL_CTX* ctx) const;
+
+        const TlsOptions options_;
+        boost::asio::ssl::context ctx_;
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, SSL_SESSION*> sessions_; // one owned reference each
+    };
+
+} // namespace tb::net
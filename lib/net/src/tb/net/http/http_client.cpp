@@ -4,7 +4,7 @@ Module Name:
 
 Abstract:
 - Coroutine-based HTTPS client on Boost.Asio/Beast with a simple connection pool.
-- Pools by "host:port", applies per-stage timeouts, supports redirects and cookies.
+- Pools by "host:port", races endpoints (happy eyeballs), applies per-stage timeouts, supports redirects and cookies.
 - Decodes gzip/br when requested and parses JSON with Glaze.
 - Design goal: minimal allocations and predictable behaviour under load.
 */
@@ -13,7 +13,6 @@ Abstract:
 #include <system_error>
 
 // Boost.Asio
-#include <boost/asio/connect.hpp>
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/use_awaitable.hpp>
 
@@ -54,6 +53,31 @@ namespace http_client
         pool_.reserve(expected_hosts); // preallocate buckets for typical host count
     }
 
+    client::client(boost::asio::any_io_executor executor,
+                   tb::net::TlsContextFactory& tls,
+                   std::size_t expected_hosts,
+                   std::size_t expected_conns_per_host) noexcept
+        :
+        client(std::move(executor), tls.context(), expected_hosts, expected_conns_per_host)
+    {
+        tls_ = &tls;
+    }
+
+    void client::prepare_tls(SSL* ssl, const std::string& host) const
+    {
+        if (tls_)
+        {
+            (void)tls_->prepare(ssl, host);
+            return;
+        }
+        if (!::SSL_set_tlsext_host_name(ssl, host.c_str()))
+        {
+            throw std::system_error{ static_cast<int>(::ERR_get_error()),
+                                     boost::asio::error::get_ssl_category(),
+                                     "SNI failure" };
+        }
+    }
+
     auto client::get_allocator() const noexcept -> allocator_type
     {
         return allocator_type(&handler_buffer_);
@@ -111,7 +135,8 @@ namespace http_client
                          std::string_view body,
                          http_headers headers,
                          const RequestOptions* opts,
-                         RequestMetrics* out_metrics) -> boost::asio::awaitable<result>
+                         RequestMetrics* out_metrics,
+                         ResponseMeta* out_meta) -> boost::asio::awaitable<result>
     {
         namespace asio = boost::asio;
         namespace beast = boost::beast;
@@ -172,23 +197,19 @@ namespace http_client
                 auto endpoints = co_await resolver_.async_resolve(cur_host, cur_port, tok);
                 metrics.t_dns = std::chrono::steady_clock::now() - t_dns_start;
 
-                beast::tcp_stream tcp(executor_);
-                beast::get_lowest_layer(tcp).expires_after(
-                    or_default(opts ? opts->tcp_connect_timeout : std::chrono::steady_clock::duration{},
-                               k_tcp_connect_timeout));
                 const auto t_conn_start = std::chrono::steady_clock::now();
-                co_await tcp.async_connect(endpoints, tok);
+                beast::tcp_stream tcp(co_await tb::net::happy_eyeballs_connect(
+                    executor_,
+                    endpoints,
+                    &endpoint_history_,
+                    { .timeout = or_default(opts ? opts->tcp_connect_timeout : std::chrono::steady_clock::duration{},
+                                            k_tcp_connect_timeout) }));
                 metrics.t_connect = std::chrono::steady_clock::now() - t_conn_start;
 
                 beast::get_lowest_layer(tcp).socket().set_option(asio::ip::tcp::no_delay{ true });
 
                 typename connection::ssl_stream ssl{ std::move(tcp), *ssl_context_ };
-                if (!::SSL_set_tlsext_host_name(ssl.native_handle(), cur_host.c_str()))
-                {
-                    throw std::system_error{ static_cast<int>(::ERR_get_error()),
-                                             asio::error::get_ssl_category(),
-                                             "SNI failure" };
-                }
+                prepare_tls(ssl.native_handle(), cur_host);
 
                 beast::get_lowest_layer(ssl).expires_after(or_default(
                     opts ? opts->tls_handshake_timeout : std::chrono::steady_clock::duration{},
@@ -284,6 +305,17 @@ namespace http_client
             keep_alive = res.keep_alive();
             metrics.status = res.result_int();
 
+            if (out_meta)
+            {
+                out_meta->status = metrics.status;
+                out_meta->headers.clear();
+                for (const auto& f : res.base())
+                {
+                    out_meta->headers.emplace_back(std::string(f.name_string().data(), f.name_string().size()),
+                                                   std::string(f.value().data(), f.value().size()));
+                }
+            }
+
             if (cookies_enabled_)
             {
                 auto path = detail::path_from_target(cur_target);
@@ -437,6 +469,17 @@ namespace http_client
         co_return co_await perform(boost::beast::http::verb::post, host, port, target, body, headers, &opts, nullptr);
     }
 
+    auto client::get_with_meta(std::string_view host,
+                               std::string_view port,
+                               std::string_view target,
+                               http_headers headers,
+                               ResponseMeta& meta,
+                               const RequestOptions* opts) -> boost::asio::awaitable<result>
+    {
+        meta = {};
+        co_return co_await perform(boost::beast::http::verb::get, host, port, target, {}, headers, opts, nullptr, &meta);
+    }
+
     auto client::get_with_retry(std::string_view host,
                                 std::string_view port,
                                 std::string_view target,
@@ -0,0 +1,176 @@
+/*
+Module Name:
+- metrics_server.cpp
+
+Abstract:
+- Accept loop and per-connection request handling for MetricsServer.
+
+Why:
+- Connections keep alive between scrapes as Prometheus expects; an idle or slow peer is dropped by a
+  read deadline so it cannot pin a socket.
+- Only GET and HEAD on /metrics are served; everything else is 404 or 405 with no body work.
+*/
+
+// C++ Standard Library
+#include <chrono>
+
+// Boost.Asio
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Boost.Beast
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+// Core
+#include <tb/net/http/metrics_server.hpp>
+#include <tb/utils/log.hpp>
+
+namespace tb::net
+{
+
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    using tcp = boost::asio::ip::tcp;
+
+    namespace
+    {
+        constexpr auto k_read_timeout = std::chrono::seconds{ 30 };
+        constexpr auto k_accept_backoff = std::chrono::milliseconds{ 100 }; // after a failed accept, e.g. EMFILE
+        constexpr char k_content_type[] = "text/plain; version=0.0.4; charset=utf-8";
+    } // namespace
+
+    MetricsServer::MetricsServer(MetricsServerOptions options, tb::metrics::Registry& registry) :
+        registry_{ registry }, acceptor_{ io_ }
+    {
+        const tcp::endpoint ep{ boost::asio::ip::make_address(options.address), options.port };
+        acceptor_.open(ep.protocol());
+        acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+        acceptor_.bind(ep);
+        acceptor_.listen();
+        port_ = acceptor_.local_endpoint().port();
+    }
+
+    MetricsServer::~MetricsServer() noexcept
+    {
+        stop();
+    }
+
+    void MetricsServer::start()
+    {
+        if (thread_.joinable())
+        {
+            return;
+        }
+        boost::asio::co_spawn(io_, accept_loop(), boost::asio::detached);
+        thread_ = std::thread([this] {
+            try
+            {
+                io_.run();
+            }
+            catch (const std::exception& e)
+            {
+                TB_LOG_ERROR("metrics", "listener stopped: {}", e.what());
+            }
+        });
+        TB_LOG_INFO("metrics", "serving /metrics on port {}", port_);
+    }
+
+    void MetricsServer::stop() noexcept
+    {
+        io_.stop();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    boost::asio::awaitable<void> MetricsServer::accept_loop()
+    {
+        boost::asio::steady_timer backoff{ io_ };
+        for (;;)
+        {
+            boost::system::error_code ec;
+            auto socket = co_await acceptor_.async_accept(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            if (ec)
+            {
+                if (ec == boost::asio::error::operation_aborted)
+                {
+                    co_return;
+                }
+                // e.g. EMFILE: the pending connection stays queued, so retrying at once would spin.
+                backoff.expires_after(k_accept_backoff);
+                co_await backoff.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                if (ec == boost::asio::error::operation_aborted)
+                {
+                    co_return;
+                }
+                continue;
+            }
+            boost::asio::co_spawn(io_, serve(std::move(socket)), boost::asio::detached);
+        }
+    }
+
+    boost::asio::awaitable<void> MetricsServer::serve(tcp::socket socket)
+    {
+        beast::tcp_stream stream{ std::move(socket) };
+        beast::flat_buffer buffer;
+        std::size_t last_size = 0;
+
+        for (;;)
+        {
+            http::request<http::empty_body> req;
+            stream.expires_after(k_read_timeout);
+            beast::error_code ec;
+            co_await http::async_read(stream, buffer, req, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            if (ec)
+            {
+                break; // closed, timed out or malformed
+            }
+
+            http::response<http::string_body> res;
+            res.version(req.version());
+            res.keep_alive(req.keep_alive());
+            res.set(http::field::server, "tb-metrics");
+
+            const bool get_or_head = req.method() == http::verb::get || req.method() == http::verb::head;
+            if (req.target() != "/metrics")
+            {
+                res.result(http::status::not_found);
+            }
+            else if (!get_or_head)
+            {
+                res.result(http::status::method_not_allowed);
+                res.set(http::field::allow, "GET, HEAD");
+            }
+            else
+            {
+                res.body().reserve(last_size); // one allocation per scrape
+                registry_.render(res.body());
+                last_size = res.body().size();
+                res.result(http::status::ok);
+                res.set(http::field::content_type, k_content_type);
+            }
+            res.prepare_payload();
+            if (req.method() == http::verb::head)
+            {
+                res.body().clear(); // Content-Length stays that of the GET body
+            }
+
+            stream.expires_after(k_read_timeout);
+            co_await http::async_write(stream, res, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            if (ec || !res.keep_alive())
+            {
+                break;
+            }
+        }
+
+        beast::error_code ignored;
+        stream.socket().shutdown(tcp::socket::shutdown_send, ignored);
+    }
+
+} // namespace tb::net
@@ -0,0 +1,246 @@
+/*
+Module Name:
+- happy_eyeballs.cpp
+
+Abstract:
+- Endpoint ordering and the connect race for happy_eyeballs_connect.
+
+Why:
+- The race runs on a private strand: one coroutine staggers attempts, connect completions only update
+  state and wake it. A failure wakes it early so the next endpoint starts without waiting out the delay.
+- Attempts that lose the race are cancelled, not recorded; only real errors and timeouts penalise an address.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <memory>
+#include <optional>
+
+// Boost.Asio
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Boost.System
+#include <boost/system/system_error.hpp>
+
+// Core
+#include <tb/net/tcp/happy_eyeballs.hpp>
+
+namespace tb::net
+{
+
+    using tcp = boost::asio::ip::tcp;
+    using error_code = boost::system::error_code;
+
+    EndpointHistory::EndpointHistory(std::chrono::seconds penalty) noexcept :
+        penalty_{ penalty }
+    {
+    }
+
+    void EndpointHistory::record_failure(const endpoint_type& ep)
+    {
+        const auto now = clock::now();
+        std::lock_guard lk(mutex_);
+        if (failed_.size() >= k_max_entries && !failed_.contains(ep))
+        {
+            std::erase_if(failed_, [&](const auto& kv) { return now - kv.second.last_failure >= penalty_; });
+            if (failed_.size() >= k_max_entries)
+            {
+                return; // bounded; a full table just stops learning
+            }
+        }
+        auto& e = failed_[ep];
+        ++e.failures;
+        e.last_failure = now;
+    }
+
+    void EndpointHistory::record_success(const endpoint_type& ep)
+    {
+        std::lock_guard lk(mutex_);
+        failed_.erase(ep);
+    }
+
+    std::vector<EndpointHistory::endpoint_type> EndpointHistory::order(const tcp::resolver::results_type& results) const
+    {
+        std::vector<endpoint_type> first_family;
+        std::vector<endpoint_type> other_family;
+        for (const auto& r : results)
+        {
+            const auto ep = r.endpoint();
+            if (first_family.empty() || ep.protocol() == first_family.front().protocol())
+            {
+                first_family.push_back(ep);
+            }
+            else
+            {
+                other_family.push_back(ep);
+            }
+        }
+
+        // RFC 8305 section 4: alternate families so one broken path costs a single attempt delay.
+        std::vector<endpoint_type> out;
+        out.reserve(first_family.size() + other_family.size());
+        for (std::size_t i = 0; i < std::max(first_family.size(), other_family.size()); ++i)
+        {
+            if (i < first_family.size())
+            {
+                out.push_back(first_family[i]);
+            }
+            if (i < other_family.size())
+            {
+                out.push_back(other_family[i]);
+            }
+        }
+
+        const auto now = clock::now();
+        std::lock_guard lk(mutex_);
+        auto failures = [&](const endpoint_type& ep) -> std::uint32_t {
+            auto it = failed_.find(ep);
+            return (it == failed_.end() || now - it->second.last_failure >= penalty_) ? 0 : it->second.failures;
+        };
+        std::stable_sort(out.begin(), out.end(), [&](const auto& a, const auto& b) { return failures(a) < failures(b); });
+        return out;
+    }
+
+    namespace
+    {
+        struct Race
+        {
+            struct Attempt
+            {
+                tcp::endpoint endpoint;
+                std::unique_ptr<tcp::socket> socket;
+                bool done = false;
+            };
+
+            explicit Race(boost::asio::any_io_executor executor) :
+                io{ executor }, strand{ boost::asio::make_strand(executor) }, wake{ strand }
+            {
+            }
+
+            boost::asio::any_io_executor io; // sockets live here, not on the race strand
+            boost::asio::strand<boost::asio::any_io_executor> strand;
+            boost::asio::steady_timer wake;
+            std::vector<Attempt> attempts;
+            std::size_t running = 0;
+            std::optional<tcp::socket> winner;
+            error_code last_error = boost::asio::error::host_not_found;
+        };
+
+        void start_attempt(const std::shared_ptr<Race>& race, const tcp::endpoint& ep, EndpointHistory* history)
+        {
+            const std::size_t idx = race->attempts.size();
+            race->attempts.push_back(Race::Attempt{ ep, std::make_unique<tcp::socket>(race->io) });
+            ++race->running;
+
+            race->attempts[idx].socket->async_connect(
+                ep, boost::asio::bind_executor(race->strand, [race, idx, history](error_code ec) {
+                    auto& a = race->attempts[idx];
+                    a.done = true;
+                    --race->running;
+                    if (!ec)
+                    {
+                        if (history)
+                        {
+                            history->record_success(a.endpoint);
+                        }
+                        if (!race->winner)
+                        {
+                            race->winner.emplace(std::move(*a.socket));
+                        }
+                    }
+                    else if (ec != boost::asio::error::operation_aborted)
+                    {
+                        race->last_error = ec;
+                        if (history)
+                        {
+                            history->record_failure(a.endpoint);
+                        }
+                    }
+                    race->wake.cancel(); // next attempt now, or finish
+                }));
+        }
+
+        boost::asio::awaitable<std::optional<tcp::socket>> run_race(std::shared_ptr<Race> race,
+                                                                    std::vector<tcp::endpoint> endpoints,
+                                                                    EndpointHistory* history,
+                                                                    HappyEyeballsOptions options)
+        {
+            using clock = std::chrono::steady_clock;
+            const auto deadline = clock::now() + options.timeout;
+            bool timed_out = false;
+            std::size_t next = 0;
+
+            // Completions run on the strand only while this coroutine waits, so no wake-up is lost.
+            while (!race->winner)
+            {
+                const auto now = clock::now();
+                if (now >= deadline)
+                {
+                    timed_out = true;
+                    break;
+                }
+                if (next < endpoints.size())
+                {
+                    start_attempt(race, endpoints[next++], history);
+                    race->wake.expires_at(std::min(now + options.attempt_delay, deadline));
+                }
+                else if (race->running == 0)
+                {
+                    break; // every endpoint failed
+                }
+                else
+                {
+                    race->wake.expires_at(deadline);
+                }
+
+                error_code ec;
+                co_await race->wake.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            }
+
+            for (auto& a : race->attempts)
+            {
+                if (timed_out && !a.done && history)
+                {
+                    history->record_failure(a.endpoint); // blackholed, not merely slower
+                }
+                error_code ignored;
+                a.socket->close(ignored); // pending losers complete with operation_aborted
+            }
+
+            if (!race->winner)
+            {
+                throw boost::system::system_error{ timed_out ? error_code{ boost::asio::error::timed_out } : race->last_error,
+                                                   "happy_eyeballs_connect" };
+            }
+            co_return std::move(race->winner);
+        }
+    } // namespace
+
+    boost::asio::awaitable<tcp::socket> happy_eyeballs_connect(boost::asio::any_io_executor executor,
+                                                               const tcp::resolver::results_type& results,
+                                                               EndpointHistory* history,
+                                                               HappyEyeballsOptions options)
+    {
+        std::vector<tcp::endpoint> endpoints;
+        if (history)
+        {
+            endpoints = history->order(results);
+        }
+        else
+        {
+            EndpointHistory none{ std::chrono::seconds::zero() };
+            endpoints = none.order(results);
+        }
+
+        auto race = std::make_shared<Race>(executor);
+        auto winner = co_await boost::asio::co_spawn(
+            race->strand, run_race(race, std::move(endpoints), history, options), boost::asio::use_awaitable);
+        co_return std::move(*winner);
+    }
+
+} // namespace tb::net
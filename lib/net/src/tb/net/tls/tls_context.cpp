@@ -0,0 +1,198 @@
+/*
+Module Name:
+- tls_context.cpp
+
+Abstract:
+- Trust store loading, protocol and cipher policy, and the client session cache for TlsContextFactory.
+
+Why:
+- OpenSSL's internal client cache never resumes on its own, so new-session callbacks feed a per-host
+  map and prepare() offers the entry. The callback sees TLS 1.3 tickets whenever they arrive.
+- Extra contexts share the X509_STORE by reference instead of parsing the bundle again.
+*/
+
+// C++ Standard Library
+#include <optional>
+#include <system_error>
+
+// Boost.Asio
+#include <boost/asio/ssl/error.hpp>
+
+// OpenSSL
+#include <openssl/err.h>
+
+// Core
+#include <tb/net/tls/tls_context.hpp>
+
+namespace tb::net
+{
+
+    namespace
+    {
+        [[noreturn]] void throw_ssl(const char* what)
+        {
+            throw std::system_error{ static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category(), what };
+        }
+
+        // Slot on SSL_CTX pointing back at the owning factory, for the session callback.
+        int factory_index()
+        {
+            static const int index = ::SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        struct ProcessSlot
+        {
+            std::mutex mutex;
+            std::optional<TlsOptions> options;
+            bool built = false;
+        };
+
+        ProcessSlot& process_slot()
+        {
+            static ProcessSlot slot;
+            return slot;
+        }
+    } // namespace
+
+    TlsContextFactory::TlsContextFactory(TlsOptions options) :
+        options_{ std::move(options) }, ctx_{ boost::asio::ssl::context::tls_client }
+    {
+        SSL_CTX* ctx = ctx_.native_handle();
+        apply_policy(ctx);
+
+        // Trust store: parsed once here, shared by every stream and by make_context().
+        if (options_.platform_store && ::SSL_CTX_set_default_verify_paths(ctx) != 1)
+        {
+            throw_ssl("failed to load platform trust store");
+        }
+        if (!options_.ca_file.empty() && ::SSL_CTX_load_verify_locations(ctx, options_.ca_file.c_str(), nullptr) != 1)
+        {
+            throw_ssl("failed to load CA bundle");
+        }
+
+        // Client-side cache without OpenSSL's internal store; on_new_session keeps one session per host.
+        ::SSL_CTX_set_ex_data(ctx, factory_index(), this);
+        ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        ::SSL_CTX_sess_set_new_cb(ctx, &TlsContextFactory::on_new_session);
+    }
+
+    TlsContextFactory::~TlsContextFactory() noexcept
+    {
+        ::SSL_CTX_sess_set_new_cb(ctx_.native_handle(), nullptr);
+        for (auto& [host, s] : sessions_)
+        {
+            ::SSL_SESSION_free(s);
+        }
+    }
+
+    void TlsContextFactory::apply_policy(SSL_CTX* ctx) const
+    {
+        if (::SSL_CTX_set_min_proto_version(ctx, options_.tls13_only ? TLS1_3_VERSION : TLS1_2_VERSION) != 1)
+        {
+            throw_ssl("failed to set TLS floor");
+        }
+        if (!options_.cipher_list.empty() && ::SSL_CTX_set_cipher_list(ctx, options_.cipher_list.c_str()) != 1)
+        {
+            throw_ssl("no usable TLS 1.2 ciphers");
+        }
+        if (!options_.ciphersuites.empty() && ::SSL_CTX_set_ciphersuites(ctx, options_.ciphersuites.c_str()) != 1)
+        {
+            throw_ssl("no usable TLS 1.3 suites");
+        }
+        ::SSL_CTX_set_options(ctx, SSL_OP_NO_COMPRESSION | SSL_OP_NO_RENEGOTIATION);
+        ::SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+    }
+
+    std::unique_ptr<boost::asio::ssl::context> TlsContextFactory::make_context()
+    {
+        auto ctx = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::tls_client);
+        apply_policy(ctx->native_handle());
+        ::SSL_CTX_set1_cert_store(ctx->native_handle(), ::SSL_CTX_get_cert_store(ctx_.native_handle()));
+        return ctx;
+    }
+
+    bool TlsContextFactory::prepare(SSL* ssl, std::string_view host)
+    {
+        const std::string name{ host };
+        if (!::SSL_set_tlsext_host_name(ssl, name.c_str()))
+        {
+            throw_ssl("SNI failure");
+        }
+        (void)::SSL_set1_host(ssl, name.c_str());
+
+        // Sessions belong to the shared context; streams on other contexts just skip resumption.
+        if (::SSL_get_SSL_CTX(ssl) != ctx_.native_handle())
+        {
+            return false;
+        }
+
+        std::lock_guard lk(mutex_);
+        auto it = sessions_.find(name);
+        if (it == sessions_.end())
+        {
+            return false;
+        }
+        if (::SSL_SESSION_is_resumable(it->second) != 1)
+        {
+            ::SSL_SESSION_free(it->second);
+            sessions_.erase(it);
+            return false;
+        }
+        return ::SSL_set_session(ssl, it->second) == 1; // takes its own reference
+    }
+
+    void TlsContextFactory::forget_session(std::string_view host)
+    {
+        std::lock_guard lk(mutex_);
+        if (auto it = sessions_.find(std::string{ host }); it != sessions_.end())
+        {
+            ::SSL_SESSION_free(it->second);
+            sessions_.erase(it);
+        }
+    }
+
+    int TlsContextFactory::on_new_session(SSL* ssl, SSL_SESSION* session)
+    {
+        auto* self = static_cast<TlsContextFactory*>(::SSL_CTX_get_ex_data(::SSL_get_SSL_CTX(ssl), factory_index()));
+        const char* host = ::SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+        if (!self || !host)
+        {
+            return 0; // not ours to keep; OpenSSL frees it
+        }
+
+        std::lock_guard lk(self->mutex_);
+        auto& slot = self->sessions_[host];
+        if (slot)
+        {
+            ::SSL_SESSION_free(slot);
+        }
+        slot = session;
+        return 1; // we now own the reference
+    }
+
+    bool TlsContextFactory::configure(TlsOptions options)
+    {
+        auto& slot = process_slot();
+        std::lock_guard lk(slot.mutex);
+        if (slot.built || slot.options)
+        {
+            return false;
+        }
+        slot.options = std::move(options);
+        return true;
+    }
+
+    TlsContextFactory& TlsContextFactory::process()
+    {
+        // Built on first use so configure() can run first; never destroyed while streams may exist.
+        static TlsContextFactory* instance = [] {
+            auto& slot = process_slot();
+            std::lock_guard lk(slot.mutex);
+            slot.built = true;
+            return new TlsContextFactory(slot.options.value_or(TlsOptions{}));
+        }();
+        return *instance;
+    }
+
+} // namespace tb::net
@@ -4,8 +4,13 @@ Module Name:
 
 Abstract:
 - Zero-copy IRC line parser for hot paths.
-- Produces views into the input buffer, avoids allocations, and uses a 64 byte SIMD scanner for separators.
+- Produces a compact IrcMessage of 16-bit offsets into the input buffer, read back as views; avoids
+  allocations and uses a 64 byte SIMD scanner for separators.
 - Detects Twitch-specific moderator and broadcaster signals from tags while scanning.
+
+Why:
+- Sixteen param views made the message about 330 bytes, copied into every handler coroutine and
+  through every dispatch. Offset pairs bring it to 104 bytes, two cache lines.
 */
 #pragma once
 
@@ -31,38 +36,80 @@ Abstract:
 namespace twitch_bot
 {
 
-    // Parsed IRC message - views only, no ownership.
-    struct IrcMessage
+    // Parsed IRC message - no ownership. Fields are 16-bit offset/length pairs into one line, read as views.
+    // command is the exception: a full view, so the dispatcher can hand handlers a name from elsewhere.
+    class IrcMessage
     {
+    public:
         static constexpr std::size_t max_params = 16; // hard cap on middle params
-
-        std::string_view command; // e.g. "PRIVMSG"
-        std::array<std::string_view, max_params> params;
-
-        // Use bytes instead of bitfields to keep generated code simple in hot loops.
-        uint8_t param_count = 0;
-        uint8_t is_moderator = 0; // tag "mod=1" or "user-type=mod"
-        uint8_t is_broadcaster = 0; // badges contains "broadcaster/1"
-
-        std::string_view raw_tags; // entire tag block without leading '@'
-        std::string_view prefix; // server or user, without leading ':'
-        std::string_view trailing; // text after the first leading ':' in the trailing field
+        static constexpr std::size_t max_line = 0xFFFF; // longest line offsets can address; Twitch sends < 9 KiB
 
         static constexpr std::size_t mod_tag_len = 5; // "mod=1"
         static constexpr std::size_t broadcaster_tag_len = 13; // "broadcaster/1"
         static constexpr std::size_t badges_prefix_len = 7; // "badges="
 
-        // Params as a span for ergonomic iteration without copying.
-        [[nodiscard]]
-        TB_FORCE_INLINE auto parameters() noexcept -> gsl::span<std::string_view>
+        IrcMessage() noexcept = default;
+
+        // Pre: line.size() <= max_line.
+        explicit IrcMessage(std::string_view line) noexcept :
+            base_{ line.data() }
         {
-            return { params.data(), params.data() + param_count };
+            Expects(line.size() <= max_line);
         }
 
-        [[nodiscard]]
-        TB_FORCE_INLINE auto parameters() const noexcept -> gsl::span<const std::string_view>
+        [[nodiscard]] TB_FORCE_INLINE std::string_view command() const noexcept
+        {
+            return command_; // e.g. "PRIVMSG"
+        }
+        [[nodiscard]] TB_FORCE_INLINE std::string_view raw_tags() const noexcept
+        {
+            return view(raw_tags_); // entire tag block without leading '@'
+        }
+        [[nodiscard]] TB_FORCE_INLINE std::string_view prefix() const noexcept
+        {
+            return view(prefix_); // server or user, without leading ':'
+        }
+        [[nodiscard]] TB_FORCE_INLINE std::string_view trailing() const noexcept
+        {
+            return view(trailing_); // text after the first leading ':' in the trailing field
+        }
+        [[nodiscard]] TB_FORCE_INLINE std::size_t param_count() const noexcept
+        {
+            return param_count_;
+        }
+        // Pre: i < param_count().
+        [[nodiscard]] TB_FORCE_INLINE std::string_view param(std::size_t i) const noexcept
+        {
+            Expects(i < param_count_);
+            return view(params_[i]);
+        }
+
+        // Setters for the parser and the dispatcher. Pre: every view but command's lies inside the line.
+        TB_FORCE_INLINE void set_command(std::string_view v) noexcept
+        {
+            command_ = v;
+        }
+        TB_FORCE_INLINE void set_raw_tags(std::string_view v) noexcept
+        {
+            raw_tags_ = span(v);
+        }
+        TB_FORCE_INLINE void set_prefix(std::string_view v) noexcept
+        {
+            prefix_ = span(v);
+        }
+        TB_FORCE_INLINE void set_trailing(std::string_view v) noexcept
         {
-            return { params.data(), params.data() + param_count };
+            trailing_ = span(v);
+        }
+        // False once max_params are stored.
+        TB_FORCE_INLINE bool add_param(std::string_view v) noexcept
+        {
+            if (param_count_ == max_params)
+            {
+                return false;
+            }
+            params_[param_count_++] = span(v);
+            return true;
         }
 
         // Fast single-pass tag lookup to avoid allocating a map.
@@ -72,8 +119,9 @@ namespace twitch_bot
         {
             Expects(!key.empty());
 
-            const char* cursor = raw_tags.data();
-            const char* const endp = cursor + raw_tags.size();
+            const auto tags = raw_tags();
+            const char* cursor = tags.data();
+            const char* const endp = cursor + tags.size();
             const std::size_t key_len = key.size();
 
             while (cursor < endp)
@@ -83,7 +131,7 @@ namespace twitch_bot
                 if (remaining >= key_len + 1 && std::memcmp(cursor, key.data(), key_len) == 0 && cursor[key_len] == '=')
                 {
                     const char* value_start = cursor + key_len + 1;
-                    const char* value_end = static_cast<const char*>(std::memchr(value_start, ';', endp - value_start));
+                    const char* value_end = static_cast<const char*>(std::memchr(value_start, ';', gsl::narrow_cast<std::size_t>(endp - value_start)));
                     if (!value_end)
                     {
                         value_end = endp;
@@ -92,14 +140,50 @@ namespace twitch_bot
                 }
 
                 // advance to next tag
-                const char* next_sep = static_cast<const char*>(std::memchr(cursor, ';', endp - cursor));
+                const char* next_sep = static_cast<const char*>(std::memchr(cursor, ';', gsl::narrow_cast<std::size_t>(endp - cursor)));
                 cursor = next_sep ? next_sep + 1 : endp;
             }
 
             return {};
         }
+
+    private:
+        struct Span
+        {
+            uint16_t off = 0;
+            uint16_t len = 0;
+        };
+
+        [[nodiscard]] TB_FORCE_INLINE std::string_view view(Span s) const noexcept
+        {
+            return s.len ? std::string_view{ base_ + s.off, s.len } : std::string_view{};
+        }
+
+        [[nodiscard]] TB_FORCE_INLINE Span span(std::string_view v) const noexcept
+        {
+            if (v.empty())
+            {
+                return {};
+            }
+            return { gsl::narrow_cast<uint16_t>(v.data() - base_), gsl::narrow_cast<uint16_t>(v.size()) };
+        }
+
+        const char* base_ = nullptr;
+        std::string_view command_;
+        Span raw_tags_;
+        Span prefix_;
+        Span trailing_;
+        std::array<Span, max_params> params_{};
+        uint8_t param_count_ = 0;
+
+    public:
+        // Use bytes instead of bitfields to keep generated code simple in hot loops.
+        uint8_t is_moderator = 0; // tag "mod=1" or "user-type=mod"
+        uint8_t is_broadcaster = 0; // badges contains "broadcaster/1"
     };
 
+    static_assert(sizeof(IrcMessage) <= 128, "IrcMessage should stay within two cache lines");
+
     namespace detail
     {
 
@@ -144,28 +228,28 @@ namespace twitch_bot
                 while (p < endp)
                 {
                     char ch = *p++;
-                    if (ch == ' ' && msg.param_count < IrcMessage::max_params)
+                    if (ch == ' ' && msg.param_count() < IrcMessage::max_params)
                     {
                         if (*token_start == ':')
                         {
                             const char* t = token_start + 1;
-                            msg.trailing = { t, gsl::narrow_cast<std::size_t>(endp - t) };
+                            msg.set_trailing({ t, gsl::narrow_cast<std::size_t>(endp - t) });
                             return;
                         }
-                        msg.params[msg.param_count++] = { token_start, gsl::narrow_cast<std::size_t>(p - token_start - 1) };
+                        msg.add_param({ token_start, gsl::narrow_cast<std::size_t>(p - token_start - 1) });
                         token_start = p;
                     }
                 }
-                if (token_start < endp && msg.param_count < IrcMessage::max_params)
+                if (token_start < endp && msg.param_count() < IrcMessage::max_params)
                 {
                     if (*token_start == ':')
                     {
                         const char* t = token_start + 1;
-                        msg.trailing = { t, gsl::narrow_cast<std::size_t>(endp - t) };
+                        msg.set_trailing({ t, gsl::narrow_cast<std::size_t>(endp - t) });
                     }
                     else
                     {
-                        msg.params[msg.param_count++] = { token_start, gsl::narrow_cast<std::size_t>(endp - token_start) };
+                        msg.add_param({ token_start, gsl::narrow_cast<std::size_t>(endp - token_start) });
                     }
                 }
                 return;
@@ -181,25 +265,25 @@ namespace twitch_bot
                 auto masks = irc_simd::scan64(reinterpret_cast<const uint8_t*>(scan), c);
 
                 uint64_t sp = masks.spaces;
-                while (sp && msg.param_count < IrcMessage::max_params)
+                while (sp && msg.param_count() < IrcMessage::max_params)
                 {
                     const uint32_t off = irc_simd::pop_lowest(sp);
                     const char* token_end = scan + off;
 
                     if (token_start == token_end)
                     {
-                        msg.params[msg.param_count++] = { token_start, 0 };
+                        msg.add_param({ token_start, 0 });
                         token_start = token_end + 1;
                     }
                     else if (*token_start == ':')
                     {
                         const char* t = token_start + 1;
-                        msg.trailing = { t, gsl::narrow_cast<std::size_t>(endp - t) };
+                        msg.set_trailing({ t, gsl::narrow_cast<std::size_t>(endp - t) });
                         return;
                     }
                     else
                     {
-                        msg.params[msg.param_count++] = { token_start, gsl::narrow_cast<std::size_t>(token_end - token_start) };
+                        msg.add_param({ token_start, gsl::narrow_cast<std::size_t>(token_end - token_start) });
                         token_start = token_end + 1;
                     }
                 }
@@ -207,16 +291,16 @@ namespace twitch_bot
                 scan += c;
             }
 
-            if (token_start < endp && msg.param_count < IrcMessage::max_params)
+            if (token_start < endp && msg.param_count() < IrcMessage::max_params)
             {
                 if (*token_start == ':')
                 {
                     const char* t = token_start + 1;
-                    msg.trailing = { t, gsl::narrow_cast<std::size_t>(endp - t) };
+                    msg.set_trailing({ t, gsl::narrow_cast<std::size_t>(endp - t) });
                 }
                 else
                 {
-                    msg.params[msg.param_count++] = { token_start, gsl::narrow_cast<std::size_t>(endp - token_start) };
+                    msg.add_param({ token_start, gsl::narrow_cast<std::size_t>(endp - token_start) });
                 }
             }
         }
@@ -224,15 +308,19 @@ namespace twitch_bot
     } // namespace detail
 
     // Parse one raw IRC line (no CRLF) into an IrcMessage.
-    // All views refer to 'raw'; no allocations.
+    // All views refer to 'raw'; no allocations. Lines over max_line yield an empty message.
     // Pre: raw.empty() || raw.data() is not null.
-    // Post: param_count <= max_params.
+    // Post: param_count() <= max_params.
     [[nodiscard]]
     TB_FORCE_INLINE auto parse_irc_line(std::string_view raw) noexcept -> IrcMessage
     {
         Expects(raw.empty() || raw.data() != nullptr);
 
-        IrcMessage msg{};
+        if (raw.size() > IrcMessage::max_line)
+        {
+            return {};
+        }
+        IrcMessage msg{ raw };
         const char* ptr = raw.data();
         const char* const endp = ptr + raw.size();
 
@@ -245,13 +333,13 @@ namespace twitch_bot
             uint8_t bc = 0;
             const char* tag_space = irc_simd::find_space_in_tags_and_flags(ptr, endp, mod, bc);
 
-            msg.raw_tags = { ptr, gsl::narrow_cast<std::size_t>(tag_space - ptr) };
+            msg.set_raw_tags({ ptr, gsl::narrow_cast<std::size_t>(tag_space - ptr) });
             msg.is_moderator = mod;
             msg.is_broadcaster = bc;
 
             if (tag_space == endp)
             {
-                Ensures(msg.param_count <= IrcMessage::max_params);
+                Ensures(msg.param_count() <= IrcMessage::max_params);
                 return msg; // only tags present
             }
             ptr = tag_space + 1;
@@ -264,11 +352,11 @@ namespace twitch_bot
             const char* space_pos = detail::find_first_space_fast(ptr, endp);
             if (space_pos == endp)
             {
-                msg.prefix = { ptr, gsl::narrow_cast<std::size_t>(endp - ptr) };
-                Ensures(msg.param_count <= IrcMessage::max_params);
+                msg.set_prefix({ ptr, gsl::narrow_cast<std::size_t>(endp - ptr) });
+                Ensures(msg.param_count() <= IrcMessage::max_params);
                 return msg;
             }
-            msg.prefix = { ptr, gsl::narrow_cast<std::size_t>(space_pos - ptr) };
+            msg.set_prefix({ ptr, gsl::narrow_cast<std::size_t>(space_pos - ptr) });
             ptr = space_pos + 1;
         }
 
@@ -277,20 +365,20 @@ namespace twitch_bot
             const char* space_pos = detail::find_first_space_fast(ptr, endp);
             if (space_pos != endp)
             {
-                msg.command = { ptr, gsl::narrow_cast<std::size_t>(space_pos - ptr) };
+                msg.set_command({ ptr, gsl::narrow_cast<std::size_t>(space_pos - ptr) });
                 ptr = space_pos + 1;
             }
             else
             {
-                msg.command = { ptr, gsl::narrow_cast<std::size_t>(endp - ptr) };
-                Ensures(msg.param_count <= IrcMessage::max_params);
+                msg.set_command({ ptr, gsl::narrow_cast<std::size_t>(endp - ptr) });
+                Ensures(msg.param_count() <= IrcMessage::max_params);
                 return msg;
             }
         }
 
         // [4] params and trailing
         detail::parse_params_and_trailing_fast(ptr, endp, msg);
-        Ensures(msg.param_count <= IrcMessage::max_params);
+        Ensures(msg.param_count() <= IrcMessage::max_params);
         return msg;
     }
 
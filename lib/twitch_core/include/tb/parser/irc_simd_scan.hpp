@@ -75,7 +75,7 @@ namespace irc_simd
     {
         CharMasks out{ 0, 0, 0, 0, 0, 0, 0 };
 
-#if IRC_SIMD_AVX2
+#if defined(IRC_SIMD_AVX2)
         // AVX2: direct loads for full lanes, copy at the tail to avoid overread.
         auto movemask32 = [](__m256i v) -> uint32_t {
             __m128i lo = _mm256_castsi256_si128(v);
@@ -121,7 +121,7 @@ namespace irc_simd
         out.letters_b = build_mask('b');
         out.letters_u = build_mask('u');
 
-#elif IRC_SIMD_SSE2
+#elif defined(IRC_SIMD_SSE2)
         // SSE2: four 16 byte loads produce a 64 bit mask, tail is zero padded.
         alignas(16) uint8_t buf[64]{};
         if (n)
@@ -155,7 +155,7 @@ namespace irc_simd
         out.letters_b = m_b;
         out.letters_u = m_u;
 
-#elif IRC_SIMD_NEON
+#elif defined(IRC_SIMD_NEON)
         // NEON assist: vector compare, then compress to a bitmask in scalar.
         uint8_t buf[64]{};
         if (n)
@@ -5,12 +5,46 @@ Module Name:
 Abstract:
 - Routes parsed IRC messages and plain chat lines to command handlers.
 - Handlers run on a supplied Asio executor to keep call sites thread agnostic.
-- Commands are case sensitive and keyed without allocations via transparent hashing.
+- Commands and their aliases are looked up in a perfect-hash CommandTable, optionally ASCII case-insensitive.
+  Before freeze() the table is rebuilt lazily, by the first command line after a registration; from
+  freeze() on, each command change rebuilds it at once.
+- Commands, triggers and listeners can be added or removed from any thread at any time. Each change
+  publishes a new immutable Routes snapshot; lanes read the current one under a tb::concurrent epoch pin.
+- Each channel hashes to one of K lanes, so channels run in parallel while one channel stays ordered.
+- A lane is a strand on the shared pool, or a whole home core in per-core mode.
+- Per-lane queue depth and command handler time are exported through tb::metrics.
+- Commands may carry a CooldownPolicy, enforced on the lane before the handler is spawned.
+- Commands run under a HandlerBudget: a timeout that cancels the handler through its Asio cancellation
+  slot, and a cap on concurrent runs. Per-command counts and timings feed tb::metrics and command_stats().
+- Chat listeners carry a ListenerPolicy: inline on the lane or on a small worker pool behind a bounded
+  queue, optionally sampled. Either way, their work is dropped and counted before it can delay commands.
+- Triggers fire a coroutine when a non-command line matches a tb::match pattern set (banned phrases,
+  keyword replies). Each trigger reads its set through a MatcherSlot, so the set can be swapped at runtime.
+
+Why:
+- One strand for every channel left the thread pool idle; lanes scale handler throughput with cores.
+- Readers never lock or touch a reference count. A writer rebuilds the snapshot under a mutex, swaps
+  the pointer and retires the old one, which is deleted after every lane that could see it has unpinned.
+- Lines are copied once into an owned buffer before crossing to a lane, so handlers never see the read buffer.
+- That buffer is a ref-counted tb::memory::Slab: every consumer of a line shares the one copy, and the
+  handler's IrcMessage views point into it, so they stay valid across co_await.
+- Slabs and command spawns draw from tb::memory's per-thread recycling pool, and handlers are shared
+  rather than copied. A slab released on a lane goes back to the reader thread's cache, so after warm-up
+  routing a line does not call malloc (tests/utils/recycling_resource_test.cpp counts this). Lines over
+  128 KiB bypass the pool.
 */
 #pragma once
 
 // C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -19,42 +53,262 @@ Abstract:
 // Boost.Asio
 #include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/awaitable.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 // Core
+#include "command_table.hpp"
+#include "cooldowns.hpp"
+#include "runtime.hpp"
 #include <tb/parser/irc_message_parser.hpp>
 #include <tb/utils/attributes.hpp>
+#include <tb/utils/bounded_mpsc_queue.hpp>
+#include <tb/utils/epoch.hpp>
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/pattern_matcher.hpp>
+#include <tb/utils/recycling_resource.hpp>
+#include <tb/utils/slab.hpp>
 #include <tb/utils/transparent_string_hash.hpp>
 
 namespace twitch_bot
 {
 
     // Plain chat listener for non-command lines.
+    // Inline listeners run on the channel's lane: one channel is always ordered, but different channels
+    // may call the same listener concurrently. Worker-pool listeners are called one line at a time.
     using chat_listener_t = std::function<void(std::string_view channel, std::string_view user, std::string_view text)>;
 
+    enum class ListenerExecution : std::uint8_t
+    {
+        inline_on_lane, // cheapest; a slow listener holds up commands on the same lane
+        worker_pool, // copied onto a bounded queue and run off the lanes
+    };
+
+    struct ListenerPolicy
+    {
+        std::string name = "listener"; // metrics label
+        ListenerExecution execution = ListenerExecution::inline_on_lane;
+        std::uint32_t sample_every = 1; // see 1 in N lines; 1 sees all
+        std::uint32_t queue_capacity = 1024; // worker_pool: lines waiting before new ones are dropped
+        std::uint32_t shed_above_depth = 512; // inline: skip while the lane has more lines queued; 0 never sheds
+    };
+
     // Coroutine handler for an IRC command.
     using command_handler_t = std::function<boost::asio::awaitable<void>(IrcMessage msg)>;
 
+    // Coroutine handler for a trigger. msg.command() is the trigger name and msg.trailing() the whole line;
+    // hit is the first pattern match in it.
+    using trigger_handler_t = std::function<boost::asio::awaitable<void>(IrcMessage msg, tb::match::Match hit)>;
+
+    // One registered trigger; shared into every spawn of it.
+    struct TriggerEntry
+    {
+        std::string name;
+        std::shared_ptr<tb::match::MatcherSlot> patterns; // store() a recompiled set to change it live
+        trigger_handler_t handler;
+        tb::metrics::Counter* hits = nullptr;
+    };
+
+    struct HandlerBudget
+    {
+        // Past this the handler's cancellation slot gets a terminal signal; its next await throws. 0 never.
+        std::chrono::milliseconds timeout{ 30'000 };
+        std::uint32_t max_concurrency = 0; // runs in flight across all channels before new ones are dropped; 0 no cap
+    };
+
+    // Point-in-time figures for one command; latencies are bucket estimates except max.
+    struct CommandStats
+    {
+        std::string name;
+        std::uint64_t invocations = 0; // handlers started
+        std::uint64_t errors = 0; // ended by an exception other than a timeout
+        std::uint64_t timeouts = 0;
+        std::uint64_t busy_rejects = 0; // dropped at max_concurrency
+        std::int64_t in_flight = 0;
+        std::chrono::nanoseconds p50{ 0 };
+        std::chrono::nanoseconds p99{ 0 };
+        std::chrono::nanoseconds max{ 0 };
+    };
+
+    // One registered command; shared by its aliases and by every spawn of it.
+    struct CommandEntry
+    {
+        std::string name; // canonical; handlers see this as IrcMessage::command()
+        command_handler_t handler;
+        CooldownPolicy cooldown;
+        HandlerBudget budget;
+        std::uint32_t id = 0; // registration order; part of every cooldown key
+        mutable std::atomic<std::int64_t> global_next_ms{ 0 }; // shared by every lane
+
+        // Accounting; metrics live in the registry, keyed by name.
+        mutable std::atomic<std::uint32_t> running{ 0 }; // exact, for max_concurrency
+        mutable std::atomic<std::int64_t> max_ns{ 0 };
+        tb::metrics::Counter* invocations = nullptr;
+        tb::metrics::Counter* errors = nullptr;
+        tb::metrics::Counter* timeouts = nullptr;
+        tb::metrics::Counter* busy = nullptr;
+        tb::metrics::Gauge* in_flight = nullptr;
+        tb::metrics::Gauge* max_us = nullptr;
+        tb::metrics::Histogram* latency = nullptr;
+    };
+
     // Routes IRC messages to command handlers or chat listeners.
     class CommandDispatcher
     {
     public:
-        // Work is posted onto executor so dispatch() can be called from any thread.
-        explicit CommandDispatcher(boost::asio::any_io_executor executor);
+        // Work is posted onto lanes so dispatch() can be called from any thread.
+        // Handlers for one channel start in arrival order; handlers for different channels run in parallel.
+        // lanes applies to the shared pool; per-core runtimes get one lane per home instead.
+        // Pre: lanes > 0.
+        explicit CommandDispatcher(Runtime& runtime, std::size_t lanes = 1);
+
+        // Pre: nothing is dispatching any more.
+        ~CommandDispatcher();
+
+        CommandDispatcher(const CommandDispatcher&) = delete;
+        CommandDispatcher& operator=(const CommandDispatcher&) = delete;
+
+        // All registration calls below are thread safe and take effect for lines routed after they return.
+        // Handlers already running keep their entry alive.
+
+        // Register a handler for 'command' and optional aliases. The first registration of a name wins.
+        // Aliases share the command's cooldowns and budget. Rejected invocations are dropped without a reply.
+        void register_command(std::string_view command,
+                              command_handler_t handler,
+                              std::initializer_list<std::string_view> aliases = {},
+                              CooldownPolicy cooldown = {},
+                              HandlerBudget budget = {});
+
+        // Remove a command and all of its aliases; any of its names will do. False if unknown.
+        bool unregister_command(std::string_view command);
 
-        // Register a handler for 'command' (case sensitive). Later calls replace earlier ones.
-        void register_command(std::string_view command, command_handler_t handler);
+        // Build the command table over every name registered so far. Call once startup commands are in.
+        // Until then a registration only records its names, and the first command line after it builds the
+        // table on its lane. Later command changes rebuild the table each time. Calling it again switches
+        // matching.
+        void freeze(CommandMatch match = CommandMatch::exact);
 
         // Register a fallback listener for non-command chat lines.
-        void register_chat_listener(chat_listener_t listener);
+        void register_chat_listener(chat_listener_t listener, ListenerPolicy policy = {});
+
+        // Remove the first listener registered under policy.name. Lines already queued for it still reach it.
+        bool remove_chat_listener(std::string_view name);
+
+        // Register a trigger for non-command lines. Triggers run before chat listeners, and listeners still see
+        // the line. Change the patterns through the slot.
+        void register_trigger(std::string_view name, std::shared_ptr<tb::match::MatcherSlot> patterns, trigger_handler_t handler);
+
+        bool remove_trigger(std::string_view name);
 
         // Dispatch a raw chat line. Channel should not include '#'; user is the login name.
         // Useful when upstream did not keep the full IRC prefix.
         void dispatch_text(std::string_view channel, std::string_view user, std::string_view text);
 
-        // Dispatch a parsed IRC message.
+        // Dispatch a parsed IRC message. Views in msg only need to live for this call.
         void dispatch(IrcMessage msg);
 
+        // One row per registered command, aliases folded in. Any thread.
+        [[nodiscard]] std::vector<CommandStats> command_stats() const;
+
+        [[nodiscard]] std::size_t lane_count() const noexcept
+        {
+            return lanes_.size();
+        }
+
+        // For the stall watchdog; lanes are fixed at construction.
+        [[nodiscard]] const HomeExecutor& lane(std::size_t index) const noexcept
+        {
+            return lanes_[index];
+        }
+
     private:
+        using lane_t = HomeExecutor;
+
+        // One chat line copied out of the read buffer into a shared slab. Copies share the bytes, so a
+        // handler, triggers and pooled listeners all read the same block, freed after the last of them.
+        struct ChatLine
+        {
+            tb::memory::Slab bytes; // channel | user | text | tags
+            std::uint32_t channel_len = 0;
+            std::uint32_t user_len = 0;
+            std::uint32_t text_len = 0;
+            bool is_moderator = false;
+            bool is_broadcaster = false;
+
+            [[nodiscard]] std::string_view channel() const noexcept
+            {
+                return { bytes.data(), channel_len };
+            }
+            [[nodiscard]] std::string_view user() const noexcept
+            {
+                return { bytes.data() + channel_len, user_len };
+            }
+            [[nodiscard]] std::string_view text() const noexcept
+            {
+                return { bytes.data() + channel_len + user_len, text_len };
+            }
+            [[nodiscard]] std::string_view tags() const noexcept
+            {
+                const std::size_t off = std::size_t{ channel_len } + user_len + text_len;
+                return { bytes.data() + off, bytes.size() - off };
+            }
+        };
+
+        struct Listener
+        {
+            chat_listener_t fn;
+            ListenerPolicy policy;
+            std::atomic<std::uint64_t> seen{ 0 }; // sampling counter
+            tb::metrics::Counter* shed = nullptr; // inline: lane over shed_above_depth
+            tb::metrics::Counter* queue_full = nullptr; // worker_pool: queue at capacity
+            std::optional<tb::concurrent::BoundedMpscQueue<ChatLine>> queue; // worker_pool only
+            std::atomic<bool> scheduled{ false }; // a drain is posted or running
+        };
+
+        // Everything route_text reads, published whole and never modified after.
+        struct Routes
+        {
+            std::shared_ptr<const CommandTable> commands; // shared by snapshots until a command change
+            bool commands_stale = false; // registered before freeze() and not in commands yet
+            std::vector<std::shared_ptr<const TriggerEntry>> triggers;
+            std::vector<std::shared_ptr<Listener>> listeners; // Listener state outlives snapshots
+        };
+
+        static constexpr std::size_t k_listener_threads = 2;
+        static constexpr std::size_t k_listener_batch = 64; // lines per drain before re-posting
+
+        static ChatLine make_line(std::string_view channel,
+                                  std::string_view user,
+                                  std::string_view text,
+                                  std::string_view raw_tags,
+                                  bool is_moderator,
+                                  bool is_broadcaster);
+
+        [[nodiscard]] std::size_t lane_for(std::string_view channel) const noexcept;
+
+        // Post line to its lane, counting it in the lane's queue depth until it is routed.
+        void post_line(std::string_view channel, ChatLine line);
+
+        struct DeadlinePool; // one lane's recycled command timeouts; defined in the .cpp
+
+        // Owns line for the lifetime of the handler so the IrcMessage views stay valid.
+        // deadlines is the lane's pool, touched only before the handler starts.
+        static boost::asio::awaitable<void> invoke_command(std::shared_ptr<const CommandEntry> entry, ChatLine line, DeadlinePool& deadlines);
+        static boost::asio::awaitable<void> invoke_trigger(std::shared_ptr<const TriggerEntry> entry, ChatLine line, tb::match::Match hit);
+
+        // Handler view of line; every view points into line.bytes.
+        static IrcMessage make_message(const ChatLine& line, std::string_view command, std::string_view trailing) noexcept;
+
+        // Caller holds registry_mutex_. Builds Routes from the registration state and swaps it in.
+        // The command table is rebuilt here only once the dispatcher is frozen; before that it is marked stale.
+        void publish(bool commands_changed = false);
+
+        // Caller holds registry_mutex_.
+        void rebuild_table();
+
+        // Any lane. Builds the table a stale snapshot is missing and publishes it; a no-op if another lane
+        // got there first.
+        void build_stale_table();
+
         // Keep channel keys uniform - most code expects names without '#'.
         static TB_FORCE_INLINE std::string_view Normalise_channel(std::string_view raw) noexcept
         {
@@ -94,22 +348,41 @@ namespace twitch_bot
             }
         }
 
-        boost::asio::any_io_executor executor_;
+        Runtime& runtime_;
+        std::vector<lane_t> lanes_;
+        std::vector<tb::metrics::Gauge*> lane_depth_; // parallel to lanes_
+        std::vector<std::unique_ptr<CooldownTable>> cooldowns_; // parallel to lanes_; created on first use
+        std::vector<std::unique_ptr<DeadlinePool>> deadlines_; // parallel to lanes_
+        std::atomic<const Routes*> routes_{ nullptr }; // never null after construction
+
+        // Registration state; writers and command_stats() only, under registry_mutex_.
+        mutable std::mutex registry_mutex_;
+        std::uint32_t next_command_id_ = 0;
+        CommandMatch match_ = CommandMatch::exact;
+        bool frozen_ = false; // freeze() has run; command changes rebuild table_ at once
+        bool table_stale_ = false; // commands_ changed since table_ was built
+        std::shared_ptr<const CommandTable> table_; // last built
         std::unordered_map<std::string,
-                           command_handler_t,
+                           std::shared_ptr<const CommandEntry>, // shared into each spawn, never copied
                            TransparentBasicStringHash<char>,
                            TransparentBasicStringEq<char>>
-            commands_;
-        std::vector<chat_listener_t> chat_listeners_;
-
-        // Single routing point so both IRC and raw-chat paths share behaviour.
-        // raw_tags and role flags are optional; supply when available to avoid re-parsing.
-        void route_text(std::string_view channel,
-                        std::string_view user,
-                        std::string_view text,
-                        std::string_view raw_tags = {},
-                        bool is_moderator = false,
-                        bool is_broadcaster = false);
+            commands_; // names and aliases
+        std::vector<std::shared_ptr<const TriggerEntry>> triggers_;
+        std::vector<std::shared_ptr<Listener>> chat_listeners_;
+        std::optional<boost::asio::thread_pool> listener_pool_; // first worker_pool listener starts it
+
+        // Single routing point so both IRC and raw-chat paths share behaviour. Runs on the line's lane.
+        void route_text(std::size_t lane, ChatLine line);
+
+        // Runs on the line's lane after the command check; spawns a handler for each trigger that matches.
+        void fire_triggers(std::size_t lane, const Routes& routes, const ChatLine& line);
+
+        // Runs on the line's lane after the command check; fans out by each listener's policy.
+        void notify_listeners(std::size_t lane, const Routes& routes, ChatLine& line);
+        void drain_listener(std::shared_ptr<Listener> l);
+
+        // False when a cooldown rejects line. Runs on the line's lane.
+        [[nodiscard]] bool admit(std::size_t lane, const CommandEntry& entry, const ChatLine& line);
     };
 
 } // namespace twitch_bot
@@ -0,0 +1,97 @@
+/*
+Module Name:
+- command_table.hpp
+
+Abstract:
+- Immutable perfect-hash index from command names and aliases to their CommandEntry.
+- Built by CommandDispatcher::freeze() and rebuilt whole whenever a command is added or removed after
+  that, as part of its Routes snapshot.
+- Matching is exact or ASCII case-insensitive, chosen at build time.
+
+Why:
+- The name set is known after startup, so hash-and-displace (CHD) can build a minimal-ish perfect
+  hash over it: names are split into small buckets, and each bucket gets a displacement that moves its
+  names into free slots. A lookup is one hash, one displacement load, one slot load and one compare,
+  with no probing and no allocation. The index stays linear in the name count.
+- Case folding is done inside the hash and compare, so "!JOIN" never needs a lowered copy.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace twitch_bot
+{
+
+    struct CommandEntry; // defined by the dispatcher; only shared here
+
+    enum class CommandMatch : std::uint8_t
+    {
+        exact,
+        ascii_case_insensitive,
+    };
+
+    class CommandTable
+    {
+    public:
+        using entry_ptr = std::shared_ptr<const CommandEntry>;
+
+        struct Key
+        {
+            std::string name; // command or alias, without '!'
+            entry_ptr entry;
+        };
+
+        // Later keys that equal an earlier one under match are dropped.
+        [[nodiscard]] static std::unique_ptr<const CommandTable> build(std::vector<Key> keys, CommandMatch match);
+
+        // nullptr on a miss.
+        [[nodiscard]] const entry_ptr* find(std::string_view name) const noexcept;
+
+        // Every name, aliases included, in build order.
+        [[nodiscard]] std::span<const Key> keys() const noexcept
+        {
+            return keys_;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return keys_.size();
+        }
+
+        [[nodiscard]] CommandMatch match() const noexcept
+        {
+            return match_;
+        }
+
+        // Slots in the index: under 2.5 per name, and at least 8.
+        [[nodiscard]] std::size_t slot_count() const noexcept
+        {
+            return slots_.size();
+        }
+
+    private:
+        CommandTable() = default;
+
+        [[nodiscard]] std::uint64_t hash(std::string_view name) const noexcept;
+        [[nodiscard]] bool equal(std::string_view a, std::string_view b) const noexcept;
+        [[nodiscard]] std::size_t bucket_of(std::uint64_t h) const noexcept;
+        [[nodiscard]] std::size_t slot_of(std::uint64_t h, std::uint16_t displacement) const noexcept;
+
+        std::vector<Key> keys_;
+        std::vector<std::uint16_t> slots_; // key index + 1; 0 is empty
+        std::vector<std::uint16_t> displace_; // per bucket
+        std::uint64_t seed_ = 0;
+        std::uint64_t mask_ = 0;
+        std::uint64_t bucket_mask_ = 0;
+        std::size_t max_len_ = 0; // longer names miss without hashing
+        CommandMatch match_ = CommandMatch::exact;
+    };
+
+} // namespace twitch_bot
@@ -4,7 +4,7 @@ Module Name:
 
 Abstract:
 - Immutable configuration for the Twitch bot loaded from a single TOML file.
-- Surfaces strongly typed sections (app, bot, auth) and the absolute file path.
+- Surfaces strongly typed sections (app, bot, auth, log, runtime, metrics, watchdog) and the absolute file path.
 - Fails fast with EnvError on invalid or missing configuration.
 - Includes a helper to update the access token on disk without changing other fields.
 */
@@ -13,6 +13,7 @@ Abstract:
 // C++ Standard Library
 #include <filesystem>
 #include <fstream>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 
@@ -39,6 +40,8 @@ namespace env
     {
         std::string login; ///< bot username (lowercase)
         std::string control_channel; ///< defaults to login if not set
+        bool anonymous_ingest = false; ///< read chat via justinfan logins; write via the bot login
+        bool case_insensitive_commands = false; ///< "!Join" matches "join" (ASCII only)
     };
 
     /// Twitch OAuth tokens.
@@ -48,6 +51,36 @@ namespace env
         std::string refresh_token;
     };
 
+    /// Logging. Optional section; defaults keep raw IRC lines out of the log.
+    struct LogConfig
+    {
+        std::string level = "info"; ///< trace, debug, info, warn, error or off
+        std::uint32_t raw_sample_every = 0; ///< log 1 in N raw IRC lines at debug; 0 disables
+    };
+
+    /// Threading model. Optional section; defaults keep the shared thread pool.
+    struct RuntimeConfig
+    {
+        bool per_core = false; ///< mode = "per_core": one pinned io_context per thread
+        std::uint32_t threads = 0; ///< 0 means one per hardware thread
+        bool pin = true; ///< per-core mode only
+    };
+
+    /// Prometheus endpoint. Optional section; off unless a port is set.
+    struct MetricsConfig
+    {
+        std::string address = "127.0.0.1"; ///< keep on loopback unless scraped from elsewhere
+        std::uint16_t port = 0; ///< 0 disables the listener
+    };
+
+    /// Stall watchdog. Optional section; on by default.
+    struct WatchdogConfig
+    {
+        std::uint32_t threshold_ms = 250; ///< probe age reported as a stall; 0 disables the watchdog
+        std::uint32_t interval_ms = 100; ///< probe period
+        bool stack_samples = true; ///< Linux only
+    };
+
     /// Immutable application configuration (single TOML file).
     class Config
     {
@@ -71,6 +104,22 @@ namespace env
         {
             return auth_;
         }
+        [[nodiscard]] const LogConfig& log() const noexcept
+        {
+            return log_;
+        }
+        [[nodiscard]] const RuntimeConfig& runtime() const noexcept
+        {
+            return runtime_;
+        }
+        [[nodiscard]] const MetricsConfig& metrics() const noexcept
+        {
+            return metrics_;
+        }
+        [[nodiscard]] const WatchdogConfig& watchdog() const noexcept
+        {
+            return watchdog_;
+        }
         /// Absolute path to the loaded config file. Useful for later persistence.
         [[nodiscard]] const std::filesystem::path& path() const noexcept
         {
@@ -84,9 +133,13 @@ namespace env
         Config(std::filesystem::path path,
                AppConfig app_cfg,
                BotConfig bot_cfg,
-               AuthConfig auth_cfg) noexcept
+               AuthConfig auth_cfg,
+               LogConfig log_cfg,
+               RuntimeConfig runtime_cfg,
+               MetricsConfig metrics_cfg,
+               WatchdogConfig watchdog_cfg) noexcept
             :
-            path_{ std::move(path) }, app_{ std::move(app_cfg) }, bot_{ std::move(bot_cfg) }, auth_{ std::move(auth_cfg) }
+            path_{ std::move(path) }, app_{ std::move(app_cfg) }, bot_{ std::move(bot_cfg) }, auth_{ std::move(auth_cfg) }, log_{ std::move(log_cfg) }, runtime_{ runtime_cfg }, metrics_{ std::move(metrics_cfg) }, watchdog_{ watchdog_cfg }
         {
         }
 
@@ -94,6 +147,10 @@ namespace env
         AppConfig app_;
         BotConfig bot_;
         AuthConfig auth_;
+        LogConfig log_;
+        RuntimeConfig runtime_;
+        MetricsConfig metrics_;
+        WatchdogConfig watchdog_;
     };
 
     /// Overwrite twitch.chat.access_token in the given config file.
@@ -0,0 +1,81 @@
+/*
+Module Name:
+- connect_cache.hpp
+
+Abstract:
+- Connection state that outlives a single IrcClient: resolved endpoints with a TTL, and the failure
+  history that orders the happy-eyeballs race.
+- Shared by every shard of a pool so a reconnect skips DNS. TLS sessions and the trust store live in
+  tb::net::TlsContextFactory.
+
+Why:
+- Resolving dominates time-to-reconnect once TLS resumes, and every millisecond after a RECONNECT
+  notice is chat the bot never sees.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Boost.Asio
+#include <boost/asio/ip/tcp.hpp>
+
+// Core
+#include <tb/net/tcp/happy_eyeballs.hpp>
+#include <tb/utils/transparent_string_hash.hpp>
+
+namespace twitch_bot
+{
+
+    struct ConnectCacheOptions
+    {
+        std::chrono::seconds dns_ttl{ 300 }; // Asio does not expose record TTLs; this bounds staleness
+    };
+
+    // Thread-safety: all members may be called from any thread.
+    class ConnectCache
+    {
+    public:
+        using results_type = boost::asio::ip::tcp::resolver::results_type;
+
+        explicit ConnectCache(ConnectCacheOptions options = {}) noexcept;
+
+        ConnectCache(const ConnectCache&) = delete;
+        ConnectCache& operator=(const ConnectCache&) = delete;
+
+        // Cached endpoints for host, if resolved within dns_ttl.
+        [[nodiscard]] std::optional<results_type> endpoints(std::string_view host) const;
+        void store_endpoints(std::string_view host, results_type results);
+
+        // Called when connecting to the cached endpoints failed, so the next attempt resolves again.
+        void forget_endpoints(std::string_view host);
+
+        // Per-address connect failures, shared by every shard.
+        [[nodiscard]] tb::net::EndpointHistory& endpoint_history() noexcept
+        {
+            return history_;
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct DnsEntry
+        {
+            results_type results;
+            clock::time_point expires;
+        };
+
+        const ConnectCacheOptions options_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, DnsEntry, TransparentBasicStringHash<char>, TransparentBasicStringEq<char>> dns_;
+
+        tb::net::EndpointHistory history_;
+    };
+
+} // namespace twitch_bot
@@ -0,0 +1,104 @@
+/*
+Module Name:
+- cooldowns.hpp
+
+Abstract:
+- Declarative command cooldowns: global, per channel and per user, with a per-user burst allowance.
+- CooldownTable is one lane's state: an open-addressing table of GCRA deadlines, emptied by a
+  tb::timing::TimingWheel as the deadlines pass.
+
+Why:
+- Checked before co_spawn, so a spammer costs a hash probe instead of a handler, a Helix call and
+  a reply.
+- A channel always maps to the same lane, so per-channel limits are exact without locks. The global
+  deadline is one atomic per command. Per-user state is per lane: a user spreading spam across
+  channels on different lanes gets at most one allowance per lane.
+- Keys are 64-bit hashes of (command, scope, name), not interned strings. An intern table for
+  millions of logins would itself be unbounded.
+- Capacity is fixed. When every slot is live, new keys are admitted untracked and counted.
+  The global and per-channel limits still hold.
+- Rejects and admits never allocate.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Core
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/timing_wheel.hpp>
+
+namespace twitch_bot
+{
+
+    struct CooldownPolicy
+    {
+        std::chrono::milliseconds global{ 0 }; // between any two runs of the command
+        std::chrono::milliseconds per_channel{ 0 };
+        std::chrono::milliseconds per_user{ 0 };
+        std::uint32_t user_burst = 1; // back-to-back runs a user gets before per_user applies
+        bool exempt_privileged = true; // broadcaster and moderators skip every limit
+
+        [[nodiscard]] bool enabled() const noexcept
+        {
+            return global.count() > 0 || per_channel.count() > 0 || per_user.count() > 0;
+        }
+    };
+
+    enum class CooldownVerdict : std::uint8_t
+    {
+        allowed,
+        global,
+        channel,
+        user,
+    };
+
+    // Not thread safe: owned by one dispatcher lane.
+    class CooldownTable
+    {
+    public:
+        static constexpr std::uint32_t k_default_capacity = 1u << 12; // live keys per lane
+
+        explicit CooldownTable(std::uint32_t capacity = k_default_capacity);
+
+        // Admits and records, or rejects and changes nothing. now_ms is steady_clock milliseconds.
+        // global_next_ms is the command's shared global deadline.
+        [[nodiscard]] CooldownVerdict check(std::uint32_t command_id,
+                                            const CooldownPolicy& policy,
+                                            std::atomic<std::int64_t>& global_next_ms,
+                                            std::string_view channel,
+                                            std::string_view user,
+                                            std::int64_t now_ms) noexcept;
+
+        [[nodiscard]] std::uint32_t size() const noexcept
+        {
+            return size_;
+        }
+
+    private:
+        static constexpr std::int64_t k_tick_ms = 16; // wheel resolution
+
+        struct Slot
+        {
+            std::uint64_t key = 0; // 0 is empty
+            std::int64_t tat_ms = 0; // GCRA theoretical arrival time
+        };
+
+        [[nodiscard]] Slot* find(std::uint64_t key) noexcept;
+        void record(std::uint64_t key, std::int64_t period_ms, std::int64_t now_ms) noexcept;
+        void erase(std::uint64_t key) noexcept;
+        void expire(std::int64_t now_ms) noexcept;
+
+        std::vector<Slot> slots_;
+        std::uint64_t mask_;
+        std::uint32_t size_ = 0;
+        std::uint32_t max_live_; // 7/8 of capacity keeps probe runs short
+        tb::timing::TimingWheel wheel_;
+        tb::metrics::Counter& untracked_;
+    };
+
+} // namespace twitch_bot
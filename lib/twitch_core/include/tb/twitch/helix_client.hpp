@@ -6,6 +6,16 @@ Abstract:
 - Small Twitch Helix client that caches and refreshes a user access token.
 - Token work is serialised on a strand to avoid concurrent refresh races.
 - Stream status returns optional to signal "no live stream" cleanly without errors.
+- Single stream-status lookups are cached (TtlCache): fresh for k_stream_ttl, served stale while a
+  refresh runs, and offline answers kept for the shorter k_stream_offline_ttl.
+- Helix calls share a HelixRateLimiter fed by the Ratelimit-* headers: chat lookups go ahead of polls
+  when points run low, and requests are spaced to the refill rate instead of tripping 429s.
+- Stream status is batched: up to 100 logins per /helix/streams call. Single-login calls made within
+  k_coalesce_window of each other are merged into one request and the answers fanned back out.
+
+Why:
+- One request per channel made a 5,000-channel poll cost 5,000 requests against a shared rate limit;
+  batched it is 50.
 */
 #pragma once
 
@@ -16,11 +26,14 @@ Abstract:
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Boost.Asio
 #include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/awaitable.hpp>
-#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 
 // Glaze
@@ -28,6 +41,9 @@ Abstract:
 
 // Core
 #include <tb/net/http/http_client.hpp>
+#include <tb/net/tls/tls_context.hpp>
+#include <tb/twitch/helix_rate_limiter.hpp>
+#include <tb/twitch/ttl_cache.hpp>
 #include <tb/utils/attributes.hpp>
 
 namespace twitch_bot
@@ -45,7 +61,7 @@ namespace twitch_bot
     {
     public:
         HelixClient(boost::asio::any_io_executor executor,
-                    boost::asio::ssl::context& ssl_ctx,
+                    tb::net::TlsContextFactory& tls,
                     std::string_view client_id,
                     std::string_view client_secret,
                     std::string_view refresh_token);
@@ -57,8 +73,10 @@ namespace twitch_bot
         ~HelixClient();
 
         // Ensure we hold a valid access token; refresh using the stored refresh token when needed.
+        // A token validated or issued within k_revalidate_after is trusted without a round trip
+        // unless force_validate is set (e.g. after the server rejected it).
         // Runs on the strand to prevent duplicate refreshes under load.
-        auto ensure_valid_token() -> boost::asio::awaitable<void>;
+        auto ensure_valid_token(bool force_validate = false) -> boost::asio::awaitable<void>;
 
         // Validate the current token via /oauth2/validate and update expiry if valid.
         [[nodiscard]] auto validate_token() -> boost::asio::awaitable<bool>;
@@ -66,11 +84,42 @@ namespace twitch_bot
         // Refresh a user access token using the stored refresh token.
         auto refresh_token() -> boost::asio::awaitable<void>;
 
-        // Return stream status for the given channel_id.
+        // Return stream status for the given login ('#' and case are ignored).
         // Returns std::nullopt when no live stream is reported.
-        auto get_stream_status(std::string_view channel_id)
+        // Answers from the cache when it can; otherwise waits up to k_coalesce_window so concurrent
+        // calls share one request.
+        auto get_stream_status(std::string_view user_login)
             -> boost::asio::awaitable<std::optional<StreamStatus>>;
 
+        // Batched form: one result per login, in order; 100 logins per request. Always asks Helix,
+        // and refreshes the cache with what it learns.
+        auto get_stream_statuses(std::vector<std::string> user_logins)
+            -> boost::asio::awaitable<std::vector<std::optional<StreamStatus>>>;
+
+        // Sends one Helix GET. Fills meta and throws on a non-2xx status, as client::get_with_meta does.
+        using transport_t = std::function<boost::asio::awaitable<http_client::result>(std::string_view host,
+                                                                                      std::string_view port,
+                                                                                      std::string_view target,
+                                                                                      http_client::http_headers headers,
+                                                                                      http_client::client::ResponseMeta& meta)>;
+
+        // Replace the HTTP call behind Helix requests (not the OAuth ones). Tests answer from a fake here.
+        // Call before issuing requests.
+        void set_transport(transport_t transport) noexcept
+        {
+            transport_ = std::move(transport);
+        }
+
+        // Install a token obtained elsewhere. It counts as validated now and expires after expires_in.
+        // Call before issuing requests.
+        void set_access_token(std::string token, std::chrono::seconds expires_in);
+
+        // Client-side view of the Helix rate-limit bucket.
+        [[nodiscard]] HelixRateLimitState rate_limit_state() const
+        {
+            return rate_limiter_->state();
+        }
+
         [[nodiscard]] auto current_token() const noexcept -> const std::string&
         {
             return token_;
@@ -84,11 +133,39 @@ namespace twitch_bot
         }
 
     private:
+        // Twitch asks for hourly validation; stay well inside that and clear of expiry.
+        static constexpr std::chrono::minutes k_revalidate_after{ 30 };
+        static constexpr std::chrono::minutes k_expiry_margin{ 5 };
+
+        static constexpr std::size_t k_streams_batch = 100; // Helix cap on user_login per call
+        static constexpr std::chrono::milliseconds k_coalesce_window{ 25 };
+        static constexpr std::chrono::seconds k_stream_ttl{ 30 };
+        static constexpr std::chrono::seconds k_stream_stale_for{ 90 };
+        static constexpr std::chrono::seconds k_stream_offline_ttl{ 10 };
+        static constexpr int k_max_429_retries = 2;
+
+        // One get_stream_status call waiting for its batch. Lives on strand_.
+        struct StatusWaiter
+        {
+            explicit StatusWaiter(const boost::asio::any_io_executor& ex, std::string login_name) :
+                login{ std::move(login_name) }, done{ ex }
+            {
+                done.expires_at(std::chrono::steady_clock::time_point::max());
+            }
+
+            std::string login; // canonical
+            std::optional<StreamStatus> result;
+            boost::asio::steady_timer done; // cancelled when result is set
+            bool ready = false;
+            bool failed = false; // the batch errored; result means nothing
+        };
+
         // Serialises all token state transitions and HTTP calls that depend on them.
         boost::asio::strand<boost::asio::any_io_executor> strand_;
 
         std::string token_;
         std::chrono::steady_clock::time_point token_expiry_{};
+        std::chrono::steady_clock::time_point validated_at_{}; // last validate or refresh that succeeded
         AccessTokenPersistor persist_access_token_{};
         const std::string client_id_;
         const std::string client_secret_;
@@ -96,6 +173,36 @@ namespace twitch_bot
 
         boost::asio::any_io_executor executor_;
         std::unique_ptr<http_client::client> http_client_; // shared across requests for connection pooling
+        transport_t transport_; // helix_get's HTTP call; http_client_ unless replaced
+
+        std::vector<std::shared_ptr<StatusWaiter>> pending_status_; // on strand_
+        bool status_flush_armed_ = false; // a window timer is running for pending_status_
+        std::unique_ptr<TtlCache<StreamStatus>> stream_cache_;
+        std::unique_ptr<HelixRateLimiter> rate_limiter_;
+
+        // Uncached single lookup through the coalescer; throws if the batch failed.
+        auto lookup_stream_status(std::string login) -> boost::asio::awaitable<std::optional<StreamStatus>>;
+
+        // What fetch_streams learned. Offline and unknown logins are absent from live; logins whose
+        // page failed are in failed and must not be taken (or cached) as offline.
+        struct StreamPages
+        {
+            std::unordered_map<std::string, StreamStatus> live;
+            std::unordered_set<std::string> failed;
+        };
+
+        // Live streams among logins (canonical, unique), keyed by login.
+        auto fetch_streams(std::vector<std::string> logins, HelixPriority priority)
+            -> boost::asio::awaitable<StreamPages>;
+        // One batch; retries once on 401.
+        auto fetch_streams_page(std::string_view target, std::unordered_map<std::string, StreamStatus>& out, HelixPriority priority)
+            -> boost::asio::awaitable<void>;
+        // Every Helix request goes through here: rate-limited, with the bearer and Client-ID headers.
+        // status is the final response's HTTP status (0 if none arrived), set before a non-2xx throws.
+        auto helix_get(std::string_view host, std::string_view port, std::string_view target, HelixPriority priority, int& status)
+            -> boost::asio::awaitable<http_client::result>;
+        // Runs on strand_. Takes every pending waiter and answers it.
+        auto flush_status_waiters() -> boost::asio::awaitable<void>;
 
         // Kept separate to centralise JSON parsing and error mapping.
         auto fetch_token(std::string body) -> boost::asio::awaitable<void>;
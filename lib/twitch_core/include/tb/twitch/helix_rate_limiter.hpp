@@ -0,0 +1,123 @@
+/*
+Module Name:
+- helix_rate_limiter.hpp
+
+Abstract:
+- Client-side model of the Helix token bucket, driven by the Ratelimit-Limit, Ratelimit-Remaining and
+  Ratelimit-Reset response headers.
+- acquire() returns at once while points are plentiful. When they run low, callers queue by priority
+  and are released one at a time as the bucket refills, so requests are spaced out until the reset.
+- Every acquire() is paired with one on_response(), which corrects the estimate from the headers. A 429
+  empties the bucket until the reset the server reports.
+
+Why:
+- Helix refills continuously (Ratelimit-Limit points per minute). Sending at the refill rate keeps
+  throughput at the limit, where bursting and then retrying on 429 wastes a minute's worth of points.
+- Interactive lookups keep a small reserve, so a background poll cannot starve chat replies.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+
+// Core
+#include <tb/net/http/http_client.hpp>
+
+namespace twitch_bot
+{
+
+    enum class HelixPriority : std::uint8_t
+    {
+        interactive, // a chat user is waiting on the answer
+        background,  // polls and prefetches; never spends the reserve
+    };
+
+    struct HelixRateLimiterOptions
+    {
+        std::uint32_t limit = 800; // points per window until the first Ratelimit-Limit header
+        std::chrono::milliseconds window{ 60'000 }; // refill period for limit points
+        std::uint32_t reserve = 20; // held back for interactive requests
+        std::chrono::milliseconds reset_slack{ 250 }; // clock skew margin on Ratelimit-Reset
+        std::chrono::milliseconds backoff_429{ 1'000 }; // when a 429 carries no Ratelimit-Reset
+    };
+
+    // Snapshot for logs and diagnostics.
+    struct HelixRateLimitState
+    {
+        std::uint32_t limit = 0;
+        double remaining = 0; // estimate, after points handed out
+        std::size_t in_flight = 0;
+        std::size_t queued = 0;
+    };
+
+    // Thread-safety: public members may be called from any thread.
+    class HelixRateLimiter
+    {
+    public:
+        explicit HelixRateLimiter(boost::asio::any_io_executor executor, HelixRateLimiterOptions options = {});
+
+        HelixRateLimiter(const HelixRateLimiter&) = delete;
+        HelixRateLimiter& operator=(const HelixRateLimiter&) = delete;
+
+        // Wait for one point. Pair with exactly one on_response().
+        auto acquire(HelixPriority priority) -> boost::asio::awaitable<void>;
+
+        // Report the outcome of a request sent under a point. meta.status == 0 means no response arrived.
+        void on_response(const http_client::client::ResponseMeta& meta);
+
+        [[nodiscard]] HelixRateLimitState state() const;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // One acquire() waiting for a point. done is cancelled once granted.
+        struct Waiter
+        {
+            explicit Waiter(const boost::asio::strand<boost::asio::any_io_executor>& ex) :
+                done{ ex }
+            {
+                done.expires_at(clock::time_point::max());
+            }
+
+            boost::asio::steady_timer done;
+            bool granted = false;
+        };
+
+        // Require mutex_.
+        void refill_locked(clock::time_point now) noexcept;
+        [[nodiscard]] double need_locked(HelixPriority p) const noexcept;
+        [[nodiscard]] clock::duration time_to_locked(double need, clock::time_point now) const noexcept;
+        void set_queued_locked() const noexcept;
+        void take_locked() noexcept;
+        void wake() noexcept;
+
+        [[nodiscard]] boost::asio::awaitable<void> pump();
+
+        boost::asio::strand<boost::asio::any_io_executor> strand_;
+        boost::asio::steady_timer wake_; // only touched on strand_
+        const HelixRateLimiterOptions options_;
+
+        mutable std::mutex mutex_; // protects everything below
+        std::uint32_t limit_;
+        double rate_; // refill, points per nanosecond
+        double tokens_; // server's remaining points as we estimate them, less points handed out
+        clock::time_point refilled_at_; // in the future after a 429: no refill until then
+        bool full_after_429_ = false; // the bucket is full again at refilled_at_
+        std::size_t in_flight_ = 0;
+        std::array<std::deque<std::shared_ptr<Waiter>>, 2> queues_; // by HelixPriority
+        bool pumping_ = false;
+    };
+
+} // namespace twitch_bot
@@ -10,6 +10,8 @@ Abstract:
 Why:
 - Twitch limits messages to 500 bytes. We split on code point boundaries and prefer word edges to reduce spammy fragments.
 - We keep a small line_tail_ to join frames that do not end with CRLF, so handlers only ever see complete lines.
+- Connect is split into transport (DNS, TCP, TLS, WS) and login so callers can overlap token work with
+  the handshakes. An optional ConnectCache skips DNS; the shared TLS factory resumes the session.
 - Best-effort send APIs trade strict erroring for resilience. On failure we close proactively to avoid half-dead sockets.
 */
 #pragma once
@@ -21,6 +23,8 @@ Why:
 
 // C++ Standard Library
 #include <array>
+#include <chrono>
+#include <cstddef>
 #include <span>
 #include <string>
 #include <string_view>
@@ -44,23 +48,50 @@ Why:
 #include <boost/beast/websocket/stream.hpp>
 
 // Core
+#include "connect_cache.hpp"
+#include <tb/net/tls/tls_context.hpp>
 #include <tb/utils/attributes.hpp>
+#include <tb/utils/trace.hpp>
 
 namespace twitch_bot
 {
 
+    /// Phase durations of the last connect. Logged by the pool to track time-to-reconnect.
+    struct ConnectTimings
+    {
+        std::chrono::microseconds resolve{ 0 };
+        std::chrono::microseconds tcp{ 0 };
+        std::chrono::microseconds tls{ 0 };
+        std::chrono::microseconds ws{ 0 };
+        std::chrono::microseconds login{ 0 };
+        bool dns_cached = false;
+        bool tls_resumed = false;
+    };
+
+    /// Log one connect as two INFO records under "irc_pool", in whole microseconds: the summary
+    /// (reason, time since the previous connection dropped, token wait, login) and the transport phases.
+    void log_connect_timings(std::size_t shard,
+                             std::string_view reason,
+                             std::chrono::microseconds gap,
+                             const ConnectTimings& timings,
+                             std::chrono::microseconds token_wait);
+
     /// Secure WebSocket IRC client for Twitch.
     /// Lifetime: the object must outlive any running coroutines started on it.
     /// Thread-safety: calls must be made on the ws_stream_ strand.
     class IrcClient
     {
     public:
-        /// Construct a client bound to the given executor and SSL context.
-        /// access_token must be "oauth:...". control_channel is also used as NICK.
+        /// Construct a client bound to the given executor and the shared TLS factory.
+        /// executor must already be serial (a strand, or a context run by one thread); no extra strand is added.
+        /// access_token must be "oauth:...", or empty for a read-only anonymous login
+        /// (then control_channel must be a "justinfan<digits>" nick). control_channel is also used as NICK.
+        /// tls and cache (when set) must outlive the client.
         explicit IrcClient(boost::asio::any_io_executor executor,
-                           boost::asio::ssl::context& ssl_context,
+                           tb::net::TlsContextFactory& tls,
                            std::string_view access_token,
-                           std::string_view control_channel);
+                           std::string_view control_channel,
+                           ConnectCache* cache = nullptr);
 
         /// Destructor wipes the OAuth token best-effort.
         /// Rationale: avoid lingering secrets in memory longer than needed.
@@ -78,6 +109,18 @@ namespace twitch_bot
         [[nodiscard]] auto connect(std::span<const std::string_view> channels)
             -> boost::asio::awaitable<void>;
 
+        /// First half of connect(): resolve (or reuse cached endpoints), TCP, TLS and WS handshakes.
+        [[nodiscard]] auto connect_transport() -> boost::asio::awaitable<void>;
+
+        /// Second half of connect(): PASS, NICK, CAP and the initial JOINs.
+        /// The token may be set with set_access_token() between the two halves.
+        [[nodiscard]] auto login(std::span<const std::string_view> channels) -> boost::asio::awaitable<void>;
+
+        [[nodiscard]] const ConnectTimings& connect_timings() const noexcept
+        {
+            return timings_;
+        }
+
         /// Send one IRC line, CRLF appended internally.
         /// No-throw: on failure the connection is closed. Keeps caller code simple under failure.
         [[nodiscard]] auto send_line(std::string_view message) noexcept -> boost::asio::awaitable<void>;
@@ -149,6 +192,7 @@ namespace twitch_bot
         using websocket_stream_type = boost::beast::websocket::stream<ssl_stream_type>;
 
         websocket_stream_type ws_stream_;
+        tb::net::TlsContextFactory* tls_; // not owned
         boost::asio::steady_timer ping_timer_;
         boost::beast::flat_static_buffer<k_read_buffer_size> read_buffer_;
 
@@ -158,6 +202,9 @@ namespace twitch_bot
         std::string access_token_;
         std::string control_channel_;
 
+        ConnectCache* cache_; // optional, not owned
+        ConnectTimings timings_;
+
         // Serialise writes to avoid interleaving frames from multiple coroutines.
         boost::asio::steady_timer write_gate_;
         bool write_inflight_ = false;
@@ -171,7 +218,11 @@ namespace twitch_bot
 
         for (;;)
         {
-            co_await ws_stream_.async_read(read_buffer_, boost::asio::use_awaitable);
+            {
+                TB_TRACE_SPAN("irc.frame_read");
+                co_await ws_stream_.async_read(read_buffer_, boost::asio::use_awaitable);
+            }
+            TB_TRACE_SPAN("irc.line_split"); // covers the handlers called below
 
             // Use the DynamicBuffer as a single contiguous view when possible.
             auto const bs = read_buffer_.cdata();
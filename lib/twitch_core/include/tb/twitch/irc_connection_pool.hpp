@@ -0,0 +1,274 @@
+/*
+Module Name:
+- irc_connection_pool.hpp
+
+Abstract:
+- Shards Twitch channels across several IrcClient connections.
+- Channels map to shards through a consistent hash ring, so adding a shard only moves a slice of channels.
+- Each shard owns a serial executor (a home core or a strand), a read loop, a keepalive and its own reconnect/backoff supervisor.
+- JOINs for every shard go through one JoinScheduler, since the join rate limit is per account.
+
+Why:
+- Twitch caps joins per connection and one websocket tops out in throughput, so one socket cannot carry thousands of channels.
+- Isolating shards means a failed socket only reconnects the channels it carries.
+- Reconnects reuse cached DNS and TLS sessions and fetch the token while the handshakes run.
+- A server RECONNECT is make-before-break: a replacement connection is opened and joined while the old
+  one keeps reading, then swapped in once it has joined every channel. The wait scales with the account's
+  join backlog, since a RECONNECT to every shard queues all their joins at once. Lines seen on both during
+  the overlap are dropped by their id tag.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+// Core
+#include "connect_cache.hpp"
+#include "irc_client.hpp"
+#include "join_scheduler.hpp"
+#include "recent_ids.hpp"
+#include "runtime.hpp"
+#include <tb/parser/irc_message_parser.hpp>
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/transparent_string_hash.hpp>
+
+namespace twitch_bot
+{
+
+    // Sizing for the shard pool. Defaults keep a single connection for small bots.
+    struct IrcPoolOptions
+    {
+        std::size_t channels_per_shard = 100; // grow once the average shard carries more than this
+        std::size_t max_shards = 64; // hard cap on concurrent connections
+        std::size_t virtual_nodes = 64; // ring points per shard; more points give a smoother spread
+        bool anonymous = false; // read-only "justinfan" logins; no token, say/reply are dropped
+        JoinSchedulerOptions join{}; // account join rate limit and confirmation policy
+        ConnectCacheOptions connect{}; // DNS and TLS session reuse across reconnects
+        bool make_before_break = true; // on RECONNECT, join a replacement before dropping the old socket
+        std::chrono::seconds handover_timeout{ 120 }; // least wait for the replacement's joins; longer while the join backlog drains
+        std::string name = "ingest"; // "pool" label on metrics; keeps two pools' shard 0 apart
+    };
+
+    // Pool of IrcClient connections with consistent-hash channel placement.
+    // Thread-safety: public members may be called from any thread.
+    class IrcConnectionPool
+    {
+    public:
+        // Supplies a fresh "oauth:..." token before each connect attempt. Unused when anonymous.
+        // revalidate is set after the server rejected the previous token.
+        using token_provider_t = std::function<boost::asio::awaitable<std::string>(bool revalidate)>;
+
+        // Receives every line that is not connection housekeeping.
+        // Runs on the serial executor of the shard that read it, so one channel is always ordered.
+        using message_handler_t = std::function<void(IrcMessage msg)>;
+
+        // Pre: on_message is set; nick and token_provider are set unless options.anonymous.
+        IrcConnectionPool(Runtime& runtime,
+                          tb::net::TlsContextFactory& tls,
+                          std::string nick,
+                          token_provider_t token_provider,
+                          message_handler_t on_message,
+                          IrcPoolOptions options = {});
+
+        ~IrcConnectionPool() noexcept;
+
+        IrcConnectionPool(const IrcConnectionPool&) = delete;
+        IrcConnectionPool& operator=(const IrcConnectionPool&) = delete;
+
+        // Replace the channel set. Grows the pool to fit and assigns channels by ring position.
+        // Connected shards pick up the change on their next reconnect.
+        void set_channels(std::vector<std::string> channels);
+
+        // Spawn one supervisor per shard. Shards added later start immediately.
+        void start();
+
+        // Stop reconnecting and close every connection. Idempotent.
+        void stop() noexcept;
+
+        // Runtime join and part. Channel names must not include '#'.
+        // A join may add a shard when the pool is over capacity. Joins are queued ahead of
+        // reconnect backlogs and complete once the JOIN is sent, not when it is confirmed.
+        [[nodiscard]] boost::asio::awaitable<void> join(std::string_view channel);
+        [[nodiscard]] boost::asio::awaitable<void> part(std::string_view channel);
+
+        // Move every channel to the shard the ring currently assigns it to.
+        // Only channels whose owner changed are parted and re-joined.
+        [[nodiscard]] boost::asio::awaitable<void> rebalance();
+
+        // Add one shard (bounded by max_shards) and rebalance onto it.
+        [[nodiscard]] boost::asio::awaitable<void> add_shard();
+
+        // Chat writes go through the connection of the shard that owns the channel.
+        // Anonymous pools cannot write; the call returns without sending. Such drops, and writes to a
+        // disconnected shard, count in tb_irc_writes_dropped_total{pool,reason}.
+        [[nodiscard]] boost::asio::awaitable<void> say(std::string_view channel, std::string_view text);
+        [[nodiscard]] boost::asio::awaitable<void>
+        reply(std::string_view channel, std::string_view parent_msg_id, std::string_view text);
+
+        [[nodiscard]] std::size_t shard_count() const;
+        [[nodiscard]] std::size_t channel_count() const;
+        [[nodiscard]] JoinProgress join_progress() const;
+
+        // Shard currently carrying channel; nullopt if the pool does not hold it.
+        [[nodiscard]] std::optional<std::size_t> shard_of(std::string_view channel) const;
+
+    private:
+        friend struct IrcConnectionPoolInternals; // tests drive handle_line and the handover without sockets
+
+        using channel_set = std::unordered_set<std::string,
+                                               TransparentBasicStringHash<char>,
+                                               TransparentBasicStringEq<char>>;
+
+        // One live connection. Shared with the coroutines that use it so a reconnect
+        // cannot free the socket under a pending read or ping.
+        struct Session : std::enable_shared_from_this<Session>
+        {
+            Session(boost::asio::any_io_executor executor,
+                    tb::net::TlsContextFactory& tls,
+                    std::string_view access_token,
+                    std::string_view login_nick,
+                    ConnectCache& cache);
+
+            IrcClient client;
+            const std::string nick; // matches the prefix of our own JOIN echoes
+            boost::asio::steady_timer reconnect_signal; // cancelled to leave the read phase
+            std::string reconnect_reason;
+
+            // Shard executor only. Latched, because a cancel() with no waiter is lost: a replacement's
+            // reader can fail or see RECONNECT while run_shard is still inside hand_over().
+            void signal_reconnect()
+            {
+                signalled = true;
+                reconnect_signal.cancel();
+            }
+            bool signalled = false;
+            std::chrono::microseconds token_wait{ 0 }; // time login waited on the token after the handshakes
+
+            // Shard executor only.
+            channel_set joined; // confirmed by our JOIN echo or ROOMSTATE on this connection
+            bool reading = true; // false once the read loop has exited
+            bool replacement = false; // being joined by hand_over; confirms may wake Shard::handover_wait
+        };
+
+        struct Shard
+        {
+            Shard(std::string_view pool, std::size_t idx, HomeExecutor home_executor);
+
+            const std::size_t index;
+            const HomeExecutor home; // serial; shards spread round-robin over homes
+
+            // Guarded by IrcConnectionPool::mutex_.
+            channel_set channels;
+            std::shared_ptr<Session> session; // null while disconnected
+            std::shared_ptr<Session> standby; // replacement being joined during a handover
+            bool running = false; // a supervisor is spawned and has not exited; see stopped_cv_
+
+            // Shard executor only.
+            std::chrono::steady_clock::time_point dedupe_until{}; // drop repeated ids until then
+            RecentIds recent;
+            std::size_t duplicates = 0;
+            boost::asio::steady_timer handover_wait; // expires at the handover deadline; cancelled on progress
+            boost::asio::steady_timer backoff; // the supervisor's sleep between connects; stop() cancels it
+
+            // Per shard so cores never share the cache line.
+            tb::metrics::Counter& lines_in;
+            tb::metrics::Histogram& parse_time;
+        };
+
+        struct RingPoint
+        {
+            std::uint64_t hash;
+            std::size_t shard;
+        };
+
+        // Requires mutex_.
+        [[nodiscard]] std::size_t owner_of(std::string_view channel) const noexcept;
+        Shard& add_shard_locked();
+        void grow_to_fit_locked();
+
+        // Send PART on a shard's own executor if it is connected.
+        [[nodiscard]] boost::asio::awaitable<void> send_part(Shard& shard, std::string channel);
+
+        // JoinScheduler sender: JOIN on whichever shard owns channel now.
+        [[nodiscard]] boost::asio::awaitable<bool> send_join(std::string channel);
+
+        // Hand every channel of a shard to the scheduler, or park them on disconnect. Takes mutex_.
+        void enqueue_joins(Shard& shard);
+        void park_joins(Shard& shard);
+
+        // Transport handshakes overlapped with the token fetch, then login. Throws on failure.
+        [[nodiscard]] boost::asio::awaitable<std::shared_ptr<Session>> open_session(Shard& shard, bool revalidate);
+
+        // Spawn the keepalive and read loop for a connected session.
+        void start_io(Shard& shard, const std::shared_ptr<Session>& session);
+
+        // Open and join a replacement while old keeps reading, then swap it in.
+        // Returns null (and leaves old untouched) if the replacement could not be brought up.
+        [[nodiscard]] boost::asio::awaitable<std::shared_ptr<Session>> hand_over(Shard& shard, std::shared_ptr<Session> old);
+
+        // hand_over without the connect: publish next as the standby and arm the handover deadline,
+        // then wait for it to join, swap, and re-queue every channel it still lacks.
+        void begin_handover(Shard& shard, const std::shared_ptr<Session>& next, std::chrono::steady_clock::time_point started);
+        [[nodiscard]] boost::asio::awaitable<std::shared_ptr<Session>>
+        finish_handover(Shard& shard, std::shared_ptr<Session> old, std::shared_ptr<Session> next, std::chrono::steady_clock::time_point started);
+
+        // True when session is the connection send_join routes this shard's JOINs to. Takes mutex_.
+        // Only that connection may confirm: the old one stays joined through a handover and keeps
+        // receiving ROOMSTATE, which would otherwise stop the standby's JOIN from ever being sent.
+        [[nodiscard]] bool is_join_target(const Shard& shard, const Session& session) const;
+
+        // Shard executor. Cancels shard.handover_wait once session has joined every channel. Takes mutex_.
+        void wake_handover_if_joined(Shard& shard, const Session& session);
+        // Time for the join scheduler to send and confirm its current backlog at the account's rate.
+        [[nodiscard]] std::chrono::steady_clock::duration join_backlog_time() const;
+
+        [[nodiscard]] boost::asio::awaitable<void> run_shard(Shard& shard);
+        [[nodiscard]] boost::asio::awaitable<void> sleep_backoff(Shard& shard, std::chrono::milliseconds delay);
+        void supervisor_exited(Shard& shard); // clears running and wakes the destructor
+        void handle_line(Shard& shard, Session& session, std::string_view raw);
+        void spawn_shard_locked(Shard& shard);
+
+        Runtime& runtime_;
+        tb::net::TlsContextFactory& tls_;
+        const std::string nick_;
+        token_provider_t token_provider_;
+        message_handler_t on_message_;
+        const IrcPoolOptions options_;
+        ConnectCache connect_cache_; // shared by every shard; they all dial the same host
+
+        mutable std::mutex mutex_; // protects shards_, ring_, owner_ and per-shard state
+        std::condition_variable stopped_cv_; // a supervisor cleared Shard::running
+        std::vector<std::unique_ptr<Shard>> shards_; // stable addresses; shards are never removed
+        std::vector<RingPoint> ring_; // sorted by hash
+        std::unordered_map<std::string,
+                           std::size_t,
+                           TransparentBasicStringHash<char>,
+                           TransparentBasicStringEq<char>>
+            owner_; // channel -> shard currently carrying it
+
+        bool started_ = false; // guarded by mutex_
+        std::atomic<bool> stopping_{ false };
+
+        JoinScheduler joins_;
+    };
+
+} // namespace twitch_bot
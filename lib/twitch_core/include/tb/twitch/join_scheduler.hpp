@@ -0,0 +1,146 @@
+/*
+Module Name:
+- join_scheduler.hpp
+
+Abstract:
+- Paces IRC JOINs to the account's join rate limit and tracks each join until the server confirms it.
+- Joins are confirmed from the JOIN echo or ROOMSTATE, retried on timeout and marked failed after max attempts.
+- Reports progress (pending, confirmed, failed) and how long the last burst took to settle.
+
+Why:
+- Twitch silently drops JOINs over 20 per 10 seconds, so batching every channel at connect loses most of them.
+- Confirmation makes reconnect-to-fully-joined observable instead of assumed.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+// Core
+#include <tb/utils/transparent_string_hash.hpp>
+
+namespace twitch_bot
+{
+
+    // Account limits. Defaults match a normal account; verified bots may raise join_limit.
+    struct JoinSchedulerOptions
+    {
+        std::size_t join_limit = 20; // JOINs allowed per window
+        std::chrono::milliseconds window{ 10'000 };
+        std::chrono::milliseconds window_slack{ 250 }; // server counts on receipt; stay clear of the edge
+        std::chrono::milliseconds confirm_timeout{ 15'000 }; // unconfirmed after this is retried
+        unsigned max_attempts = 3; // then the channel is reported failed until the next connect
+    };
+
+    // Snapshot of join state across all tracked channels.
+    struct JoinProgress
+    {
+        std::size_t pending = 0; // waiting for a slot, or sent and not yet confirmed
+        std::size_t confirmed = 0;
+        std::size_t failed = 0;
+        std::chrono::milliseconds last_settle{ 0 }; // first enqueue to nothing pending, for the last burst
+    };
+
+    // Thread-safety: public members may be called from any thread.
+    class JoinScheduler
+    {
+    public:
+        // Sends one JOIN for channel. Returns false when no connection can carry it right now;
+        // the channel is then parked until enqueue() is called again on reconnect.
+        using sender_t = std::function<boost::asio::awaitable<bool>(std::string channel)>;
+
+        // Pre: serial never runs two handlers at once (a strand, or a single-threaded context).
+        JoinScheduler(boost::asio::any_io_executor serial, sender_t sender, JoinSchedulerOptions options = {});
+
+        JoinScheduler(const JoinScheduler&) = delete;
+        JoinScheduler& operator=(const JoinScheduler&) = delete;
+
+        // Spawn the pacing loop. Idempotent.
+        void start();
+
+        // Stop sending. Idempotent.
+        void stop() noexcept;
+
+        // Queue a JOIN, resetting any previous state. urgent joins go ahead of reconnect backlogs.
+        void enqueue(std::string_view channel, bool urgent = false);
+
+        // The connection carrying channel went away; it waits for the next enqueue().
+        void park(std::string_view channel);
+
+        // Server echoed JOIN or sent ROOMSTATE for channel.
+        void confirm(std::string_view channel);
+
+        // Stop tracking a parted channel.
+        void forget(std::string_view channel);
+
+        [[nodiscard]] JoinProgress progress() const;
+
+        // Joins queued or sent and not yet confirmed: what the rate limit still has to get through. Unlike
+        // JoinProgress::pending this leaves out parked channels, which wait for a connection, not a slot.
+        [[nodiscard]] std::size_t backlog() const;
+
+    private:
+        enum class State : std::uint8_t
+        {
+            parked, // known but no connection to join on
+            queued,
+            sent,
+            confirmed,
+            failed,
+        };
+
+        using clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            State state = State::parked;
+            unsigned attempts = 0;
+            clock::time_point deadline{};
+        };
+
+        // Sent joins in send order. Deadlines are monotonic because confirm_timeout is fixed.
+        struct Inflight
+        {
+            clock::time_point deadline;
+            std::string channel;
+        };
+
+        // Requires mutex_.
+        void set_state_locked(Entry& e, State s) noexcept;
+        void expire_locked(clock::time_point now);
+        void settle_check_locked(clock::time_point now);
+        void wake() noexcept;
+
+        [[nodiscard]] boost::asio::awaitable<void> run();
+
+        boost::asio::any_io_executor strand_; // serial; see constructor
+        boost::asio::steady_timer wake_; // only touched on strand_
+        sender_t sender_;
+        const JoinSchedulerOptions options_;
+
+        mutable std::mutex mutex_; // protects everything below
+        std::unordered_map<std::string, Entry, TransparentBasicStringHash<char>, TransparentBasicStringEq<char>> entries_;
+        std::deque<std::string> queue_; // may hold stale names; skipped unless still queued
+        std::deque<Inflight> inflight_;
+        std::deque<clock::time_point> sent_at_; // sliding window of recent sends
+        std::size_t counts_[5]{}; // per State
+        clock::time_point burst_start_{};
+        std::chrono::milliseconds last_settle_{ 0 };
+        bool started_ = false;
+        bool stopping_ = false;
+    };
+
+} // namespace twitch_bot
@@ -0,0 +1,52 @@
+/*
+Module Name:
+- recent_ids.hpp
+
+Abstract:
+- Bounded FIFO set of recently seen message ids. insert() reports whether an id is new; once full,
+  the oldest id is dropped to make room, so it reads as new again.
+
+Why:
+- During a make-before-break handover two sockets carry the same lines; the shard keeps the first copy
+  of each id. The bound keeps memory flat however long an overlap runs.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+// Core
+#include <tb/utils/transparent_string_hash.hpp>
+
+namespace twitch_bot
+{
+
+    // Not thread-safe; IrcConnectionPool uses one per shard on the shard executor.
+    class RecentIds
+    {
+    public:
+        static constexpr std::size_t k_default_capacity = 8192; // well over a busy shard's lines per overlap second
+
+        // A capacity of 0 is treated as 1.
+        explicit RecentIds(std::size_t capacity = k_default_capacity);
+
+        // False if id is already held.
+        bool insert(std::string_view id);
+        void clear() noexcept;
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return order_.size();
+        }
+
+    private:
+        std::size_t capacity_;
+        std::unordered_set<std::string, TransparentBasicStringHash<char>, TransparentBasicStringEq<char>> ids_;
+        std::deque<std::string_view> order_; // views into ids_ nodes, oldest first
+    };
+
+} // namespace twitch_bot
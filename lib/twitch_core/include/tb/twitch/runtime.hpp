@@ -0,0 +1,169 @@
+/*
+Module Name:
+- runtime.hpp
+
+Abstract:
+- Execution model for the bot: either one shared thread pool with strands, or one io_context per pinned core.
+- In per-core mode each component gets a home core; work for another core crosses through a lock-free MPSC queue.
+- With a single thread there is one io_context run by the caller and no strands at all.
+
+Why:
+- A strand per hop on a shared pool pays locking on every handler and bounces cache lines between cores.
+- A context driven by exactly one thread is already serial, so strands on it are pure overhead.
+- Cross-core posts batch behind one wake-up instead of taking the target context's queue lock per message.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+namespace twitch_bot
+{
+
+    enum class ExecutionMode : std::uint8_t
+    {
+        shared_pool, // thread_pool plus strands; the original model
+        per_core, // one single-threaded io_context per core
+    };
+
+    struct RuntimeOptions
+    {
+        ExecutionMode mode = ExecutionMode::shared_pool;
+        std::size_t threads = std::thread::hardware_concurrency(); // 0 is treated as 1
+        bool pin_threads = true; // per-core mode only; pins home i to CPU i
+    };
+
+    // An executor and the home (core) that runs it. Lanes and shards carry one of these.
+    struct HomeExecutor
+    {
+        boost::asio::any_io_executor executor;
+        std::size_t home = 0;
+    };
+
+    // Owns the threads and io_contexts. Components ask it for executors instead of making strands.
+    // Thread-safety: post() and the accessors may be called from any thread.
+    class Runtime
+    {
+    public:
+        using task_t = std::move_only_function<void()>;
+
+        explicit Runtime(RuntimeOptions options = {});
+        ~Runtime() noexcept;
+
+        Runtime(const Runtime&) = delete;
+        Runtime& operator=(const Runtime&) = delete;
+
+        [[nodiscard]] ExecutionMode mode() const noexcept
+        {
+            return mode_;
+        }
+
+        [[nodiscard]] std::size_t threads() const noexcept
+        {
+            return threads_;
+        }
+
+        // Number of homes. One for the shared pool; one per thread otherwise.
+        [[nodiscard]] std::size_t homes() const noexcept
+        {
+            return homes_.empty() ? 1 : homes_.size();
+        }
+
+        // True when every home is driven by exactly one thread, so its executor is already serial.
+        [[nodiscard]] bool homes_are_serial() const noexcept
+        {
+            return !homes_.empty();
+        }
+
+        // Plain executor of a home (the pool executor in shared mode).
+        [[nodiscard]] boost::asio::any_io_executor executor(std::size_t home = 0) const;
+
+        // Executor that never runs two handlers at once: a new strand on the shared pool,
+        // or the home's own context when that is single-threaded.
+        [[nodiscard]] HomeExecutor serial_executor(std::size_t home) const;
+
+        // Stable home for a key, e.g. a channel name.
+        [[nodiscard]] std::size_t home_of(std::string_view key) const noexcept;
+
+        // Run fn on target. Per-core homes receive it through a lock-free queue; FIFO per producer thread.
+        void post(const HomeExecutor& target, task_t fn);
+
+        // Block until stop(). Per-core mode runs home 0 on the calling thread.
+        void run();
+
+        // Stop every context. Idempotent.
+        void stop() noexcept;
+
+        // stop() has been called; handlers not yet started will not run.
+        [[nodiscard]] bool stopped() const noexcept
+        {
+            return stopped_.load(std::memory_order_acquire);
+        }
+
+    private:
+        // Vyukov intrusive MPSC queue. Producers never block; the single consumer is the home's thread.
+        class MpscQueue
+        {
+        public:
+            struct Node
+            {
+                std::atomic<Node*> next{ nullptr };
+                task_t fn;
+            };
+
+            MpscQueue() noexcept;
+            ~MpscQueue() noexcept;
+
+            void push(Node* n) noexcept;
+
+            // Null when empty or when a producer is mid-push; the caller re-checks with empty().
+            [[nodiscard]] Node* pop() noexcept;
+            [[nodiscard]] bool empty() const noexcept;
+
+        private:
+            alignas(64) std::atomic<Node*> head_;
+            alignas(64) Node* tail_;
+            Node stub_;
+        };
+
+        struct Home
+        {
+            Home();
+
+            boost::asio::io_context ctx; // concurrency hint 1: one thread drives it
+            std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work;
+            MpscQueue inbox;
+            std::atomic<bool> scheduled{ false }; // a drain is posted or running
+            std::thread thread; // empty for home 0, which runs on the caller of run()
+        };
+
+        static constexpr std::size_t k_drain_batch = 256; // yield to I/O between batches
+
+        void schedule_drain(Home& home);
+        void drain(Home& home);
+        static void pin_current_thread(std::size_t cpu) noexcept;
+
+        const ExecutionMode mode_;
+        const std::size_t threads_;
+        const bool pin_;
+
+        mutable std::optional<boost::asio::thread_pool> pool_; // shared mode with more than one thread
+        std::vector<std::unique_ptr<Home>> homes_; // per-core mode, or the single-thread fast path
+        std::atomic<bool> stopped_{ false };
+    };
+
+} // namespace twitch_bot
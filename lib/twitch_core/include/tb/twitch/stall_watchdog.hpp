@@ -0,0 +1,90 @@
+/*
+Module Name:
+- stall_watchdog.hpp
+
+Abstract:
+- Posts a probe onto every watched executor at a fixed interval and measures how long it waits to run.
+- Lag goes to tb_loop_lag_seconds{target}. A probe older than the threshold is a stall: the watchdog
+  logs which tb::activity scopes are running and a stack sample of those threads.
+
+Why:
+- One blocking call on a strand (synchronous file I/O, a slow listener) holds up everything behind it,
+  and nothing else in the process notices.
+- The watchdog runs on its own thread, so a stalled executor cannot also stall the thing watching it.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+
+// Core
+#include "runtime.hpp"
+#include <tb/utils/metrics.hpp>
+
+namespace twitch_bot
+{
+
+    struct StallWatchdogOptions
+    {
+        std::chrono::milliseconds interval{ 100 }; // probe period per target
+        std::chrono::milliseconds threshold{ 250 }; // probe age that counts as a stall
+        bool stack_samples = true; // POSIX with execinfo only
+    };
+
+    class StallWatchdog
+    {
+    public:
+        StallWatchdog(Runtime& runtime, StallWatchdogOptions options = {});
+        ~StallWatchdog() noexcept;
+
+        StallWatchdog(const StallWatchdog&) = delete;
+        StallWatchdog& operator=(const StallWatchdog&) = delete;
+
+        // Add targets before start(). Runtime homes go through Runtime::post, so inbox delay counts too.
+        void watch(std::string name, HomeExecutor target);
+        void watch(std::string name, boost::asio::any_io_executor target);
+
+        void start();
+        void stop() noexcept;
+
+    private:
+        struct Target
+        {
+            std::string name;
+            HomeExecutor home;
+            bool via_runtime = false;
+            tb::metrics::Histogram* lag = nullptr;
+            tb::metrics::Counter* stalls = nullptr;
+
+            std::atomic<std::int64_t> posted_ns{ 0 }; // 0 when no probe is outstanding
+            std::atomic<std::int64_t> last_lag_ns{ 0 };
+            bool reported = false; // watchdog thread only
+        };
+
+        void run();
+        void tick();
+        void probe(const std::shared_ptr<Target>& t);
+        void report(const Target& t, std::chrono::milliseconds age);
+
+        Runtime& runtime_;
+        const StallWatchdogOptions options_;
+        std::vector<std::shared_ptr<Target>> targets_; // shared with probes still queued at shutdown
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        std::thread thread_;
+    };
+
+} // namespace twitch_bot
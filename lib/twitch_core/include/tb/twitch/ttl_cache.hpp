@@ -0,0 +1,293 @@
+/*
+Module Name:
+- ttl_cache.hpp
+
+Abstract:
+- TtlCache<V>: an async, string-keyed TTL cache for remote lookups, run on one strand.
+- get(key, load) returns a fresh value without waiting. For a stale value it returns at once and starts
+  a background refresh. On a miss it calls load, and concurrent misses for the same key all await that
+  one call (single-flight).
+- A load that yields std::nullopt is cached as a negative result for the shorter negative_ttl. A load
+  that throws caches nothing: its waiters get the exception, and a stale value stays in place.
+
+Why:
+- Chat commands ask the same question many times a second. With the cache, remote calls scale with
+  the number of distinct keys rather than the number of messages.
+- Serving stale values during the refresh keeps the refresh's latency off the chat path.
+- Metrics: tb_cache_requests_total{cache,result} with result one of hit, stale, miss, coalesced or
+  negative, plus tb_cache_load_errors_total{cache} and the tb_cache_entries{cache} gauge.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// Boost.Asio
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Core
+#include <tb/utils/metrics.hpp>
+#include <tb/utils/transparent_string_hash.hpp>
+
+namespace twitch_bot
+{
+
+    struct TtlCacheOptions
+    {
+        std::chrono::milliseconds ttl{ std::chrono::seconds{ 30 } };          // fresh: served without a load
+        std::chrono::milliseconds stale_for{ std::chrono::seconds{ 60 } };    // then served while a refresh runs
+        std::chrono::milliseconds negative_ttl{ std::chrono::seconds{ 5 } };  // nullopt results; never served stale
+        std::size_t max_entries = 10'000;
+    };
+
+    // Thread-safety: every member may be called from any thread. State lives on the strand.
+    // The cache must outlive the refreshes it starts; keep it beside the client whose calls it caches.
+    template<class V>
+    class TtlCache
+    {
+    public:
+        TtlCache(boost::asio::any_io_executor executor, std::string_view name, TtlCacheOptions options = {}) :
+            strand_{ boost::asio::make_strand(std::move(executor)) },
+            options_{ options },
+            metrics_{ name }
+        {
+        }
+
+        TtlCache(const TtlCache&) = delete;
+        TtlCache& operator=(const TtlCache&) = delete;
+
+        // load: () -> awaitable<std::optional<V>>, called at most once at a time per key. It is copied,
+        // so anything it references must outlive the call.
+        template<class Load>
+        auto get(std::string key, Load load) -> boost::asio::awaitable<std::optional<V>>
+        {
+            co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
+            const auto now = clock::now();
+
+            auto it = entries_.find(key);
+            if (it != entries_.end() && it->second.loaded)
+            {
+                Entry& e = it->second;
+                if (now < e.fresh_until)
+                {
+                    (e.value ? metrics_.hit : metrics_.negative).inc();
+                    co_return e.value;
+                }
+                if (e.value && now < e.stale_until)
+                {
+                    metrics_.stale.inc();
+                    if (!e.flight)
+                    {
+                        start(it->first, e, std::move(load));
+                    }
+                    co_return e.value;
+                }
+            }
+
+            std::shared_ptr<Flight> flight;
+            if (it != entries_.end() && it->second.flight)
+            {
+                metrics_.coalesced.inc();
+                flight = it->second.flight;
+            }
+            else
+            {
+                metrics_.miss.inc();
+                if (it == entries_.end())
+                {
+                    trim(now);
+                    it = entries_.try_emplace(std::move(key)).first;
+                    metrics_.entries.set(static_cast<std::int64_t>(entries_.size()));
+                }
+                flight = start(it->first, it->second, std::move(load));
+            }
+
+            if (!flight->ready)
+            {
+                boost::system::error_code ec;
+                co_await flight->done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            }
+            if (flight->error)
+            {
+                std::rethrow_exception(flight->error);
+            }
+            co_return flight->result;
+        }
+
+        // Store a result obtained elsewhere (e.g. from a batched call), as if a load had returned it.
+        auto put(std::string key, std::optional<V> value) -> boost::asio::awaitable<void>
+        {
+            co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
+            const auto now = clock::now();
+            auto it = entries_.find(key);
+            if (it == entries_.end())
+            {
+                trim(now);
+                it = entries_.try_emplace(std::move(key)).first;
+                metrics_.entries.set(static_cast<std::int64_t>(entries_.size()));
+            }
+            store(it->second, std::move(value), now);
+        }
+
+        // Drop a cached value. A load already in flight still completes and stores its result.
+        auto invalidate(std::string key) -> boost::asio::awaitable<void>
+        {
+            co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
+            if (auto it = entries_.find(key); it != entries_.end() && !it->second.flight)
+            {
+                entries_.erase(it);
+                metrics_.entries.set(static_cast<std::int64_t>(entries_.size()));
+            }
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // One load and the callers waiting on it. done is cancelled when the load finishes.
+        struct Flight
+        {
+            explicit Flight(const boost::asio::strand<boost::asio::any_io_executor>& ex) :
+                done{ ex }
+            {
+                done.expires_at(clock::time_point::max());
+            }
+
+            boost::asio::steady_timer done;
+            std::optional<V> result;
+            std::exception_ptr error;
+            bool ready = false;
+        };
+
+        struct Entry
+        {
+            std::optional<V> value;
+            clock::time_point fresh_until{};
+            clock::time_point stale_until{};
+            std::shared_ptr<Flight> flight; // set while a load runs
+            bool loaded = false;
+        };
+
+        struct Metrics
+        {
+            explicit Metrics(std::string_view cache) :
+                hit{ counter(cache, "hit") },
+                stale{ counter(cache, "stale") },
+                miss{ counter(cache, "miss") },
+                coalesced{ counter(cache, "coalesced") },
+                negative{ counter(cache, "negative") },
+                load_errors{ tb::metrics::registry().counter("tb_cache_load_errors_total", "Cache loads that threw", { { "cache", cache } }) },
+                entries{ tb::metrics::registry().gauge("tb_cache_entries", "Keys held by a cache", { { "cache", cache } }) }
+            {
+            }
+
+            static tb::metrics::Counter& counter(std::string_view cache, std::string_view result)
+            {
+                return tb::metrics::registry().counter("tb_cache_requests_total", "Cache lookups by outcome", { { "cache", cache }, { "result", result } });
+            }
+
+            tb::metrics::Counter& hit;
+            tb::metrics::Counter& stale;
+            tb::metrics::Counter& miss;
+            tb::metrics::Counter& coalesced;
+            tb::metrics::Counter& negative;
+            tb::metrics::Counter& load_errors;
+            tb::metrics::Gauge& entries;
+        };
+
+        // On strand_. Node-based map: the key and entry stay put while the load runs.
+        template<class Load>
+        std::shared_ptr<Flight> start(const std::string& key, Entry& e, Load load)
+        {
+            e.flight = std::make_shared<Flight>(strand_);
+            boost::asio::co_spawn(strand_, run(key, std::move(load)), boost::asio::detached);
+            return e.flight;
+        }
+
+        template<class Load>
+        auto run(std::string key, Load load) -> boost::asio::awaitable<void>
+        {
+            std::optional<V> result;
+            std::exception_ptr error;
+            try
+            {
+                result = co_await load();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
+
+            auto it = entries_.find(key);
+            if (it == entries_.end())
+            {
+                co_return; // unreachable while flight is set; kept for safety
+            }
+            Entry& e = it->second;
+            auto flight = std::exchange(e.flight, nullptr);
+            if (error)
+            {
+                metrics_.load_errors.inc();
+                if (!e.loaded)
+                {
+                    entries_.erase(it);
+                    metrics_.entries.set(static_cast<std::int64_t>(entries_.size()));
+                }
+            }
+            else
+            {
+                store(e, result, clock::now());
+            }
+
+            flight->result = std::move(result);
+            flight->error = error;
+            flight->ready = true;
+            flight->done.cancel();
+        }
+
+        void store(Entry& e, std::optional<V> value, clock::time_point now)
+        {
+            const auto ttl = value ? options_.ttl : options_.negative_ttl;
+            e.fresh_until = now + ttl;
+            e.stale_until = value ? e.fresh_until + options_.stale_for : e.fresh_until;
+            e.value = std::move(value);
+            e.loaded = true;
+        }
+
+        // Make room for one more key: drop expired entries, then any idle one if still full.
+        void trim(clock::time_point now)
+        {
+            if (entries_.size() < options_.max_entries)
+            {
+                return;
+            }
+            std::erase_if(entries_, [&](const auto& kv) { return !kv.second.flight && kv.second.stale_until <= now; });
+            for (auto it = entries_.begin(); entries_.size() >= options_.max_entries && it != entries_.end();)
+            {
+                it = it->second.flight ? std::next(it) : entries_.erase(it);
+            }
+        }
+
+        boost::asio::strand<boost::asio::any_io_executor> strand_;
+        const TtlCacheOptions options_;
+        Metrics metrics_;
+        std::unordered_map<std::string, Entry, TransparentBasicStringHash<char>, TransparentBasicStringEq<char>> entries_;
+    };
+
+} // namespace twitch_bot
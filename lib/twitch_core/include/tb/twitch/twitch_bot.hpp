@@ -4,35 +4,41 @@ Module Name:
 
 Abstract:
 - High level Twitch bot that wires IRC, command dispatch, Helix and channel management.
-- All async work is serialised on strand_ and executed by a thread pool.
+- Bot state is serialised on strand_; command handlers run on per-channel dispatcher lanes.
+- IRC traffic is sharded across an IrcConnectionPool; each shard reads on its own serial executor.
+- Threads come from a Runtime: a shared pool with strands, or one pinned io_context per core.
+- Optionally ingests through anonymous read-only logins and writes through a separate authenticated connection.
 - Exposes small safe helpers for chat that respect Twitch 500 byte limits.
 
 Why:
-- Serialising on a strand keeps message ordering deterministic and avoids races across handlers.
-- A shared SSL context and executor let downstream code reuse connection pools and timers.
+- Per-channel lanes keep each channel's ordering deterministic while using every pool thread.
+- One process-wide TLS factory (trust store parsed once) and a shared executor let downstream code
+  reuse connection pools, sessions and timers.
+- Splitting ingest from writes keeps inbound floods off the rate-limited write identity's socket and strand.
 */
 #pragma once
 
 // C++ Standard Library
 #include <algorithm>
 #include <memory>
-#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 
 // Boost.Asio
 #include <boost/asio/awaitable.hpp>
-#include <boost/asio/io_context.hpp>
 #include <boost/asio/post.hpp>
 #include <boost/asio/ssl/context.hpp>
-#include <boost/asio/strand.hpp>
-#include <boost/asio/thread_pool.hpp>
 
 // Core
 #include "command_dispatcher.hpp"
 #include "helix_client.hpp"
 #include "irc_client.hpp"
+#include "irc_connection_pool.hpp"
+#include "runtime.hpp"
+#include "stall_watchdog.hpp"
+#include <tb/net/tls/tls_context.hpp>
 #include <tb/parser/irc_message_parser.hpp>
 #include <tb/utils/attributes.hpp>
 
@@ -40,28 +46,34 @@ namespace twitch_bot
 {
 
     // Coordinates IRC, commands, Helix queries and channel storage.
-    // All asynchronous work is serialized through strand_, executed by pool_.
+    // Command handlers run on per-channel lanes; IRC shards run on their own serial executors.
     class TwitchBot
     {
     public:
         // Pre: access_token, refresh_token, client_id, client_secret and control_channel are non-empty.
+        // ingest.anonymous reads chat through justinfan logins; say/reply then use a dedicated
+        // authenticated connection. Both feed the same dispatcher.
         explicit TwitchBot(std::string access_token,
                            std::string refresh_token,
                            std::string client_id,
                            std::string client_secret,
                            std::string control_channel,
-                           std::size_t threads = std::thread::hardware_concurrency());
+                           IrcPoolOptions ingest = {},
+                           RuntimeOptions runtime = {});
 
         ~TwitchBot() noexcept;
 
         TwitchBot(const TwitchBot&) = delete;
         TwitchBot& operator=(const TwitchBot&) = delete;
 
-        // Run until the IO context stops.
+        // Run until the runtime stops. Per-core mode drives home 0 on the calling thread.
         void run();
 
+        // Probe strand_ and every dispatcher lane for stalls. Call once, before run().
+        void start_watchdog(StallWatchdogOptions options);
+
         // Register a listener for non-command chat messages.
-        void add_chat_listener(chat_listener_t listener);
+        void add_chat_listener(chat_listener_t listener, ListenerPolicy policy = {});
 
         // Access the command dispatcher to register app-level commands.
         [[nodiscard]] CommandDispatcher& dispatcher() noexcept
@@ -75,14 +87,42 @@ namespace twitch_bot
             return helix_client_;
         }
 
-        // Executor and SSL so app code can build its own HTTP clients.
+        // Executor and TLS so app code can build its own HTTP clients.
         [[nodiscard]] boost::asio::any_io_executor executor() const noexcept
         {
-            return strand_.get_inner_executor();
+            return runtime_.executor();
         }
         [[nodiscard]] boost::asio::ssl::context& ssl_context() noexcept
         {
-            return ssl_ctx_;
+            return tls_.context();
+        }
+        [[nodiscard]] tb::net::TlsContextFactory& tls() noexcept
+        {
+            return tls_;
+        }
+
+        // Ingest connection pool, for shard counts and explicit rebalancing.
+        [[nodiscard]] IrcConnectionPool& irc() noexcept
+        {
+            return irc_pool_;
+        }
+
+        // JOIN progress across the ingest shards (pending, confirmed, failed).
+        [[nodiscard]] JoinProgress join_progress() const
+        {
+            return irc_pool_.join_progress();
+        }
+
+        // Per-command invocations, errors, timeouts, in-flight runs and latency.
+        [[nodiscard]] std::vector<CommandStats> command_stats() const
+        {
+            return dispatcher_.command_stats();
+        }
+
+        // Pool that carries say/reply: the ingest pool unless ingest is anonymous.
+        [[nodiscard]] IrcConnectionPool& irc_writer() noexcept
+        {
+            return writer_ ? *writer_ : irc_pool_;
         }
 
         // Control channel name.
@@ -115,17 +155,19 @@ namespace twitch_bot
             {
                 return true;
             }
-            return msg.prefix == ""; // admin
+            return msg.prefix() == ""; // admin
         }
 
     private:
-        boost::asio::awaitable<void> run_bot();
+        // Ensure a fresh OAuth token and return it in IRC "oauth:" form.
+        // Skips the validate round trip for a recently confirmed token unless revalidate is set.
+        boost::asio::awaitable<std::string> irc_token(bool revalidate);
 
         static constexpr std::string_view kCRLF{ "\r\n" }; // line terminator
 
-        boost::asio::thread_pool pool_; // worker threads
-        boost::asio::strand<boost::asio::any_io_executor> strand_; // serialises callbacks
-        boost::asio::ssl::context ssl_ctx_; // shared TLS config
+        Runtime runtime_; // worker threads; destroyed last so every component stops first
+        boost::asio::any_io_executor strand_; // serialises callbacks
+        tb::net::TlsContextFactory& tls_; // process-wide; outlives the bot
 
         const std::string access_token_;
         const std::string refresh_token_;
@@ -133,12 +175,11 @@ namespace twitch_bot
         const std::string client_secret_;
         const std::string control_channel_;
 
-        IrcClient irc_client_;
+        IrcConnectionPool irc_pool_; // ingest; joins every channel
+        std::optional<IrcConnectionPool> writer_; // authenticated, joins nothing; only when ingest is anonymous
         CommandDispatcher dispatcher_;
         HelixClient helix_client_;
-
-        std::mutex chan_mutex_; // protects initial_channels_
-        std::vector<std::string> initial_channels_;
+        std::optional<StallWatchdog> watchdog_; // stopped first, while every target still exists
     };
 
 } // namespace twitch_bot
@@ -14,12 +14,12 @@ Why:
 // C++ Standard Library
 #include <fstream>
 #include <future>
-#include <iostream>
 #include <sstream>
 #include <system_error>
 
 // Core
 #include <tb/twitch/channel_store.hpp>
+#include <tb/utils/log.hpp>
 
 namespace {
 // Debounce interval for write back. Large enough to batch edits, small enough to feel prompt.
@@ -42,9 +42,9 @@ ChannelStore::~ChannelStore()
         boost::asio::post(strand_, [p = std::move(done)]() mutable { p.set_value(); });
         fut.wait();
     } catch (const std::exception& ex) {
-        std::cerr << "[ChannelStore::~ChannelStore] exception: " << ex.what() << '\n';
+        TB_LOG_ERROR("channel_store", "~ChannelStore exception: {}", ex.what());
     } catch (...) {
-        std::cerr << "[ChannelStore::~ChannelStore] unknown exception\n";
+        TB_LOG_ERROR("channel_store", "~ChannelStore unknown exception");
     }
 }
 
@@ -57,10 +57,10 @@ void ChannelStore::load()
     try {
         tbl = toml::parse_file(filename_.string());
     } catch (const toml::parse_error& e) {
-        std::cerr << "[ChannelStore] parse error: " << e << '\n';
+        TB_LOG_ERROR("channel_store", "parse error at line {}: {}", e.source().begin.line, e.description());
         return;
     } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << "[ChannelStore] fs error: " << e.what() << '\n';
+        TB_LOG_ERROR("channel_store", "fs error: {}", e.what());
         return;
     }
 
@@ -107,7 +107,7 @@ void ChannelStore::perform_save() const noexcept
     {
         std::ofstream out{tmp, std::ios::trunc | std::ios::binary};
         if (!out) {
-            std::cerr << "[ChannelStore] cannot open " << tmp << '\n';
+            TB_LOG_ERROR("channel_store", "cannot open {}", tmp);
             return;
         }
 
@@ -117,7 +117,7 @@ void ChannelStore::perform_save() const noexcept
         out.write(data.data(), static_cast<std::streamsize>(data.size()));
 
         if (!out) {
-            std::cerr << "[ChannelStore] write failed: " << tmp << '\n';
+            TB_LOG_ERROR("channel_store", "write failed: {}", tmp);
             return;
         }
     }
@@ -125,7 +125,7 @@ void ChannelStore::perform_save() const noexcept
     std::error_code ec;
     std::filesystem::rename(tmp, filename_, ec);
     if (ec) {
-        std::cerr << "[ChannelStore] rename failed: " << ec.message() << '\n';
+        TB_LOG_ERROR("channel_store", "rename failed: {}", ec.message());
         std::filesystem::remove(tmp, ec);
     }
 }
@@ -7,120 +7,688 @@ Abstract:
 
 Why:
 - Pre-reserve small buckets to avoid rehash churn on first use.
-- Contain exceptions inside command coroutines so a bad handler cannot tear down the bot.
-- Copy the target handler into the coroutine so it stays valid even if the map changes.
+- Contain exceptions inside command and trigger coroutines so a bad handler cannot tear down the bot.
+- A trigger pins its current pattern set for one line, so a swap mid-line cannot free it.
+- Routes are rebuilt whole on every registration change. Changes are rare and small, and a rebuild
+  keeps the read side to one pointer load. The command table build is the costly part. Before freeze()
+  a batch of registrations is built once, by the first command line that needs it, so commands route
+  whether or not the caller ever freezes. Snapshots that only change triggers or listeners share it.
+- Share the target handler into the coroutine so it stays valid even if the map changes.
+- Lane choice is a pure function of the channel name, which is what keeps each channel ordered.
+- Lines cross to their lane through Runtime::post, which is a lock-free inbox between cores.
 */
 
 // C++ Standard Library
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
 
 // Boost.Asio
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
 
 // Core
 #include <tb/twitch/command_dispatcher.hpp>
+#include <tb/utils/activity.hpp>
+#include <tb/utils/log.hpp>
+#include <tb/utils/trace.hpp>
 
 namespace twitch_bot
 {
 
-    CommandDispatcher::CommandDispatcher(boost::asio::any_io_executor executor) :
-        executor_(std::move(executor))
+    namespace
     {
+        // Armed per run; shared with the timer's completion, which may outlive the run.
+        struct Deadline
+        {
+            explicit Deadline(const boost::asio::any_io_executor& ex) :
+                timer{ ex }
+            {
+            }
+
+            boost::asio::steady_timer timer;
+            boost::asio::cancellation_signal signal;
+            bool fired = false;
+        };
+
+        tb::metrics::Counter& cooldown_rejects(CooldownVerdict scope)
+        {
+            static auto& global = tb::metrics::registry().counter("tb_command_cooldown_rejects_total", "Commands dropped by a cooldown", { { "scope", "global" } });
+            static auto& channel = tb::metrics::registry().counter("tb_command_cooldown_rejects_total", "Commands dropped by a cooldown", { { "scope", "channel" } });
+            static auto& user = tb::metrics::registry().counter("tb_command_cooldown_rejects_total", "Commands dropped by a cooldown", { { "scope", "user" } });
+            return scope == CooldownVerdict::global ? global : scope == CooldownVerdict::channel ? channel : user;
+        }
+    } // namespace
+
+    // Lane-local. A deadline is free again once both its run and its timer completion have let go,
+    // which leaves the pool as the only owner.
+    struct CommandDispatcher::DeadlinePool
+    {
+        static constexpr std::size_t k_max = 16; // more concurrent timed runs than this allocate
+
+        std::shared_ptr<Deadline> acquire(const boost::asio::any_io_executor& executor)
+        {
+            for (const auto& d : items)
+            {
+                if (d.use_count() == 1)
+                {
+                    d->fired = false;
+                    return d;
+                }
+            }
+            auto d = std::allocate_shared<Deadline>(tb::memory::recycling_allocator(), executor);
+            if (items.size() < k_max)
+            {
+                items.push_back(d);
+            }
+            return d;
+        }
+
+        std::vector<std::shared_ptr<Deadline>> items;
+    };
+
+    CommandDispatcher::CommandDispatcher(Runtime& runtime, std::size_t lanes) :
+        runtime_{ runtime }
+    {
+        Expects(lanes > 0);
+
+        // A serial home is already a lane; more lanes than homes would only share threads.
+        if (runtime_.homes_are_serial())
+        {
+            lanes = runtime_.homes();
+        }
+
+        lanes_.reserve(lanes);
+        lane_depth_.reserve(lanes);
+        cooldowns_.reserve(lanes);
+        deadlines_.reserve(lanes);
+        for (std::size_t i = 0; i < lanes; ++i)
+        {
+            lanes_.push_back(runtime_.serial_executor(i));
+            cooldowns_.emplace_back();
+            deadlines_.push_back(std::make_unique<DeadlinePool>());
+            lane_depth_.push_back(&tb::metrics::registry().gauge("tb_dispatch_queue_depth", "Chat lines posted to a lane and not yet routed", { { "lane", std::to_string(i) } }));
+        }
         commands_.reserve(16); // small stable footprint for a handful of commands
-        chat_listeners_.reserve(4); // avoid first-push reallocs in hot paths
+        chat_listeners_.reserve(4);
+
+        std::lock_guard lk(registry_mutex_);
+        table_ = CommandTable::build({}, match_);
+        publish();
+    }
+
+    CommandDispatcher::~CommandDispatcher()
+    {
+        // Queued listener drains hold their Listener, not the dispatcher's tables; finish them first.
+        if (listener_pool_)
+        {
+            listener_pool_->join();
+        }
+        delete routes_.exchange(nullptr, std::memory_order_acq_rel);
     }
 
-    void CommandDispatcher::register_command(std::string_view command, command_handler_t handler)
+    void CommandDispatcher::register_command(std::string_view command,
+                                             command_handler_t handler,
+                                             std::initializer_list<std::string_view> aliases,
+                                             CooldownPolicy cooldown,
+                                             HandlerBudget budget)
     {
+        auto entry = std::make_shared<CommandEntry>();
+        entry->name = std::string{ command };
+        entry->handler = std::move(handler);
+        entry->cooldown = cooldown;
+        entry->budget = budget;
+
+        auto& registry = tb::metrics::registry();
+        const tb::metrics::Labels labels{ { "command", entry->name } };
+        entry->invocations = &registry.counter("tb_command_invocations_total", "Command handlers started", labels);
+        entry->errors = &registry.counter("tb_command_errors_total", "Command handlers that ended in an exception other than a timeout", labels);
+        entry->timeouts = &registry.counter("tb_command_timeouts_total", "Command handlers cancelled at their budget's timeout", labels);
+        entry->busy = &registry.counter("tb_command_busy_rejects_total", "Commands dropped because max_concurrency runs were in flight", labels);
+        entry->in_flight = &registry.gauge("tb_command_in_flight", "Command handlers running now", labels);
+        entry->max_us = &registry.gauge("tb_command_handler_max_microseconds", "Longest command handler run since start", labels);
+        entry->latency = &registry.histogram("tb_command_handler_seconds", "Command handler run time, including awaits", labels);
+
+        std::lock_guard lk(registry_mutex_);
+        entry->id = next_command_id_++;
         // Insert-or-ignore by design: accidental duplicate registration is treated as a no-op.
-        // If you prefer last-wins, switch to operator[] assignment.
-        (void)commands_.try_emplace(std::string{ command }, std::move(handler));
+        (void)commands_.try_emplace(std::string{ command }, entry);
+        for (const auto alias : aliases)
+        {
+            (void)commands_.try_emplace(std::string{ alias }, entry);
+        }
+        publish(true);
+    }
+
+    bool CommandDispatcher::unregister_command(std::string_view command)
+    {
+        std::lock_guard lk(registry_mutex_);
+        const auto it = commands_.find(command);
+        if (it == commands_.end())
+        {
+            return false;
+        }
+        const auto entry = it->second;
+        std::erase_if(commands_, [&](const auto& kv) { return kv.second == entry; });
+        publish(true);
+        return true;
+    }
+
+    void CommandDispatcher::freeze(CommandMatch match)
+    {
+        std::lock_guard lk(registry_mutex_);
+        match_ = match;
+        frozen_ = true;
+        publish(true);
+    }
+
+    void CommandDispatcher::publish(bool commands_changed)
+    {
+        table_stale_ = table_stale_ || commands_changed;
+        if (table_stale_ && frozen_)
+        {
+            rebuild_table();
+        }
+
+        auto next = std::make_unique<Routes>();
+        next->commands = table_;
+        next->commands_stale = table_stale_;
+        next->triggers = triggers_;
+        next->listeners = chat_listeners_;
+        TB_LOG_DEBUG("dispatcher", "routes: {} command names, {} triggers, {} listeners", next->commands->size(), next->triggers.size(), next->listeners.size());
+
+        // Lanes may still be reading the old snapshot; the epoch domain frees it once they have all moved on.
+        tb::concurrent::epoch_domain().retire(routes_.exchange(next.release(), std::memory_order_acq_rel));
     }
 
-    void CommandDispatcher::register_chat_listener(chat_listener_t listener)
+    void CommandDispatcher::rebuild_table()
     {
-        chat_listeners_.push_back(std::move(listener));
+        std::vector<CommandTable::Key> keys;
+        keys.reserve(commands_.size());
+        for (const auto& [name, entry] : commands_)
+        {
+            keys.push_back({ name, entry });
+        }
+        // Map order is arbitrary. Registration order decides which of two case-folded duplicates
+        // survives, so the first registration wins; names within one entry all lead to it anyway.
+        std::sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) {
+            return a.entry->id != b.entry->id ? a.entry->id < b.entry->id : a.name < b.name;
+        });
+        table_ = CommandTable::build(std::move(keys), match_);
+        table_stale_ = false;
+    }
+
+    void CommandDispatcher::build_stale_table()
+    {
+        std::lock_guard lk(registry_mutex_);
+        if (table_stale_)
+        {
+            rebuild_table();
+            publish();
+        }
+    }
+
+    void CommandDispatcher::register_trigger(std::string_view name, std::shared_ptr<tb::match::MatcherSlot> patterns, trigger_handler_t handler)
+    {
+        Expects(patterns != nullptr);
+        auto entry = std::make_shared<TriggerEntry>();
+        entry->name = std::string{ name };
+        entry->patterns = std::move(patterns);
+        entry->handler = std::move(handler);
+        entry->hits = &tb::metrics::registry().counter("tb_trigger_hits_total", "Chat lines that fired a trigger", { { "trigger", entry->name } });
+
+        std::lock_guard lk(registry_mutex_);
+        triggers_.push_back(std::move(entry));
+        publish();
+    }
+
+    bool CommandDispatcher::remove_trigger(std::string_view name)
+    {
+        std::lock_guard lk(registry_mutex_);
+        const auto it = std::find_if(triggers_.begin(), triggers_.end(), [&](const auto& t) { return t->name == name; });
+        if (it == triggers_.end())
+        {
+            return false;
+        }
+        triggers_.erase(it);
+        publish();
+        return true;
+    }
+
+    void CommandDispatcher::fire_triggers(std::size_t lane, const Routes& routes, const ChatLine& line)
+    {
+        for (const auto& t : routes.triggers)
+        {
+            const auto matcher = t->patterns->load();
+            if (!matcher)
+            {
+                continue;
+            }
+            const auto hit = matcher->first(line.text());
+            if (!hit)
+            {
+                continue;
+            }
+            t->hits->inc();
+            boost::asio::co_spawn(lanes_[lane].executor,
+                                  invoke_trigger(t, line, *hit),
+                                  boost::asio::bind_allocator(tb::memory::recycling_allocator(), boost::asio::detached));
+        }
+    }
+
+    void CommandDispatcher::register_chat_listener(chat_listener_t listener, ListenerPolicy policy)
+    {
+        auto l = std::make_shared<Listener>();
+        l->fn = std::move(listener);
+        policy.sample_every = std::max<std::uint32_t>(policy.sample_every, 1);
+        l->policy = std::move(policy);
+
+        auto& registry = tb::metrics::registry();
+        const auto& name = l->policy.name;
+        constexpr std::string_view help = "Chat lines a listener did not see because of load";
+        if (l->policy.execution == ListenerExecution::worker_pool)
+        {
+            l->queue.emplace(l->policy.queue_capacity);
+            l->queue_full = &registry.counter("tb_chat_listener_dropped_total", help, { { "listener", name }, { "reason", "queue_full" } });
+        }
+        else
+        {
+            l->shed = &registry.counter("tb_chat_listener_dropped_total", help, { { "listener", name }, { "reason", "shed" } });
+        }
+
+        std::lock_guard lk(registry_mutex_);
+        // Started before the first snapshot that needs it is published.
+        if (l->queue && !listener_pool_)
+        {
+            listener_pool_.emplace(k_listener_threads);
+        }
+        chat_listeners_.push_back(std::move(l));
+        publish();
+    }
+
+    bool CommandDispatcher::remove_chat_listener(std::string_view name)
+    {
+        std::lock_guard lk(registry_mutex_);
+        const auto it = std::find_if(chat_listeners_.begin(), chat_listeners_.end(), [&](const auto& l) { return l->policy.name == name; });
+        if (it == chat_listeners_.end())
+        {
+            return false;
+        }
+        chat_listeners_.erase(it);
+        publish();
+        return true;
+    }
+
+    void CommandDispatcher::notify_listeners(std::size_t lane, const Routes& routes, ChatLine& line)
+    {
+        const auto depth = lane_depth_[lane]->value();
+        const auto& listeners = routes.listeners;
+        for (std::size_t i = 0; i < listeners.size(); ++i)
+        {
+            Listener& l = *listeners[i];
+            if (l.policy.sample_every > 1 && l.seen.fetch_add(1, std::memory_order_relaxed) % l.policy.sample_every != 0)
+            {
+                continue;
+            }
+
+            if (l.policy.execution == ListenerExecution::inline_on_lane)
+            {
+                // Commands behind this line are already waiting; listeners give way first.
+                if (l.policy.shed_above_depth != 0 && depth > static_cast<std::int64_t>(l.policy.shed_above_depth))
+                {
+                    l.shed->inc();
+                    continue;
+                }
+                const tb::activity::Scope activity{ "dispatch.chat_listener" };
+                l.fn(line.channel(), line.user(), line.text());
+                continue;
+            }
+
+            // Shares the slab; the last listener can take the line itself.
+            const bool last = i + 1 == listeners.size();
+            ChatLine copy = last ? std::move(line) : line;
+            if (!l.queue->try_push(copy))
+            {
+                l.queue_full->inc();
+                continue;
+            }
+            if (!l.scheduled.exchange(true, std::memory_order_acq_rel))
+            {
+                boost::asio::post(*listener_pool_, [this, l = listeners[i]]() mutable { drain_listener(std::move(l)); });
+            }
+        }
+    }
+
+    // The drain holds its Listener, so removal cannot free it mid-batch.
+    void CommandDispatcher::drain_listener(std::shared_ptr<Listener> lp)
+    {
+        Listener& l = *lp;
+        for (std::size_t n = 0; n < k_listener_batch; ++n)
+        {
+            auto line = l.queue->try_pop();
+            if (!line)
+            {
+                break;
+            }
+            try
+            {
+                const tb::activity::Scope activity{ "dispatch.pooled_listener" };
+                l.fn(line->channel(), line->user(), line->text());
+            }
+            catch (const std::exception& e)
+            {
+                TB_LOG_ERROR("dispatcher", "listener '{}' threw: {}", l.policy.name, e.what());
+            }
+        }
+
+        // Clear first, then look again: a push that saw the flag still set is picked up here.
+        l.scheduled.store(false, std::memory_order_release);
+        if (!l.queue->empty() && !l.scheduled.exchange(true, std::memory_order_acq_rel))
+        {
+            boost::asio::post(*listener_pool_, [this, lp = std::move(lp)]() mutable { drain_listener(std::move(lp)); });
+        }
+    }
+
+    CommandDispatcher::ChatLine CommandDispatcher::make_line(std::string_view channel,
+                                                             std::string_view user,
+                                                             std::string_view text,
+                                                             std::string_view raw_tags,
+                                                             bool is_moderator,
+                                                             bool is_broadcaster)
+    {
+        // One pooled allocation per line; lines are capped well below 4 GiB by the read buffer.
+        ChatLine line;
+        line.bytes = tb::memory::Slab::copy_of({ channel, user, text, raw_tags });
+        line.channel_len = gsl::narrow_cast<std::uint32_t>(channel.size());
+        line.user_len = gsl::narrow_cast<std::uint32_t>(user.size());
+        line.text_len = gsl::narrow_cast<std::uint32_t>(text.size());
+        line.is_moderator = is_moderator;
+        line.is_broadcaster = is_broadcaster;
+        return line;
+    }
+
+    std::size_t CommandDispatcher::lane_for(std::string_view channel) const noexcept
+    {
+        return std::hash<std::string_view>{}(channel) % lanes_.size();
+    }
+
+    void CommandDispatcher::post_line(std::string_view channel, ChatLine line)
+    {
+        const std::size_t idx = lane_for(channel);
+        auto& depth = *lane_depth_[idx];
+        depth.add(1);
+        runtime_.post(lanes_[idx], [this, idx, &depth, line = std::move(line)]() mutable {
+            depth.add(-1);
+            route_text(idx, std::move(line));
+        });
+    }
+
+    IrcMessage CommandDispatcher::make_message(const ChatLine& line, std::string_view command, std::string_view trailing) noexcept
+    {
+        IrcMessage msg{ line.bytes.view() };
+        msg.set_command(command);
+        msg.add_param(line.channel());
+        msg.set_prefix(line.user());
+        msg.set_trailing(trailing);
+        msg.set_raw_tags(line.tags()); // forward tags for context-sensitive handlers
+        msg.is_moderator = line.is_moderator ? 1 : 0; // keep role bits
+        msg.is_broadcaster = line.is_broadcaster ? 1 : 0;
+        return msg;
     }
 
     // Run the handler and surface errors without crashing the event loop.
-    template<typename Handler>
-    boost::asio::awaitable<void> invoke_command(Handler handler, IrcMessage msg)
+    boost::asio::awaitable<void> CommandDispatcher::invoke_command(std::shared_ptr<const CommandEntry> entry, ChatLine line, DeadlinePool& deadlines)
     {
+        std::string_view typed;
+        std::string_view args;
+        split_command(line.text(), typed, args);
+        const std::string_view cmd_name = entry->name; // an alias or other casing reaches the handler as the canonical name
+        const IrcMessage cmd_msg = make_message(line, cmd_name, args);
+        const auto executor = co_await boost::asio::this_coro::executor;
+
+        // The timer only emits; the handler sees the cancellation at its next await and unwinds normally.
+        std::shared_ptr<Deadline> deadline;
+        if (entry->budget.timeout.count() > 0)
+        {
+            deadline = deadlines.acquire(executor);
+            deadline->timer.expires_after(entry->budget.timeout);
+            deadline->timer.async_wait([deadline](boost::system::error_code ec) {
+                if (!ec)
+                {
+                    deadline->fired = true;
+                    deadline->signal.emit(boost::asio::cancellation_type::terminal);
+                }
+            });
+        }
+
+        entry->invocations->inc();
+        entry->in_flight->add(1);
+        const auto started = std::chrono::steady_clock::now();
         try
         {
-            co_await handler(std::move(msg));
+            TB_TRACE_SPAN("dispatch.handler");
+            if (deadline)
+            {
+                co_await boost::asio::co_spawn(executor,
+                                               entry->handler(cmd_msg),
+                                               boost::asio::bind_allocator(tb::memory::recycling_allocator(),
+                                                                           boost::asio::bind_cancellation_slot(deadline->signal.slot(), boost::asio::use_awaitable)));
+            }
+            else
+            {
+                co_await entry->handler(cmd_msg);
+            }
         }
         catch (const std::exception& e)
         {
-            std::cerr << "[dispatcher] '" << msg.command << "' threw: " << e.what() << '\n';
+            if (!deadline || !deadline->fired) // after a timeout this is the cancellation surfacing
+            {
+                entry->errors->inc();
+                TB_LOG_ERROR("dispatcher", "'{}' threw: {}", cmd_name, e.what());
+            }
         }
         catch (...)
         {
-            std::cerr << "[dispatcher] '" << msg.command << "' threw: <unknown exception>\n";
+            if (!deadline || !deadline->fired)
+            {
+                entry->errors->inc();
+                TB_LOG_ERROR("dispatcher", "'{}' threw: <unknown exception>", cmd_name);
+            }
         }
+        if (deadline)
+        {
+            deadline->timer.cancel();
+            if (deadline->fired)
+            {
+                entry->timeouts->inc();
+                TB_LOG_WARN("dispatcher", "'{}' cancelled after {} ms", cmd_name, entry->budget.timeout.count());
+            }
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - started;
+        entry->latency->observe(elapsed);
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        auto seen = entry->max_ns.load(std::memory_order_relaxed);
+        while (ns > seen && !entry->max_ns.compare_exchange_weak(seen, ns, std::memory_order_relaxed))
+        {
+        }
+        if (ns > seen)
+        {
+            entry->max_us->set(ns / 1000);
+        }
+        entry->in_flight->add(-1);
+        entry->running.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::vector<CommandStats> CommandDispatcher::command_stats() const
+    {
+        std::vector<std::shared_ptr<const CommandEntry>> entries;
+        {
+            // Registered commands, including any the routed table has not been rebuilt with yet.
+            std::lock_guard lk(registry_mutex_);
+            entries.reserve(commands_.size());
+            for (const auto& [name, entry] : commands_)
+            {
+                entries.push_back(entry);
+            }
+        }
+
+        std::vector<CommandStats> out;
+        std::vector<const CommandEntry*> seen; // aliases repeat an entry
+        for (const auto& entry : entries)
+        {
+            if (std::find(seen.begin(), seen.end(), entry.get()) != seen.end())
+            {
+                continue;
+            }
+            seen.push_back(entry.get());
+            CommandStats& st = out.emplace_back();
+            st.name = entry->name;
+            st.invocations = entry->invocations->value();
+            st.errors = entry->errors->value();
+            st.timeouts = entry->timeouts->value();
+            st.busy_rejects = entry->busy->value();
+            st.in_flight = entry->in_flight->value();
+            st.p50 = entry->latency->quantile(0.50);
+            st.p99 = entry->latency->quantile(0.99);
+            st.max = std::chrono::nanoseconds{ entry->max_ns.load(std::memory_order_relaxed) };
+        }
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+        return out;
+    }
+
+    boost::asio::awaitable<void> CommandDispatcher::invoke_trigger(std::shared_ptr<const TriggerEntry> entry, ChatLine line, tb::match::Match hit)
+    {
+        const IrcMessage msg = make_message(line, entry->name, line.text());
+        try
+        {
+            TB_TRACE_SPAN("dispatch.trigger");
+            co_await entry->handler(msg, hit);
+        }
+        catch (const std::exception& e)
+        {
+            TB_LOG_ERROR("dispatcher", "trigger '{}' threw: {}", entry->name, e.what());
+        }
+        catch (...)
+        {
+            TB_LOG_ERROR("dispatcher", "trigger '{}' threw: <unknown exception>", entry->name);
+        }
+    }
+
+    bool CommandDispatcher::admit(std::size_t lane, const CommandEntry& entry, const ChatLine& line)
+    {
+        const auto& policy = entry.cooldown;
+        if (!policy.enabled() || (policy.exempt_privileged && (line.is_moderator || line.is_broadcaster)))
+        {
+            return true;
+        }
+
+        auto& table = cooldowns_[lane];
+        if (!table)
+        {
+            table = std::make_unique<CooldownTable>();
+        }
+        const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        const auto verdict = table->check(entry.id, policy, entry.global_next_ms, line.channel(), line.user(), now_ms);
+        if (verdict == CooldownVerdict::allowed)
+        {
+            return true;
+        }
+        cooldown_rejects(verdict).inc();
+        return false;
     }
 
     // Route a single line.
     // Prefer command handling first so chat listeners do not double-handle command text.
-    void CommandDispatcher::route_text(std::string_view channel,
-                                       std::string_view user,
-                                       std::string_view text,
-                                       std::string_view raw_tags,
-                                       bool is_moderator,
-                                       bool is_broadcaster)
+    void CommandDispatcher::route_text(std::size_t lane, ChatLine line)
     {
+        TB_TRACE_SPAN("dispatch.route_text");
+        const auto pin = tb::concurrent::epoch_domain().pin();
+        const Routes* current = routes_.load(std::memory_order_acquire);
+
+        const auto text = line.text();
+        if (!text.empty() && text.front() == '!' && current->commands_stale)
+        {
+            // Registered before freeze(): build once for the whole batch, then read the new snapshot.
+            // The pin keeps the old one alive until this line is done.
+            build_stale_table();
+            current = routes_.load(std::memory_order_acquire);
+        }
+        const Routes& routes = *current;
+
         if (!text.empty() && text.front() == '!')
         {
             std::string_view cmd_name;
             std::string_view args;
             split_command(text, cmd_name, args);
-            if (auto it = commands_.find(cmd_name); it != commands_.end())
-            {
-                IrcMessage cmd_msg{};
-                cmd_msg.command = cmd_name;
-                cmd_msg.params[0] = channel;
-                cmd_msg.param_count = 1;
-                cmd_msg.prefix = user;
-                cmd_msg.trailing = args;
-                cmd_msg.raw_tags = raw_tags; // forward tags for context-sensitive handlers
-                cmd_msg.is_moderator = is_moderator ? 1 : 0; // keep role bits
-                cmd_msg.is_broadcaster = is_broadcaster ? 1 : 0;
-
-                // Copy the target functor into the coroutine so it cannot dangle if the map mutates.
-                boost::asio::co_spawn(
-                    executor_, invoke_command(it->second, std::move(cmd_msg)), boost::asio::detached);
+            if (const auto* hit = routes.commands->find(cmd_name))
+            {
+                // Concurrency first: a busy reject must not spend the user's cooldown allowance.
+                const CommandEntry& entry = **hit;
+                const auto running = entry.running.fetch_add(1, std::memory_order_relaxed);
+                if (entry.budget.max_concurrency != 0 && running >= entry.budget.max_concurrency)
+                {
+                    entry.running.fetch_sub(1, std::memory_order_relaxed);
+                    entry.busy->inc();
+                    return; // the handler's own backlog is the limit; queueing would only grow it
+                }
+                if (!admit(lane, entry, line))
+                {
+                    entry.running.fetch_sub(1, std::memory_order_relaxed);
+                    return; // on cooldown: no handler, no reply, and not chat either
+                }
+                // Share the target functor into the coroutine so it cannot dangle if the map mutates.
+                // Spawning on the same lane keeps handler start order equal to arrival order.
+                boost::asio::co_spawn(lanes_[lane].executor,
+                                      invoke_command(*hit, std::move(line), *deadlines_[lane]),
+                                      boost::asio::bind_allocator(tb::memory::recycling_allocator(), boost::asio::detached));
                 return;
             }
         }
 
-        // Not a command or no matching handler: notify listeners.
-        for (auto& listener : chat_listeners_)
-            listener(channel, user, text);
+        // Not a command or no matching handler: triggers, then listeners.
+        fire_triggers(lane, routes, line);
+        notify_listeners(lane, routes, line);
     }
 
     void CommandDispatcher::dispatch_text(std::string_view channel,
                                           std::string_view user,
                                           std::string_view text)
     {
+        // Handler messages address the line with 16-bit offsets; parsed lines always fit.
+        if (channel.size() + user.size() + text.size() > IrcMessage::max_line)
+        {
+            TB_LOG_WARN("dispatcher", "dropping {} byte line for #{}: too long", text.size(), channel);
+            return;
+        }
         // No tags available in this entry point.
-        route_text(channel, user, text);
+        post_line(channel, make_line(channel, user, text, {}, false, false));
     }
 
     void CommandDispatcher::dispatch(IrcMessage msg)
     {
         // Only chat lines are interesting here.
-        if (msg.command != "PRIVMSG" || msg.param_count < 1)
+        if (msg.command() != "PRIVMSG" || msg.param_count() < 1)
         {
             return;
         }
 
-        std::string_view channel = Normalise_channel(msg.params[0]);
-        std::string_view user = extract_user(msg.prefix);
-        std::string_view text = msg.trailing;
+        std::string_view channel = Normalise_channel(msg.param(0));
+        std::string_view user = extract_user(msg.prefix());
+        std::string_view text = msg.trailing();
 
         // Preserve tags and role bits so permission checks can happen in handlers.
-        route_text(channel, user, text, msg.raw_tags, msg.is_moderator != 0, msg.is_broadcaster != 0);
+        // The copy is what lets the reader reuse its buffer while the lane catches up.
+        post_line(channel, make_line(channel, user, text, msg.raw_tags(), msg.is_moderator != 0, msg.is_broadcaster != 0));
     }
 
 } // namespace twitch_bot
@@ -0,0 +1,239 @@
+/*
+Module Name:
+- command_table.cpp
+
+Abstract:
+- Hash-and-displace construction and lookup for CommandTable.
+
+Why:
+- One seed with no collisions over all n names in m slots is found with probability about
+  exp(-n^2 / 2m), which vanishes past a few dozen names. CHD only needs each bucket of about four names
+  to fit into the slots still free. Buckets go largest first, while the table is emptiest, so a
+  displacement is found within a few tries.
+- The load stays between 0.4 and 0.8, so the last single-name buckets still find a free slot quickly.
+  A bucket that runs out of displacements makes the build reseed, which in practice never happens.
+- FNV-1a over folded bytes keeps both the hash and the compare branch-light for names under 16 bytes.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Core
+#include <tb/twitch/command_table.hpp>
+#include <tb/utils/log.hpp>
+
+namespace twitch_bot
+{
+
+    namespace
+    {
+        constexpr std::uint64_t k_fnv_prime = 0x100000001b3ull;
+        constexpr std::uint64_t k_golden = 0x9e3779b97f4a7c15ull;
+        constexpr std::size_t k_bucket_keys = 4; // average names per bucket
+        constexpr std::uint32_t k_max_displacement = std::numeric_limits<std::uint16_t>::max();
+        constexpr int k_seeds_per_size = 4;
+
+        // splitmix64's finaliser: every input bit reaches every output bit.
+        constexpr std::uint64_t mix(std::uint64_t x) noexcept
+        {
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        constexpr unsigned char fold(unsigned char c) noexcept
+        {
+            return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+        }
+    } // namespace
+
+    std::uint64_t CommandTable::hash(std::string_view name) const noexcept
+    {
+        std::uint64_t h = seed_ ^ (name.size() * k_fnv_prime);
+        if (match_ == CommandMatch::ascii_case_insensitive)
+        {
+            for (const char c : name)
+            {
+                h = (h ^ fold(static_cast<unsigned char>(c))) * k_fnv_prime;
+            }
+        }
+        else
+        {
+            for (const char c : name)
+            {
+                h = (h ^ static_cast<unsigned char>(c)) * k_fnv_prime;
+            }
+        }
+        return h ^ (h >> 32);
+    }
+
+    std::size_t CommandTable::bucket_of(std::uint64_t h) const noexcept
+    {
+        return static_cast<std::size_t>((h >> 40) & bucket_mask_);
+    }
+
+    std::size_t CommandTable::slot_of(std::uint64_t h, std::uint16_t displacement) const noexcept
+    {
+        return static_cast<std::size_t>(mix(h + displacement * k_golden) & mask_);
+    }
+
+    bool CommandTable::equal(std::string_view a, std::string_view b) const noexcept
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        if (match_ == CommandMatch::exact)
+        {
+            return a == b;
+        }
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            if (fold(static_cast<unsigned char>(a[i])) != fold(static_cast<unsigned char>(b[i])))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::unique_ptr<const CommandTable> CommandTable::build(std::vector<Key> keys, CommandMatch match)
+    {
+        std::unique_ptr<CommandTable> t{ new CommandTable() };
+        t->match_ = match;
+
+        // "Join" and "join" are one key once folded; the first registration wins.
+        t->keys_.reserve(keys.size());
+        std::unordered_set<std::string> seen;
+        seen.reserve(keys.size());
+        for (auto& k : keys)
+        {
+            std::string folded = k.name;
+            if (match == CommandMatch::ascii_case_insensitive)
+            {
+                std::transform(folded.begin(), folded.end(), folded.begin(), [](char c) { return static_cast<char>(fold(static_cast<unsigned char>(c))); });
+            }
+            if (!seen.insert(std::move(folded)).second)
+            {
+                TB_LOG_WARN("dispatcher", "command '{}' duplicates an earlier name; ignored", k.name);
+                continue;
+            }
+            t->max_len_ = std::max(t->max_len_, k.name.size());
+            t->keys_.push_back(std::move(k));
+        }
+        if (t->keys_.size() >= std::numeric_limits<std::uint16_t>::max())
+        {
+            throw std::length_error("CommandTable: too many commands");
+        }
+
+        const std::size_t n = t->keys_.size();
+        std::size_t size = std::bit_ceil(std::max<std::size_t>(8, n));
+        if (n * 5 > size * 4)
+        {
+            size *= 2; // keep the load at or under 0.8
+        }
+        const std::size_t buckets = std::bit_ceil(std::max<std::size_t>(1, (n + k_bucket_keys - 1) / k_bucket_keys));
+        t->bucket_mask_ = buckets - 1;
+
+        std::vector<std::uint64_t> hashes(n);
+        std::vector<std::vector<std::uint16_t>> members(buckets);
+        std::vector<std::size_t> order(buckets);
+        std::vector<std::size_t> placed;
+        for (std::uint64_t attempt = 1;; ++attempt)
+        {
+            t->mask_ = size - 1;
+            t->seed_ = attempt * k_golden;
+            t->slots_.assign(size, 0);
+            t->displace_.assign(buckets, 0);
+
+            for (auto& m : members)
+            {
+                m.clear();
+            }
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                hashes[i] = t->hash(t->keys_[i].name);
+                members[t->bucket_of(hashes[i])].push_back(static_cast<std::uint16_t>(i));
+            }
+            for (std::size_t b = 0; b < buckets; ++b)
+            {
+                order[b] = b;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return members[a].size() > members[b].size(); });
+
+            bool ok = true;
+            for (const std::size_t b : order)
+            {
+                if (members[b].empty())
+                {
+                    break; // sorted, so the rest are empty too
+                }
+                bool fits = false;
+                for (std::uint32_t d = 0; d <= k_max_displacement && !fits; ++d)
+                {
+                    const auto disp = static_cast<std::uint16_t>(d);
+                    placed.clear();
+                    fits = true;
+                    for (const auto i : members[b])
+                    {
+                        const auto slot = t->slot_of(hashes[i], disp);
+                        if (t->slots_[slot] != 0)
+                        {
+                            fits = false; // taken, possibly by this bucket's own earlier name
+                            break;
+                        }
+                        t->slots_[slot] = static_cast<std::uint16_t>(i + 1);
+                        placed.push_back(slot);
+                    }
+                    if (fits)
+                    {
+                        t->displace_[b] = disp;
+                    }
+                    else
+                    {
+                        for (const auto slot : placed)
+                        {
+                            t->slots_[slot] = 0;
+                        }
+                    }
+                }
+                if (!fits)
+                {
+                    ok = false;
+                    break;
+                }
+            }
+            if (ok)
+            {
+                return t;
+            }
+            if (attempt % k_seeds_per_size == 0)
+            {
+                size *= 2;
+            }
+        }
+    }
+
+    const CommandTable::entry_ptr* CommandTable::find(std::string_view name) const noexcept
+    {
+        if (name.empty() || name.size() > max_len_)
+        {
+            return nullptr;
+        }
+        const auto h = hash(name);
+        const auto idx = slots_[slot_of(h, displace_[bucket_of(h)])];
+        if (idx == 0)
+        {
+            return nullptr;
+        }
+        const Key& k = keys_[idx - 1];
+        return equal(k.name, name) ? &k.entry : nullptr;
+    }
+
+} // namespace twitch_bot
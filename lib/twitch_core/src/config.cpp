@@ -24,6 +24,7 @@ Why:
 
 // Core
 #include <tb/twitch/config.hpp>
+#include <tb/utils/activity.hpp>
 
 namespace env
 {
@@ -90,6 +91,36 @@ namespace env
             }
             return {};
         }
+
+        // Return optional bool if present, fallback otherwise. A non-bool value is an error.
+        bool fetch_optional_bool(const toml::table& root,
+                                 std::initializer_list<std::string_view> keys,
+                                 const std::string& path_str,
+                                 bool fallback)
+        {
+            const toml::node* node = &root;
+            for (auto key : keys)
+            {
+                const auto* table_ptr = node->as_table();
+                if (!table_ptr)
+                {
+                    return fallback;
+                }
+                if (const auto* found = table_ptr->get(key))
+                {
+                    node = found;
+                }
+                else
+                {
+                    return fallback;
+                }
+            }
+            if (auto opt = node->value<bool>())
+            {
+                return *opt;
+            }
+            throw EnvError("Invalid value in " + path_str);
+        }
     } // namespace
 
     // Read, validate and convert the TOML file at path.
@@ -119,11 +150,15 @@ namespace env
         BotConfig bot_cfg{
             .login = fetch_string(tbl, { "twitch", "bot", "login" }, path_str),
             .control_channel = {}, // defaults to login below
+            .anonymous_ingest = false,
+            .case_insensitive_commands = false,
         };
         {
             // Why: control channel typically equals the bot login; allow override when needed.
             auto cc = fetch_optional_string(tbl, { "twitch", "bot", "control_channel" });
             bot_cfg.control_channel = cc.empty() ? bot_cfg.login : std::move(cc);
+            bot_cfg.anonymous_ingest = fetch_optional_bool(tbl, { "twitch", "bot", "anonymous_ingest" }, path_str, false);
+            bot_cfg.case_insensitive_commands = fetch_optional_bool(tbl, { "twitch", "bot", "case_insensitive_commands" }, path_str, false);
         }
 
         AuthConfig auth_cfg{
@@ -131,7 +166,73 @@ namespace env
             .refresh_token = fetch_string(tbl, { "twitch", "auth", "refresh_token" }, path_str),
         };
 
-        return Config(path, std::move(app_cfg), std::move(bot_cfg), std::move(auth_cfg));
+        LogConfig log_cfg;
+        if (auto lvl = fetch_optional_string(tbl, { "log", "level" }); !lvl.empty())
+        {
+            log_cfg.level = std::move(lvl);
+        }
+        if (auto n = tbl.at_path("log.raw_sample_every").value<std::int64_t>())
+        {
+            if (*n < 0)
+            {
+                throw EnvError("Invalid value in " + path_str);
+            }
+            log_cfg.raw_sample_every = static_cast<std::uint32_t>(*n);
+        }
+
+        RuntimeConfig runtime_cfg;
+        if (auto mode = fetch_optional_string(tbl, { "runtime", "mode" }); !mode.empty())
+        {
+            if (mode != "pool" && mode != "per_core")
+            {
+                throw EnvError("Invalid runtime.mode in " + path_str + " (expected \"pool\" or \"per_core\")");
+            }
+            runtime_cfg.per_core = mode == "per_core";
+        }
+        if (auto n = tbl.at_path("runtime.threads").value<std::int64_t>())
+        {
+            if (*n < 0 || *n > 1024)
+            {
+                throw EnvError("Invalid value in " + path_str);
+            }
+            runtime_cfg.threads = static_cast<std::uint32_t>(*n);
+        }
+        runtime_cfg.pin = fetch_optional_bool(tbl, { "runtime", "pin" }, path_str, true);
+
+        MetricsConfig metrics_cfg;
+        if (auto addr = fetch_optional_string(tbl, { "metrics", "address" }); !addr.empty())
+        {
+            metrics_cfg.address = std::move(addr);
+        }
+        if (auto n = tbl.at_path("metrics.port").value<std::int64_t>())
+        {
+            if (*n < 0 || *n > 65535)
+            {
+                throw EnvError("Invalid value in " + path_str);
+            }
+            metrics_cfg.port = static_cast<std::uint16_t>(*n);
+        }
+
+        WatchdogConfig watchdog_cfg;
+        if (auto n = tbl.at_path("watchdog.threshold_ms").value<std::int64_t>())
+        {
+            if (*n < 0 || *n > 600'000)
+            {
+                throw EnvError("Invalid value in " + path_str);
+            }
+            watchdog_cfg.threshold_ms = static_cast<std::uint32_t>(*n);
+        }
+        if (auto n = tbl.at_path("watchdog.interval_ms").value<std::int64_t>())
+        {
+            if (*n < 1 || *n > 60'000)
+            {
+                throw EnvError("Invalid value in " + path_str);
+            }
+            watchdog_cfg.interval_ms = static_cast<std::uint32_t>(*n);
+        }
+        watchdog_cfg.stack_samples = fetch_optional_bool(tbl, { "watchdog", "stack_samples" }, path_str, true);
+
+        return Config(path, std::move(app_cfg), std::move(bot_cfg), std::move(auth_cfg), std::move(log_cfg), runtime_cfg, std::move(metrics_cfg), watchdog_cfg);
     }
 
     Config Config::load_file(const std::filesystem::path& path)
@@ -165,6 +266,7 @@ namespace env
     {
         try
         {
+            const tb::activity::Scope activity{ "config.write_token" }; // may register the thread, which allocates
             auto tbl = toml::parse_file(path.string());
 
             auto set_token = [&](toml::table& auth) {
@@ -0,0 +1,55 @@
+/*
+Module Name:
+- connect_cache.cpp
+
+Abstract:
+- DNS bookkeeping for ConnectCache.
+
+Why:
+- Results are copied out under the mutex; resolver results share their storage, so the copy is cheap.
+*/
+
+// Core
+#include <tb/twitch/connect_cache.hpp>
+
+namespace twitch_bot
+{
+
+    ConnectCache::ConnectCache(ConnectCacheOptions options) noexcept :
+        options_{ options }
+    {
+    }
+
+    std::optional<ConnectCache::results_type> ConnectCache::endpoints(std::string_view host) const
+    {
+        std::lock_guard lk(mutex_);
+        auto it = dns_.find(host);
+        if (it == dns_.end() || clock::now() >= it->second.expires)
+        {
+            return std::nullopt;
+        }
+        return it->second.results;
+    }
+
+    void ConnectCache::store_endpoints(std::string_view host, results_type results)
+    {
+        if (results.empty())
+        {
+            return;
+        }
+        std::lock_guard lk(mutex_);
+        auto& e = dns_[std::string{ host }];
+        e.results = std::move(results);
+        e.expires = clock::now() + options_.dns_ttl;
+    }
+
+    void ConnectCache::forget_endpoints(std::string_view host)
+    {
+        std::lock_guard lk(mutex_);
+        if (auto it = dns_.find(host); it != dns_.end())
+        {
+            dns_.erase(it);
+        }
+    }
+
+} // namespace twitch_bot
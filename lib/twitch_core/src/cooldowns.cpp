@@ -0,0 +1,196 @@
+/*
+Module Name:
+- cooldowns.cpp
+
+Abstract:
+- GCRA admission, linear-probing table and wheel-driven expiry for CooldownTable.
+
+Why:
+- GCRA keeps one deadline per key and still expresses a burst: a user conforms while
+  now >= tat - (burst - 1) * period. Once tat has passed, the key is the same as absent.
+  That is exactly when the wheel drops it.
+- check() peeks every scope before it records any, so a reject on one scope never uses up another
+  scope's allowance.
+- Deletion shifts later entries back instead of leaving tombstones, so probe runs stay as short
+  under churn as they were when the table was fresh.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+// Core
+#include <tb/twitch/cooldowns.hpp>
+
+namespace twitch_bot
+{
+
+    namespace
+    {
+        enum : std::uint64_t
+        {
+            k_scope_channel = 1,
+            k_scope_user = 2,
+        };
+
+        constexpr std::uint64_t mix(std::uint64_t x) noexcept
+        {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        std::uint64_t key_of(std::uint32_t command_id, std::uint64_t scope, std::string_view name) noexcept
+        {
+            const auto k = mix(std::hash<std::string_view>{}(name) ^ (((std::uint64_t{ command_id } << 2) | scope) * 0x9e3779b97f4a7c15ull));
+            return k != 0 ? k : 1;
+        }
+    } // namespace
+
+    CooldownTable::CooldownTable(std::uint32_t capacity) :
+        slots_(std::bit_ceil(std::max<std::uint32_t>(capacity, 64))),
+        mask_{ slots_.size() - 1 },
+        max_live_{ static_cast<std::uint32_t>(slots_.size() - slots_.size() / 8) },
+        wheel_{ max_live_ },
+        untracked_{ tb::metrics::registry().counter("tb_command_cooldown_untracked_total", "Cooldown keys admitted without tracking because a lane's table was full") }
+    {
+    }
+
+    CooldownVerdict CooldownTable::check(std::uint32_t command_id,
+                                         const CooldownPolicy& policy,
+                                         std::atomic<std::int64_t>& global_next_ms,
+                                         std::string_view channel,
+                                         std::string_view user,
+                                         std::int64_t now_ms) noexcept
+    {
+        expire(now_ms);
+
+        const auto global_ms = policy.global.count();
+        const auto channel_ms = policy.per_channel.count();
+        const auto user_ms = policy.per_user.count();
+        const auto burst = static_cast<std::int64_t>(std::max<std::uint32_t>(policy.user_burst, 1));
+        const auto channel_key = channel_ms > 0 ? key_of(command_id, k_scope_channel, channel) : 0;
+        const auto user_key = user_ms > 0 ? key_of(command_id, k_scope_user, user) : 0;
+
+        // Peek.
+        auto global_next = global_ms > 0 ? global_next_ms.load(std::memory_order_relaxed) : 0;
+        if (now_ms < global_next)
+        {
+            return CooldownVerdict::global;
+        }
+        if (const Slot* s = channel_key ? find(channel_key) : nullptr; s && now_ms < s->tat_ms)
+        {
+            return CooldownVerdict::channel;
+        }
+        if (const Slot* s = user_key ? find(user_key) : nullptr; s && now_ms < s->tat_ms - (burst - 1) * user_ms)
+        {
+            return CooldownVerdict::user;
+        }
+
+        // Record. Another lane can win the global deadline between peek and here.
+        if (global_ms > 0)
+        {
+            while (!global_next_ms.compare_exchange_weak(global_next, now_ms + global_ms, std::memory_order_relaxed))
+            {
+                if (now_ms < global_next)
+                {
+                    return CooldownVerdict::global;
+                }
+            }
+        }
+        if (channel_key)
+        {
+            record(channel_key, channel_ms, now_ms);
+        }
+        if (user_key)
+        {
+            record(user_key, user_ms, now_ms);
+        }
+        return CooldownVerdict::allowed;
+    }
+
+    CooldownTable::Slot* CooldownTable::find(std::uint64_t key) noexcept
+    {
+        for (auto i = key & mask_; slots_[i].key != 0; i = (i + 1) & mask_)
+        {
+            if (slots_[i].key == key)
+            {
+                return &slots_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void CooldownTable::record(std::uint64_t key, std::int64_t period_ms, std::int64_t now_ms) noexcept
+    {
+        if (Slot* s = find(key))
+        {
+            s->tat_ms = std::max(s->tat_ms, now_ms) + period_ms; // its wheel node reschedules itself on expiry
+            return;
+        }
+        if (size_ >= max_live_)
+        {
+            untracked_.inc();
+            return;
+        }
+
+        auto i = key & mask_;
+        while (slots_[i].key != 0)
+        {
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = { key, now_ms + period_ms };
+        ++size_;
+        // The wheel holds exactly max_live_ nodes, one per live key, so this cannot fail.
+        (void)wheel_.schedule(key, static_cast<std::uint64_t>((now_ms + period_ms) / k_tick_ms + 1));
+    }
+
+    void CooldownTable::erase(std::uint64_t key) noexcept
+    {
+        auto i = key & mask_;
+        while (slots_[i].key != key)
+        {
+            if (slots_[i].key == 0)
+            {
+                return;
+            }
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = {};
+        --size_;
+
+        // Backward shift: pull each later entry of the run into the hole unless its home lies after the hole.
+        for (auto j = (i + 1) & mask_; slots_[j].key != 0; j = (j + 1) & mask_)
+        {
+            const auto home = slots_[j].key & mask_;
+            const bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+            if (!stays)
+            {
+                slots_[i] = slots_[j];
+                slots_[j] = {};
+                i = j;
+            }
+        }
+    }
+
+    void CooldownTable::expire(std::int64_t now_ms) noexcept
+    {
+        wheel_.advance(static_cast<std::uint64_t>(now_ms / k_tick_ms), [this, now_ms](std::uint64_t key) noexcept -> std::uint64_t {
+            const Slot* s = find(key);
+            if (!s)
+            {
+                return 0;
+            }
+            if (s->tat_ms > now_ms)
+            {
+                return static_cast<std::uint64_t>(s->tat_ms / k_tick_ms + 1); // extended since it was filed
+            }
+            erase(key);
+            return 0;
+        });
+    }
+
+} // namespace twitch_bot
@@ -9,18 +9,33 @@ Abstract:
 Why:
 - Keep OAuth state and retries on a strand so callers do not need to coordinate.
 - Validate before refresh to avoid unnecessary token churn.
+- Skip validation for a recently confirmed token so reconnects do not wait on an HTTPS round trip.
 - Retry once on 401 to hide transient expiry from callers.
+- Stream lookups go out 100 logins at a time with first=100, since Helix otherwise pages at 20. Single
+  lookups wait briefly on the strand for company, and each login is asked once per batch.
+- Single lookups go through a TTL cache first, keyed "streams:<login>". Offline answers get a shorter TTL,
+  and failed lookups are never cached. A failed page fails only its own logins, so one bad page in a
+  large poll does not turn the rest offline.
+- Every Helix request waits on the rate limiter for a point and reports its Ratelimit-* headers back.
+  Polls queue behind chat lookups, and a 429 is retried only after the hold the server asked for.
 */
 
 // C++ Standard Library
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <optional>
+#include <stdexcept>
+#include <cstddef>
 #include <string>
 #include <string_view>
+#include <utility>
 
 // Boost.Asio
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/redirect_error.hpp>
 #include <boost/asio/use_awaitable.hpp>
 
 // Glaze
@@ -32,6 +47,7 @@ Why:
 // Core
 #include <tb/net/http/http_client.hpp>
 #include <tb/twitch/helix_client.hpp>
+#include <tb/utils/metrics.hpp>
 
 namespace twitch_bot
 {
@@ -94,7 +110,35 @@ namespace twitch_bot
         // Endpoints used by this client.
         constexpr EndPoint oauth_validate{ "id.twitch.tv", "443", "/oauth2/validate" };
         constexpr EndPoint access_token{ "id.twitch.tv", "443", "/oauth2/token" };
-        constexpr EndPoint helix_streams{ "api.twitch.tv", "443", "/helix/streams?user_login=" };
+        constexpr EndPoint helix_streams{ "api.twitch.tv", "443", "/helix/streams?first=100" }; // then &user_login=...
+
+        // "#Chan" -> "chan"; Helix reports logins in lower case.
+        std::string canonical_login(std::string_view s)
+        {
+            if (!s.empty() && s.front() == '#')
+            {
+                s.remove_prefix(1);
+            }
+            std::string out{ s };
+            for (auto& c : out)
+            {
+                c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+            return out;
+        }
+
+        struct StreamMetrics
+        {
+            tb::metrics::Counter& lookups = tb::metrics::registry().counter("tb_helix_stream_lookups_total", "Logins asked for stream status, before batching");
+            tb::metrics::Counter& requests = tb::metrics::registry().counter("tb_helix_stream_requests_total", "/helix/streams requests sent");
+            tb::metrics::Counter& failed_pages = tb::metrics::registry().counter("tb_helix_stream_failed_pages_total", "/helix/streams pages that failed; their logins stay uncached");
+        };
+
+        StreamMetrics& stream_metrics()
+        {
+            static StreamMetrics m;
+            return m;
+        }
 
         // Percent-encode for application/x-www-form-urlencoded.
         // Note: spaces are encoded as %20, not plus.
@@ -120,29 +164,104 @@ namespace twitch_bot
             return out;
         }
 
+
+        // HTTP stage timings from RequestMetrics. Stages and status classes are fixed, so every
+        // series is looked up once.
+        struct HttpMetrics
+        {
+            HttpMetrics()
+            {
+                auto& r = tb::metrics::registry();
+                constexpr std::array<std::string_view, 7> stages{ "dns", "connect", "tls", "write", "ttfb", "read", "total" };
+                for (std::size_t i = 0; i < stages.size(); ++i)
+                {
+                    stage[i] = &r.histogram("tb_http_request_seconds", "Helix/OAuth request time by stage", { { "stage", stages[i] } });
+                }
+                constexpr std::array<std::string_view, 6> classes{ "other", "1xx", "2xx", "3xx", "4xx", "5xx" };
+                for (std::size_t i = 0; i < classes.size(); ++i)
+                {
+                    status[i] = &r.counter("tb_http_requests_total", "Helix/OAuth requests by status class", { { "code", classes[i] } });
+                }
+                reused = &r.counter("tb_http_connection_reuse_total", "Requests sent on a pooled connection");
+            }
+
+            void record(const http_client::client::RequestMetrics& m) noexcept
+            {
+                const std::array<std::chrono::steady_clock::duration, 7> t{ m.t_dns, m.t_connect, m.t_tls, m.t_write, m.t_ttfb, m.t_read, m.t_total };
+                for (std::size_t i = 0; i < t.size(); ++i)
+                {
+                    // Skipped stages (a reused connection has no DNS/connect/TLS) stay out of the histogram.
+                    if (t[i] != std::chrono::steady_clock::duration::zero())
+                    {
+                        stage[i]->observe(t[i]);
+                    }
+                }
+                const int cls = m.status / 100;
+                status[cls >= 1 && cls <= 5 ? cls : 0]->inc();
+                if (m.reused_connection)
+                {
+                    reused->inc();
+                }
+            }
+
+            std::array<tb::metrics::Histogram*, 7> stage{};
+            std::array<tb::metrics::Counter*, 6> status{};
+            tb::metrics::Counter* reused = nullptr;
+        };
+
+        HttpMetrics& http_metrics()
+        {
+            static HttpMetrics m;
+            return m;
+        }
     } // namespace
 
     HelixClient::HelixClient(boost::asio::any_io_executor executor,
-                             boost::asio::ssl::context& ssl_ctx,
+                             tb::net::TlsContextFactory& tls,
                              std::string_view client_id,
                              std::string_view client_secret,
                              std::string_view refresh_token) :
-        strand_{ executor }, token_expiry_{ std::chrono::steady_clock::now() }, executor_{ executor }, http_client_{ std::make_unique<http_client::client>(executor, ssl_ctx) }, client_id_{ client_id }, client_secret_{ client_secret }, refresh_token_value_(refresh_token)
+        strand_{ executor }, token_expiry_{ std::chrono::steady_clock::now() }, executor_{ executor }, http_client_{ std::make_unique<http_client::client>(executor, tls) }, client_id_{ client_id }, client_secret_{ client_secret }, refresh_token_value_(refresh_token),
+        stream_cache_{ std::make_unique<TtlCache<StreamStatus>>(executor, "helix_streams", TtlCacheOptions{ k_stream_ttl, k_stream_stale_for, k_stream_offline_ttl }) },
+        rate_limiter_{ std::make_unique<HelixRateLimiter>(executor) }
     {
         // No redirects and no cookies for OAuth and Helix JSON calls.
         http_client_->set_redirect_policy(
             tb::net::RedirectPolicy{ /*max_hops*/ 0, tb::net::RedirectMode::follow_none });
         http_client_->enable_cookies(false);
+        http_client_->set_metrics_callback([](const http_client::client::RequestMetrics& m) { http_metrics().record(m); });
+
+        // The raw client pointer, not this: HelixClient is movable and the client is not.
+        transport_ = [client = http_client_.get()](std::string_view host,
+                                                   std::string_view port,
+                                                   std::string_view target,
+                                                   http_client::http_headers headers,
+                                                   http_client::client::ResponseMeta& meta) {
+            return client->get_with_meta(host, port, target, headers, meta);
+        };
+    }
+
+    void HelixClient::set_access_token(std::string token, std::chrono::seconds expires_in)
+    {
+        token_ = std::move(token);
+        validated_at_ = std::chrono::steady_clock::now();
+        token_expiry_ = validated_at_ + expires_in;
     }
 
     HelixClient::~HelixClient() = default;
 
     // Ensure we have a valid token. Validate fast path, then refresh if needed.
-    auto HelixClient::ensure_valid_token() -> boost::asio::awaitable<void>
+    auto HelixClient::ensure_valid_token(bool force_validate) -> boost::asio::awaitable<void>
     {
         co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
 
-        const bool looks_fresh = !token_.empty() && std::chrono::steady_clock::now() < token_expiry_;
+        const auto now = std::chrono::steady_clock::now();
+        const bool looks_fresh = !token_.empty() && now < token_expiry_;
+        if (looks_fresh && !force_validate && now + k_expiry_margin < token_expiry_ && now - validated_at_ < k_revalidate_after)
+        {
+            co_return; // confirmed recently; nothing to learn from another round trip
+        }
+
         if (looks_fresh && co_await validate_token())
         {
             co_return;
@@ -183,7 +302,8 @@ namespace twitch_bot
 
             const auto& j = res.value();
             const int expires_in_s = j["expires_in"].as<int>(); // trust server view of expiry
-            token_expiry_ = std::chrono::steady_clock::now() + std::chrono::seconds{ expires_in_s };
+            validated_at_ = std::chrono::steady_clock::now();
+            token_expiry_ = validated_at_ + std::chrono::seconds{ expires_in_s };
             co_return true;
         }
         catch (...)
@@ -231,7 +351,8 @@ namespace twitch_bot
             token_ = j["access_token"].get<std::string>();
 
             const int expires = j["expires_in"].as<int>();
-            token_expiry_ = std::chrono::steady_clock::now() + std::chrono::seconds{ expires };
+            validated_at_ = std::chrono::steady_clock::now(); // freshly issued counts as validated
+            token_expiry_ = validated_at_ + std::chrono::seconds{ expires };
 
             if (persist_access_token_)
             {
@@ -251,93 +372,283 @@ namespace twitch_bot
         }
     }
 
-    // Read stream status for a channel. Validates or refreshes auth as needed.
-    auto HelixClient::get_stream_status(std::string_view channel_id)
+    // Read stream status for a channel: cache first, then the coalescer.
+    auto HelixClient::get_stream_status(std::string_view user_login)
         -> boost::asio::awaitable<std::optional<StreamStatus>>
     {
-        Expects(!channel_id.empty());
+        Expects(!user_login.empty());
 
+        std::string login = canonical_login(user_login);
+        std::string key = "streams:" + login;
+        try
+        {
+            co_return co_await stream_cache_->get(std::move(key), [this, login = std::move(login)]() { return lookup_stream_status(login); });
+        }
+        catch (...)
+        {
+            co_return std::nullopt; // no cached value to fall back on
+        }
+    }
+
+    // Throws when the batch failed, so the cache does not take the failure for "offline".
+    auto HelixClient::lookup_stream_status(std::string login)
+        -> boost::asio::awaitable<std::optional<StreamStatus>>
+    {
         co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
-        co_await ensure_valid_token();
+        stream_metrics().lookups.inc();
 
-        if (token_.empty())
+        auto waiter = std::make_shared<StatusWaiter>(strand_, std::move(login));
+        pending_status_.push_back(waiter);
+        if (pending_status_.size() >= k_streams_batch)
+        {
+            // A full batch gains nothing from waiting.
+            boost::asio::co_spawn(strand_, flush_status_waiters(), boost::asio::detached);
+        }
+        else if (!status_flush_armed_)
+        {
+            status_flush_armed_ = true;
+            boost::asio::co_spawn(
+                strand_,
+                [this]() -> boost::asio::awaitable<void> {
+                    boost::asio::steady_timer window{ strand_ };
+                    window.expires_after(k_coalesce_window);
+                    boost::system::error_code ec;
+                    co_await window.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                    status_flush_armed_ = false;
+                    co_await flush_status_waiters();
+                },
+                boost::asio::detached);
+        }
+
+        if (!waiter->ready)
+        {
+            boost::system::error_code ec;
+            co_await waiter->done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+        if (waiter->failed)
         {
-            co_return std::nullopt;
+            throw std::runtime_error("helix: stream lookup failed");
         }
+        co_return waiter->result;
+    }
 
-        auto do_request = [&]() -> boost::asio::awaitable<std::optional<StreamStatus>> {
-            std::string path;
-            path.reserve(helix_streams.target.size() + channel_id.size());
-            path = helix_streams.target;
-            path += channel_id;
+    auto HelixClient::get_stream_statuses(std::vector<std::string> user_logins)
+        -> boost::asio::awaitable<std::vector<std::optional<StreamStatus>>>
+    {
+        for (auto& login : user_logins)
+        {
+            login = canonical_login(login);
+        }
+        stream_metrics().lookups.inc(user_logins.size());
 
-            const std::string auth = "Bearer " + token_;
-            std::array<http_client::http_header, 2> hdrs{
-                { { "Client-ID", client_id_ }, { "Authorization", auth } }
-            };
-            http_client::http_headers headers{ hdrs.data(), static_cast<std::size_t>(hdrs.size()) };
+        std::vector<std::string> unique = user_logins;
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
 
-            auto res = co_await http_client_->get(helix_streams.host, helix_streams.port, path, headers);
-            if (!res)
+        StreamPages pages;
+        try
+        {
+            pages = co_await fetch_streams(unique, HelixPriority::background);
+        }
+        catch (...)
+        {
+            pages.failed.insert(unique.begin(), unique.end());
+        }
+
+        // Later single lookups for these channels are answered from the cache. Logins on a failed page
+        // read as "no live stream" here, as in the single lookup, but are not cached as offline.
+        for (auto& login : unique)
+        {
+            if (pages.failed.contains(login))
             {
-                co_return std::nullopt;
+                continue;
             }
+            auto it = pages.live.find(login);
+            co_await stream_cache_->put("streams:" + login, it != pages.live.end() ? std::optional{ it->second } : std::nullopt);
+        }
 
-            const auto& j = res.value();
+        std::vector<std::optional<StreamStatus>> out(user_logins.size());
+        for (std::size_t i = 0; i < user_logins.size(); ++i)
+        {
+            if (auto it = pages.live.find(user_logins[i]); it != pages.live.end())
+            {
+                out[i] = it->second;
+            }
+        }
+        co_return out;
+    }
 
-            if (!j["data"].holds<json::array_t>())
+    auto HelixClient::flush_status_waiters() -> boost::asio::awaitable<void>
+    {
+        auto batch = std::exchange(pending_status_, {});
+        if (batch.empty())
+        {
+            co_return; // a full batch already took them
+        }
+
+        std::vector<std::string> logins;
+        logins.reserve(batch.size());
+        for (const auto& w : batch)
+        {
+            logins.push_back(w->login);
+        }
+        std::sort(logins.begin(), logins.end());
+        logins.erase(std::unique(logins.begin(), logins.end()), logins.end());
+
+        StreamPages pages;
+        try
+        {
+            pages = co_await fetch_streams(logins, HelixPriority::interactive);
+        }
+        catch (...)
+        {
+            pages.failed.insert(logins.begin(), logins.end());
+        }
+
+        for (const auto& w : batch)
+        {
+            w->failed = pages.failed.contains(w->login);
+            if (auto it = pages.live.find(w->login); it != pages.live.end())
             {
-                co_return std::nullopt;
+                w->result = it->second;
             }
-            auto data = j["data"].get<json::array_t>();
-            if (data.empty())
+            w->ready = true;
+            w->done.cancel();
+        }
+    }
+
+    // Validates or refreshes auth once for the whole set. A page that fails marks only its own logins
+    // failed; the pages around it still count.
+    auto HelixClient::fetch_streams(std::vector<std::string> logins, HelixPriority priority)
+        -> boost::asio::awaitable<StreamPages>
+    {
+        co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
+
+        StreamPages out;
+        if (logins.empty())
+        {
+            co_return out;
+        }
+
+        co_await ensure_valid_token();
+        if (token_.empty())
+        {
+            out.failed.insert(logins.begin(), logins.end()); // no answer is not an offline answer
+            co_return out;
+        }
+
+        std::string target;
+        for (std::size_t first = 0; first < logins.size(); first += k_streams_batch)
+        {
+            const std::size_t last = std::min(logins.size(), first + k_streams_batch);
+            target = helix_streams.target;
+            for (std::size_t i = first; i < last; ++i)
             {
-                co_return std::nullopt;
+                target += "&user_login=";
+                target += form_urlencode(logins[i]);
             }
 
-            auto started = data.front()["started_at"].get<std::string>();
-            if (auto ms = parse_iso8601_ms(started))
+            bool ok = false;
+            try
             {
-                co_return StreamStatus{ true, *ms };
+                co_await fetch_streams_page(target, out.live, priority);
+                ok = true;
             }
+            catch (...)
+            {
+                stream_metrics().failed_pages.inc();
+            }
+            if (!ok)
+            {
+                out.failed.insert(logins.begin() + static_cast<std::ptrdiff_t>(first), logins.begin() + static_cast<std::ptrdiff_t>(last));
+            }
+        }
+        co_return out;
+    }
 
-            co_return std::nullopt;
+    auto HelixClient::fetch_streams_page(std::string_view target, std::unordered_map<std::string, StreamStatus>& out, HelixPriority priority)
+        -> boost::asio::awaitable<void>
+    {
+        int status = 0;
+        auto do_request = [&]() -> boost::asio::awaitable<void> {
+            stream_metrics().requests.inc();
+            auto res = co_await helix_get(helix_streams.host, helix_streams.port, target, priority, status);
+            if (!res)
+            {
+                co_return;
+            }
+
+            const auto& j = res.value();
+            if (!j["data"].holds<json::array_t>())
+            {
+                co_return;
+            }
+            // Only live streams are listed; everyone absent is offline.
+            for (const auto& stream : j["data"].get<json::array_t>())
+            {
+                if (auto ms = parse_iso8601_ms(stream["started_at"].get<std::string>()))
+                {
+                    out.insert_or_assign(stream["user_login"].get<std::string>(), StreamStatus{ true, *ms });
+                }
+            }
         };
 
-        std::optional<StreamStatus> status;
-        std::string error_msg;
         try
         {
-            status = co_await do_request();
+            co_await do_request();
+            co_return;
         }
-        catch (std::runtime_error& e)
+        catch (...)
         {
-            error_msg = e.what(); // capture status text from HTTP client
+            if (status != 401)
+            {
+                throw;
+            }
         }
-        catch (...)
+
+        // The token was rejected: retry once with a fresh one.
+        token_.clear();
+        co_await ensure_valid_token();
+        if (token_.empty())
         {
-            co_return std::nullopt;
+            throw std::runtime_error("helix: token rejected and could not be refreshed");
         }
+        co_await do_request();
+    }
 
-        if (status)
-            co_return status;
+    // Sends one Helix GET under a rate-limit point. A 429 has already told the limiter how long to
+    // hold, so acquiring again waits that out before the retry.
+    auto HelixClient::helix_get(std::string_view host, std::string_view port, std::string_view target, HelixPriority priority, int& status)
+        -> boost::asio::awaitable<http_client::result>
+    {
+        status = 0;
+        const std::string auth = "Bearer " + token_;
+        std::array<http_client::http_header, 2> hdrs{
+            { { "Client-ID", client_id_ }, { "Authorization", auth } }
+        };
+        http_client::http_headers headers{ hdrs.data(), static_cast<std::size_t>(hdrs.size()) };
 
-        // Retry once on likely auth failure.
-        if (!error_msg.empty() && error_msg.find("401") != std::string::npos)
+        for (int attempt = 0;; ++attempt)
         {
-            token_.clear();
-            co_await ensure_valid_token();
+            co_await rate_limiter_->acquire(priority);
+            http_client::client::ResponseMeta meta;
             try
             {
-                status = co_await do_request();
+                auto res = co_await transport_(host, port, target, headers, meta);
+                status = meta.status;
+                rate_limiter_->on_response(meta);
+                co_return res;
             }
             catch (...)
             {
-                status = std::nullopt;
+                status = meta.status;
+                rate_limiter_->on_response(meta);
+                if (meta.status != 429 || attempt >= k_max_429_retries)
+                {
+                    throw;
+                }
             }
         }
-
-        co_return status;
     }
 
 } // namespace twitch_bot
@@ -0,0 +1,278 @@
+/*
+Module Name:
+- helix_rate_limiter.cpp
+
+Abstract:
+- Bucket estimate, header feedback and the priority pump for HelixRateLimiter.
+
+Why:
+- Points are taken when a request is sent, and the headers on its response overwrite the estimate.
+  Other requests may still be in flight at that point, and the server may not have counted them yet,
+  so they are subtracted again. Erring low costs a little latency; erring high costs a 429.
+- The refill rate comes from the headers: (limit - remaining) points are back by Ratelimit-Reset. This
+  tracks the real bucket better than limit / window when the server's window differs from ours.
+- One pump coroutine, and only while someone is queued. The fast path takes the mutex and nothing else.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <string_view>
+
+// Boost.Asio
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Core
+#include <tb/twitch/helix_rate_limiter.hpp>
+#include <tb/utils/log.hpp>
+#include <tb/utils/metrics.hpp>
+
+namespace twitch_bot
+{
+
+    namespace
+    {
+        std::optional<std::uint64_t> header_u64(const http_client::client::ResponseMeta& meta, std::string_view name) noexcept
+        {
+            const auto v = meta.header(name);
+            std::uint64_t out = 0;
+            const auto [ptr, ec] = std::from_chars(v.data(), v.data() + v.size(), out);
+            if (v.empty() || ec != std::errc{} || ptr != v.data() + v.size())
+            {
+                return std::nullopt;
+            }
+            return out;
+        }
+
+        struct LimiterMetrics
+        {
+            tb::metrics::Gauge& remaining = tb::metrics::registry().gauge("tb_helix_ratelimit_remaining", "Helix points left, as last reported by the server");
+            tb::metrics::Gauge& queued = tb::metrics::registry().gauge("tb_helix_ratelimit_queued", "Helix requests waiting for a rate-limit point");
+            tb::metrics::Counter& throttled = tb::metrics::registry().counter("tb_helix_ratelimit_429_total", "Helix responses with status 429");
+            tb::metrics::Histogram& wait = tb::metrics::registry().histogram("tb_helix_ratelimit_wait_seconds", "Time Helix requests spent queued for a point");
+        };
+
+        LimiterMetrics& limiter_metrics()
+        {
+            static LimiterMetrics m;
+            return m;
+        }
+    } // namespace
+
+    HelixRateLimiter::HelixRateLimiter(boost::asio::any_io_executor executor, HelixRateLimiterOptions options) :
+        strand_{ boost::asio::make_strand(std::move(executor)) },
+        wake_{ strand_ },
+        options_{ options },
+        limit_{ options.limit },
+        rate_{ static_cast<double>(options.limit) / static_cast<double>(std::chrono::nanoseconds{ options.window }.count()) },
+        tokens_{ static_cast<double>(options.limit) },
+        refilled_at_{ clock::now() }
+    {
+    }
+
+    auto HelixRateLimiter::acquire(HelixPriority priority) -> boost::asio::awaitable<void>
+    {
+        std::shared_ptr<Waiter> w;
+        bool start = false;
+        {
+            std::lock_guard lk(mutex_);
+            refill_locked(clock::now());
+            if (queues_[0].empty() && queues_[1].empty() && tokens_ >= need_locked(priority))
+            {
+                take_locked();
+                co_return;
+            }
+            w = std::make_shared<Waiter>(strand_);
+            queues_[static_cast<std::size_t>(priority)].push_back(w);
+            set_queued_locked();
+            start = !std::exchange(pumping_, true);
+        }
+
+        if (start)
+        {
+            boost::asio::co_spawn(strand_, pump(), boost::asio::detached);
+        }
+        else
+        {
+            wake(); // a higher priority may now go first
+        }
+
+        const auto t0 = clock::now();
+        co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
+        if (!w->granted)
+        {
+            boost::system::error_code ec;
+            co_await w->done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+        limiter_metrics().wait.observe(clock::now() - t0);
+    }
+
+    void HelixRateLimiter::on_response(const http_client::client::ResponseMeta& meta)
+    {
+        {
+            std::lock_guard lk(mutex_);
+            in_flight_ -= (in_flight_ > 0);
+            const auto now = clock::now();
+            refill_locked(now);
+            if (meta.status == 0)
+            {
+                return; // no response: the point may or may not have been spent, so keep it spent
+            }
+
+            const auto limit = header_u64(meta, "Ratelimit-Limit");
+            const auto remaining = header_u64(meta, "Ratelimit-Remaining");
+            const auto reset = header_u64(meta, "Ratelimit-Reset"); // Unix seconds
+
+            // Ratelimit-Reset is wall-clock; pacing runs on the steady clock.
+            std::optional<clock::time_point> reset_at;
+            if (reset)
+            {
+                const auto sys_now = std::chrono::system_clock::now();
+                const auto sys_reset = std::chrono::system_clock::time_point{ std::chrono::seconds{ static_cast<std::int64_t>(*reset) } };
+                reset_at = now + std::max<clock::duration>(std::chrono::duration_cast<clock::duration>(sys_reset - sys_now), clock::duration::zero()) + options_.reset_slack;
+            }
+
+            if (limit && *limit > 0)
+            {
+                limit_ = static_cast<std::uint32_t>(std::min<std::uint64_t>(*limit, UINT32_MAX));
+                rate_ = static_cast<double>(limit_) / static_cast<double>(std::chrono::nanoseconds{ options_.window }.count());
+            }
+            if (remaining)
+            {
+                limiter_metrics().remaining.set(static_cast<std::int64_t>(*remaining));
+                tokens_ = std::min(static_cast<double>(*remaining), static_cast<double>(limit_)) - static_cast<double>(in_flight_);
+                if (reset_at && *remaining < limit_ && *reset_at > now)
+                {
+                    rate_ = static_cast<double>(limit_ - *remaining) / static_cast<double>(std::chrono::nanoseconds{ *reset_at - now }.count());
+                }
+            }
+
+            if (meta.status == 429)
+            {
+                limiter_metrics().throttled.inc();
+                tokens_ = std::min(tokens_, 0.0);
+                refilled_at_ = reset_at.value_or(now + options_.backoff_429);
+                full_after_429_ = true;
+                TB_LOG_WARN("helix", "rate limited; holding requests for {} ms",
+                            std::chrono::duration_cast<std::chrono::milliseconds>(refilled_at_ - now).count());
+            }
+        }
+        wake();
+    }
+
+    HelixRateLimitState HelixRateLimiter::state() const
+    {
+        std::lock_guard lk(mutex_);
+        return { limit_, tokens_, in_flight_, queues_[0].size() + queues_[1].size() };
+    }
+
+    void HelixRateLimiter::refill_locked(clock::time_point now) noexcept
+    {
+        if (now <= refilled_at_)
+        {
+            return;
+        }
+        if (std::exchange(full_after_429_, false))
+        {
+            tokens_ = static_cast<double>(limit_) - static_cast<double>(in_flight_);
+        }
+        else
+        {
+            tokens_ = std::min(static_cast<double>(limit_), tokens_ + rate_ * static_cast<double>(std::chrono::nanoseconds{ now - refilled_at_ }.count()));
+        }
+        refilled_at_ = now;
+    }
+
+    double HelixRateLimiter::need_locked(HelixPriority p) const noexcept
+    {
+        return p == HelixPriority::interactive ? 1.0 : 1.0 + static_cast<double>(options_.reserve);
+    }
+
+    auto HelixRateLimiter::time_to_locked(double need, clock::time_point now) const noexcept -> clock::duration
+    {
+        const clock::duration blocked = refilled_at_ > now ? refilled_at_ - now : clock::duration::zero();
+        if (full_after_429_)
+        {
+            return blocked;
+        }
+        const double deficit = std::max(need - tokens_, 0.0);
+        const auto refill = std::chrono::nanoseconds{ static_cast<std::int64_t>(deficit / rate_) + 1 };
+        return blocked + std::chrono::duration_cast<clock::duration>(refill);
+    }
+
+    void HelixRateLimiter::take_locked() noexcept
+    {
+        tokens_ -= 1.0;
+        ++in_flight_;
+    }
+
+    void HelixRateLimiter::set_queued_locked() const noexcept
+    {
+        limiter_metrics().queued.set(static_cast<std::int64_t>(queues_[0].size() + queues_[1].size()));
+    }
+
+    void HelixRateLimiter::wake() noexcept
+    {
+        try
+        {
+            // The timer is only touched on strand_; the pump re-checks state before each wait.
+            boost::asio::post(strand_, [this] { wake_.cancel(); });
+        }
+        catch (...)
+        {
+            // Posting only fails on shutdown.
+        }
+    }
+
+    // Grants points in priority order, one at a time, as the bucket allows. Higher priorities go
+    // strictly first: a background request never overtakes a waiting interactive one.
+    auto HelixRateLimiter::pump() -> boost::asio::awaitable<void>
+    {
+        for (;;)
+        {
+            std::shared_ptr<Waiter> next;
+            clock::duration wait{};
+            {
+                std::lock_guard lk(mutex_);
+                const auto now = clock::now();
+                refill_locked(now);
+                auto q = std::find_if(queues_.begin(), queues_.end(), [](const auto& d) { return !d.empty(); });
+                if (q == queues_.end())
+                {
+                    pumping_ = false;
+                    co_return;
+                }
+                const double need = need_locked(static_cast<HelixPriority>(q - queues_.begin()));
+                if (tokens_ >= need)
+                {
+                    next = std::move(q->front());
+                    q->pop_front();
+                    take_locked();
+                    set_queued_locked();
+                }
+                else
+                {
+                    wait = time_to_locked(need, now);
+                }
+            }
+
+            if (next)
+            {
+                next->granted = true;
+                next->done.cancel();
+                continue;
+            }
+
+            wake_.expires_after(wait);
+            boost::system::error_code ec;
+            co_await wake_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+    }
+
+} // namespace twitch_bot
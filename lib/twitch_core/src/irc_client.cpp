@@ -2,6 +2,9 @@
 
 // Why:
 // - Keep the ws and TLS handshakes on tight deadlines to avoid hanging connects.
+// - Race TCP endpoints (happy eyeballs) instead of trying them in turn.
+// - With a ConnectCache, reuse resolved endpoints; the TLS factory resumes the last session.
+//   A failure on cached state drops it so the next attempt starts clean.
 // - Enforce peer verification and SNI to prevent MITM.
 // - Serialise writes explicitly to avoid concurrent async writes on the WS stream.
 // - Clip and wrap chat text on UTF-8 boundaries and sanitise CR/LF to match Twitch limits.
@@ -15,7 +18,6 @@
 // Boost.Asio
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/co_spawn.hpp>
-#include <boost/asio/connect.hpp>
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/post.hpp>
 #include <boost/asio/redirect_error.hpp>
@@ -36,7 +38,10 @@
 #include <openssl/ssl.h>
 
 // Core
+#include <tb/net/tcp/happy_eyeballs.hpp>
 #include <tb/twitch/irc_client.hpp>
+#include <tb/utils/log.hpp>
+#include <tb/utils/metrics.hpp>
 
 namespace twitch_bot
 {
@@ -47,11 +52,65 @@ namespace twitch_bot
     using error_code = boost::system::error_code;
     namespace beast = boost::beast;
 
+    namespace
+    {
+        constexpr char k_host_name[] = "irc-ws.chat.twitch.tv";
+        constexpr char k_port[] = "443";
+
+        // Shared by every client; writes are rare next to reads, so one cache line is enough.
+        struct SendMetrics
+        {
+            tb::metrics::Counter& lines_out = tb::metrics::registry().counter("tb_irc_lines_sent_total", "IRC frames written");
+            tb::metrics::Histogram& queue_wait = tb::metrics::registry().histogram("tb_irc_send_queue_wait_seconds", "Wait for the write gate");
+        };
+
+        SendMetrics& send_metrics()
+        {
+            static SendMetrics m;
+            return m;
+        }
+
+        template<typename Clock>
+        std::chrono::microseconds since(typename Clock::time_point& mark) noexcept
+        {
+            const auto now = Clock::now();
+            const auto d = std::chrono::duration_cast<std::chrono::microseconds>(now - mark);
+            mark = now;
+            return d;
+        }
+    } // namespace
+
+    void log_connect_timings(std::size_t shard,
+                             std::string_view reason,
+                             std::chrono::microseconds gap,
+                             const ConnectTimings& timings,
+                             std::chrono::microseconds token_wait)
+    {
+        // Two records: the renderer takes plain "{}" only and at most eight arguments per record.
+        TB_LOG_INFO("irc_pool",
+                    "shard#{} up reason={} gap={}us token_wait={}us login={}us",
+                    shard,
+                    reason,
+                    gap.count(),
+                    token_wait.count(),
+                    timings.login.count());
+        TB_LOG_INFO("irc_pool",
+                    "shard#{} phases dns={}us{} tcp={}us tls={}us{} ws={}us",
+                    shard,
+                    timings.resolve.count(),
+                    timings.dns_cached ? " (cached)" : "",
+                    timings.tcp.count(),
+                    timings.tls.count(),
+                    timings.tls_resumed ? " (resumed)" : "",
+                    timings.ws.count());
+    }
+
     IrcClient::IrcClient(boost::asio::any_io_executor executor,
-                         boost::asio::ssl::context& ssl_context,
+                         tb::net::TlsContextFactory& tls,
                          std::string_view access_token,
-                         std::string_view control_channel) :
-        ws_stream_{ boost::asio::make_strand(executor), ssl_context }, ping_timer_{ executor }, access_token_{ access_token }, control_channel_{ control_channel }, write_gate_{ executor }
+                         std::string_view control_channel,
+                         ConnectCache* cache) :
+        ws_stream_{ executor, tls.context() }, tls_{ &tls }, ping_timer_{ executor }, access_token_{ access_token }, control_channel_{ control_channel }, cache_{ cache }, write_gate_{ executor }
     {
         // Start with an already-expired timer so waiters can block until first write completes.
         write_gate_.expires_at(std::chrono::steady_clock::time_point::max());
@@ -65,61 +124,79 @@ namespace twitch_bot
 
     auto IrcClient::connect(std::span<const std::string_view> channels) -> boost::asio::awaitable<void>
     {
-        static const char host_name[] = "irc-ws.chat.twitch.tv";
-        static const char port_str[] = "443";
-
-        auto executor = co_await boost::asio::this_coro::executor;
-
-        // DNS and TCP connect with deadlines to avoid stalls.
-        boost::asio::ip::tcp::resolver resolver{ executor };
-        auto results = co_await resolver.async_resolve(host_name, port_str, use_awaitable);
+        co_await connect_transport();
+        co_await login(channels);
+    }
 
-        auto& tcp = beast::get_lowest_layer(ws_stream_);
-        tcp.expires_after(std::chrono::seconds(30));
-        co_await tcp.async_connect(results, use_awaitable);
-        tcp.expires_never();
+    auto IrcClient::connect_transport() -> boost::asio::awaitable<void>
+    {
+        using clock = std::chrono::steady_clock;
+        const char* const host_name = k_host_name;
 
-        // Low latency socket options - Twitch chat is latency sensitive.
-        tcp.socket().set_option(boost::asio::ip::tcp::no_delay(true));
-        tcp.socket().set_option(boost::asio::socket_base::keep_alive(true));
+        timings_ = {};
+        auto mark = clock::now();
 
-        // TLS - explicitly load CA bundle and enable peer verification.
-        auto& ssl = ws_stream_.next_layer();
-        if (SSL* s = ssl.native_handle())
+        // DNS: reuse the cached result while it is fresh.
+        ConnectCache::results_type results;
+        if (auto cached = cache_ ? cache_->endpoints(host_name) : std::nullopt)
         {
-            if (SSL_CTX* ctx = ::SSL_get_SSL_CTX(s))
-            {
-                // Why: some distros or portable builds do not have a default CA path.
-                if (::SSL_CTX_load_verify_locations(ctx, TB_CACERT_PEM_PATH, nullptr) != 1)
-                {
-                    const unsigned long e = ::ERR_get_error();
-                    throw std::system_error{ static_cast<int>(e), boost::asio::error::get_ssl_category(), "failed to load CA bundle" };
-                }
-            }
-            else
-            {
-                throw std::runtime_error("SSL context unavailable");
-            }
+            results = std::move(*cached);
+            timings_.dns_cached = true;
         }
         else
         {
-            throw std::runtime_error("SSL handle unavailable");
+            boost::asio::ip::tcp::resolver resolver{ co_await boost::asio::this_coro::executor };
+            results = co_await resolver.async_resolve(host_name, k_port, use_awaitable);
+            if (cache_)
+            {
+                cache_->store_endpoints(host_name, results);
+            }
         }
+        timings_.resolve = since<clock>(mark);
 
-        // SNI + hostname verification are required for secure WS endpoints.
-        if (!::SSL_set_tlsext_host_name(ssl.native_handle(), host_name))
+        // TCP connect: race the endpoints so one dead address cannot eat the deadline.
+        auto& tcp = beast::get_lowest_layer(ws_stream_);
+        try
         {
-            throw std::system_error{ static_cast<int>(::ERR_get_error()),
-                                     boost::asio::error::get_ssl_category(),
-                                     "SNI failure" };
+            tcp.socket() = co_await tb::net::happy_eyeballs_connect(
+                tcp.get_executor(), results, cache_ ? &cache_->endpoint_history() : nullptr, { .timeout = std::chrono::seconds(30) });
+        }
+        catch (...)
+        {
+            if (cache_ && timings_.dns_cached)
+            {
+                cache_->forget_endpoints(host_name); // addresses may have moved
+            }
+            throw;
         }
-        (void)::SSL_set1_host(ssl.native_handle(), host_name);
-        ssl.set_verify_mode(boost::asio::ssl::verify_peer);
+        timings_.tcp = since<clock>(mark);
+
+        // Low latency socket options - Twitch chat is latency sensitive.
+        tcp.socket().set_option(boost::asio::ip::tcp::no_delay(true));
+        tcp.socket().set_option(boost::asio::socket_base::keep_alive(true));
+
+        // TLS policy and trust store come from the factory; per connection we only set SNI, the
+        // hostname check and offer the last session. The server falls back to a full handshake if it declines.
+        auto& ssl = ws_stream_.next_layer();
+        const bool offered = tls_->prepare(ssl.native_handle(), host_name);
 
         // TLS handshake under deadline to bound time-to-failure.
         tcp.expires_after(std::chrono::seconds(30));
-        co_await ssl.async_handshake(boost::asio::ssl::stream_base::client, use_awaitable);
+        try
+        {
+            co_await ssl.async_handshake(boost::asio::ssl::stream_base::client, use_awaitable);
+        }
+        catch (...)
+        {
+            if (offered)
+            {
+                tls_->forget_session(host_name);
+            }
+            throw;
+        }
         tcp.expires_never();
+        timings_.tls_resumed = ::SSL_session_reused(ssl.native_handle()) == 1;
+        timings_.tls = since<clock>(mark);
 
         // WebSocket settings - no auto fragmentation and strict read cap for predictable memory.
         ws_stream_.set_option(
@@ -139,6 +216,13 @@ namespace twitch_bot
 
         // IRC over WS uses text frames.
         ws_stream_.text(true);
+        timings_.ws = since<clock>(mark);
+    }
+
+    auto IrcClient::login(std::span<const std::string_view> channels) -> boost::asio::awaitable<void>
+    {
+        using clock = std::chrono::steady_clock;
+        auto mark = clock::now();
 
         // Use string_view constants so we cannot mismatch literal lengths.
         using sv = std::string_view;
@@ -146,7 +230,8 @@ namespace twitch_bot
         static constexpr sv NICK_ = "NICK ";
         static constexpr sv CAPS = "CAP REQ :twitch.tv/membership twitch.tv/tags twitch.tv/commands\r\n";
 
-        // Authenticate and request capabilities.
+        // Authenticate and request capabilities. Anonymous (justinfan) logins send no PASS.
+        if (!access_token_.empty())
         {
             std::array<const_buffer, 3> bufs_pass{ buffer(PASS_), buffer(access_token_), boost::asio::buffer(kCRLF) };
             co_await send_buffers(bufs_pass);
@@ -212,6 +297,7 @@ namespace twitch_bot
                 co_await send_buffers(bufs);
             }
         }
+        timings_.login = since<clock>(mark);
     }
 
     auto IrcClient::send_line(std::string_view message) noexcept -> boost::asio::awaitable<void>
@@ -243,19 +329,30 @@ namespace twitch_bot
     {
         try
         {
+            auto& metrics = send_metrics();
+            const auto queued_at = std::chrono::steady_clock::now();
+
             // Why: Beast WS does not allow overlapping writes. Use a timer as a simple gate
             // that writers can await without busy waiting.
-            while (write_inflight_)
             {
-                boost::system::error_code ec;
-                write_gate_.expires_at(std::chrono::steady_clock::time_point::max());
-                co_await write_gate_.async_wait(
-                    boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                TB_TRACE_SPAN("irc.send_queue");
+                while (write_inflight_)
+                {
+                    boost::system::error_code ec;
+                    write_gate_.expires_at(std::chrono::steady_clock::time_point::max());
+                    co_await write_gate_.async_wait(
+                        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                }
             }
 
             write_inflight_ = true;
-            co_await ws_stream_.async_write(buffers, boost::asio::use_awaitable);
+            metrics.queue_wait.observe(std::chrono::steady_clock::now() - queued_at);
+            {
+                TB_TRACE_SPAN("irc.ws_write");
+                co_await ws_stream_.async_write(buffers, boost::asio::use_awaitable);
+            }
             write_inflight_ = false;
+            metrics.lines_out.inc();
 
             write_gate_.cancel(); // wake one waiter
         }
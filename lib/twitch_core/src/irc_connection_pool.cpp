@@ -0,0 +1,1077 @@
+/*
+Module Name:
+- irc_connection_pool.cpp
+
+Abstract:
+- Consistent-hash placement, per-shard supervisors and membership changes for IrcConnectionPool.
+
+Why:
+- Each shard reconnects with its own jittered backoff so one failure never drops the others.
+- Membership is kept as intent under one mutex; after every connect the supervisor hands the shard's
+  channels to the JoinScheduler, so a JOIN issued while a shard is still handshaking is never lost.
+- Fresh IrcClient per connection: a closed TLS websocket cannot be reused safely.
+- The token is fetched concurrently with DNS/TCP/TLS/WS; both run on the shard executor, so the
+  hand-off needs no locking. Phase timings are logged on every connect.
+- Make-before-break swaps only once the replacement has joined every channel (or the old socket died, or the
+  handover timed out), so planned maintenance costs no lines. Until then both sockets feed handle_line
+  and the first copy of each id wins.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+
+// Boost.Asio
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Core
+#include <tb/twitch/irc_connection_pool.hpp>
+#include <tb/utils/activity.hpp>
+#include <tb/utils/log.hpp>
+#include <tb/utils/recycling_resource.hpp>
+#include <tb/utils/trace.hpp>
+
+namespace twitch_bot
+{
+
+    namespace
+    {
+        // splitmix64 finaliser. Spreads short, similar channel names across the ring.
+        constexpr std::uint64_t mix64(std::uint64_t x) noexcept
+        {
+            x += 0x9E3779B97F4A7C15ULL;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            return x ^ (x >> 31);
+        }
+
+        // FNV-1a over the name. Stable across runs so placement survives restarts.
+        std::uint64_t channel_hash(std::string_view s) noexcept
+        {
+            std::uint64_t h = 0xCBF29CE484222325ULL;
+            for (const char c : s)
+            {
+                h ^= std::uint64_t{ static_cast<unsigned char>(c) };
+                h *= 0x100000001B3ULL;
+            }
+            return mix64(h);
+        }
+
+        // Reasons are a small fixed set, so looking the series up per reconnect is fine.
+        void count_reconnect(std::string_view pool, std::string_view reason)
+        {
+            tb::metrics::registry().counter("tb_irc_reconnects_total", "IRC reconnects by reason", { { "pool", pool }, { "reason", reason } }).inc();
+        }
+
+        // say/reply never throw, so a write that goes nowhere is only visible here.
+        void count_dropped_write(std::string_view pool, std::string_view reason)
+        {
+            tb::metrics::registry().counter("tb_irc_writes_dropped_total", "say/reply lines not sent", { { "pool", pool }, { "reason", reason } }).inc();
+        }
+
+        std::uint64_t vnode_hash(std::uint64_t shard, std::uint64_t vnode) noexcept
+        {
+            return mix64((shard << 32) ^ vnode);
+        }
+
+        // Reconnect policy: exponential backoff with full jitter.
+        constexpr auto k_connect_base = std::chrono::seconds{ 3 };
+        constexpr auto k_reconnect_base = std::chrono::seconds{ 2 };
+        constexpr auto k_backoff_cap = std::chrono::seconds{ 30 };
+        constexpr auto k_min_sleep = std::chrono::milliseconds{ 150 };
+
+        // A server RECONNECT reconnects at once, unless the session it ends was this short-lived.
+        constexpr auto k_fast_reconnect_min_uptime = std::chrono::seconds{ 10 };
+
+        // Grows like base * 2^attempts, capped; randomise to avoid a thundering herd across shards.
+        std::chrono::milliseconds next_backoff(unsigned& attempts,
+                                               std::chrono::milliseconds base,
+                                               std::chrono::milliseconds cap)
+        {
+            using namespace std::chrono;
+
+            const unsigned exp = std::min<unsigned>(attempts, 16);
+            const auto grown = base * (1u << exp);
+            const auto max_d = grown > cap ? cap : grown;
+
+            static thread_local std::mt19937 rng{ std::random_device{}() };
+            std::uniform_int_distribution<long long> dist(0, duration_cast<milliseconds>(max_d).count());
+
+            ++attempts;
+            auto d = milliseconds{ dist(rng) };
+            if (d < k_min_sleep)
+            {
+                d = k_min_sleep;
+            }
+            return d;
+        }
+
+        // Twitch accepts any "justinfan<digits>" nick without PASS as a read-only login.
+        std::string anonymous_nick()
+        {
+            static thread_local std::mt19937 rng{ std::random_device{}() };
+            std::uniform_int_distribution<unsigned> dist(10000, 99999999);
+            return "justinfan" + std::to_string(dist(rng));
+        }
+    } // namespace
+
+    IrcConnectionPool::Session::Session(boost::asio::any_io_executor executor,
+                                        tb::net::TlsContextFactory& tls,
+                                        std::string_view access_token,
+                                        std::string_view login_nick,
+                                        ConnectCache& cache) :
+        client{ executor, tls, access_token, login_nick, &cache }, nick{ login_nick }, reconnect_signal{ executor }
+    {
+        reconnect_signal.expires_at(std::chrono::steady_clock::time_point::max());
+    }
+
+    IrcConnectionPool::Shard::Shard(std::string_view pool, std::size_t idx, HomeExecutor home_executor) :
+        index{ idx }, home{ std::move(home_executor) }, handover_wait{ home.executor }, backoff{ home.executor },
+        lines_in{ tb::metrics::registry().counter("tb_irc_lines_received_total", "IRC lines read", { { "pool", pool }, { "shard", std::to_string(idx) } }) },
+        parse_time{ tb::metrics::registry().histogram("tb_irc_parse_seconds", "parse_irc_line time", { { "pool", pool }, { "shard", std::to_string(idx) } }) }
+    {
+    }
+
+    IrcConnectionPool::IrcConnectionPool(Runtime& runtime,
+                                         tb::net::TlsContextFactory& tls,
+                                         std::string nick,
+                                         token_provider_t token_provider,
+                                         message_handler_t on_message,
+                                         IrcPoolOptions options) :
+        runtime_{ runtime }, tls_{ tls }, nick_{ std::move(nick) }, token_provider_{ std::move(token_provider) }, on_message_{ std::move(on_message) }, options_{ options }, connect_cache_{ options.connect },
+        joins_{ runtime.serial_executor(0).executor, [this](std::string channel) { return send_join(std::move(channel)); }, options.join }
+    {
+        std::lock_guard lk(mutex_);
+        (void)add_shard_locked(); // always at least one connection
+    }
+
+    IrcConnectionPool::~IrcConnectionPool() noexcept
+    {
+        stop();
+
+        // Supervisors hold this and their Shard until they exit. While the runtime runs they will wake,
+        // see stopping_ and leave; once it has stopped, their frames are never resumed, only destroyed.
+        std::unique_lock lk(mutex_);
+        const auto any_running = [this] { return std::any_of(shards_.begin(), shards_.end(), [](const auto& s) { return s->running; }); };
+        while (any_running() && !runtime_.stopped())
+        {
+            stopped_cv_.wait_for(lk, std::chrono::milliseconds{ 50 }); // also notices a runtime stopped meanwhile
+        }
+    }
+
+    std::size_t IrcConnectionPool::owner_of(std::string_view channel) const noexcept
+    {
+        const auto h = channel_hash(channel);
+        auto it = std::lower_bound(ring_.begin(), ring_.end(), h, [](const RingPoint& p, std::uint64_t v) { return p.hash < v; });
+        if (it == ring_.end())
+        {
+            it = ring_.begin(); // wrap around the ring
+        }
+        return it->shard;
+    }
+
+    IrcConnectionPool::Shard& IrcConnectionPool::add_shard_locked()
+    {
+        const std::size_t idx = shards_.size();
+        auto& shard = *shards_.emplace_back(std::make_unique<Shard>(options_.name, idx, runtime_.serial_executor(idx)));
+
+        const std::size_t vnodes = std::max<std::size_t>(options_.virtual_nodes, 1);
+        ring_.reserve(ring_.size() + vnodes);
+        for (std::size_t v = 0; v < vnodes; ++v)
+        {
+            ring_.push_back(RingPoint{ vnode_hash(idx, v), idx });
+        }
+        std::sort(ring_.begin(), ring_.end(), [](const RingPoint& a, const RingPoint& b) { return a.hash < b.hash; });
+
+        if (started_ && !stopping_.load(std::memory_order_relaxed))
+        {
+            spawn_shard_locked(shard);
+        }
+        return shard;
+    }
+
+    void IrcConnectionPool::grow_to_fit_locked()
+    {
+        const std::size_t per_shard = std::max<std::size_t>(options_.channels_per_shard, 1);
+        while (shards_.size() < options_.max_shards && owner_.size() > shards_.size() * per_shard)
+        {
+            (void)add_shard_locked();
+        }
+    }
+
+    void IrcConnectionPool::spawn_shard_locked(Shard& shard)
+    {
+        if (shard.running)
+        {
+            return;
+        }
+        shard.running = true;
+        boost::asio::co_spawn(shard.home.executor, run_shard(shard), boost::asio::detached);
+    }
+
+    void IrcConnectionPool::set_channels(std::vector<std::string> channels)
+    {
+        std::lock_guard lk(mutex_);
+
+        owner_.clear();
+        for (auto& s : shards_)
+        {
+            s->channels.clear();
+        }
+
+        // Size the ring first so the initial placement does not churn as the set loads.
+        owner_.reserve(channels.size());
+        for (auto& ch : channels)
+        {
+            owner_.try_emplace(std::move(ch), 0);
+        }
+        grow_to_fit_locked();
+
+        for (auto& [ch, idx] : owner_)
+        {
+            idx = owner_of(ch);
+            shards_[idx]->channels.insert(ch);
+        }
+    }
+
+    void IrcConnectionPool::start()
+    {
+        joins_.start();
+
+        std::lock_guard lk(mutex_);
+        started_ = true;
+        for (auto& s : shards_)
+        {
+            spawn_shard_locked(*s);
+        }
+    }
+
+    void IrcConnectionPool::stop() noexcept
+    {
+        stopping_.store(true, std::memory_order_relaxed);
+        joins_.stop();
+
+        try
+        {
+            std::lock_guard lk(mutex_);
+            for (auto& s : shards_)
+            {
+                // Timers belong to the shard executor; wake a supervisor out of a backoff or a handover.
+                // Only while one runs: the destructor waits for it, and so keeps the shard alive for this post.
+                if (s->running)
+                {
+                    boost::asio::post(s->home.executor, [&shard = *s] {
+                        shard.handover_wait.cancel();
+                        shard.backoff.cancel();
+                    });
+                }
+                for (auto session : { s->session, s->standby })
+                {
+                    if (!session)
+                    {
+                        continue;
+                    }
+                    // Close on the shard executor; the supervisor sees stopping_ and exits.
+                    boost::asio::post(s->home.executor, [session] {
+                        session->reconnect_reason = "shutdown";
+                        session->client.close();
+                        session->signal_reconnect();
+                    });
+                }
+            }
+        }
+        catch (...)
+        {
+            // Best effort during teardown.
+        }
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::join(std::string_view channel)
+    {
+        Shard* target = nullptr;
+        bool grew = false;
+        {
+            std::lock_guard lk(mutex_);
+            if (owner_.find(channel) != owner_.end())
+            {
+                co_return;
+            }
+
+            auto [it, _] = owner_.try_emplace(std::string{ channel }, 0);
+            const std::size_t before = shards_.size();
+            grow_to_fit_locked();
+            grew = shards_.size() != before;
+
+            it->second = owner_of(channel);
+            target = shards_[it->second].get();
+            target->channels.insert(it->first);
+        }
+
+        // A user-requested join goes ahead of any reconnect backlog.
+        joins_.enqueue(channel, true);
+
+        if (grew)
+        {
+            // New ring points took over slices of existing shards; move those channels now.
+            co_await rebalance();
+        }
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::part(std::string_view channel)
+    {
+        Shard* from = nullptr;
+        {
+            std::lock_guard lk(mutex_);
+            auto it = owner_.find(channel);
+            if (it == owner_.end())
+            {
+                co_return;
+            }
+            from = shards_[it->second].get();
+            if (auto sit = from->channels.find(channel); sit != from->channels.end())
+            {
+                from->channels.erase(sit);
+            }
+            owner_.erase(it);
+        }
+
+        joins_.forget(channel);
+        co_await send_part(*from, std::string{ channel });
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::rebalance()
+    {
+        struct Move
+        {
+            Shard* from;
+            Shard* to;
+            std::string channel;
+        };
+
+        std::vector<Move> moves;
+        {
+            std::lock_guard lk(mutex_);
+            for (auto& [ch, idx] : owner_)
+            {
+                const std::size_t want = owner_of(ch);
+                if (want == idx)
+                {
+                    continue;
+                }
+                Shard* from = shards_[idx].get();
+                Shard* to = shards_[want].get();
+                if (auto sit = from->channels.find(ch); sit != from->channels.end())
+                {
+                    from->channels.erase(sit);
+                }
+                to->channels.insert(ch);
+                idx = want;
+                moves.push_back(Move{ from, to, ch });
+            }
+        }
+
+        // Part before join so a command is never seen twice by the dispatcher.
+        // The scheduler resolves the new owner when the slot comes up.
+        for (auto& m : moves)
+        {
+            co_await send_part(*m.from, m.channel);
+            joins_.enqueue(m.channel);
+        }
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::add_shard()
+    {
+        {
+            std::lock_guard lk(mutex_);
+            if (shards_.size() >= options_.max_shards)
+            {
+                co_return;
+            }
+            (void)add_shard_locked();
+        }
+        co_await rebalance();
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::send_part(Shard& shard, std::string channel)
+    {
+        std::shared_ptr<Session> session;
+        std::shared_ptr<Session> standby;
+        {
+            std::lock_guard lk(mutex_);
+            session = shard.session;
+            standby = shard.standby;
+        }
+        if (!session && !standby)
+        {
+            co_return; // nothing joined on a disconnected shard
+        }
+
+        // During a handover the channel may be joined on both connections.
+        co_await boost::asio::co_spawn(
+            shard.home.executor,
+            [&shard, session, standby, channel = std::move(channel)]() -> boost::asio::awaitable<void> {
+                for (auto* s : { session.get(), standby.get() })
+                {
+                    if (s)
+                    {
+                        co_await s->client.part(channel);
+                    }
+                }
+                if (standby)
+                {
+                    shard.handover_wait.cancel(); // the standby may now carry every remaining channel
+                }
+            },
+            boost::asio::use_awaitable);
+    }
+
+    boost::asio::awaitable<bool> IrcConnectionPool::send_join(std::string channel)
+    {
+        Shard* shard = nullptr;
+        std::shared_ptr<Session> session;
+        {
+            std::lock_guard lk(mutex_);
+            auto it = owner_.find(channel);
+            if (it == owner_.end())
+            {
+                co_return true; // parted while queued; nothing to send
+            }
+            shard = shards_[it->second].get();
+            session = shard->standby ? shard->standby : shard->session; // joins go to the connection that will stay
+        }
+        if (!session)
+        {
+            co_return false; // the shard re-enqueues its channels once connected
+        }
+
+        co_await boost::asio::co_spawn(
+            shard->home.executor,
+            [session, channel = std::move(channel)]() -> boost::asio::awaitable<void> { co_await session->client.join(channel); },
+            boost::asio::use_awaitable);
+        co_return true;
+    }
+
+    void IrcConnectionPool::enqueue_joins(Shard& shard)
+    {
+        std::vector<std::string> channels;
+        {
+            std::lock_guard lk(mutex_);
+            channels.assign(shard.channels.begin(), shard.channels.end());
+        }
+        for (const auto& ch : channels)
+        {
+            joins_.enqueue(ch);
+        }
+    }
+
+    void IrcConnectionPool::park_joins(Shard& shard)
+    {
+        std::vector<std::string> channels;
+        {
+            std::lock_guard lk(mutex_);
+            channels.assign(shard.channels.begin(), shard.channels.end());
+        }
+        for (const auto& ch : channels)
+        {
+            joins_.park(ch);
+        }
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::say(std::string_view channel, std::string_view text)
+    {
+        co_await reply(channel, {}, text);
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::reply(std::string_view channel,
+                                                          std::string_view parent_msg_id,
+                                                          std::string_view text)
+    {
+        if (options_.anonymous)
+        {
+            count_dropped_write(options_.name, "anonymous");
+            co_return; // read-only login; writes belong on an authenticated pool
+        }
+
+        Shard* shard = nullptr;
+        std::shared_ptr<Session> session;
+        {
+            std::lock_guard lk(mutex_);
+            auto it = owner_.find(channel);
+            shard = shards_[it != owner_.end() ? it->second : owner_of(channel)].get();
+            session = shard->session;
+        }
+        if (!session)
+        {
+            count_dropped_write(options_.name, "disconnected");
+            co_return; // disconnected; dropping matches the no-throw send contract
+        }
+
+        // Views stay valid: the caller awaits completion.
+        co_await boost::asio::co_spawn(
+            shard->home.executor,
+            [session, channel, parent_msg_id, text]() -> boost::asio::awaitable<void> {
+                co_await session->client.reply_wrap(channel, parent_msg_id, text);
+            },
+            boost::asio::use_awaitable);
+    }
+
+    std::size_t IrcConnectionPool::shard_count() const
+    {
+        std::lock_guard lk(mutex_);
+        return shards_.size();
+    }
+
+    std::size_t IrcConnectionPool::channel_count() const
+    {
+        std::lock_guard lk(mutex_);
+        return owner_.size();
+    }
+
+    JoinProgress IrcConnectionPool::join_progress() const
+    {
+        return joins_.progress();
+    }
+
+    std::optional<std::size_t> IrcConnectionPool::shard_of(std::string_view channel) const
+    {
+        std::lock_guard lk(mutex_);
+        auto it = owner_.find(channel);
+        if (it == owner_.end())
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void IrcConnectionPool::wake_handover_if_joined(Shard& shard, const Session& session)
+    {
+        std::lock_guard lk(mutex_);
+        if (session.joined.size() < shard.channels.size())
+        {
+            return; // cheap reject while most joins are still outstanding
+        }
+        for (const auto& ch : shard.channels)
+        {
+            if (!session.joined.contains(ch))
+            {
+                return;
+            }
+        }
+        shard.handover_wait.cancel();
+    }
+
+    bool IrcConnectionPool::is_join_target(const Shard& shard, const Session& session) const
+    {
+        std::lock_guard lk(mutex_);
+        const auto& target = shard.standby ? shard.standby : shard.session; // as in send_join
+        return target.get() == &session;
+    }
+
+    void IrcConnectionPool::handle_line(Shard& shard, Session& session, std::string_view raw)
+    {
+        const tb::activity::Scope activity{ "irc.handle_line" };
+        // Raw lines are opt-in and sampled; logging every line used to dominate CPU in busy channels.
+        if (tb::log::sample_raw())
+        {
+            TB_LOG_DEBUG("irc", "shard#{} raw {}", shard.index, raw);
+        }
+        shard.lines_in.inc();
+        const auto parse_start = std::chrono::steady_clock::now();
+        IrcMessage msg;
+        {
+            TB_TRACE_SPAN("irc.parse");
+            msg = parse_irc_line(raw);
+        }
+        shard.parse_time.observe(std::chrono::steady_clock::now() - parse_start);
+
+        if (msg.command() == "PING")
+        {
+            // Reply with PONG on the connection that was pinged; keep payload as-is.
+            // Payload and spawn state come from the per-thread pool, so a PING costs no malloc.
+            std::pmr::string payload{ msg.trailing(), tb::memory::recycling_allocator() };
+            boost::asio::co_spawn(
+                shard.home.executor,
+                [s = session.shared_from_this(), payload = std::move(payload)]() -> boost::asio::awaitable<void> {
+                    std::array<boost::asio::const_buffer, 4> bufs{
+                        boost::asio::buffer("PONG ", 5),
+                        boost::asio::buffer(":", 1),
+                        boost::asio::buffer(payload),
+                        boost::asio::buffer("\r\n", 2)
+                    };
+                    co_await s->client.send_buffers(bufs);
+                },
+                boost::asio::bind_allocator(tb::memory::recycling_allocator(), boost::asio::detached));
+            return;
+        }
+
+        // Our own JOIN echo or the ROOMSTATE that follows it confirms a join.
+        if (msg.command() == "ROOMSTATE" || (msg.command() == "JOIN" && msg.prefix().substr(0, msg.prefix().find('!')) == session.nick))
+        {
+            if (msg.param_count() != 0)
+            {
+                auto ch = msg.param(0);
+                ch = !ch.empty() && ch.front() == '#' ? ch.substr(1) : ch;
+                if (is_join_target(shard, session))
+                {
+                    joins_.confirm(ch);
+                }
+                if (session.joined.find(ch) == session.joined.end())
+                {
+                    session.joined.emplace(ch);
+                    if (session.replacement)
+                    {
+                        wake_handover_if_joined(shard, session);
+                    }
+                }
+            }
+        }
+        else if (msg.command() == "PART" && msg.param_count() != 0 && msg.prefix().substr(0, msg.prefix().find('!')) == session.nick)
+        {
+            auto ch = msg.param(0);
+            if (auto it = session.joined.find(!ch.empty() && ch.front() == '#' ? ch.substr(1) : ch); it != session.joined.end())
+            {
+                session.joined.erase(it);
+            }
+        }
+
+        if (msg.command() == "RECONNECT")
+        {
+            // With make-before-break the old socket keeps reading until its replacement is joined.
+            session.reconnect_reason = "server-reconnect";
+            if (!options_.make_before_break)
+            {
+                session.client.close();
+            }
+            session.signal_reconnect();
+            return;
+        }
+
+        if (msg.command() == "NOTICE")
+        {
+            // Auth errors: reconnect this shard; the next connect forces token revalidation.
+            auto id = msg.get_tag("msg-id");
+            if (id == "msg_auth_failed" || msg.trailing() == "Login authentication failed" || msg.trailing() == "Improperly formatted auth")
+            {
+                session.reconnect_reason = "auth-fail";
+                session.client.close();
+                session.signal_reconnect();
+                return;
+            }
+        }
+
+        if (msg.command() == "CAP" && msg.param_count() >= 2)
+        {
+            auto sub = msg.param(1); // "ACK" / "NAK"
+            if (sub == "ACK")
+            {
+                TB_LOG_INFO("irc", "shard#{} CAP ACK {}", shard.index, msg.trailing());
+            }
+            else if (sub == "NAK")
+            {
+                TB_LOG_WARN("irc", "shard#{} CAP NAK {} (tags/commands/membership may be unavailable)", shard.index, msg.trailing());
+            }
+            return;
+        }
+
+        // During and shortly after a handover both sockets may carry the same line.
+        if (shard.dedupe_until != std::chrono::steady_clock::time_point{} && std::chrono::steady_clock::now() < shard.dedupe_until)
+        {
+            if (auto id = msg.get_tag("id"); !id.empty() && !shard.recent.insert(id))
+            {
+                ++shard.duplicates;
+                return;
+            }
+        }
+
+        on_message_(std::move(msg));
+    }
+
+    boost::asio::awaitable<std::shared_ptr<IrcConnectionPool::Session>> IrcConnectionPool::open_session(Shard& shard, bool revalidate)
+    {
+        const auto& executor = shard.home.executor;
+
+        // No JOINs at login: the scheduler paces them to the account limit.
+        if (options_.anonymous)
+        {
+            auto session = std::make_shared<Session>(executor, tls_, std::string_view{}, anonymous_nick(), connect_cache_);
+            co_await session->client.connect({});
+            co_return session;
+        }
+
+        // Token result handed from the fetch coroutine to this one. Both run on the shard executor.
+        struct PendingToken
+        {
+            explicit PendingToken(const boost::asio::any_io_executor& ex) :
+                done{ ex }
+            {
+                done.expires_at(std::chrono::steady_clock::time_point::max());
+            }
+
+            boost::asio::steady_timer done; // cancelled when ready
+            std::string token;
+            std::exception_ptr error;
+            bool ready = false;
+        };
+
+        auto pending = std::make_shared<PendingToken>(executor);
+        boost::asio::co_spawn(executor, token_provider_(revalidate), [pending](std::exception_ptr e, std::string token) {
+            pending->error = e;
+            pending->token = std::move(token);
+            pending->ready = true;
+            pending->done.cancel();
+        });
+
+        auto session = std::make_shared<Session>(executor, tls_, std::string_view{}, nick_, connect_cache_);
+        co_await session->client.connect_transport();
+
+        const auto waited_from = std::chrono::steady_clock::now();
+        if (!pending->ready)
+        {
+            boost::system::error_code ec;
+            co_await pending->done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+        session->token_wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - waited_from);
+        if (pending->error)
+        {
+            std::rethrow_exception(pending->error);
+        }
+
+        session->client.set_access_token(pending->token);
+        co_await session->client.login({});
+        co_return session;
+    }
+
+    void IrcConnectionPool::start_io(Shard& shard, const std::shared_ptr<Session>& session)
+    {
+        // Keep the link alive.
+        boost::asio::co_spawn(
+            shard.home.executor,
+            [session]() noexcept -> boost::asio::awaitable<void> { co_await session->client.ping_loop(); },
+            boost::asio::detached);
+
+        // Read loop and routing. Holds the session so the socket outlives the loop.
+        boost::asio::co_spawn(
+            shard.home.executor,
+            [this, &shard, session]() noexcept -> boost::asio::awaitable<void> {
+                try
+                {
+                    co_await session->client.read_loop(
+                        [this, &shard, s = session.get()](std::string_view raw) { handle_line(shard, *s, raw); });
+                }
+                catch (...)
+                {
+                    if (session->reconnect_reason.empty())
+                    {
+                        session->reconnect_reason = "read-error";
+                    }
+                    session->reading = false;
+                    session->signal_reconnect();
+                    shard.handover_wait.cancel(); // a handover stops waiting on a dead socket
+                }
+                co_return;
+            },
+            boost::asio::detached);
+    }
+
+    boost::asio::awaitable<std::shared_ptr<IrcConnectionPool::Session>>
+    IrcConnectionPool::hand_over(Shard& shard, std::shared_ptr<Session> old)
+    {
+        const auto started = std::chrono::steady_clock::now();
+
+        TB_LOG_INFO("irc_pool", "shard#{} RECONNECT: joining a replacement before closing", shard.index);
+
+        std::shared_ptr<Session> next;
+        try
+        {
+            next = co_await open_session(shard, false);
+        }
+        catch (const std::exception& e)
+        {
+            TB_LOG_WARN("irc_pool", "shard#{} replacement connect failed: {}", shard.index, e.what());
+            co_return nullptr;
+        }
+
+        begin_handover(shard, next, started);
+        start_io(shard, next);
+        enqueue_joins(shard); // send_join routes these to the standby
+        co_return co_await finish_handover(shard, std::move(old), std::move(next), started);
+    }
+
+    void IrcConnectionPool::begin_handover(Shard& shard, const std::shared_ptr<Session>& next, std::chrono::steady_clock::time_point started)
+    {
+        shard.recent.clear();
+        shard.duplicates = 0;
+        shard.dedupe_until = std::chrono::steady_clock::time_point::max();
+        {
+            std::lock_guard lk(mutex_);
+            shard.standby = next;
+        }
+
+        // The timer runs to the deadline, which finish_handover moves while joins still land; a confirm
+        // that completes the set, a part, a dead socket or stop() cancels it early.
+        next->replacement = true;
+        shard.handover_wait.expires_at(started + options_.handover_timeout);
+    }
+
+    std::chrono::steady_clock::duration IrcConnectionPool::join_backlog_time() const
+    {
+        const auto pending = joins_.backlog();
+        if (pending == 0)
+        {
+            return {};
+        }
+        const auto& j = options_.join;
+        const auto windows = (pending + std::max<std::size_t>(j.join_limit, 1) - 1) / std::max<std::size_t>(j.join_limit, 1);
+        return static_cast<long>(windows) * (j.window + j.window_slack) + j.confirm_timeout;
+    }
+
+    boost::asio::awaitable<std::shared_ptr<IrcConnectionPool::Session>>
+    IrcConnectionPool::finish_handover(Shard& shard, std::shared_ptr<Session> old, std::shared_ptr<Session> next, std::chrono::steady_clock::time_point started)
+    {
+        using namespace std::chrono;
+
+        // Wait until the replacement carries every channel. Its joins queue behind every other shard's
+        // in the account-wide scheduler, and a RECONNECT to all shards at once puts thousands there, so
+        // the deadline follows that backlog rather than a constant. At the deadline it moves on while the
+        // replacement still gains channels; a join stuck past its retries no longer holds the swap.
+        std::size_t want = 0;
+        std::size_t have = 0;
+        const auto count = [&] {
+            std::lock_guard lk(mutex_);
+            want = shard.channels.size();
+            have = 0;
+            for (const auto& ch : shard.channels)
+            {
+                have += next->joined.contains(ch) ? 1u : 0u;
+            }
+        };
+        count();
+        auto deadline = std::max(started + options_.handover_timeout, steady_clock::now() + join_backlog_time());
+        std::size_t have_at_deadline = have;
+        for (;;)
+        {
+            if (have >= want || !old->reading || !next->reading || stopping_.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            const auto now = steady_clock::now();
+            if (now >= deadline)
+            {
+                if (have == have_at_deadline)
+                {
+                    break;
+                }
+                have_at_deadline = have;
+                deadline = now + std::max(join_backlog_time(), steady_clock::duration{ options_.join.confirm_timeout });
+            }
+            if (shard.handover_wait.expiry() != deadline)
+            {
+                shard.handover_wait.expires_at(deadline);
+            }
+            boost::system::error_code ec;
+            co_await shard.handover_wait.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            count();
+        }
+        next->replacement = false;
+
+        const bool usable = next->reading && !stopping_.load(std::memory_order_relaxed);
+        std::vector<std::string> missing;
+        {
+            std::lock_guard lk(mutex_);
+            shard.standby.reset();
+            if (usable)
+            {
+                shard.session = next;
+                for (const auto& ch : shard.channels)
+                {
+                    if (!next->joined.contains(ch))
+                    {
+                        missing.push_back(ch);
+                    }
+                }
+            }
+        }
+        if (!usable)
+        {
+            shard.dedupe_until = {};
+            next->client.close();
+            TB_LOG_WARN("irc_pool", "shard#{} replacement lost during handover", shard.index);
+            co_return nullptr;
+        }
+
+        // Swapped early (no progress by the deadline, or the old socket died): whatever the scheduler believes about the
+        // rest, the new connection has not joined them, so queue them again rather than wait for a reconnect.
+        for (const auto& ch : missing)
+        {
+            joins_.enqueue(ch);
+        }
+
+        // The old socket may still deliver lines already read; keep dropping repeats briefly.
+        shard.dedupe_until = steady_clock::now() + seconds{ 5 };
+        old->client.close();
+
+        TB_LOG_INFO("irc_pool",
+                    "shard#{} handed over in {}ms joined={}/{} requeued={} duplicates={}{}",
+                    shard.index,
+                    duration_cast<milliseconds>(steady_clock::now() - started).count(),
+                    have,
+                    want,
+                    missing.size(),
+                    shard.duplicates,
+                    old->reading ? "" : " (old socket closed first)");
+        co_return next;
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::run_shard(Shard& shard)
+    {
+        using namespace std::chrono;
+
+        unsigned connect_attempts = 0;
+        unsigned reconnect_attempts = 0;
+        bool revalidate = false; // the server rejected the last token
+        std::string last_reason = "initial";
+        auto down_since = steady_clock::now();
+
+        while (!stopping_.load(std::memory_order_relaxed))
+        {
+            std::shared_ptr<Session> session;
+            bool connected = false;
+            try
+            {
+                session = co_await open_session(shard, revalidate);
+                connected = true;
+            }
+            catch (const std::exception& e)
+            {
+                TB_LOG_ERROR("irc_pool", "shard#{} connect error: {}", shard.index, e.what());
+            }
+            if (!connected)
+            {
+                count_reconnect(options_.name, "connect-error");
+                const auto delay = next_backoff(connect_attempts,
+                                                duration_cast<milliseconds>(k_connect_base),
+                                                duration_cast<milliseconds>(k_backoff_cap));
+                TB_LOG_INFO("irc_pool", "shard#{} backoff#{} reason=connect-error sleep={}ms", shard.index, connect_attempts, delay.count());
+                co_await sleep_backoff(shard, delay);
+                continue;
+            }
+
+            // Connected: reset counters.
+            connect_attempts = 0;
+            reconnect_attempts = 0;
+            revalidate = false;
+
+            log_connect_timings(shard.index,
+                                last_reason,
+                                duration_cast<microseconds>(steady_clock::now() - down_since),
+                                session->client.connect_timings(),
+                                session->token_wait);
+
+            // Publish the session, then queue every channel the shard owns now.
+            {
+                std::lock_guard lk(mutex_);
+                shard.session = session;
+            }
+            enqueue_joins(shard);
+            start_io(shard, session);
+
+            auto up_since = steady_clock::now();
+            for (;;)
+            {
+                if (!session->signalled)
+                {
+                    boost::system::error_code ec;
+                    co_await session->reconnect_signal.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                    if (!session->signalled)
+                    {
+                        continue; // woken by something other than signal_reconnect()
+                    }
+                }
+
+                if (!options_.make_before_break || session->reconnect_reason != "server-reconnect" || stopping_.load(std::memory_order_relaxed))
+                {
+                    break;
+                }
+                auto next = co_await hand_over(shard, session);
+                if (!next)
+                {
+                    break; // fall back to break-then-make below
+                }
+                count_reconnect(options_.name, "handover");
+                session = std::move(next);
+                up_since = steady_clock::now();
+            }
+
+            {
+                std::lock_guard lk(mutex_);
+                shard.session.reset();
+            }
+            park_joins(shard);
+
+            // Close only this shard's connection before backing off and retrying.
+            session->client.close();
+
+            if (stopping_.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+
+            last_reason = session->reconnect_reason.empty() ? std::string{ "unknown" } : session->reconnect_reason;
+            revalidate = last_reason == "auth-fail";
+            down_since = steady_clock::now();
+            count_reconnect(options_.name, last_reason);
+
+            // Twitch is moving us off a healthy server: every moment spent backing off is missed chat.
+            if (last_reason == "server-reconnect" && down_since - up_since >= k_fast_reconnect_min_uptime)
+            {
+                TB_LOG_INFO("irc_pool", "shard#{} reason=server-reconnect reconnecting now", shard.index);
+                continue;
+            }
+
+            const auto delay = next_backoff(reconnect_attempts,
+                                            duration_cast<milliseconds>(k_reconnect_base),
+                                            duration_cast<milliseconds>(k_backoff_cap));
+            TB_LOG_INFO("irc_pool",
+                        "shard#{} backoff#{} reason={} sleep={}ms",
+                        shard.index,
+                        reconnect_attempts,
+                        last_reason,
+                        delay.count());
+
+            co_await sleep_backoff(shard, delay);
+            // loop and reconnect
+        }
+
+        supervisor_exited(shard);
+    }
+
+    void IrcConnectionPool::supervisor_exited(Shard& shard)
+    {
+        {
+            std::lock_guard lk(mutex_);
+            shard.running = false;
+        }
+        stopped_cv_.notify_all();
+    }
+
+    boost::asio::awaitable<void> IrcConnectionPool::sleep_backoff(Shard& shard, std::chrono::milliseconds delay)
+    {
+        // Checked here as well: a stop() posted before this wait began has already run its cancel.
+        if (stopping_.load(std::memory_order_relaxed))
+        {
+            co_return;
+        }
+        shard.backoff.expires_after(delay);
+        boost::system::error_code ec; // cancelled by stop(); the loop condition ends the supervisor
+        co_await shard.backoff.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+
+} // namespace twitch_bot
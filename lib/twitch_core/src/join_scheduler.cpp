@@ -0,0 +1,299 @@
+/*
+Module Name:
+- join_scheduler.cpp
+
+Abstract:
+- Sliding-window JOIN pacing, confirmation deadlines and retry bookkeeping for JoinScheduler.
+
+Why:
+- A sliding log of send times is exact for a "N per window" limit, unlike a refilling bucket that can
+  briefly allow 2N across a window edge.
+- One pacing coroutine on a private strand; state lives under a mutex so shard strands never wait on it.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+
+// Boost.Asio
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Core
+#include <tb/twitch/join_scheduler.hpp>
+#include <tb/utils/log.hpp>
+
+namespace twitch_bot
+{
+
+    JoinScheduler::JoinScheduler(boost::asio::any_io_executor serial, sender_t sender, JoinSchedulerOptions options) :
+        strand_{ std::move(serial) }, wake_{ strand_ }, sender_{ std::move(sender) }, options_{ options }
+    {
+    }
+
+    void JoinScheduler::start()
+    {
+        std::lock_guard lk(mutex_);
+        if (started_)
+        {
+            return;
+        }
+        started_ = true;
+        boost::asio::co_spawn(strand_, run(), boost::asio::detached);
+    }
+
+    void JoinScheduler::stop() noexcept
+    {
+        {
+            std::lock_guard lk(mutex_);
+            stopping_ = true;
+        }
+        wake();
+    }
+
+    void JoinScheduler::wake() noexcept
+    {
+        try
+        {
+            // The timer is only touched on strand_; the loop re-checks state before each wait.
+            boost::asio::post(strand_, [this] { wake_.cancel(); });
+        }
+        catch (...)
+        {
+            // Posting only fails on shutdown.
+        }
+    }
+
+    void JoinScheduler::set_state_locked(Entry& e, State s) noexcept
+    {
+        --counts_[static_cast<std::size_t>(e.state)];
+        ++counts_[static_cast<std::size_t>(s)];
+        e.state = s;
+    }
+
+    void JoinScheduler::enqueue(std::string_view channel, bool urgent)
+    {
+        {
+            std::lock_guard lk(mutex_);
+            const auto now = clock::now();
+            if (counts_[static_cast<std::size_t>(State::queued)] + counts_[static_cast<std::size_t>(State::sent)] == 0)
+            {
+                burst_start_ = now; // a new burst starts from idle
+            }
+
+            auto it = entries_.find(channel);
+            if (it == entries_.end())
+            {
+                it = entries_.emplace(std::string{ channel }, Entry{}).first;
+                ++counts_[static_cast<std::size_t>(State::parked)];
+            }
+            it->second.attempts = 0;
+            set_state_locked(it->second, State::queued);
+
+            if (urgent)
+            {
+                queue_.push_front(it->first);
+            }
+            else
+            {
+                queue_.push_back(it->first);
+            }
+        }
+        wake();
+    }
+
+    void JoinScheduler::park(std::string_view channel)
+    {
+        std::lock_guard lk(mutex_);
+        if (auto it = entries_.find(channel); it != entries_.end())
+        {
+            set_state_locked(it->second, State::parked);
+            settle_check_locked(clock::now());
+        }
+    }
+
+    void JoinScheduler::confirm(std::string_view channel)
+    {
+        std::lock_guard lk(mutex_);
+        auto it = entries_.find(channel);
+        if (it == entries_.end() || it->second.state == State::confirmed)
+        {
+            return;
+        }
+        set_state_locked(it->second, State::confirmed);
+        settle_check_locked(clock::now());
+    }
+
+    void JoinScheduler::forget(std::string_view channel)
+    {
+        std::lock_guard lk(mutex_);
+        if (auto it = entries_.find(channel); it != entries_.end())
+        {
+            --counts_[static_cast<std::size_t>(it->second.state)];
+            entries_.erase(it);
+            settle_check_locked(clock::now());
+        }
+    }
+
+    JoinProgress JoinScheduler::progress() const
+    {
+        std::lock_guard lk(mutex_);
+        JoinProgress p;
+        p.pending = counts_[static_cast<std::size_t>(State::parked)] + counts_[static_cast<std::size_t>(State::queued)] + counts_[static_cast<std::size_t>(State::sent)];
+        p.confirmed = counts_[static_cast<std::size_t>(State::confirmed)];
+        p.failed = counts_[static_cast<std::size_t>(State::failed)];
+        p.last_settle = last_settle_;
+        return p;
+    }
+
+    std::size_t JoinScheduler::backlog() const
+    {
+        std::lock_guard lk(mutex_);
+        return counts_[static_cast<std::size_t>(State::queued)] + counts_[static_cast<std::size_t>(State::sent)];
+    }
+
+    void JoinScheduler::expire_locked(clock::time_point now)
+    {
+        while (!inflight_.empty() && inflight_.front().deadline <= now)
+        {
+            auto node = std::move(inflight_.front());
+            inflight_.pop_front();
+
+            auto it = entries_.find(node.channel);
+            if (it == entries_.end() || it->second.state != State::sent || it->second.deadline != node.deadline)
+            {
+                continue; // confirmed, parted or re-sent since
+            }
+
+            if (it->second.attempts < options_.max_attempts)
+            {
+                set_state_locked(it->second, State::queued);
+                queue_.push_back(it->first);
+            }
+            else
+            {
+                set_state_locked(it->second, State::failed);
+                TB_LOG_WARN("joins", "#{} unconfirmed after {} attempts", it->first, it->second.attempts);
+            }
+        }
+        settle_check_locked(now);
+    }
+
+    void JoinScheduler::settle_check_locked(clock::time_point now)
+    {
+        if (burst_start_ == clock::time_point{})
+        {
+            return;
+        }
+        if (counts_[static_cast<std::size_t>(State::queued)] + counts_[static_cast<std::size_t>(State::sent)] != 0)
+        {
+            return;
+        }
+
+        last_settle_ = std::chrono::duration_cast<std::chrono::milliseconds>(now - burst_start_);
+        burst_start_ = {};
+        TB_LOG_INFO("joins",
+                    "settled in {}ms confirmed={} failed={}",
+                    last_settle_.count(),
+                    counts_[static_cast<std::size_t>(State::confirmed)],
+                    counts_[static_cast<std::size_t>(State::failed)]);
+    }
+
+    boost::asio::awaitable<void> JoinScheduler::run()
+    {
+        const auto window = options_.window + options_.window_slack;
+        const std::size_t limit = std::max<std::size_t>(options_.join_limit, 1);
+
+        for (;;)
+        {
+            std::string channel;
+            auto wait_until = clock::time_point::max();
+            {
+                std::lock_guard lk(mutex_);
+                if (stopping_)
+                {
+                    co_return;
+                }
+
+                const auto now = clock::now();
+                expire_locked(now);
+
+                while (!sent_at_.empty() && now - sent_at_.front() >= window)
+                {
+                    sent_at_.pop_front();
+                }
+
+                // Skip names that were confirmed, parked or parted after being queued.
+                while (!queue_.empty())
+                {
+                    auto it = entries_.find(queue_.front());
+                    if (it != entries_.end() && it->second.state == State::queued)
+                    {
+                        break;
+                    }
+                    queue_.pop_front();
+                }
+
+                if (!queue_.empty())
+                {
+                    if (sent_at_.size() < limit)
+                    {
+                        channel = std::move(queue_.front());
+                        queue_.pop_front();
+
+                        auto& e = entries_.find(channel)->second;
+                        ++e.attempts;
+                        e.deadline = now + options_.confirm_timeout;
+                        set_state_locked(e, State::sent);
+                        inflight_.push_back(Inflight{ e.deadline, channel });
+                        sent_at_.push_back(now);
+                    }
+                    else
+                    {
+                        wait_until = sent_at_.front() + window; // next free slot
+                    }
+                }
+                if (channel.empty() && !inflight_.empty())
+                {
+                    wait_until = std::min(wait_until, inflight_.front().deadline);
+                }
+            }
+
+            if (!channel.empty())
+            {
+                bool sent = false;
+                try
+                {
+                    sent = co_await sender_(channel);
+                }
+                catch (...)
+                {
+                    sent = false;
+                }
+                if (!sent)
+                {
+                    // Slot stays spent: the server may still have counted it.
+                    std::lock_guard lk(mutex_);
+                    if (auto it = entries_.find(channel); it != entries_.end() && it->second.state == State::sent)
+                    {
+                        set_state_locked(it->second, State::parked);
+                    }
+                }
+                continue;
+            }
+
+            // No suspension between the state check above and this wait, so a posted wake() is never lost.
+            wake_.expires_at(wait_until);
+            try
+            {
+                co_await wake_.async_wait(boost::asio::use_awaitable);
+            }
+            catch (...)
+            {
+                // Woken by enqueue() or stop().
+            }
+        }
+    }
+
+} // namespace twitch_bot
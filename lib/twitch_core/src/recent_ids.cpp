@@ -0,0 +1,41 @@
+/*
+Module Name:
+- recent_ids.cpp
+
+Abstract:
+- Insert and eviction for RecentIds.
+*/
+
+// Core
+#include <tb/twitch/recent_ids.hpp>
+
+namespace twitch_bot
+{
+
+    RecentIds::RecentIds(std::size_t capacity) :
+        capacity_{ capacity == 0 ? 1 : capacity }
+    {
+    }
+
+    bool RecentIds::insert(std::string_view id)
+    {
+        if (ids_.find(id) != ids_.end())
+        {
+            return false;
+        }
+        if (order_.size() >= capacity_)
+        {
+            ids_.erase(ids_.find(order_.front()));
+            order_.pop_front();
+        }
+        order_.push_back(*ids_.emplace(id).first);
+        return true;
+    }
+
+    void RecentIds::clear() noexcept
+    {
+        order_.clear();
+        ids_.clear();
+    }
+
+} // namespace twitch_bot
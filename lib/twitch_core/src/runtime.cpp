@@ -0,0 +1,286 @@
+/*
+Module Name:
+- runtime.cpp
+
+Abstract:
+- Thread pool or io_context-per-core startup, CPU pinning and the cross-core inbox for Runtime.
+
+Why:
+- The inbox wakes its home with one asio post per batch. The scheduled flag is cleared before a drain,
+  so a push that races the drain either is seen by it or posts a fresh one.
+- Pinning keeps a home's sockets, buffers and handler state in one core's cache.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+
+// Boost.Asio
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+
+// Platform
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+// Core
+#include <tb/twitch/runtime.hpp>
+#include <tb/utils/activity.hpp>
+#include <tb/utils/log.hpp>
+
+namespace twitch_bot
+{
+
+    Runtime::MpscQueue::MpscQueue() noexcept :
+        head_{ &stub_ }, tail_{ &stub_ }
+    {
+    }
+
+    Runtime::MpscQueue::~MpscQueue() noexcept
+    {
+        while (Node* n = pop())
+        {
+            delete n;
+        }
+    }
+
+    void Runtime::MpscQueue::push(Node* n) noexcept
+    {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    Runtime::MpscQueue::Node* Runtime::MpscQueue::pop() noexcept
+    {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_)
+        {
+            if (!next)
+            {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next)
+        {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire))
+        {
+            return nullptr; // producer between exchange and link
+        }
+        push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    bool Runtime::MpscQueue::empty() const noexcept
+    {
+        // Fully drained means only the stub is left; anything else is an item or a push in flight.
+        return tail_ == &stub_ && head_.load(std::memory_order_acquire) == &stub_;
+    }
+
+    Runtime::Home::Home() :
+        ctx{ 1 }
+    {
+        work.emplace(boost::asio::make_work_guard(ctx));
+    }
+
+    Runtime::Runtime(RuntimeOptions options) :
+        mode_{ options.mode }, threads_{ std::max<std::size_t>(options.threads, 1) }, pin_{ options.pin_threads }
+    {
+        if (mode_ == ExecutionMode::shared_pool && threads_ > 1)
+        {
+            pool_.emplace(threads_);
+            return;
+        }
+
+        // Per-core, or the single-thread fast path: every home is a context with one driver.
+        homes_.reserve(threads_);
+        for (std::size_t i = 0; i < threads_; ++i)
+        {
+            homes_.push_back(std::make_unique<Home>());
+        }
+    }
+
+    Runtime::~Runtime() noexcept
+    {
+        stop();
+        for (auto& h : homes_)
+        {
+            if (h->thread.joinable())
+            {
+                h->thread.join();
+            }
+        }
+        if (pool_)
+        {
+            pool_->join();
+        }
+    }
+
+    boost::asio::any_io_executor Runtime::executor(std::size_t home) const
+    {
+        if (pool_)
+        {
+            return pool_->get_executor();
+        }
+        return homes_[home % homes_.size()]->ctx.get_executor();
+    }
+
+    HomeExecutor Runtime::serial_executor(std::size_t home) const
+    {
+        if (pool_)
+        {
+            return HomeExecutor{ boost::asio::make_strand(pool_->get_executor()), 0 };
+        }
+        const std::size_t h = home % homes_.size();
+        return HomeExecutor{ homes_[h]->ctx.get_executor(), h };
+    }
+
+    std::size_t Runtime::home_of(std::string_view key) const noexcept
+    {
+        return std::hash<std::string_view>{}(key) % homes();
+    }
+
+    void Runtime::post(const HomeExecutor& target, task_t fn)
+    {
+        if (pool_)
+        {
+            boost::asio::post(target.executor, std::move(fn));
+            return;
+        }
+
+        Home& home = *homes_[target.home % homes_.size()];
+        home.inbox.push(new MpscQueue::Node{ {}, std::move(fn) });
+        schedule_drain(home);
+    }
+
+    void Runtime::schedule_drain(Home& home)
+    {
+        if (!home.scheduled.exchange(true, std::memory_order_acq_rel))
+        {
+            boost::asio::post(home.ctx, [this, &home] { drain(home); });
+        }
+    }
+
+    void Runtime::drain(Home& home)
+    {
+        // Clear first: a producer that pushes after this either lands in this batch or posts again.
+        home.scheduled.store(false, std::memory_order_seq_cst);
+
+        for (std::size_t n = 0; n < k_drain_batch; ++n)
+        {
+            MpscQueue::Node* node = home.inbox.pop();
+            if (!node)
+            {
+                break;
+            }
+            std::unique_ptr<MpscQueue::Node> owned{ node };
+            try
+            {
+                owned->fn();
+            }
+            catch (const std::exception& e)
+            {
+                TB_LOG_ERROR("runtime", "cross-core task threw: {}", e.what());
+            }
+        }
+
+        // Leftovers, or a producer caught mid-push: come back after other ready handlers.
+        if (!home.inbox.empty())
+        {
+            schedule_drain(home);
+        }
+    }
+
+    void Runtime::pin_current_thread(std::size_t cpu) noexcept
+    {
+        const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        cpu %= cpus;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) != 0)
+        {
+            TB_LOG_WARN("runtime", "could not pin thread to cpu {}", cpu);
+        }
+#elif defined(_WIN32)
+        if (cpu < sizeof(DWORD_PTR) * 8 && ::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR{ 1 } << cpu) == 0)
+        {
+            TB_LOG_WARN("runtime", "could not pin thread to cpu {}", cpu);
+        }
+#else
+        (void)cpu; // no portable affinity API; run unpinned
+#endif
+    }
+
+    void Runtime::run()
+    {
+        // Home drivers register up front so the stall watchdog can sample them. Pool threads belong to
+        // asio and register on their first tb::activity::Scope.
+        if (pool_)
+        {
+            pool_->join();
+            return;
+        }
+
+        const bool pin = pin_ && mode_ == ExecutionMode::per_core;
+        for (std::size_t i = 1; i < homes_.size(); ++i)
+        {
+            homes_[i]->thread = std::thread([this, i, pin] {
+                tb::activity::register_this_thread();
+                if (pin)
+                {
+                    pin_current_thread(i);
+                }
+                homes_[i]->ctx.run();
+            });
+        }
+
+        tb::activity::register_this_thread();
+        if (pin)
+        {
+            pin_current_thread(0);
+        }
+        homes_[0]->ctx.run();
+
+        for (std::size_t i = 1; i < homes_.size(); ++i)
+        {
+            if (homes_[i]->thread.joinable())
+            {
+                homes_[i]->thread.join();
+            }
+        }
+    }
+
+    void Runtime::stop() noexcept
+    {
+        stopped_.store(true, std::memory_order_release);
+        if (pool_)
+        {
+            pool_->stop();
+            return;
+        }
+        for (auto& h : homes_)
+        {
+            h->work.reset();
+            h->ctx.stop();
+        }
+    }
+
+} // namespace twitch_bot
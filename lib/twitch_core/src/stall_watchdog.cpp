@@ -0,0 +1,280 @@
+/*
+Module Name:
+- stall_watchdog.cpp
+
+Abstract:
+- Probe scheduling, lag accounting and stall reports for StallWatchdog.
+
+Why:
+- At most one probe per target is in flight, so a stalled executor never builds up probes behind it.
+  Its age is the stall length so far, and the probe's eventual lag is the whole stall.
+- Stack samples come from a signal sent to the stalled thread: only that thread can walk its own stack.
+  The handler does backtrace() into a per-thread slot that was allocated earlier; symbolising and
+  logging run on the watchdog thread.
+- The signal is sent under the activity registry's lock, so a thread that has exited since the snapshot
+  is skipped instead of signalled through a stale handle.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <string_view>
+
+// Boost.Asio
+#include <boost/asio/post.hpp>
+
+// Platform
+#if defined(__linux__)
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <execinfo.h>
+#endif
+
+// Core
+#include <tb/twitch/stall_watchdog.hpp>
+#include <tb/utils/activity.hpp>
+#include <tb/utils/log.hpp>
+
+namespace twitch_bot
+{
+
+    namespace
+    {
+        constexpr std::size_t k_max_sampled_threads = 8;
+        constexpr std::size_t k_max_logged_frames = 24;
+
+        std::int64_t now_ns() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+#if defined(__linux__)
+        int sample_signal() noexcept
+        {
+            return SIGRTMIN + 4;
+        }
+
+        void on_sample_signal(int) noexcept
+        {
+            auto* self = tb::activity::current_or_null();
+            if (!self)
+            {
+                return;
+            }
+            const int saved_errno = errno;
+            const int n = ::backtrace(self->frames.data(), static_cast<int>(self->frames.size()));
+            self->frame_count.store(n, std::memory_order_release);
+            errno = saved_errno;
+        }
+
+        bool install_sampler() noexcept
+        {
+            static const bool ok = [] {
+                void* warm[1];
+                (void)::backtrace(warm, 1); // loads libgcc now, not inside the handler
+
+                struct sigaction sa{};
+                sa.sa_handler = &on_sample_signal;
+                sigemptyset(&sa.sa_mask);
+                sa.sa_flags = SA_RESTART;
+                return ::sigaction(sample_signal(), &sa, nullptr) == 0;
+            }();
+            return ok;
+        }
+
+        // Frames of another thread, innermost first, without the handler's own frames.
+        std::vector<std::string> sample_stack(tb::activity::ThreadState& t)
+        {
+            std::vector<std::string> out;
+            t.frame_count.store(-1, std::memory_order_relaxed);
+            if (!install_sampler() || !tb::activity::signal_thread(t, sample_signal()))
+            {
+                return out;
+            }
+
+            int n = -1;
+            for (int waited = 0; waited < 100 && (n = t.frame_count.load(std::memory_order_acquire)) < 0; ++waited)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+            }
+            if (n <= 0)
+            {
+                return out;
+            }
+
+            char** symbols = ::backtrace_symbols(t.frames.data(), n);
+            if (!symbols)
+            {
+                return out;
+            }
+            constexpr int k_skip = 2; // on_sample_signal and the signal trampoline
+            for (int i = k_skip; i < n && out.size() < k_max_logged_frames; ++i)
+            {
+                out.emplace_back(symbols[i]);
+            }
+            std::free(symbols);
+            return out;
+        }
+#else
+        std::vector<std::string> sample_stack(tb::activity::ThreadState&)
+        {
+            return {}; // no portable way to sample another thread's stack
+        }
+#endif
+    } // namespace
+
+    StallWatchdog::StallWatchdog(Runtime& runtime, StallWatchdogOptions options) :
+        runtime_{ runtime }, options_{ options }
+    {
+    }
+
+    StallWatchdog::~StallWatchdog() noexcept
+    {
+        stop();
+    }
+
+    void StallWatchdog::watch(std::string name, HomeExecutor target)
+    {
+        auto t = std::make_shared<Target>();
+        auto& registry = tb::metrics::registry();
+        t->lag = &registry.histogram("tb_loop_lag_seconds", "Time a watchdog probe waited to run", { { "target", name } });
+        t->stalls = &registry.counter("tb_loop_stalls_total", "Probes older than the stall threshold", { { "target", name } });
+        t->name = std::move(name);
+        t->home = std::move(target);
+        t->via_runtime = true;
+        targets_.push_back(std::move(t));
+    }
+
+    void StallWatchdog::watch(std::string name, boost::asio::any_io_executor target)
+    {
+        watch(std::move(name), HomeExecutor{ std::move(target), 0 });
+        targets_.back()->via_runtime = false;
+    }
+
+    void StallWatchdog::start()
+    {
+        if (thread_.joinable() || targets_.empty())
+        {
+            return;
+        }
+        thread_ = std::thread([this] { run(); });
+        TB_LOG_INFO("watchdog", "watching {} executors every {}ms, stall at {}ms", targets_.size(), options_.interval.count(), options_.threshold.count());
+    }
+
+    void StallWatchdog::stop() noexcept
+    {
+        {
+            std::lock_guard lk(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    void StallWatchdog::run()
+    {
+        std::unique_lock lk(mutex_);
+        while (!stopping_)
+        {
+            lk.unlock();
+            tick();
+            lk.lock();
+            cv_.wait_for(lk, options_.interval, [this] { return stopping_; });
+        }
+    }
+
+    void StallWatchdog::tick()
+    {
+        const auto now = now_ns();
+        for (const auto& t : targets_)
+        {
+            const auto posted = t->posted_ns.load(std::memory_order_acquire);
+            if (posted == 0)
+            {
+                if (t->reported)
+                {
+                    t->reported = false;
+                    TB_LOG_WARN("watchdog", "{} recovered after {}ms", t->name, t->last_lag_ns.load(std::memory_order_relaxed) / 1'000'000);
+                }
+                t->posted_ns.store(now, std::memory_order_relaxed);
+                probe(t);
+                continue;
+            }
+
+            const std::chrono::milliseconds age{ (now - posted) / 1'000'000 };
+            if (!t->reported && age >= options_.threshold)
+            {
+                t->reported = true;
+                t->stalls->inc();
+                report(*t, age);
+            }
+        }
+    }
+
+    void StallWatchdog::probe(const std::shared_ptr<Target>& t)
+    {
+        auto fn = [t] {
+            const auto lag = now_ns() - t->posted_ns.load(std::memory_order_relaxed);
+            t->lag->observe(std::chrono::nanoseconds{ lag });
+            t->last_lag_ns.store(lag, std::memory_order_relaxed);
+            t->posted_ns.store(0, std::memory_order_release);
+        };
+        try
+        {
+            if (t->via_runtime)
+            {
+                runtime_.post(t->home, std::move(fn));
+            }
+            else
+            {
+                boost::asio::post(t->home.executor, std::move(fn));
+            }
+        }
+        catch (...)
+        {
+            t->posted_ns.store(0, std::memory_order_relaxed); // shutting down; try again next tick
+        }
+    }
+
+    void StallWatchdog::report(const Target& t, std::chrono::milliseconds age)
+    {
+        TB_LOG_WARN("watchdog", "{} stalled: probe waiting {}ms", t.name, age.count());
+
+        // Threads inside a named scope first; with none, the blocking call is unmarked, so sample everyone.
+        auto threads = tb::activity::threads();
+        std::vector<std::shared_ptr<tb::activity::ThreadState>> picked;
+        for (const auto& th : threads)
+        {
+            if (th->name.load(std::memory_order_relaxed) != nullptr)
+            {
+                picked.push_back(th);
+            }
+        }
+        if (picked.empty())
+        {
+            picked = std::move(threads);
+        }
+        if (picked.size() > k_max_sampled_threads)
+        {
+            picked.resize(k_max_sampled_threads);
+        }
+
+        for (const auto& th : picked)
+        {
+            const char* running = th->name.load(std::memory_order_relaxed);
+            TB_LOG_WARN("watchdog", "  thread#{} running {}", th->index, running ? std::string_view{ running } : std::string_view{ "(unmarked)" });
+            if (!options_.stack_samples)
+            {
+                continue;
+            }
+            for (const auto& frame : sample_stack(*th))
+            {
+                TB_LOG_WARN("watchdog", "    {}", frame);
+            }
+        }
+    }
+
+} // namespace twitch_bot
@@ -1,15 +1,15 @@
 // Twitch bot core supervisor.
-// Coordinates IRC, Helix, command dispatch, and reconnect/backoff strategy.
+// Coordinates IRC, Helix and command dispatch.
 // Rationale:
-// - Serialise all state changes and socket writes via a strand to avoid races.
-// - Keep reconnects bounded and jittered to prevent thundering herd.
+// - Serialise bot state via a strand; handlers fan out across per-channel lanes (4 per thread)
+//   so a hot channel rarely shares a lane with another. Per-core runtimes use one lane per core.
+// - Reconnect/backoff lives in IrcConnectionPool so each shard recovers on its own.
 // - Keep control-channel always joined; persist user-joined channels across reconnects.
+// - With anonymous ingest, writes go through one authenticated connection that joins nothing;
+//   Twitch accepts PRIVMSG to channels a connection has not joined.
 
 // C++ Standard Library
 #include <algorithm>
-#include <array>
-#include <iostream>
-#include <random>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -17,8 +17,6 @@
 // Boost.Asio
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
-#include <boost/asio/steady_timer.hpp>
-#include <boost/asio/this_coro.hpp>
 
 // Core
 #include <tb/parser/irc_message_parser.hpp>
@@ -27,329 +25,147 @@
 namespace twitch_bot
 {
 
+    namespace
+    {
+        // Bundled CA file plus the platform store, unless the app configured the factory first.
+        tb::net::TlsContextFactory& shared_tls()
+        {
+            (void)tb::net::TlsContextFactory::configure(tb::net::TlsOptions{ .ca_file = TB_CACERT_PEM_PATH });
+            return tb::net::TlsContextFactory::process();
+        }
+    } // namespace
+
     TwitchBot::TwitchBot(std::string access_token,
                          std::string refresh_token,
                          std::string client_id,
                          std::string client_secret,
                          std::string control_channel,
-                         std::size_t threads)
-        // One pool for I/O; keep it small and fixed.
+                         IrcPoolOptions ingest,
+                         RuntimeOptions runtime)
+        // One runtime for I/O; keep it small and fixed.
         :
-        pool_{ threads > 0 ? threads : 1 }
-        // Serialise all bot state transitions (handlers, sends, reconnect).
+        runtime_{ runtime }
+        // Serialise all bot state transitions (handlers, sends).
         ,
-        strand_{ pool_.get_executor() },
-        ssl_ctx_{ boost::asio::ssl::context::tlsv12_client },
+        strand_{ runtime_.serial_executor(0).executor },
+        tls_{ shared_tls() },
         access_token_{ std::move(access_token) },
         refresh_token_(std::move(refresh_token)),
         client_id_{ std::move(client_id) },
         client_secret_{ std::move(client_secret) },
         control_channel_{ std::move(control_channel) },
-        irc_client_{ strand_, ssl_ctx_, access_token_, control_channel_ },
-        dispatcher_{ strand_ },
-        helix_client_{ strand_, ssl_ctx_, client_id_, client_secret_, refresh_token_ }
+        // Shards spread over the runtime's serial executors so reads run in parallel.
+        irc_pool_{ runtime_,
+                   tls_,
+                   control_channel_,
+                   [this](bool revalidate) { return irc_token(revalidate); },
+                   [this](IrcMessage msg) { dispatcher_.dispatch(std::move(msg)); },
+                   ingest },
+        dispatcher_{ runtime_, runtime_.threads() * 4 },
+        helix_client_{ strand_, tls_, client_id_, client_secret_, refresh_token_ }
     {
-        // Use platform store (keeps cert management out of the bot).
-        ssl_ctx_.set_default_verify_paths();
+        irc_pool_.set_channels({ control_channel_ });
+
+        // Anonymous ingest cannot send, so writes get a single login of their own. Its NOTICE and
+        // USERSTATE lines reach the same dispatcher.
+        if (ingest.anonymous)
+        {
+            writer_.emplace(runtime_,
+                            tls_,
+                            control_channel_,
+                            [this](bool revalidate) { return irc_token(revalidate); },
+                            [this](IrcMessage msg) { dispatcher_.dispatch(std::move(msg)); },
+                            IrcPoolOptions{ .max_shards = 1, .name = "writer" });
+        }
     }
 
     TwitchBot::~TwitchBot() noexcept
     {
-        // Best-effort: stop timers and close the socket.
-        irc_client_.close();
+        // Best-effort: stop reconnecting and close every shard.
+        watchdog_.reset();
+        irc_pool_.stop();
+        if (writer_)
+        {
+            writer_->stop();
+        }
+        runtime_.stop();
     }
 
-    void TwitchBot::add_chat_listener(chat_listener_t listener)
+    void TwitchBot::add_chat_listener(chat_listener_t listener, ListenerPolicy policy)
     {
-        dispatcher_.register_chat_listener(std::move(listener));
+        dispatcher_.register_chat_listener(std::move(listener), std::move(policy));
     }
 
     void TwitchBot::run()
     {
-        // Run the supervisor on our strand; block until the pool stops.
-        boost::asio::co_spawn(strand_, run_bot(), boost::asio::detached);
-        pool_.join();
+        // Shard supervisors run on their own executors; block until the runtime stops.
+        irc_pool_.start();
+        if (writer_)
+        {
+            writer_->start();
+        }
+        runtime_.run();
     }
 
-    void TwitchBot::set_initial_channels(std::vector<std::string> channels)
+    void TwitchBot::start_watchdog(StallWatchdogOptions options)
     {
-        std::lock_guard lk(chan_mutex_);
-        initial_channels_ = std::move(channels);
+        if (watchdog_)
+        {
+            return;
+        }
+        watchdog_.emplace(runtime_, options);
+        watchdog_->watch("bot", strand_);
+        for (std::size_t i = 0; i < dispatcher_.lane_count(); ++i)
+        {
+            watchdog_->watch("lane#" + std::to_string(i), dispatcher_.lane(i));
+        }
+        watchdog_->start();
     }
 
-    boost::asio::awaitable<void> TwitchBot::join_channel(std::string_view channel)
+    void TwitchBot::set_initial_channels(std::vector<std::string> channels)
     {
-        // All socket operations go through the strand (shared state + ordering).
-        co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
-
-        // IRC: JOIN #<channel>.
-        co_await irc_client_.join(channel);
-
-        // Persist in-memory intent so reconnects re-join.
+        // Always include the control channel.
+        if (std::find(channels.begin(), channels.end(), control_channel_) == channels.end())
         {
-            std::lock_guard lk(chan_mutex_);
-            std::string c{ channel };
-            if (std::find(initial_channels_.begin(), initial_channels_.end(), c) == initial_channels_.end())
-            {
-                initial_channels_.push_back(std::move(c));
-            }
+            channels.push_back(control_channel_);
         }
+        irc_pool_.set_channels(std::move(channels));
     }
 
-    boost::asio::awaitable<void> TwitchBot::part_channel(std::string_view channel)
+    boost::asio::awaitable<void> TwitchBot::join_channel(std::string_view channel)
     {
-        co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
-
-        co_await irc_client_.part(channel);
+        // The pool records intent so reconnects re-join, then JOINs on the owning shard.
+        co_await irc_pool_.join(channel);
+    }
 
+    boost::asio::awaitable<void> TwitchBot::part_channel(std::string_view channel)
+    {
         // Stop auto-rejoining on future reconnects.
-        {
-            std::lock_guard lk(chan_mutex_);
-            const std::string c{ channel };
-            auto it = std::find(initial_channels_.begin(), initial_channels_.end(), c);
-            if (it != initial_channels_.end())
-            {
-                initial_channels_.erase(it);
-            }
-        }
+        co_await irc_pool_.part(channel);
     }
 
     boost::asio::awaitable<void> TwitchBot::say(std::string_view channel, std::string_view text)
     {
-        // Keep ordering and avoid interleaving with other sends.
-        co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
-        co_await irc_client_.privmsg_wrap(channel, text);
+        // The writing connection serialises sends, so they never interleave.
+        co_await irc_writer().say(channel, text);
     }
 
     boost::asio::awaitable<void>
     TwitchBot::reply(std::string_view channel, std::string_view parent_msg_id, std::string_view text)
     {
-        co_await boost::asio::dispatch(strand_, boost::asio::use_awaitable);
-        if (parent_msg_id.empty())
-        {
-            co_await irc_client_.privmsg_wrap(channel, text);
-        }
-        else
-        {
-            co_await irc_client_.reply(channel, parent_msg_id, text);
-        }
+        co_await irc_writer().reply(channel, parent_msg_id, text);
     }
 
-    boost::asio::awaitable<void> TwitchBot::run_bot()
+    boost::asio::awaitable<std::string> TwitchBot::irc_token(bool revalidate)
     {
-        using namespace std::chrono;
-
-        // Reconnect policy: exponential backoff with full jitter.
-        static constexpr auto k_connect_base = seconds{ 3 };
-        static constexpr auto k_reconnect_base = seconds{ 2 };
-        static constexpr auto k_backoff_cap = seconds{ 30 };
-        static constexpr auto k_min_sleep = milliseconds{ 150 };
-
-        auto next_backoff = [](unsigned& attempts, milliseconds base, milliseconds cap) -> milliseconds {
-            // Grows like base * 2^attempts, capped; randomise to avoid thundering herd.
-            const unsigned exp = std::min<unsigned>(attempts, 16);
-            const auto grown = base * (1u << exp);
-            const auto max_d = grown > cap ? cap : grown;
-
-            static thread_local std::mt19937 rng{ std::random_device{}() };
-            const auto ms_max = duration_cast<milliseconds>(max_d).count();
-            std::uniform_int_distribution<long long> dist(0, ms_max);
-
-            ++attempts;
-            auto d = milliseconds{ dist(rng) };
-            if (d < k_min_sleep)
-            {
-                d = k_min_sleep;
-            }
-            return d;
-        };
-
-        unsigned connect_attempts = 0;
-        unsigned reconnect_attempts = 0;
-
-        for (;;)
+        // Ensure fresh OAuth before every shard (re)connect; cheap when recently validated.
+        co_await helix_client_.ensure_valid_token(revalidate);
+        std::string access_token = helix_client_.current_token();
+        if (access_token.rfind("oauth:", 0) != 0)
         {
-            // Snapshot channel list under lock; always include control channel.
-            std::vector<std::string_view> channels;
-            {
-                std::lock_guard lk(chan_mutex_);
-                channels.reserve(initial_channels_.size() + 1);
-                for (auto& c : initial_channels_)
-                {
-                    channels.push_back(c);
-                }
-            }
-            if (std::find(channels.begin(), channels.end(), control_channel_) == channels.end())
-            {
-                channels.push_back(control_channel_);
-            }
-
-            // Ensure fresh OAuth, then update IRC client token.
-            co_await helix_client_.ensure_valid_token();
-            std::string access_token = helix_client_.current_token();
-            if (access_token.rfind("oauth:", 0) != 0)
-            {
-                access_token = "oauth:" + access_token;
-            }
-            irc_client_.set_access_token(access_token);
-
-            bool connected = false;
-            try
-            {
-                co_await irc_client_.connect(channels);
-                connected = true;
-            }
-            catch (const std::exception& e)
-            {
-                std::cerr << "[TwitchBot] IRC connect error: " << e.what() << '\n';
-            }
-            if (!connected)
-            {
-                const auto delay = next_backoff(connect_attempts,
-                                                duration_cast<milliseconds>(k_connect_base),
-                                                duration_cast<milliseconds>(k_backoff_cap));
-                std::cout << "[TwitchBot] backoff#" << connect_attempts
-                          << " reason=connect-error sleep=" << delay.count() << "ms\n";
-                boost::asio::steady_timer pause{ pool_ };
-                pause.expires_after(delay);
-                co_await pause.async_wait(boost::asio::use_awaitable);
-                continue;
-            }
-
-            // Connected: reset counters.
-            connect_attempts = 0;
-            reconnect_attempts = 0;
-
-            auto exec = co_await boost::asio::this_coro::executor;
-
-            // Signal used to break out to the reconnect path.
-            boost::asio::steady_timer reconnect_signal{ pool_ };
-            reconnect_signal.expires_at(std::chrono::steady_clock::time_point::max());
-
-            std::string reconnect_reason;
-
-            // Keep the link alive.
-            boost::asio::co_spawn(
-                exec,
-                [this]() noexcept -> boost::asio::awaitable<void> { co_await irc_client_.ping_loop(); },
-                boost::asio::detached);
-
-            // Read loop and routing.
-            boost::asio::co_spawn(
-                exec,
-                [this, &reconnect_signal, exec, &reconnect_reason]() noexcept
-                    -> boost::asio::awaitable<void> {
-                    try
-                    {
-                        co_await irc_client_.read_loop(
-                            [this, &reconnect_signal, exec, &reconnect_reason](std::string_view raw) {
-                                std::cout << "[IRC] " << raw << '\n';
-                                auto msg = parse_irc_line(raw);
-
-                                if (msg.command == "PING")
-                                {
-                                    // Reply with PONG; keep payload as-is.
-                                    auto payload = std::string{ msg.trailing };
-                                    boost::asio::co_spawn(
-                                        exec,
-                                        [this, payload = std::move(payload)]()
-                                            -> boost::asio::awaitable<void> {
-                                            std::array<boost::asio::const_buffer, 4> bufs{
-                                                boost::asio::buffer("PONG ", 5),
-                                                boost::asio::buffer(":", 1),
-                                                boost::asio::buffer(payload),
-                                                boost::asio::buffer("\r\n", 2)
-                                            };
-                                            co_await irc_client_.send_buffers(bufs);
-                                            co_return;
-                                        },
-                                        boost::asio::detached);
-                                    return;
-                                }
-
-                                if (msg.command == "RECONNECT")
-                                {
-                                    reconnect_reason = "server-reconnect";
-                                    irc_client_.close();
-                                    reconnect_signal.cancel();
-                                    return;
-                                }
-
-                                if (msg.command == "NOTICE")
-                                {
-                                    // Detect auth errors and trigger token refresh.
-                                    auto id = msg.get_tag("msg-id");
-                                    if (id == "msg_auth_failed" || msg.trailing == "Login authentication failed" || msg.trailing == "Improperly formatted auth")
-                                    {
-                                        reconnect_reason = "auth-fail";
-                                        boost::asio::co_spawn(
-                                            exec,
-                                            [this]() -> boost::asio::awaitable<void> {
-                                                co_await helix_client_.ensure_valid_token();
-                                                co_return;
-                                            },
-                                            boost::asio::detached);
-                                        irc_client_.close();
-                                        reconnect_signal.cancel();
-                                        return;
-                                    }
-                                }
-
-                                if (msg.command == "CAP" && msg.parameters().size() >= 2)
-                                {
-                                    auto sub = msg.parameters()[1]; // "ACK" / "NAK"
-                                    if (sub == "ACK")
-                                    {
-                                        std::cout << "[IRC] CAP ACK " << msg.trailing << '\n';
-                                    }
-                                    else if (sub == "NAK")
-                                    {
-                                        std::cerr << "[IRC] CAP NAK " << msg.trailing
-                                                  << " (tags/commands/membership may be unavailable)\n";
-                                    }
-                                    return;
-                                }
-
-                                // Normal chat routing.
-                                dispatcher_.dispatch(std::move(msg));
-                            });
-                    }
-                    catch (...)
-                    {
-                        if (reconnect_reason.empty())
-                        {
-                            reconnect_reason = "read-error";
-                        }
-                        reconnect_signal.cancel();
-                    }
-                    co_return;
-                },
-                boost::asio::detached);
-
-            try
-            {
-                co_await reconnect_signal.async_wait(boost::asio::use_awaitable);
-            }
-            catch (...)
-            {
-                // Woken by cancel(); continue to reconnect.
-            }
-
-            // Close the current connection before backing off and retrying.
-            irc_client_.close();
-
-            const auto delay = next_backoff(reconnect_attempts,
-                                            duration_cast<milliseconds>(k_reconnect_base),
-                                            duration_cast<milliseconds>(k_backoff_cap));
-            std::cout << "[TwitchBot] backoff#" << reconnect_attempts
-                      << " reason=" << (reconnect_reason.empty() ? "unknown" : reconnect_reason)
-                      << " sleep=" << delay.count() << "ms\n";
-
-            boost::asio::steady_timer pause{ pool_ };
-            pause.expires_after(delay);
-            co_await pause.async_wait(boost::asio::use_awaitable);
-            // loop and reconnect
+            access_token = "oauth:" + access_token;
         }
+        co_return access_token;
     }
 
 } // namespace twitch_bot
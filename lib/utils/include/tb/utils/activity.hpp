@@ -0,0 +1,177 @@
+/*
+Module Name:
+- activity.hpp
+
+Abstract:
+- Per-thread "what is running now" markers for the stall watchdog.
+- const tb::activity::Scope scope{ "channel_store.save" }; names the enclosing synchronous section.
+- Each registered thread also has a slot the watchdog's signal handler fills with a stack sample.
+
+Why:
+- When a strand stalls, the name of the handler that holds it is the first thing anyone asks for.
+- A scope is two relaxed stores to a thread-owned cache line, so it can sit on per-line paths.
+- Do not hold a Scope across co_await: the thread runs other work while the coroutine is suspended.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Platform
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+namespace tb::activity
+{
+
+    struct ThreadState
+    {
+        static constexpr std::size_t k_max_frames = 48;
+
+        std::uint32_t index = 0; // registration order, stable for the process
+#if !defined(_WIN32)
+        pthread_t handle{};
+#endif
+        alignas(64) std::atomic<const char*> name{ nullptr }; // innermost open scope, or null
+        std::atomic<std::uint64_t> entered{ 0 }; // bumped on every scope entry
+
+        // Written by the sampling signal handler on this thread; -1 while no sample is ready.
+        std::array<void*, k_max_frames> frames{};
+        std::atomic<int> frame_count{ -1 };
+    };
+
+    namespace detail
+    {
+        class Registry
+        {
+        public:
+            std::shared_ptr<ThreadState> add()
+            {
+                auto s = std::make_shared<ThreadState>();
+#if !defined(_WIN32)
+                s->handle = ::pthread_self();
+#endif
+                std::lock_guard lk(mutex_);
+                s->index = static_cast<std::uint32_t>(states_.size());
+                states_.push_back(s);
+                return s;
+            }
+
+            void remove(const ThreadState* s)
+            {
+                std::lock_guard lk(mutex_);
+                std::erase_if(states_, [s](const auto& p) { return p.get() == s; });
+            }
+
+            [[nodiscard]] std::vector<std::shared_ptr<ThreadState>> snapshot() const
+            {
+                std::lock_guard lk(mutex_);
+                return states_;
+            }
+
+#if !defined(_WIN32)
+            // The lock keeps s registered, and so its thread alive, until pthread_kill returns.
+            bool signal(const ThreadState& s, int sig) const
+            {
+                std::lock_guard lk(mutex_);
+                const bool registered = std::any_of(states_.begin(), states_.end(), [&s](const auto& p) { return p.get() == &s; });
+                return registered && ::pthread_kill(s.handle, sig) == 0;
+            }
+#endif
+
+        private:
+            mutable std::mutex mutex_;
+            std::vector<std::shared_ptr<ThreadState>> states_;
+        };
+
+        inline Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        // Constant-initialised so the signal handler can read it without a TLS init guard.
+        inline thread_local ThreadState* t_current = nullptr;
+
+        struct Owner
+        {
+            std::shared_ptr<ThreadState> state = registry().add();
+
+            Owner()
+            {
+                t_current = state.get();
+            }
+            ~Owner()
+            {
+                t_current = nullptr;
+                registry().remove(state.get()); // a dead thread cannot be sampled
+            }
+        };
+    } // namespace detail
+
+    // Registers the calling thread on first use.
+    inline ThreadState& this_thread()
+    {
+        thread_local detail::Owner owner;
+        return *owner.state;
+    }
+
+    // Register now, so the thread can be stack-sampled before it ever opens a scope.
+    inline void register_this_thread()
+    {
+        (void)this_thread();
+    }
+
+    // Only reads the thread's own slot; safe in a signal handler.
+    [[nodiscard]] inline ThreadState* current_or_null() noexcept
+    {
+        return detail::t_current;
+    }
+
+    [[nodiscard]] inline std::vector<std::shared_ptr<ThreadState>> threads()
+    {
+        return detail::registry().snapshot();
+    }
+
+#if !defined(_WIN32)
+    // Send sig to the thread behind a state from threads(). False once that thread has exited: its
+    // handle may already name another thread, so it is never used after deregistration.
+    inline bool signal_thread(const ThreadState& state, int sig)
+    {
+        return detail::registry().signal(state, sig);
+    }
+#endif
+
+    // Names the enclosing synchronous section. name must be a string literal.
+    // The first scope on an unregistered thread registers it, which allocates and may throw.
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) :
+            state_{ this_thread() }, prev_{ state_.name.load(std::memory_order_relaxed) }
+        {
+            state_.entered.store(state_.entered.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            state_.name.store(name, std::memory_order_relaxed);
+        }
+
+        ~Scope()
+        {
+            state_.name.store(prev_, std::memory_order_relaxed);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ThreadState& state_;
+        const char* prev_;
+    };
+
+} // namespace tb::activity
@@ -0,0 +1,126 @@
+/*
+Module Name:
+- bounded_mpsc_queue.hpp
+
+Abstract:
+- Fixed-capacity lock-free queue: any number of producers, one consumer.
+- try_push fails instead of blocking or growing when the queue is full.
+
+Why:
+- Work that may be dropped (listener fan-out, sampling) needs back-pressure that costs the producer
+  one CAS and tells it the queue is full, so it can count the drop and move on.
+- Vyukov's bounded array queue: each cell carries a sequence number, so producers claim cells with
+  one CAS on the tail and the consumer never touches a shared counter.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace tb::concurrent
+{
+
+    template<class T>
+    class BoundedMpscQueue
+    {
+    public:
+        // Capacity is rounded up to a power of two.
+        explicit BoundedMpscQueue(std::size_t capacity) :
+            mask_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 },
+            cells_{ std::make_unique<Cell[]>(mask_ + 1) }
+        {
+            for (std::size_t i = 0; i <= mask_; ++i)
+            {
+                cells_[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~BoundedMpscQueue()
+        {
+            while (try_pop())
+            {
+            }
+        }
+
+        BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+        BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+        // Any thread. False when full; value is left untouched.
+        bool try_push(T& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            auto pos = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& c = cells_[pos & mask_];
+                const auto seq = c.seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        ::new (static_cast<void*>(c.storage)) T(std::move(value));
+                        c.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // the consumer has not freed this cell yet
+                }
+                else
+                {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer only.
+        std::optional<T> try_pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            Cell& c = cells_[head_ & mask_];
+            if (c.seq.load(std::memory_order_acquire) != head_ + 1)
+            {
+                return std::nullopt; // empty, or a producer has claimed the cell but not filled it
+            }
+            T* p = std::launder(reinterpret_cast<T*>(c.storage));
+            std::optional<T> out{ std::move(*p) };
+            p->~T();
+            c.seq.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+            return out;
+        }
+
+        // Consumer only.
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return cells_[head_ & mask_].seq.load(std::memory_order_acquire) != head_ + 1;
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept
+        {
+            return mask_ + 1;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<std::size_t> seq{ 0 };
+            alignas(T) std::byte storage[sizeof(T)];
+        };
+
+        const std::size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<std::size_t> tail_{ 0 };
+        alignas(64) std::size_t head_ = 0;
+    };
+
+} // namespace tb::concurrent
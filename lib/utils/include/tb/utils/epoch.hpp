@@ -0,0 +1,248 @@
+/*
+Module Name:
+- epoch.hpp
+
+Abstract:
+- Epoch-based reclamation for read-mostly structures published behind an atomic pointer.
+- Readers pin() around their use of a snapshot. A writer swaps in a new one and retire()s the old, which
+  is deleted once every reader that could have seen it has unpinned.
+- One process-wide domain, epoch_domain(); each thread claims a reader record on its first pin.
+
+Why:
+- A pin is a store and a fence on the thread's own cache line: no lock, no shared counter, and no
+  reference count bouncing between the cores that read the same snapshot.
+- Classic three-epoch scheme: the global epoch advances only when every pinned reader has seen the
+  current one, so anything retired in epoch e is unreachable once the epoch reaches e + 2.
+- Reclamation runs on the writer's thread when it retires. A reader pinned at that moment delays
+  deletion to a later retire() or reclaim() call. Writes are rare, so the backlog stays small.
+- Past k_max_threads live readers, the extra threads share one counter that blocks every advance while
+  it is nonzero: slower, never unsafe.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace tb::concurrent
+{
+
+    class EpochDomain
+    {
+    public:
+        static constexpr std::size_t k_max_threads = 256;
+
+        // Keeps every pointer loaded while it lives. Nests; only the outermost guard pins.
+        class Guard
+        {
+        public:
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard()
+            {
+                domain_.unpin();
+            }
+
+        private:
+            friend class EpochDomain;
+
+            explicit Guard(EpochDomain& domain) noexcept :
+                domain_{ domain }
+            {
+            }
+
+            EpochDomain& domain_;
+        };
+
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        ~EpochDomain()
+        {
+            for (auto& r : retired_)
+            {
+                r.deleter(r.ptr);
+            }
+        }
+
+        [[nodiscard]] Guard pin() noexcept
+        {
+            auto& local = thread_local_state();
+            if (local.depth++ == 0)
+            {
+                if (!local.record && !local.overflow)
+                {
+                    claim(local);
+                }
+                if (local.record)
+                {
+                    local.record->epoch.store(global_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                else
+                {
+                    overflow_readers_.fetch_add(1, std::memory_order_relaxed);
+                }
+                // Orders the announcement before the caller's pointer load; pairs with the fence in reclaim().
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            return Guard{ *this };
+        }
+
+        // Delete p once no pinned reader can hold it. Call after p is unreachable for new readers.
+        template<class T>
+        void retire(const T* p)
+        {
+            if (!p)
+            {
+                return;
+            }
+            {
+                std::lock_guard lk(mutex_);
+                retired_.push_back({ const_cast<T*>(p), [](void* q) { delete static_cast<T*>(q); }, global_.load(std::memory_order_relaxed) });
+            }
+            reclaim();
+        }
+
+        // Advance the epoch if every reader allows it, and delete what has become unreachable.
+        void reclaim()
+        {
+            std::vector<Retired> ready;
+            {
+                std::lock_guard lk(mutex_);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (can_advance())
+                {
+                    global_.fetch_add(1, std::memory_order_relaxed);
+                }
+                const auto now = global_.load(std::memory_order_relaxed);
+                std::erase_if(retired_, [&](Retired& r) {
+                    if (r.epoch + 2 > now)
+                    {
+                        return false;
+                    }
+                    ready.push_back(r);
+                    return true;
+                });
+            }
+            for (auto& r : ready)
+            {
+                r.deleter(r.ptr); // outside the lock: destructors may retire in turn
+            }
+        }
+
+        [[nodiscard]] std::size_t pending() const
+        {
+            std::lock_guard lk(mutex_);
+            return retired_.size();
+        }
+
+    private:
+        friend EpochDomain& epoch_domain() noexcept;
+
+        struct alignas(64) Record
+        {
+            std::atomic<std::uint64_t> epoch{ 0 }; // 0 while not pinned
+            std::atomic<bool> claimed{ false };
+        };
+
+        struct Retired
+        {
+            void* ptr;
+            void (*deleter)(void*);
+            std::uint64_t epoch;
+        };
+
+        struct Local
+        {
+            Record* record = nullptr;
+            bool overflow = false; // every record was taken
+            std::uint32_t depth = 0;
+
+            ~Local()
+            {
+                if (record)
+                {
+                    record->epoch.store(0, std::memory_order_release);
+                    record->claimed.store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        EpochDomain() = default;
+
+        static Local& thread_local_state() noexcept
+        {
+            thread_local Local local;
+            return local;
+        }
+
+        void claim(Local& local) noexcept
+        {
+            for (auto& r : records_)
+            {
+                bool expected = false;
+                if (!r.claimed.load(std::memory_order_relaxed) && r.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    local.record = &r;
+                    return;
+                }
+            }
+            local.overflow = true;
+        }
+
+        void unpin() noexcept
+        {
+            auto& local = thread_local_state();
+            if (--local.depth != 0)
+            {
+                return;
+            }
+            if (local.record)
+            {
+                local.record->epoch.store(0, std::memory_order_release);
+            }
+            else
+            {
+                overflow_readers_.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // Caller holds mutex_.
+        [[nodiscard]] bool can_advance() const noexcept
+        {
+            if (overflow_readers_.load(std::memory_order_acquire) != 0)
+            {
+                return false;
+            }
+            const auto now = global_.load(std::memory_order_relaxed);
+            for (const auto& r : records_)
+            {
+                const auto e = r.epoch.load(std::memory_order_acquire);
+                if (e != 0 && e != now)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::array<Record, k_max_threads> records_{};
+        alignas(64) std::atomic<std::uint64_t> global_{ 1 };
+        std::atomic<std::int64_t> overflow_readers_{ 0 };
+        mutable std::mutex mutex_;
+        std::vector<Retired> retired_;
+    };
+
+    [[nodiscard]] inline EpochDomain& epoch_domain() noexcept
+    {
+        static EpochDomain domain;
+        return domain;
+    }
+
+} // namespace tb::concurrent
@@ -0,0 +1,641 @@
+/*
+Module Name:
+- log.hpp
+
+Abstract:
+- Asynchronous leveled logger: producers copy a record into a per-thread lock-free ring and return.
+- A background flusher drains every ring, formats, orders by timestamp and writes in batches.
+- Formatting is deferred: the hot path stores integers and copies string bytes, nothing is rendered.
+- Raw IRC line logging is opt-in and sampled (1 in N) through sample_raw().
+
+Usage:
+- TB_LOG_INFO("irc", "shard#{} connected in {}ms", idx, ms);
+- Format strings and components must be string literals; "{}" is replaced in order, "{{" and "}}" escape.
+- The format string is checked at compile time: a format spec such as "{:.1f}", a stray brace, a
+  placeholder count that differs from the argument count, or more than Record::k_max_args arguments
+  fails the build.
+
+Why:
+- A synchronous std::cout write per line takes a global lock on the strand that serialises bot work.
+- Single-producer rings need no locks or CAS on the hot path; a full ring drops and counts instead of blocking.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Core
+#include <tb/utils/attributes.hpp>
+
+namespace tb::log
+{
+
+    enum class Level : std::uint8_t
+    {
+        trace,
+        debug,
+        info,
+        warn,
+        error,
+        off,
+    };
+
+    [[nodiscard]] constexpr std::string_view level_name(Level l) noexcept
+    {
+        switch (l)
+        {
+        case Level::trace:
+            return "TRACE";
+        case Level::debug:
+            return "DEBUG";
+        case Level::info:
+            return "INFO ";
+        case Level::warn:
+            return "WARN ";
+        case Level::error:
+            return "ERROR";
+        default:
+            return "OFF  ";
+        }
+    }
+
+    // Parse "trace".."error"/"off". Unknown names keep fallback.
+    [[nodiscard]] constexpr Level parse_level(std::string_view s, Level fallback) noexcept
+    {
+        if (s == "trace")
+            return Level::trace;
+        if (s == "debug")
+            return Level::debug;
+        if (s == "info")
+            return Level::info;
+        if (s == "warn" || s == "warning")
+            return Level::warn;
+        if (s == "error")
+            return Level::error;
+        if (s == "off")
+            return Level::off;
+        return fallback;
+    }
+
+    namespace detail
+    {
+        inline std::atomic<Level> g_level{ Level::info };
+        inline std::atomic<std::uint32_t> g_raw_every{ 0 }; // 0 disables raw line logging
+
+        enum class ArgKind : std::uint8_t
+        {
+            i64,
+            u64,
+            f64,
+            boolean,
+            chr,
+            str,
+        };
+
+        struct Arg
+        {
+            ArgKind kind;
+            union
+            {
+                std::int64_t i;
+                std::uint64_t u;
+                double d;
+                bool b;
+                char c;
+                struct
+                {
+                    std::uint16_t off;
+                    std::uint16_t len;
+                } s;
+            };
+        };
+
+        // Fixed-size so rings are plain arrays. String arguments are copied into bytes and truncated past it.
+        struct Record
+        {
+            static constexpr std::size_t k_max_args = 8;
+            static constexpr std::size_t k_bytes = 400;
+
+            std::chrono::system_clock::time_point ts;
+            const char* component;
+            const char* fmt;
+            Level level;
+            std::uint8_t argc;
+            std::uint16_t used; // bytes consumed
+            bool truncated;
+            std::array<Arg, k_max_args> args;
+            std::array<char, k_bytes> bytes;
+        };
+
+        // Single producer (the owning thread), single consumer (the flusher).
+        class Ring
+        {
+        public:
+            static constexpr std::size_t k_capacity = 1024; // power of two
+
+            [[nodiscard]] Record* try_claim() noexcept
+            {
+                const auto h = head_.load(std::memory_order_relaxed);
+                if (TB_UNLIKELY(h - tail_.load(std::memory_order_acquire) >= k_capacity))
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                return &slots_[h & (k_capacity - 1)];
+            }
+
+            void publish() noexcept
+            {
+                head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            template<typename F>
+            void drain(F&& f)
+            {
+                auto t = tail_.load(std::memory_order_relaxed);
+                const auto h = head_.load(std::memory_order_acquire);
+                for (; t != h; ++t)
+                {
+                    f(slots_[t & (k_capacity - 1)]);
+                }
+                tail_.store(t, std::memory_order_release);
+            }
+
+            [[nodiscard]] bool empty() const noexcept
+            {
+                return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+            }
+
+            [[nodiscard]] std::uint64_t take_dropped() noexcept
+            {
+                return dropped_.exchange(0, std::memory_order_relaxed);
+            }
+
+            std::atomic<bool> orphaned{ false }; // owning thread exited; remove once drained
+
+        private:
+            std::array<Record, k_capacity> slots_{};
+            alignas(64) std::atomic<std::size_t> head_{ 0 };
+            alignas(64) std::atomic<std::size_t> tail_{ 0 };
+            std::atomic<std::uint64_t> dropped_{ 0 };
+        };
+
+        // Rendering helpers run on the flusher only.
+        inline void append_arg(std::string& out, const Record& r, const Arg& a)
+        {
+            char buf[32];
+            switch (a.kind)
+            {
+            case ArgKind::i64:
+                out.append(buf, std::to_chars(buf, buf + sizeof buf, a.i).ptr);
+                break;
+            case ArgKind::u64:
+                out.append(buf, std::to_chars(buf, buf + sizeof buf, a.u).ptr);
+                break;
+            case ArgKind::f64:
+                out.append(buf, std::to_chars(buf, buf + sizeof buf, a.d).ptr);
+                break;
+            case ArgKind::boolean:
+                out.append(a.b ? "true" : "false");
+                break;
+            case ArgKind::chr:
+                out.push_back(a.c);
+                break;
+            case ArgKind::str:
+                out.append(r.bytes.data() + a.s.off, a.s.len);
+                break;
+            }
+        }
+
+        // The message part: fmt with each "{}" replaced by the next captured argument.
+        inline void render_message(std::string& out, const Record& r)
+        {
+            std::string_view fmt{ r.fmt };
+            std::size_t next = 0;
+            for (std::size_t i = 0; i < fmt.size(); ++i)
+            {
+                const char c = fmt[i];
+                if (c == '{' && i + 1 < fmt.size() && fmt[i + 1] == '{')
+                {
+                    out.push_back('{');
+                    ++i;
+                }
+                else if (c == '}' && i + 1 < fmt.size() && fmt[i + 1] == '}')
+                {
+                    out.push_back('}');
+                    ++i;
+                }
+                else if (c == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}')
+                {
+                    if (next < r.argc)
+                    {
+                        append_arg(out, r, r.args[next++]);
+                    }
+                    ++i;
+                }
+                else
+                {
+                    out.push_back(c);
+                }
+            }
+            if (r.truncated)
+            {
+                out.append(" [truncated]");
+            }
+        }
+
+        inline void render(std::string& out, const Record& r)
+        {
+            // ISO-8601 UTC with milliseconds.
+            const auto secs = std::chrono::time_point_cast<std::chrono::seconds>(r.ts);
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(r.ts - secs).count();
+            const std::time_t tt = std::chrono::system_clock::to_time_t(secs);
+            std::tm tm{};
+#if defined(_WIN32)
+            gmtime_s(&tm, &tt);
+#else
+            gmtime_r(&tt, &tm);
+#endif
+            char head[40];
+            const int n = std::snprintf(head, sizeof head, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<int>(ms));
+            out.append(head, n > 0 ? static_cast<std::size_t>(n) : 0);
+            out.append(level_name(r.level));
+            out.append(" [").append(r.component).append("] ");
+            render_message(out, r);
+            out.push_back('\n');
+        }
+
+        class Logger
+        {
+        public:
+            Logger() = default;
+
+            ~Logger()
+            {
+                {
+                    std::lock_guard lk(mutex_);
+                    stopping_ = true;
+                }
+                cv_.notify_one();
+                if (flusher_.joinable())
+                {
+                    flusher_.join();
+                }
+                flush();
+            }
+
+            Logger(const Logger&) = delete;
+            Logger& operator=(const Logger&) = delete;
+
+            std::shared_ptr<Ring> register_thread()
+            {
+                auto ring = std::make_shared<Ring>();
+                std::lock_guard lk(mutex_);
+                rings_.push_back(ring);
+                if (!flusher_.joinable() && !stopping_)
+                {
+                    flusher_ = std::thread([this] { run(); });
+                }
+                return ring;
+            }
+
+            // Wake the flusher now; used for errors so they are not held for a full period.
+            void nudge() noexcept
+            {
+                cv_.notify_one();
+            }
+
+            // Drain every ring and write. Safe from any thread; serialised internally.
+            void flush()
+            {
+                std::lock_guard flk(flush_mutex_);
+
+                std::vector<std::shared_ptr<Ring>> rings;
+                {
+                    std::lock_guard lk(mutex_);
+                    rings = rings_;
+                }
+
+                batch_.clear();
+                std::uint64_t dropped = 0;
+                for (auto& ring : rings)
+                {
+                    ring->drain([this](const Record& r) {
+                        Line line{ r.ts, r.level, {} };
+                        render(line.text, r);
+                        batch_.push_back(std::move(line));
+                    });
+                    dropped += ring->take_dropped();
+                }
+
+                // Per-thread rings are ordered; merge them by time for a readable stream.
+                std::stable_sort(batch_.begin(), batch_.end(), [](const Line& a, const Line& b) { return a.ts < b.ts; });
+                for (const auto& line : batch_)
+                {
+                    std::FILE* sink = line.level >= Level::warn ? stderr : stdout;
+                    std::fwrite(line.text.data(), 1, line.text.size(), sink);
+                }
+                if (dropped != 0)
+                {
+                    std::fprintf(stderr, "[log] dropped %llu records (ring full)\n", static_cast<unsigned long long>(dropped));
+                }
+                std::fflush(stdout);
+                std::fflush(stderr);
+
+                // Forget rings whose threads have exited and that are now empty.
+                std::lock_guard lk(mutex_);
+                std::erase_if(rings_, [](const std::shared_ptr<Ring>& r) { return r->orphaned.load(std::memory_order_acquire) && r->empty(); });
+            }
+
+        private:
+            struct Line
+            {
+                std::chrono::system_clock::time_point ts;
+                Level level;
+                std::string text;
+            };
+
+            static constexpr auto k_period = std::chrono::milliseconds{ 50 };
+
+            void run()
+            {
+                std::unique_lock lk(mutex_);
+                while (!stopping_)
+                {
+                    cv_.wait_for(lk, k_period);
+                    lk.unlock();
+                    flush();
+                    lk.lock();
+                }
+            }
+
+            std::mutex mutex_; // guards rings_ and stopping_
+            std::condition_variable cv_;
+            std::vector<std::shared_ptr<Ring>> rings_;
+            bool stopping_ = false;
+            std::thread flusher_;
+
+            std::mutex flush_mutex_; // one drainer at a time (SPSC consumer side)
+            std::vector<Line> batch_;
+        };
+
+        inline Logger& logger()
+        {
+            static Logger instance;
+            return instance;
+        }
+
+        // Registers on first use; marks the ring orphaned when the thread exits.
+        struct ThreadRing
+        {
+            std::shared_ptr<Ring> ring = logger().register_thread();
+
+            ~ThreadRing()
+            {
+                ring->orphaned.store(true, std::memory_order_release);
+            }
+        };
+
+        inline Ring& thread_ring()
+        {
+            thread_local ThreadRing tr;
+            return *tr.ring;
+        }
+
+        // Argument capture: store scalars as-is, copy string bytes. No formatting here.
+        inline void capture_str(Record& r, Arg& a, std::string_view s) noexcept
+        {
+            const std::size_t room = Record::k_bytes - r.used;
+            const std::size_t n = std::min(s.size(), room);
+            if (n < s.size())
+            {
+                r.truncated = true;
+            }
+            std::copy_n(s.data(), n, r.bytes.data() + r.used);
+            a.kind = ArgKind::str;
+            a.s.off = r.used;
+            a.s.len = static_cast<std::uint16_t>(n);
+            r.used = static_cast<std::uint16_t>(r.used + n);
+        }
+
+        template<typename T>
+        void capture(Record& r, T&& v) noexcept
+        {
+            using U = std::remove_cvref_t<T>;
+            if (r.argc >= Record::k_max_args)
+            {
+                r.truncated = true;
+                return;
+            }
+            Arg& a = r.args[r.argc++];
+
+            if constexpr (std::same_as<U, bool>)
+            {
+                a.kind = ArgKind::boolean;
+                a.b = v;
+            }
+            else if constexpr (std::same_as<U, char>)
+            {
+                a.kind = ArgKind::chr;
+                a.c = v;
+            }
+            else if constexpr (std::is_enum_v<U>)
+            {
+                a.kind = ArgKind::i64;
+                a.i = static_cast<std::int64_t>(v);
+            }
+            else if constexpr (std::signed_integral<U>)
+            {
+                a.kind = ArgKind::i64;
+                a.i = v;
+            }
+            else if constexpr (std::unsigned_integral<U>)
+            {
+                a.kind = ArgKind::u64;
+                a.u = v;
+            }
+            else if constexpr (std::floating_point<U>)
+            {
+                a.kind = ArgKind::f64;
+                a.d = static_cast<double>(v);
+            }
+            else if constexpr (std::convertible_to<const U&, std::string_view>)
+            {
+                capture_str(r, a, std::string_view{ v });
+            }
+            else
+            {
+                static_assert(sizeof(U) == 0, "unsupported log argument type");
+            }
+        }
+
+        // Stamp r and capture args into it. fmt must outlive the record; write() only passes literals.
+        template<typename... Args>
+        void fill(Record& r, Level l, const char* component, const char* fmt, Args&&... args) noexcept
+        {
+            r.ts = std::chrono::system_clock::now();
+            r.component = component;
+            r.fmt = fmt;
+            r.level = l;
+            r.argc = 0;
+            r.used = 0;
+            r.truncated = false;
+            (capture(r, std::forward<Args>(args)), ...);
+        }
+
+        // Number of "{}" in fmt, or -1 if a brace is used any other way. The renderer has no format specs.
+        [[nodiscard]] constexpr int count_placeholders(std::string_view fmt) noexcept
+        {
+            int n = 0;
+            for (std::size_t i = 0; i < fmt.size(); ++i)
+            {
+                const char c = fmt[i];
+                if (c != '{' && c != '}')
+                {
+                    continue;
+                }
+                if (i + 1 < fmt.size() && (fmt[i + 1] == c || (c == '{' && fmt[i + 1] == '}')))
+                {
+                    n += (c == '{' && fmt[i + 1] == '}') ? 1 : 0;
+                    ++i;
+                    continue;
+                }
+                return -1;
+            }
+            return n;
+        }
+
+        // Not constexpr: reaching one in FormatString's constructor stops compilation with this name.
+        inline void log_format_has_unsupported_braces() noexcept {}
+        inline void log_format_placeholder_count_differs_from_argument_count() noexcept {}
+        inline void log_call_has_more_than_k_max_args_arguments() noexcept {}
+    } // namespace detail
+
+    // A format string checked against its arguments at compile time, as std::format_string is.
+    template<typename... Args>
+    class FormatString
+    {
+    public:
+        template<std::size_t N>
+        consteval FormatString(const char (&fmt)[N]) noexcept :
+            fmt_{ fmt }
+        {
+            const int n = detail::count_placeholders({ fmt, N - 1 });
+            if (n < 0)
+            {
+                detail::log_format_has_unsupported_braces();
+            }
+            if (static_cast<std::size_t>(n) != sizeof...(Args))
+            {
+                detail::log_format_placeholder_count_differs_from_argument_count();
+            }
+            if (sizeof...(Args) > detail::Record::k_max_args)
+            {
+                detail::log_call_has_more_than_k_max_args_arguments();
+            }
+        }
+
+        [[nodiscard]] constexpr const char* get() const noexcept
+        {
+            return fmt_;
+        }
+
+    private:
+        const char* fmt_;
+    };
+
+    template<typename... Args>
+    using format_string = FormatString<std::type_identity_t<Args>...>;
+
+    inline void set_level(Level l) noexcept
+    {
+        detail::g_level.store(l, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline Level level() noexcept
+    {
+        return detail::g_level.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] TB_FORCE_INLINE bool enabled(Level l) noexcept
+    {
+        return l >= detail::g_level.load(std::memory_order_relaxed);
+    }
+
+    // Log 1 in every n raw IRC lines at debug level; 0 turns raw logging off (the default).
+    inline void set_raw_sample_every(std::uint32_t n) noexcept
+    {
+        detail::g_raw_every.store(n, std::memory_order_relaxed);
+    }
+
+    // True when this raw line should be logged. Per-thread counter, so no shared cache line.
+    [[nodiscard]] TB_FORCE_INLINE bool sample_raw() noexcept
+    {
+        const auto n = detail::g_raw_every.load(std::memory_order_relaxed);
+        if (TB_LIKELY(n == 0) || !enabled(Level::debug))
+        {
+            return false;
+        }
+        thread_local std::uint32_t counter = 0;
+        return ++counter % n == 0;
+    }
+
+    // Enqueue one record. Never blocks: a full ring drops the record and counts it.
+    template<std::size_t C, typename... Args>
+    void write(Level l, const char (&component)[C], format_string<Args...> fmt, Args&&... args) noexcept
+    {
+        auto& ring = detail::thread_ring();
+        detail::Record* r = ring.try_claim();
+        if (!r)
+        {
+            return;
+        }
+        detail::fill(*r, l, component, fmt.get(), std::forward<Args>(args)...);
+        ring.publish();
+
+        if (l >= Level::error)
+        {
+            detail::logger().nudge();
+        }
+    }
+
+    // Synchronously drain all rings. Call before exit or after fatal errors.
+    inline void flush()
+    {
+        detail::logger().flush();
+    }
+
+} // namespace tb::log
+
+// Arguments are not evaluated when the level is disabled.
+#define TB_LOG(level, component, ...)                                  \
+    do                                                                 \
+    {                                                                  \
+        if (::tb::log::enabled(level))                                 \
+        {                                                              \
+            ::tb::log::write(level, component, __VA_ARGS__);           \
+        }                                                              \
+    } while (0)
+
+#define TB_LOG_TRACE(component, ...) TB_LOG(::tb::log::Level::trace, component, __VA_ARGS__)
+#define TB_LOG_DEBUG(component, ...) TB_LOG(::tb::log::Level::debug, component, __VA_ARGS__)
+#define TB_LOG_INFO(component, ...) TB_LOG(::tb::log::Level::info, component, __VA_ARGS__)
+#define TB_LOG_WARN(component, ...) TB_LOG(::tb::log::Level::warn, component, __VA_ARGS__)
+#define TB_LOG_ERROR(component, ...) TB_LOG(::tb::log::Level::error, component, __VA_ARGS__)
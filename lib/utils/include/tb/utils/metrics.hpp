@@ -0,0 +1,413 @@
+/*
+Module Name:
+- metrics.hpp
+
+Abstract:
+- Process metrics registry: counters, gauges and fixed-bucket histograms rendered as Prometheus text.
+- Usage: look a metric up once (cold, takes a lock), keep the reference, update it on the hot path.
+  auto& lines = tb::metrics::registry().counter("tb_irc_lines_total", "IRC lines", { { "direction", "in" } });
+  lines.inc();
+
+Why:
+- Updates are single relaxed atomics on their own cache line; nothing a strand does waits on a scrape.
+- Metrics are never removed, so references stay valid for the life of the process and render() only
+  holds the lock long enough to copy pointers.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tb::metrics
+{
+
+    class Counter
+    {
+    public:
+        void inc(std::uint64_t n = 1) noexcept
+        {
+            value_.fetch_add(n, std::memory_order_relaxed);
+        }
+        [[nodiscard]] std::uint64_t value() const noexcept
+        {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        alignas(64) std::atomic<std::uint64_t> value_{ 0 };
+    };
+
+    class Gauge
+    {
+    public:
+        void set(std::int64_t v) noexcept
+        {
+            value_.store(v, std::memory_order_relaxed);
+        }
+        void add(std::int64_t d) noexcept
+        {
+            value_.fetch_add(d, std::memory_order_relaxed);
+        }
+        [[nodiscard]] std::int64_t value() const noexcept
+        {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        alignas(64) std::atomic<std::int64_t> value_{ 0 };
+    };
+
+    // Latency buckets in seconds, 10 µs to 10 s; covers a parse and a Helix round trip alike.
+    inline constexpr std::array<double, 18> k_latency_buckets{ 0.00001, 0.00005, 0.0001, 0.00025, 0.0005, 0.001,
+                                                                0.0025, 0.005, 0.01, 0.025, 0.05, 0.1,
+                                                                0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+
+    class Histogram
+    {
+    public:
+        static constexpr std::size_t k_max_buckets = 24;
+
+        // bounds are upper bounds in seconds, ascending; at most k_max_buckets are kept.
+        explicit Histogram(std::span<const double> bounds) noexcept
+        {
+            count_bounds_ = std::min(bounds.size(), k_max_buckets);
+            for (std::size_t i = 0; i < count_bounds_; ++i)
+            {
+                bounds_[i] = bounds[i];
+                bounds_ns_[i] = static_cast<std::int64_t>(bounds[i] * 1e9);
+            }
+        }
+
+        void observe(std::chrono::nanoseconds d) noexcept
+        {
+            const auto ns = d.count();
+            std::size_t i = 0;
+            while (i < count_bounds_ && ns > bounds_ns_[i])
+            {
+                ++i;
+            }
+            buckets_[i].fetch_add(1, std::memory_order_relaxed); // i == count_bounds_ is +Inf
+            sum_ns_.fetch_add(static_cast<std::uint64_t>(std::max<std::int64_t>(ns, 0)), std::memory_order_relaxed);
+        }
+
+        template<class Rep, class Period>
+        void observe(std::chrono::duration<Rep, Period> d) noexcept
+        {
+            observe(std::chrono::duration_cast<std::chrono::nanoseconds>(d));
+        }
+
+        [[nodiscard]] std::uint64_t count() const noexcept
+        {
+            std::uint64_t n = 0;
+            for (std::size_t i = 0; i <= count_bounds_; ++i)
+            {
+                n += buckets_[i].load(std::memory_order_relaxed);
+            }
+            return n;
+        }
+
+        // Estimate from the buckets, interpolating linearly inside the one that holds the q-th observation.
+        // Past the last bound the answer is that bound. Zero when empty.
+        [[nodiscard]] std::chrono::nanoseconds quantile(double q) const noexcept
+        {
+            std::array<std::uint64_t, k_max_buckets + 1> counts{};
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i <= count_bounds_; ++i)
+            {
+                counts[i] = buckets_[i].load(std::memory_order_relaxed);
+                total += counts[i];
+            }
+            if (total == 0)
+            {
+                return std::chrono::nanoseconds{ 0 };
+            }
+            const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(total);
+            double below = 0;
+            for (std::size_t i = 0; i < count_bounds_; ++i)
+            {
+                if (below + static_cast<double>(counts[i]) >= rank && counts[i] != 0)
+                {
+                    const double lo = i == 0 ? 0.0 : static_cast<double>(bounds_ns_[i - 1]);
+                    const double hi = static_cast<double>(bounds_ns_[i]);
+                    return std::chrono::nanoseconds{ static_cast<std::int64_t>(lo + (hi - lo) * (rank - below) / static_cast<double>(counts[i])) };
+                }
+                below += static_cast<double>(counts[i]);
+            }
+            return std::chrono::nanoseconds{ count_bounds_ ? bounds_ns_[count_bounds_ - 1] : 0 };
+        }
+
+        // Appends the _bucket, _sum and _count lines. labels is "" or `k="v",...` without braces.
+        void render(std::string& out, std::string_view name, std::string_view labels) const
+        {
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i <= count_bounds_; ++i)
+            {
+                cumulative += buckets_[i].load(std::memory_order_relaxed);
+                out.append(name).append("_bucket{");
+                if (!labels.empty())
+                {
+                    out.append(labels).push_back(',');
+                }
+                out.append("le=\"");
+                if (i < count_bounds_)
+                {
+                    append_number(out, bounds_[i]);
+                }
+                else
+                {
+                    out.append("+Inf");
+                }
+                out.append("\"} ");
+                append_number(out, cumulative);
+                out.push_back('\n');
+            }
+            append_series(out, name, "_sum", labels);
+            append_number(out, static_cast<double>(sum_ns_.load(std::memory_order_relaxed)) / 1e9);
+            out.push_back('\n');
+            append_series(out, name, "_count", labels);
+            append_number(out, cumulative);
+            out.push_back('\n');
+        }
+
+        template<class T>
+        static void append_number(std::string& out, T v)
+        {
+            std::array<char, 32> buf{};
+            auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), v);
+            out.append(buf.data(), ec == std::errc{} ? end : buf.data());
+        }
+
+        static void append_series(std::string& out, std::string_view name, std::string_view suffix, std::string_view labels)
+        {
+            out.append(name).append(suffix);
+            if (!labels.empty())
+            {
+                out.push_back('{');
+                out.append(labels).push_back('}');
+            }
+            out.push_back(' ');
+        }
+
+    private:
+        std::array<double, k_max_buckets> bounds_{};
+        std::array<std::int64_t, k_max_buckets> bounds_ns_{};
+        std::size_t count_bounds_ = 0;
+
+        alignas(64) std::array<std::atomic<std::uint64_t>, k_max_buckets + 1> buckets_{};
+        std::atomic<std::uint64_t> sum_ns_{ 0 };
+    };
+
+    using Labels = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+    // Thread-safety: all members may be called from any thread.
+    class Registry
+    {
+    public:
+        // Same name and labels return the same metric. Throws std::logic_error if name has another type.
+        Counter& counter(std::string_view name, std::string_view help, Labels labels = {})
+        {
+            return *get(name, help, Type::counter, labels, {}).counter;
+        }
+
+        Gauge& gauge(std::string_view name, std::string_view help, Labels labels = {})
+        {
+            return *get(name, help, Type::gauge, labels, {}).gauge;
+        }
+
+        Histogram& histogram(std::string_view name,
+                             std::string_view help,
+                             Labels labels = {},
+                             std::span<const double> bounds = k_latency_buckets)
+        {
+            return *get(name, help, Type::histogram, labels, bounds).histogram;
+        }
+
+        // Prometheus text exposition format 0.0.4.
+        void render(std::string& out) const
+        {
+            // Pointers are collected under the lock and read after it: families, series and metrics
+            // are never erased, and deque::emplace_back keeps references to existing elements valid.
+            std::vector<std::pair<const Family*, std::vector<const Series*>>> snapshot;
+            {
+                std::lock_guard lk(mutex_);
+                snapshot.reserve(families_.size());
+                for (const auto& [name, f] : families_)
+                {
+                    auto& [family, series] = snapshot.emplace_back(&f, std::vector<const Series*>{});
+                    series.reserve(f.series.size());
+                    for (const auto& sr : f.series)
+                    {
+                        series.push_back(&sr);
+                    }
+                }
+            }
+
+            for (const auto& [f, series] : snapshot)
+            {
+                out.append("# HELP ").append(f->name).push_back(' ');
+                out.append(f->help).push_back('\n');
+                out.append("# TYPE ").append(f->name).push_back(' ');
+                out.append(type_name(f->type)).push_back('\n');
+                for (const Series* s : series)
+                {
+                    switch (f->type)
+                    {
+                    case Type::counter:
+                        Histogram::append_series(out, f->name, {}, s->labels);
+                        Histogram::append_number(out, s->counter->value());
+                        out.push_back('\n');
+                        break;
+                    case Type::gauge:
+                        Histogram::append_series(out, f->name, {}, s->labels);
+                        Histogram::append_number(out, s->gauge->value());
+                        out.push_back('\n');
+                        break;
+                    case Type::histogram:
+                        s->histogram->render(out, f->name, s->labels);
+                        break;
+                    }
+                }
+            }
+        }
+
+    private:
+        enum class Type : std::uint8_t
+        {
+            counter,
+            gauge,
+            histogram,
+        };
+
+        struct Series
+        {
+            std::string labels;
+            Counter* counter = nullptr;
+            Gauge* gauge = nullptr;
+            Histogram* histogram = nullptr;
+        };
+
+        struct Family
+        {
+            std::string name;
+            std::string help;
+            Type type;
+            std::deque<Series> series;
+        };
+
+        static constexpr std::string_view type_name(Type t) noexcept
+        {
+            switch (t)
+            {
+            case Type::counter:
+                return "counter";
+            case Type::gauge:
+                return "gauge";
+            case Type::histogram:
+                return "histogram";
+            }
+            return "untyped";
+        }
+
+        static std::string render_labels(Labels labels)
+        {
+            std::string out;
+            for (const auto& [k, v] : labels)
+            {
+                if (!out.empty())
+                {
+                    out.push_back(',');
+                }
+                out.append(k).append("=\"");
+                for (char c : v)
+                {
+                    if (c == '\\' || c == '"')
+                    {
+                        out.push_back('\\');
+                        out.push_back(c);
+                    }
+                    else if (c == '\n')
+                    {
+                        out.append("\\n");
+                    }
+                    else
+                    {
+                        out.push_back(c);
+                    }
+                }
+                out.push_back('"');
+            }
+            return out;
+        }
+
+        const Series& get(std::string_view name, std::string_view help, Type type, Labels labels, std::span<const double> bounds)
+        {
+            auto rendered = render_labels(labels);
+
+            std::lock_guard lk(mutex_);
+            auto it = families_.find(name);
+            if (it == families_.end())
+            {
+                it = families_.emplace(std::string{ name }, Family{ std::string{ name }, std::string{ help }, type, {} }).first;
+            }
+            Family& f = it->second;
+            if (f.type != type)
+            {
+                throw std::logic_error("metric '" + f.name + "' registered with another type");
+            }
+            for (const auto& s : f.series)
+            {
+                if (s.labels == rendered)
+                {
+                    return s;
+                }
+            }
+
+            Series s{ std::move(rendered) };
+            switch (f.type)
+            {
+            case Type::counter:
+                s.counter = &counters_.emplace_back();
+                break;
+            case Type::gauge:
+                s.gauge = &gauges_.emplace_back();
+                break;
+            case Type::histogram:
+                s.histogram = &histograms_.emplace_back(bounds.empty() ? std::span<const double>{ k_latency_buckets } : bounds);
+                break;
+            }
+            return f.series.emplace_back(std::move(s));
+        }
+
+        mutable std::mutex mutex_;
+        std::map<std::string, Family, std::less<>> families_;
+
+        // Stable addresses: deques never move existing elements on emplace_back.
+        std::deque<Counter> counters_;
+        std::deque<Gauge> gauges_;
+        std::deque<Histogram> histograms_;
+    };
+
+    // Process-wide registry scraped by the metrics endpoint.
+    [[nodiscard]] inline Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+
+} // namespace tb::metrics
@@ -0,0 +1,455 @@
+/*
+Module Name:
+- pattern_matcher.hpp
+
+Abstract:
+- Multi-pattern matcher for chat moderation and triggers: PatternSet collects (pattern, id, options)
+  and compile() produces an immutable Matcher. Matching is exact or ASCII case-insensitive per set.
+  Whole-word matching is chosen per pattern.
+- Matcher is an Aho-Corasick DFA over byte classes. Sets of up to 64 patterns also get a Teddy-style
+  SIMD prefilter (SSSE3 or NEON) that skips text no pattern can start in.
+- MatcherSlot holds the current Matcher for readers on any thread; store() swaps in a recompiled set.
+
+Why:
+- One pass over the line finds every pattern, where N find() calls read it N times.
+- Byte classes keep the DFA small: a row is as wide as the set's alphabet, not 256. Case folding
+  lives in the class map, so the text is never lowered.
+- Transitions hold the next row's offset with a match flag in the top bit, so the inner loop is two
+  dependent loads and one branch per byte.
+- The prefilter runs only while the DFA is at the root, where no partial match can be lost.
+  It checks nibble-table fingerprints of up to three bytes per pattern, 16 positions at a time.
+  Past 64 patterns the fingerprints match almost everywhere, so the DFA runs alone.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <tmmintrin.h>
+#define TB_MATCH_SSSE3 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define TB_MATCH_NEON 1
+#endif
+
+namespace tb::match
+{
+
+    struct Match
+    {
+        std::uint32_t id; // as passed to PatternSet::add
+        std::uint32_t start; // byte offsets into the text, [start, end)
+        std::uint32_t end;
+    };
+
+    struct PatternOptions
+    {
+        bool whole_word = false; // neighbours must not be [A-Za-z0-9_] or non-ASCII
+    };
+
+    namespace detail
+    {
+        [[nodiscard]] constexpr bool is_word_byte(unsigned char c) noexcept
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+        }
+
+        [[nodiscard]] constexpr unsigned char other_case(unsigned char c) noexcept
+        {
+            if (c >= 'a' && c <= 'z')
+            {
+                return static_cast<unsigned char>(c - 32);
+            }
+            if (c >= 'A' && c <= 'Z')
+            {
+                return static_cast<unsigned char>(c + 32);
+            }
+            return c;
+        }
+
+        // Teddy: per fingerprint byte, a low-nibble and a high-nibble table of 8 bucket bits.
+        class Teddy
+        {
+        public:
+            static constexpr std::size_t k_max_patterns = 64;
+            static constexpr std::size_t k_max_fingerprint = 3;
+
+            Teddy(const std::vector<std::string>& patterns, bool case_insensitive) noexcept
+            {
+                std::size_t min_len = std::numeric_limits<std::size_t>::max();
+                for (const auto& p : patterns)
+                {
+                    min_len = std::min(min_len, p.size());
+                }
+                k_ = std::min(min_len, k_max_fingerprint);
+                for (std::size_t i = 0; i < patterns.size(); ++i)
+                {
+                    const auto bucket = static_cast<std::uint8_t>(1u << (i % 8));
+                    for (std::size_t j = 0; j < k_; ++j)
+                    {
+                        const auto c = static_cast<unsigned char>(patterns[i][j]);
+                        add(j, c, bucket);
+                        if (case_insensitive)
+                        {
+                            add(j, other_case(c), bucket);
+                        }
+                    }
+                }
+            }
+
+            // First position >= from where some pattern may start, or n.
+            [[nodiscard]] std::size_t next(const unsigned char* d, std::size_t n, std::size_t from) const noexcept
+            {
+                std::size_t p = from;
+#if defined(TB_MATCH_SSSE3) || defined(TB_MATCH_NEON)
+                for (; p + 16 + k_ - 1 <= n; p += 16)
+                {
+                    if (const auto hit = block(d + p); hit != 16)
+                    {
+                        return p + hit;
+                    }
+                }
+#endif
+                for (; p + k_ <= n; ++p)
+                {
+                    std::uint8_t acc = 0xFF;
+                    for (std::size_t j = 0; j < k_; ++j)
+                    {
+                        acc = static_cast<std::uint8_t>(acc & lo_[j][d[p + j] & 15] & hi_[j][d[p + j] >> 4]);
+                    }
+                    if (acc)
+                    {
+                        return p;
+                    }
+                }
+                return n; // too few bytes left for any pattern
+            }
+
+        private:
+            void add(std::size_t j, unsigned char c, std::uint8_t bucket) noexcept
+            {
+                lo_[j][c & 15] |= bucket;
+                hi_[j][c >> 4] |= bucket;
+            }
+
+#if defined(TB_MATCH_SSSE3)
+            // Offset of the first candidate in d[0, 16), or 16.
+            [[nodiscard]] std::size_t block(const unsigned char* d) const noexcept
+            {
+                const __m128i nib = _mm_set1_epi8(0x0F);
+                __m128i acc = _mm_set1_epi8(static_cast<char>(0xFF));
+                for (std::size_t j = 0; j < k_; ++j)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d + j));
+                    const __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lo_[j].data())), _mm_and_si128(v, nib));
+                    const __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hi_[j].data())), _mm_and_si128(_mm_srli_epi16(v, 4), nib));
+                    acc = _mm_and_si128(acc, _mm_and_si128(lo, hi));
+                }
+                const auto empty = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())));
+                const auto found = ~empty & 0xFFFFu;
+                return found ? static_cast<std::size_t>(std::countr_zero(found)) : 16;
+            }
+#elif defined(TB_MATCH_NEON)
+            [[nodiscard]] std::size_t block(const unsigned char* d) const noexcept
+            {
+                const uint8x16_t nib = vdupq_n_u8(0x0F);
+                uint8x16_t acc = vdupq_n_u8(0xFF);
+                for (std::size_t j = 0; j < k_; ++j)
+                {
+                    const uint8x16_t v = vld1q_u8(d + j);
+                    const uint8x16_t lo = vqtbl1q_u8(vld1q_u8(lo_[j].data()), vandq_u8(v, nib));
+                    const uint8x16_t hi = vqtbl1q_u8(vld1q_u8(hi_[j].data()), vshrq_n_u8(v, 4));
+                    acc = vandq_u8(acc, vandq_u8(lo, hi));
+                }
+                if (vmaxvq_u8(acc) == 0)
+                {
+                    return 16;
+                }
+                alignas(16) std::array<std::uint8_t, 16> lanes;
+                vst1q_u8(lanes.data(), acc);
+                for (std::size_t i = 0; i < 16; ++i)
+                {
+                    if (lanes[i])
+                    {
+                        return i;
+                    }
+                }
+                return 16;
+            }
+#endif
+
+            std::size_t k_ = 1;
+            alignas(16) std::array<std::array<std::uint8_t, 16>, k_max_fingerprint> lo_{};
+            alignas(16) std::array<std::array<std::uint8_t, 16>, k_max_fingerprint> hi_{};
+        };
+    } // namespace detail
+
+    class PatternSet;
+
+    class Matcher
+    {
+    public:
+        // on_match(const Match&) returns false to stop. Matches come in order of their end offset.
+        template<class OnMatch>
+        void for_each(std::string_view text, OnMatch&& on_match) const
+        {
+            const auto* d = reinterpret_cast<const unsigned char*>(text.data());
+            const std::size_t n = text.size();
+            std::uint32_t row = 0;
+            for (std::size_t i = 0; i < n;)
+            {
+                if (row == 0 && teddy_)
+                {
+                    i = teddy_->next(d, n, i);
+                    if (i >= n)
+                    {
+                        return;
+                    }
+                }
+                const auto t = trans_[row + classes_[d[i++]]];
+                row = t & ~k_match_bit;
+                if ((t & k_match_bit) == 0)
+                {
+                    continue;
+                }
+
+                const auto state = row / width_;
+                for (auto k = out_begin_[state]; k < out_begin_[state + 1]; ++k)
+                {
+                    const auto p = out_[k];
+                    const auto start = i - lengths_[p];
+                    if (whole_word_[p] && ((start > 0 && detail::is_word_byte(d[start - 1])) || (i < n && detail::is_word_byte(d[i]))))
+                    {
+                        continue;
+                    }
+                    if (!on_match(Match{ ids_[p], static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(i) }))
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] std::optional<Match> first(std::string_view text) const
+        {
+            std::optional<Match> out;
+            for_each(text, [&out](const Match& m) {
+                out = m;
+                return false;
+            });
+            return out;
+        }
+
+        [[nodiscard]] bool any(std::string_view text) const
+        {
+            return first(text).has_value();
+        }
+
+        [[nodiscard]] std::size_t pattern_count() const noexcept
+        {
+            return ids_.size();
+        }
+
+        [[nodiscard]] bool prefiltered() const noexcept
+        {
+            return teddy_.has_value();
+        }
+
+    private:
+        friend class PatternSet;
+        static constexpr std::uint32_t k_match_bit = 0x8000'0000u;
+
+        Matcher() = default;
+
+        std::array<std::uint8_t, 256> classes_{}; // byte -> class; 0 is "in no pattern"
+        std::uint32_t width_ = 1; // classes per row
+        std::vector<std::uint32_t> trans_; // row offset of the next state | k_match_bit
+        std::vector<std::uint32_t> out_begin_; // per state, into out_
+        std::vector<std::uint32_t> out_; // pattern indices, own and inherited through fail links
+        std::vector<std::uint32_t> ids_;
+        std::vector<std::uint32_t> lengths_;
+        std::vector<std::uint8_t> whole_word_;
+        std::optional<detail::Teddy> teddy_;
+    };
+
+    class PatternSet
+    {
+    public:
+        // Empty patterns are ignored. The same text may be added under several ids.
+        void add(std::string_view pattern, std::uint32_t id, PatternOptions options = {})
+        {
+            if (pattern.empty())
+            {
+                return;
+            }
+            patterns_.emplace_back(pattern);
+            ids_.push_back(id);
+            whole_word_.push_back(options.whole_word ? 1 : 0);
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return patterns_.size();
+        }
+
+        [[nodiscard]] std::shared_ptr<const Matcher> compile(bool case_insensitive = true) const
+        {
+            constexpr auto k_none = std::numeric_limits<std::uint32_t>::max();
+            std::shared_ptr<Matcher> m{ new Matcher() };
+
+            // Byte classes; folding both cases into one class makes the DFA case-insensitive.
+            std::uint32_t classes = 1;
+            for (const auto& p : patterns_)
+            {
+                for (const char ch : p)
+                {
+                    const auto c = static_cast<unsigned char>(ch);
+                    if (m->classes_[c] == 0)
+                    {
+                        m->classes_[c] = static_cast<std::uint8_t>(classes);
+                        if (case_insensitive && detail::other_case(c) != c)
+                        {
+                            m->classes_[detail::other_case(c)] = static_cast<std::uint8_t>(classes);
+                        }
+                        ++classes;
+                    }
+                }
+            }
+            const std::uint32_t width = classes; // at most 256
+            m->width_ = width;
+
+            // Trie.
+            std::vector<std::uint32_t> next(width, k_none);
+            std::vector<std::vector<std::uint32_t>> outputs(1);
+            for (std::uint32_t i = 0; i < patterns_.size(); ++i)
+            {
+                std::uint32_t s = 0;
+                for (const char ch : patterns_[i])
+                {
+                    auto& slot = next[s * width + m->classes_[static_cast<unsigned char>(ch)]];
+                    if (slot == k_none)
+                    {
+                        slot = static_cast<std::uint32_t>(outputs.size());
+                        outputs.emplace_back();
+                        next.resize(next.size() + width, k_none);
+                    }
+                    s = next[s * width + m->classes_[static_cast<unsigned char>(ch)]];
+                }
+                outputs[s].push_back(i);
+            }
+            const auto states = static_cast<std::uint32_t>(outputs.size());
+            if (static_cast<std::uint64_t>(states) * width >= Matcher::k_match_bit)
+            {
+                throw std::length_error("PatternSet: automaton too large");
+            }
+
+            // Breadth-first fail links turn the trie into a complete DFA.
+            std::vector<std::uint32_t> fail(states, 0);
+            std::deque<std::uint32_t> queue;
+            for (std::uint32_t c = 0; c < width; ++c)
+            {
+                auto& t = next[c];
+                if (t == k_none)
+                {
+                    t = 0;
+                }
+                else
+                {
+                    queue.push_back(t);
+                }
+            }
+            while (!queue.empty())
+            {
+                const auto s = queue.front();
+                queue.pop_front();
+                const auto& inherited = outputs[fail[s]];
+                outputs[s].insert(outputs[s].end(), inherited.begin(), inherited.end());
+                for (std::uint32_t c = 0; c < width; ++c)
+                {
+                    auto& t = next[s * width + c];
+                    if (t == k_none)
+                    {
+                        t = next[fail[s] * width + c];
+                    }
+                    else
+                    {
+                        fail[t] = next[fail[s] * width + c];
+                        queue.push_back(t);
+                    }
+                }
+            }
+
+            // Flatten: row offsets with the match flag, and one output run per state.
+            m->trans_.resize(next.size());
+            for (std::size_t k = 0; k < next.size(); ++k)
+            {
+                const auto t = next[k];
+                m->trans_[k] = t * width | (outputs[t].empty() ? 0 : Matcher::k_match_bit);
+            }
+            m->out_begin_.reserve(states + 1);
+            for (const auto& o : outputs)
+            {
+                m->out_begin_.push_back(static_cast<std::uint32_t>(m->out_.size()));
+                m->out_.insert(m->out_.end(), o.begin(), o.end());
+            }
+            m->out_begin_.push_back(static_cast<std::uint32_t>(m->out_.size()));
+
+            m->ids_ = ids_;
+            m->whole_word_ = whole_word_;
+            m->lengths_.reserve(patterns_.size());
+            for (const auto& p : patterns_)
+            {
+                m->lengths_.push_back(static_cast<std::uint32_t>(p.size()));
+            }
+            if (!patterns_.empty() && patterns_.size() <= detail::Teddy::k_max_patterns)
+            {
+                m->teddy_.emplace(patterns_, case_insensitive);
+            }
+            return m;
+        }
+
+    private:
+        std::vector<std::string> patterns_;
+        std::vector<std::uint32_t> ids_;
+        std::vector<std::uint8_t> whole_word_;
+    };
+
+    // The current Matcher for a trigger or filter. Readers pin it for the duration of one line.
+    class MatcherSlot
+    {
+    public:
+        explicit MatcherSlot(std::shared_ptr<const Matcher> initial) noexcept :
+            current_{ std::move(initial) }
+        {
+        }
+
+        [[nodiscard]] std::shared_ptr<const Matcher> load() const noexcept
+        {
+            return current_.load(std::memory_order_acquire);
+        }
+
+        // Lines already being matched finish on the old set.
+        void store(std::shared_ptr<const Matcher> next) noexcept
+        {
+            current_.store(std::move(next), std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::shared_ptr<const Matcher>> current_;
+    };
+
+} // namespace tb::match
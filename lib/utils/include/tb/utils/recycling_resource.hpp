@@ -0,0 +1,312 @@
+/*
+Module Name:
+- recycling_resource.hpp
+
+Abstract:
+- A process-wide std::pmr::memory_resource backed by per-thread free lists. Size classes are 64 B steps
+  up to 1 KiB, then powers of two up to 128 KiB.
+- tb::memory::recycling_allocator() returns a polymorphic_allocator over it, for asio::bind_allocator
+  at hot co_spawn sites; tb::memory::Slab draws the blocks that carry a line between threads.
+
+Why:
+- Dispatch and PONG allocate and free the same few block sizes on every line. After warm-up a block
+  is reused from a free list, with no lock and no call into malloc.
+- Every block remembers the cache that allocated it, and a free always returns it there. A free from
+  another thread goes onto the owner's lock-free remote stack, and the owner drains that stack when
+  its own list runs dry. A line read on one core and released on another is therefore back in the
+  reader's list for the next line. Without this, the reader would call malloc for every line while
+  the lane threads' lists filled up and overflowed.
+- A cache outlives its thread: on exit it is parked, and the next new thread adopts it, so the owner
+  of an outstanding block is always a live cache.
+- Lists are bounded per class (64 blocks, or 256 KiB for large classes), so a burst cannot pin memory
+  after it is over. Blocks over 128 KiB, or over-aligned ones, go straight to ::operator new.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace tb::memory
+{
+
+    namespace detail
+    {
+        class ThreadCache
+        {
+        public:
+            static constexpr std::size_t k_granule = 64;
+            static constexpr std::size_t k_small_classes = 16; // 64 B .. 1 KiB
+            static constexpr std::size_t k_classes = k_small_classes + 7; // then 2 KiB .. 128 KiB
+            static constexpr std::size_t k_max_block = std::size_t{ 1024 } << 7;
+            static constexpr std::size_t k_max_cached = 64; // blocks per class
+            static constexpr std::size_t k_class_budget = 256 * 1024; // bytes per large class
+
+            // Prefixed to every cached block. Keeps the payload at the default new alignment.
+            struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) Header
+            {
+                ThreadCache* owner; // null: allocated without a cache, freed with ::operator delete
+                std::size_t cls;
+            };
+
+            [[nodiscard]] static constexpr std::size_t class_of(std::size_t bytes) noexcept
+            {
+                if (bytes <= k_granule * k_small_classes)
+                {
+                    return bytes == 0 ? 0 : (bytes - 1) / k_granule;
+                }
+                std::size_t cls = k_small_classes; // 2 KiB
+                for (auto v = (bytes - 1) >> 11; v != 0; v >>= 1)
+                {
+                    ++cls;
+                }
+                return cls;
+            }
+
+            [[nodiscard]] static constexpr std::size_t class_size(std::size_t cls) noexcept
+            {
+                return cls < k_small_classes ? (cls + 1) * k_granule : std::size_t{ 1024 } << (cls - k_small_classes + 1);
+            }
+
+            [[nodiscard]] static constexpr std::size_t class_cap(std::size_t cls) noexcept
+            {
+                return std::clamp<std::size_t>(k_class_budget / class_size(cls), 4, k_max_cached);
+            }
+
+            // Owner thread only.
+            Header* take(std::size_t cls) noexcept
+            {
+                if (!heads_[cls])
+                {
+                    drain_remote();
+                }
+                Node* n = heads_[cls];
+                if (!n)
+                {
+                    return nullptr;
+                }
+                heads_[cls] = n->next;
+                --counts_[cls];
+                return header_of(n);
+            }
+
+            // Owner thread only.
+            void give(Header* h) noexcept
+            {
+                const auto cls = h->cls;
+                if (counts_[cls] >= class_cap(cls))
+                {
+                    ::operator delete(h);
+                    return;
+                }
+                heads_[cls] = ::new (h + 1) Node{ heads_[cls] };
+                ++counts_[cls];
+            }
+
+            // Any thread. The block waits on the remote stack until the owner next runs dry.
+            void give_remote(Header* h) noexcept
+            {
+                Node* n = ::new (h + 1) Node{ remote_.load(std::memory_order_relaxed) };
+                while (!remote_.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            // Owner thread only; called when the thread exits and the cache is parked.
+            void release_local() noexcept
+            {
+                for (auto& head : heads_)
+                {
+                    while (head)
+                    {
+                        Node* next = head->next;
+                        ::operator delete(header_of(head));
+                        head = next;
+                    }
+                }
+                counts_.fill(0);
+            }
+
+        private:
+            struct Node
+            {
+                Node* next;
+            };
+
+            static Header* header_of(Node* n) noexcept
+            {
+                return reinterpret_cast<Header*>(n) - 1;
+            }
+
+            // Only the owner pops, and it takes the whole stack at once, so there is no ABA.
+            void drain_remote() noexcept
+            {
+                Node* n = remote_.exchange(nullptr, std::memory_order_acquire);
+                while (n)
+                {
+                    Node* next = n->next;
+                    give(header_of(n));
+                    n = next;
+                }
+            }
+
+            std::array<Node*, k_classes> heads_{};
+            std::array<std::size_t, k_classes> counts_{};
+            alignas(64) std::atomic<Node*> remote_{ nullptr };
+        };
+
+        // Caches are never freed: parked ones wait here for the next thread. Leaked on purpose so
+        // thread exits during static destruction still have somewhere to park.
+        struct CacheRegistry
+        {
+            std::mutex mutex;
+            std::vector<ThreadCache*> parked;
+        };
+
+        inline CacheRegistry& cache_registry() noexcept
+        {
+            static auto* registry = new CacheRegistry;
+            return *registry;
+        }
+
+        enum class CacheState : std::uint8_t
+        {
+            none,
+            live,
+            exited, // thread_local destructors are running; no cache any more
+        };
+
+        inline thread_local CacheState t_cache_state = CacheState::none;
+
+        struct CacheLease
+        {
+            CacheLease() noexcept
+            {
+                auto& r = cache_registry();
+                {
+                    std::lock_guard lk(r.mutex);
+                    if (!r.parked.empty())
+                    {
+                        cache = r.parked.back();
+                        r.parked.pop_back();
+                    }
+                }
+                if (!cache)
+                {
+                    cache = new (std::nothrow) ThreadCache;
+                }
+                t_cache_state = CacheState::live;
+            }
+
+            ~CacheLease()
+            {
+                t_cache_state = CacheState::exited;
+                if (!cache)
+                {
+                    return;
+                }
+                cache->release_local();
+                try
+                {
+                    auto& r = cache_registry();
+                    std::lock_guard lk(r.mutex);
+                    r.parked.push_back(cache);
+                }
+                catch (...)
+                {
+                    // Out of memory at thread exit: the cache leaks, which is still safe.
+                }
+            }
+
+            CacheLease(const CacheLease&) = delete;
+            CacheLease& operator=(const CacheLease&) = delete;
+
+            ThreadCache* cache = nullptr;
+        };
+
+        // Null once the thread has started tearing down, or if no cache could be made.
+        inline ThreadCache* thread_cache() noexcept
+        {
+            if (t_cache_state == CacheState::exited)
+            {
+                return nullptr;
+            }
+            thread_local CacheLease lease;
+            return lease.cache;
+        }
+    } // namespace detail
+
+    class RecyclingResource final : public std::pmr::memory_resource
+    {
+    private:
+        using cache = detail::ThreadCache;
+        using header = cache::Header;
+
+        [[nodiscard]] static bool cached(std::size_t bytes, std::size_t alignment) noexcept
+        {
+            return bytes <= cache::k_max_block && alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+        }
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            if (!cached(bytes, alignment))
+            {
+                return ::operator new(bytes, std::align_val_t{ alignment });
+            }
+            const auto cls = cache::class_of(bytes);
+            auto* owner = detail::thread_cache();
+            header* h = owner ? owner->take(cls) : nullptr;
+            if (!h)
+            {
+                h = ::new (::operator new(sizeof(header) + cache::class_size(cls))) header{ owner, cls };
+            }
+            return h + 1;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept override
+        {
+            if (!cached(bytes, alignment))
+            {
+                ::operator delete(p, std::align_val_t{ alignment });
+                return;
+            }
+            auto* h = static_cast<header*>(p) - 1;
+            if (!h->owner)
+            {
+                ::operator delete(h);
+            }
+            else if (h->owner == detail::thread_cache())
+            {
+                h->owner->give(h);
+            }
+            else
+            {
+                h->owner->give_remote(h);
+            }
+        }
+
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    [[nodiscard]] inline RecyclingResource& recycling_resource() noexcept
+    {
+        static RecyclingResource instance;
+        return instance;
+    }
+
+    [[nodiscard]] inline std::pmr::polymorphic_allocator<std::byte> recycling_allocator() noexcept
+    {
+        return std::pmr::polymorphic_allocator<std::byte>{ &recycling_resource() };
+    }
+
+} // namespace tb::memory
@@ -0,0 +1,129 @@
+/*
+Module Name:
+- slab.hpp
+
+Abstract:
+- Slab: an immutable, reference-counted byte buffer drawn from tb::memory::recycling_resource().
+- Slab::copy_of(parts...) concatenates string views into one new slab. Copying a Slab shares it, and
+  the last copy to go returns the block to the pool.
+
+Why:
+- One routed chat line can reach a command handler, several triggers and worker-pool listeners, on
+  different threads. Sharing one copy costs an atomic increment per consumer, where a string copy
+  per consumer costs an allocation and a memcpy each.
+- The count and the bytes share one pooled block, so a line is one allocation when it is made and
+  none after warm-up.
+- The bytes never change after copy_of, so shared readers need no synchronisation beyond the count.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <string_view>
+#include <utility>
+
+// Core
+#include "recycling_resource.hpp"
+
+namespace tb::memory
+{
+
+    class Slab
+    {
+    public:
+        Slab() noexcept = default;
+
+        // Pre: total size below 4 GiB.
+        [[nodiscard]] static Slab copy_of(std::initializer_list<std::string_view> parts)
+        {
+            std::size_t size = 0;
+            for (const auto p : parts)
+            {
+                size += p.size();
+            }
+            void* block = recycling_resource().allocate(sizeof(Header) + size, alignof(Header));
+            auto* h = ::new (block) Header{ { 1 }, static_cast<std::uint32_t>(size) };
+            char* out = reinterpret_cast<char*>(h + 1);
+            for (const auto p : parts)
+            {
+                if (!p.empty())
+                {
+                    std::memcpy(out, p.data(), p.size());
+                    out += p.size();
+                }
+            }
+            return Slab{ h };
+        }
+
+        Slab(const Slab& other) noexcept :
+            h_{ other.h_ }
+        {
+            if (h_)
+            {
+                h_->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        Slab(Slab&& other) noexcept :
+            h_{ std::exchange(other.h_, nullptr) }
+        {
+        }
+
+        Slab& operator=(Slab other) noexcept
+        {
+            std::swap(h_, other.h_);
+            return *this;
+        }
+
+        ~Slab()
+        {
+            if (h_ && h_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                const std::size_t bytes = sizeof(Header) + h_->size;
+                h_->~Header();
+                recycling_resource().deallocate(h_, bytes, alignof(Header));
+            }
+        }
+
+        [[nodiscard]] const char* data() const noexcept
+        {
+            return h_ ? reinterpret_cast<const char*>(h_ + 1) : nullptr;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return h_ ? h_->size : 0;
+        }
+
+        [[nodiscard]] std::string_view view() const noexcept
+        {
+            return { data(), size() };
+        }
+
+        // Holders of this slab, including this one; 0 when empty.
+        [[nodiscard]] std::uint32_t use_count() const noexcept
+        {
+            return h_ ? h_->refs.load(std::memory_order_relaxed) : 0;
+        }
+
+    private:
+        struct Header
+        {
+            std::atomic<std::uint32_t> refs;
+            std::uint32_t size;
+        };
+
+        explicit Slab(Header* h) noexcept :
+            h_{ h }
+        {
+        }
+
+        Header* h_ = nullptr;
+    };
+
+} // namespace tb::memory
@@ -0,0 +1,214 @@
+/*
+Module Name:
+- timing_wheel.hpp
+
+Abstract:
+- Hierarchical timing wheel over integer ticks: three levels of 64 slots, so 262144 ticks ahead.
+- schedule(key, due) files a 64-bit key; advance(now, on_due) calls on_due(key) for everything due.
+  on_due returns the next due tick to keep the key, or 0 to drop it.
+
+Why:
+- Scheduling and expiry are O(1) per item. Compare that with a heap, whose every push and pop pays
+  log n cache misses.
+- Each level keeps a 64-bit occupancy mask, and advance() jumps straight to the next occupied slot or
+  cascade boundary. An idle gap of any length costs a few bit scans, not one step per tick.
+- Nodes live in a pool sized at construction and are linked by index, so nothing allocates after
+  that. The owner bounds memory by picking the capacity.
+- Due ticks past the top level are filed at the horizon and come back through on_due early. The owner
+  checks its own deadline and reschedules.
+- Not thread safe. One owner, one thread (or strand) at a time.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace tb::timing
+{
+
+    class TimingWheel
+    {
+    public:
+        static constexpr unsigned k_bits = 6;
+        static constexpr std::uint64_t k_slots = 1u << k_bits;
+        static constexpr unsigned k_levels = 3;
+        static constexpr std::uint64_t k_horizon = std::uint64_t{ 1 } << (k_bits * k_levels);
+
+        explicit TimingWheel(std::uint32_t capacity) :
+            nodes_(capacity)
+        {
+            for (auto& level : heads_)
+            {
+                level.fill(k_nil);
+            }
+            for (std::uint32_t i = 0; i < capacity; ++i)
+            {
+                nodes_[i].next = i + 1 < capacity ? i + 1 : k_nil;
+            }
+            free_ = capacity ? 0 : k_nil;
+        }
+
+        // False when the pool is full.
+        bool schedule(std::uint64_t key, std::uint64_t due) noexcept
+        {
+            if (free_ == k_nil)
+            {
+                return false;
+            }
+            const auto n = free_;
+            free_ = nodes_[n].next;
+            nodes_[n].key = key;
+            nodes_[n].due = due;
+            place(n, now_ + 1);
+            ++size_;
+            return true;
+        }
+
+        template<class OnDue>
+        void advance(std::uint64_t now, OnDue&& on_due) noexcept(noexcept(on_due(std::uint64_t{})))
+        {
+            if (now <= now_)
+            {
+                return;
+            }
+            while (size_ != 0)
+            {
+                const auto next = next_event();
+                if (next > now)
+                {
+                    break;
+                }
+                now_ = next;
+                if ((now_ & (k_slots - 1)) == 0)
+                {
+                    if ((now_ & (k_slots * k_slots - 1)) == 0)
+                    {
+                        cascade(2);
+                    }
+                    cascade(1);
+                }
+                fire(on_due);
+            }
+            now_ = now;
+        }
+
+        [[nodiscard]] std::uint32_t size() const noexcept
+        {
+            return size_;
+        }
+
+        [[nodiscard]] std::uint64_t now() const noexcept
+        {
+            return now_;
+        }
+
+    private:
+        static constexpr std::uint32_t k_nil = std::numeric_limits<std::uint32_t>::max();
+
+        struct Node
+        {
+            std::uint64_t key = 0;
+            std::uint64_t due = 0;
+            std::uint32_t next = k_nil;
+        };
+
+        // Offset of the first occupied slot at or after index from, wrapping; k_slots when none is.
+        [[nodiscard]] static std::uint64_t next_occupied(std::uint64_t occupied, std::uint64_t from) noexcept
+        {
+            const auto bits = std::rotr(occupied, static_cast<int>(from & (k_slots - 1)));
+            return bits != 0 ? static_cast<std::uint64_t>(std::countr_zero(bits)) : k_slots;
+        }
+
+        // The earliest tick after now_ that fires a level-0 slot or cascades an occupied higher slot.
+        // A slot at level l is reached every 64^(l+1) ticks, and nothing is filed further ahead than
+        // that, so the first match after now_ is the right one.
+        [[nodiscard]] std::uint64_t next_event() const noexcept
+        {
+            auto next = std::numeric_limits<std::uint64_t>::max();
+            for (unsigned level = 0; level < k_levels; ++level)
+            {
+                if (occupied_[level] == 0)
+                {
+                    continue;
+                }
+                const auto shift = k_bits * level;
+                const auto first = (now_ >> shift) + 1;
+                next = std::min(next, (first + next_occupied(occupied_[level], first)) << shift);
+            }
+            return next;
+        }
+
+        // earliest is now_ + 1 for new and rescheduled items, whose tick has already fired. A cascade
+        // passes now_: an item due on the cascade tick itself lands in the level-0 slot fired next.
+        void place(std::uint32_t n, std::uint64_t earliest) noexcept
+        {
+            auto due = std::max(nodes_[n].due, earliest);
+            if (due - now_ >= k_horizon)
+            {
+                due = now_ + k_horizon - 1;
+            }
+
+            const auto delta = due - now_;
+            unsigned level = 0;
+            while (level + 1 < k_levels && delta >= (std::uint64_t{ 1 } << (k_bits * (level + 1))))
+            {
+                ++level;
+            }
+            const auto slot = (due >> (k_bits * level)) & (k_slots - 1);
+            nodes_[n].next = heads_[level][slot];
+            heads_[level][slot] = n;
+            occupied_[level] |= std::uint64_t{ 1 } << slot;
+        }
+
+        void cascade(unsigned level) noexcept
+        {
+            const auto slot = (now_ >> (k_bits * level)) & (k_slots - 1);
+            auto n = std::exchange(heads_[level][slot], k_nil);
+            occupied_[level] &= ~(std::uint64_t{ 1 } << slot);
+            while (n != k_nil)
+            {
+                const auto next = nodes_[n].next;
+                place(n, now_);
+                n = next;
+            }
+        }
+
+        template<class OnDue>
+        void fire(OnDue& on_due)
+        {
+            const auto slot = now_ & (k_slots - 1);
+            auto n = std::exchange(heads_[0][slot], k_nil);
+            occupied_[0] &= ~(std::uint64_t{ 1 } << slot);
+            while (n != k_nil)
+            {
+                const auto next = nodes_[n].next;
+                if (const auto again = on_due(nodes_[n].key); again != 0)
+                {
+                    nodes_[n].due = again;
+                    place(n, now_ + 1);
+                }
+                else
+                {
+                    nodes_[n].next = free_;
+                    free_ = n;
+                    --size_;
+                }
+                n = next;
+            }
+        }
+
+        std::vector<Node> nodes_;
+        std::array<std::array<std::uint32_t, k_slots>, k_levels> heads_{};
+        std::array<std::uint64_t, k_levels> occupied_{}; // bit s set: heads_[level][s] is non-empty
+        std::uint32_t free_ = k_nil;
+        std::uint32_t size_ = 0;
+        std::uint64_t now_ = 0;
+    };
+
+} // namespace tb::timing
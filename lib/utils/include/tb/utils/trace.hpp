@@ -0,0 +1,295 @@
+/*
+Module Name:
+- trace.hpp
+
+Abstract:
+- Hot-path spans recorded into per-thread flight-recorder rings and exported as Chrome trace-event
+  JSON (chrome://tracing, ui.perfetto.dev).
+- TB_TRACE_SPAN("irc.parse") times the enclosing scope. Without TB_ENABLE_TRACING it expands to nothing.
+- write_chrome_trace() snapshots every ring; dump_detached() does it on a throwaway thread.
+
+Usage:
+- Build with -DENABLE_TRACING=ON, then `kill -USR1 <pid>` or `!trace` in the control channel.
+
+Why:
+- A p99 spike is over before anyone can attach a profiler; the last few thousand spans per thread
+  are always there to dump.
+- Rings overwrite the oldest span and never block. Each slot carries a sequence number so a dump
+  taken while a thread writes skips the torn slot instead of locking the writer.
+*/
+#pragma once
+
+// C++ Standard Library
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Core
+#include <tb/utils/log.hpp>
+
+namespace tb::trace
+{
+
+    [[nodiscard]] constexpr bool compiled_in() noexcept
+    {
+#if defined(TB_ENABLE_TRACING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    namespace detail
+    {
+        using clock = std::chrono::steady_clock;
+
+        inline const clock::time_point g_epoch = clock::now();
+
+        [[nodiscard]] inline std::uint64_t now_ns() noexcept
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - g_epoch).count());
+        }
+
+        struct Event
+        {
+            const char* name;
+            std::uint64_t start_ns;
+            std::uint64_t dur_ns;
+        };
+
+        // Single writer (the owning thread), any number of snapshot readers.
+        class Ring
+        {
+        public:
+            static constexpr std::size_t k_capacity = 4096; // power of two
+
+            explicit Ring(std::uint32_t thread_id) noexcept :
+                tid{ thread_id }
+            {
+            }
+
+            void record(const char* name, std::uint64_t start_ns, std::uint64_t dur_ns) noexcept
+            {
+                const auto h = head_.load(std::memory_order_relaxed);
+                Slot& s = slots_[h & (k_capacity - 1)];
+                s.seq.store(2 * h + 1, std::memory_order_relaxed); // odd: being written
+                std::atomic_thread_fence(std::memory_order_release);
+                s.name.store(name, std::memory_order_relaxed);
+                s.start_ns.store(start_ns, std::memory_order_relaxed);
+                s.dur_ns.store(dur_ns, std::memory_order_relaxed);
+                s.seq.store(2 * h + 2, std::memory_order_release);
+                head_.store(h + 1, std::memory_order_release);
+            }
+
+            void snapshot(std::vector<Event>& out) const
+            {
+                const auto h = head_.load(std::memory_order_acquire);
+                const auto first = h > k_capacity ? h - k_capacity : 0;
+                for (auto i = first; i < h; ++i)
+                {
+                    const Slot& s = slots_[i & (k_capacity - 1)];
+                    const auto seq = s.seq.load(std::memory_order_acquire);
+                    Event e{ s.name.load(std::memory_order_relaxed), s.start_ns.load(std::memory_order_relaxed), s.dur_ns.load(std::memory_order_relaxed) };
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (seq != 2 * i + 2 || s.seq.load(std::memory_order_relaxed) != seq)
+                    {
+                        continue; // overwritten or mid-write
+                    }
+                    out.push_back(e);
+                }
+            }
+
+            const std::uint32_t tid;
+
+        private:
+            friend struct RingInternals; // tests stage a write caught halfway
+
+            struct Slot
+            {
+                std::atomic<std::uint64_t> seq{ 0 };
+                std::atomic<const char*> name{ nullptr };
+                std::atomic<std::uint64_t> start_ns{ 0 };
+                std::atomic<std::uint64_t> dur_ns{ 0 };
+            };
+
+            std::array<Slot, k_capacity> slots_{};
+            alignas(64) std::atomic<std::uint64_t> head_{ 0 };
+        };
+
+        // Rings outlive their threads so a dump still shows what an exited thread did last.
+        class Registry
+        {
+        public:
+            std::shared_ptr<Ring> register_thread()
+            {
+                std::lock_guard lk(mutex_);
+                auto ring = std::make_shared<Ring>(static_cast<std::uint32_t>(rings_.size() + 1));
+                rings_.push_back(ring);
+                return ring;
+            }
+
+            [[nodiscard]] std::vector<std::shared_ptr<Ring>> rings() const
+            {
+                std::lock_guard lk(mutex_);
+                return rings_;
+            }
+
+        private:
+            mutable std::mutex mutex_;
+            std::vector<std::shared_ptr<Ring>> rings_;
+        };
+
+        inline Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        inline Ring& thread_ring()
+        {
+            thread_local std::shared_ptr<Ring> ring = registry().register_thread();
+            return *ring;
+        }
+
+        inline void append_json_string(std::string& out, const char* s)
+        {
+            out.push_back('"');
+            for (; s && *s; ++s)
+            {
+                const auto c = static_cast<unsigned char>(*s);
+                if (c == '"' || c == '\\')
+                {
+                    out.push_back('\\');
+                }
+                else if (c < 0x20)
+                {
+                    // Control characters are not allowed raw inside a JSON string.
+                    constexpr char k_hex[] = "0123456789abcdef";
+                    out.append("\\u00");
+                    out.push_back(k_hex[c >> 4]);
+                    out.push_back(k_hex[c & 0xf]);
+                    continue;
+                }
+                out.push_back(*s);
+            }
+            out.push_back('"');
+        }
+    } // namespace detail
+
+    // Times its scope. name must be a string literal (only the pointer is stored).
+    class Span
+    {
+    public:
+        explicit Span(const char* name) noexcept :
+            name_{ name }, start_{ detail::now_ns() }
+        {
+        }
+
+        ~Span()
+        {
+            detail::thread_ring().record(name_, start_, detail::now_ns() - start_);
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* name_;
+        std::uint64_t start_;
+    };
+
+    // Render every ring as trace-event JSON ("X" complete events, microsecond timestamps).
+    inline void render_chrome_trace(std::string& out)
+    {
+        std::vector<detail::Event> events;
+        events.reserve(detail::Ring::k_capacity);
+
+        out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        bool first = true;
+        char num[64];
+        for (const auto& ring : detail::registry().rings())
+        {
+            events.clear();
+            ring->snapshot(events);
+            for (const auto& e : events)
+            {
+                if (!first)
+                {
+                    out.push_back(',');
+                }
+                first = false;
+                out.append("{\"name\":");
+                detail::append_json_string(out, e.name);
+                const int n = std::snprintf(num,
+                                            sizeof(num),
+                                            ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                                            ring->tid,
+                                            static_cast<double>(e.start_ns) / 1000.0,
+                                            static_cast<double>(e.dur_ns) / 1000.0);
+                out.append(num, n > 0 ? static_cast<std::size_t>(n) : 0);
+            }
+        }
+        out.append("]}\n");
+    }
+
+    // Returns false if the file could not be written.
+    inline bool write_chrome_trace(const std::filesystem::path& path)
+    {
+        std::string json;
+        render_chrome_trace(json);
+
+        std::FILE* f = std::fopen(path.string().c_str(), "wb");
+        if (!f)
+        {
+            return false;
+        }
+        const bool ok = std::fwrite(json.data(), 1, json.size(), f) == json.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    // Dump without holding up the caller's executor; the result is logged.
+    inline void dump_detached(std::filesystem::path path)
+    {
+        if constexpr (!compiled_in())
+        {
+            TB_LOG_WARN("trace", "tracing is compiled out; rebuild with ENABLE_TRACING=ON");
+            return;
+        }
+        std::thread([path = std::move(path)] {
+            if (write_chrome_trace(path))
+            {
+                TB_LOG_INFO("trace", "wrote {}", path.string());
+            }
+            else
+            {
+                TB_LOG_ERROR("trace", "cannot write {}", path.string());
+            }
+        }).detach();
+    }
+
+    // Timestamped file name in the working directory, e.g. "trace-1718000000.json".
+    [[nodiscard]] inline std::filesystem::path default_dump_path()
+    {
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        return std::filesystem::path{ "trace-" + std::to_string(secs) + ".json" };
+    }
+
+} // namespace tb::trace
+
+#define TB_TRACE_CONCAT_INNER(a, b) a##b
+#define TB_TRACE_CONCAT(a, b) TB_TRACE_CONCAT_INNER(a, b)
+
+#if defined(TB_ENABLE_TRACING)
+#define TB_TRACE_SPAN(name) const ::tb::trace::Span TB_TRACE_CONCAT(tb_trace_span_, __LINE__)(name)
+#else
+#define TB_TRACE_SPAN(name) static_cast<void>(0)
+#endif
@@ -0,0 +1,222 @@
+/*
+Module Name:
+- happy_eyeballs_test.cpp
+
+Abstract:
+- tb::net::EndpointHistory ordering: families interleave from the resolver's first answer and recent
+  failures go last, fewest first, until the penalty window passes.
+- tb::net::happy_eyeballs_connect on loopback. A refused port fails over without waiting out the
+  attempt delay. A silent port (a listener whose accept queue is full drops SYNs) is only joined by
+  the next attempt after the delay, then loses and is cancelled without being penalised. A race of
+  silent ports times out and penalises them.
+*/
+
+// C++ Standard Library
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+// Boost.System
+#include <boost/system/system_error.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/net/tcp/happy_eyeballs.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using boost::asio::ip::tcp;
+    using clock_type = std::chrono::steady_clock;
+    using tb::net::EndpointHistory;
+    using tb::net::HappyEyeballsOptions;
+
+    tcp::endpoint ep(const char* address, unsigned short port)
+    {
+        return { boost::asio::ip::make_address(address), port };
+    }
+
+    tcp::resolver::results_type results(const std::vector<tcp::endpoint>& endpoints)
+    {
+        return tcp::resolver::results_type::create(endpoints.begin(), endpoints.end(), "test", "0");
+    }
+
+    // A loopback port with nothing listening: connects are refused at once.
+    tcp::endpoint refused_endpoint(boost::asio::io_context& io)
+    {
+        tcp::acceptor probe{ io, tcp::endpoint{ boost::asio::ip::address_v4::loopback(), 0 } };
+        const auto out = probe.local_endpoint();
+        probe.close(); // bound but never listened on, so the port is free again
+        return out;
+    }
+
+    // A listening port that never answers: the one-slot accept queue is filled and never drained,
+    // so the kernel drops further SYNs and a connect hangs until cancelled.
+    struct SilentPort
+    {
+        explicit SilentPort(boost::asio::io_context& io) :
+            acceptor{ io, tcp::endpoint{ boost::asio::ip::address_v4::loopback(), 0 } }, filler{ io }
+        {
+            acceptor.listen(0);
+            filler.connect(acceptor.local_endpoint());
+            std::this_thread::sleep_for(20ms); // let the handshake land in the queue
+        }
+
+        tcp::endpoint endpoint() const
+        {
+            return acceptor.local_endpoint();
+        }
+
+        tcp::acceptor acceptor;
+        tcp::socket filler;
+    };
+
+    struct Outcome
+    {
+        std::optional<tcp::endpoint> peer;
+        boost::system::error_code error;
+        clock_type::duration took{};
+    };
+
+    Outcome race(boost::asio::io_context& io, const std::vector<tcp::endpoint>& endpoints, EndpointHistory* history, HappyEyeballsOptions options)
+    {
+        Outcome out;
+        const auto start = clock_type::now();
+        boost::asio::co_spawn(
+            io,
+            [&]() -> boost::asio::awaitable<void> {
+                try
+                {
+                    auto s = co_await tb::net::happy_eyeballs_connect(io.get_executor(), results(endpoints), history, options);
+                    out.peer = s.remote_endpoint();
+                }
+                catch (const boost::system::system_error& err)
+                {
+                    out.error = err.code();
+                }
+                out.took = clock_type::now() - start;
+            },
+            boost::asio::detached);
+        io.run();
+        io.restart();
+        return out;
+    }
+
+    TEST(EndpointHistory, InterleavesFamiliesFromTheFirstAnswer)
+    {
+        const auto v6a = ep("2001:db8::1", 443);
+        const auto v6b = ep("2001:db8::2", 443);
+        const auto v6c = ep("2001:db8::3", 443);
+        const auto v4a = ep("192.0.2.1", 443);
+        const auto v4b = ep("192.0.2.2", 443);
+
+        EndpointHistory history;
+        EXPECT_EQ(history.order(results({ v6a, v6b, v6c, v4a, v4b })), (std::vector<tcp::endpoint>{ v6a, v4a, v6b, v4b, v6c }));
+        EXPECT_EQ(history.order(results({ v4a, v6a, v6b, v4b })), (std::vector<tcp::endpoint>{ v4a, v6a, v4b, v6b }));
+        EXPECT_EQ(history.order(results({ v4a, v4b })), (std::vector<tcp::endpoint>{ v4a, v4b }));
+    }
+
+    TEST(EndpointHistory, RecentFailuresGoLastFewestFirst)
+    {
+        const auto v6a = ep("2001:db8::1", 443);
+        const auto v6b = ep("2001:db8::2", 443);
+        const auto v4a = ep("192.0.2.1", 443);
+        const auto v4b = ep("192.0.2.2", 443);
+        const auto all = results({ v6a, v6b, v4a, v4b });
+
+        EndpointHistory history;
+        history.record_failure(v6a);
+        history.record_failure(v6a);
+        history.record_failure(v4a);
+        EXPECT_EQ(history.order(all), (std::vector<tcp::endpoint>{ v6b, v4b, v4a, v6a }));
+
+        history.record_success(v6a);
+        EXPECT_EQ(history.order(all), (std::vector<tcp::endpoint>{ v6a, v6b, v4b, v4a }));
+
+        // Outside the penalty window a failure no longer counts.
+        EndpointHistory forgetful{ std::chrono::seconds::zero() };
+        forgetful.record_failure(v6a);
+        EXPECT_EQ(forgetful.order(all), (std::vector<tcp::endpoint>{ v6a, v4a, v6b, v4b }));
+    }
+
+    TEST(HappyEyeballs, RefusedEndpointFailsOverWithoutTheDelay)
+    {
+        boost::asio::io_context io;
+        tcp::acceptor listener{ io, tcp::endpoint{ boost::asio::ip::address_v4::loopback(), 0 } };
+        listener.listen();
+        const auto good = listener.local_endpoint();
+        const auto bad = refused_endpoint(io);
+
+        EndpointHistory history;
+        const auto out = race(io, { bad, good }, &history, { .attempt_delay = 5s, .timeout = 10s });
+
+        ASSERT_TRUE(out.peer.has_value()) << out.error.message();
+        EXPECT_EQ(*out.peer, good);
+        EXPECT_LT(out.took, 2s); // the refusal started the next attempt at once
+        EXPECT_EQ(history.order(results({ bad, good })), (std::vector<tcp::endpoint>{ good, bad }));
+    }
+
+    TEST(HappyEyeballs, SilentEndpointIsRacedAfterTheDelayAndCancelled)
+    {
+        boost::asio::io_context io;
+        SilentPort silent{ io };
+        tcp::acceptor listener{ io, tcp::endpoint{ boost::asio::ip::address_v4::loopback(), 0 } };
+        listener.listen();
+        const auto good = listener.local_endpoint();
+
+        EndpointHistory history;
+        const auto out = race(io, { silent.endpoint(), good }, &history, { .attempt_delay = 150ms, .timeout = 10s });
+
+        ASSERT_TRUE(out.peer.has_value()) << out.error.message();
+        EXPECT_EQ(*out.peer, good);
+        EXPECT_GE(out.took, 150ms); // staggered: the second attempt waited for the delay
+        EXPECT_LT(out.took, 2s);
+
+        // The loser was cancelled, not failed: it keeps its place for the next race.
+        EXPECT_EQ(history.order(results({ silent.endpoint(), good })), (std::vector<tcp::endpoint>{ silent.endpoint(), good }));
+    }
+
+    TEST(HappyEyeballs, TimeoutFailsTheRaceAndPenalisesPendingAttempts)
+    {
+        boost::asio::io_context io;
+        SilentPort silent{ io };
+        tcp::acceptor listener{ io, tcp::endpoint{ boost::asio::ip::address_v4::loopback(), 0 } };
+        listener.listen();
+        const auto good = listener.local_endpoint();
+
+        EndpointHistory history;
+        const auto out = race(io, { silent.endpoint() }, &history, { .attempt_delay = 50ms, .timeout = 200ms });
+
+        EXPECT_FALSE(out.peer.has_value());
+        EXPECT_EQ(out.error, boost::asio::error::timed_out);
+        EXPECT_GE(out.took, 200ms);
+        EXPECT_LT(out.took, 2s);
+
+        // Blackholed, so the next race tries it last.
+        EXPECT_EQ(history.order(results({ silent.endpoint(), good })), (std::vector<tcp::endpoint>{ good, silent.endpoint() }));
+    }
+
+    TEST(HappyEyeballs, EveryEndpointRefusedReportsTheLastError)
+    {
+        boost::asio::io_context io;
+        const auto bad = refused_endpoint(io);
+
+        const auto out = race(io, { bad }, nullptr, { .attempt_delay = 5s, .timeout = 10s });
+
+        EXPECT_FALSE(out.peer.has_value());
+        EXPECT_EQ(out.error, boost::asio::error::connection_refused);
+        EXPECT_LT(out.took, 2s);
+    }
+} // namespace
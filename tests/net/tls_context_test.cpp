@@ -0,0 +1,162 @@
+/*
+Module Name:
+- tls_context_test.cpp
+
+Abstract:
+- tb::net::TlsContextFactory::configure: the first call wins, a second call is a no-op that returns
+  false, and process() is built from the first options.
+- make_context() applies the same policy and shares the factory's X509_STORE instead of loading a copy.
+- The per-host session cache: a handshake against an in-memory server (a self-signed certificate
+  trusted through the shared store, over a BIO pair) stores the session for its SNI host, prepare()
+  offers it on the next connection, which resumes, and forget_session() drops it.
+*/
+
+// C++ Standard Library
+#include <memory>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// OpenSSL
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+// Core
+#include <tb/net/tls/tls_context.hpp>
+
+namespace
+{
+    using tb::net::TlsContextFactory;
+    using tb::net::TlsOptions;
+
+    struct SslFree
+    {
+        void operator()(SSL* p) const noexcept { ::SSL_free(p); }
+        void operator()(SSL_CTX* p) const noexcept { ::SSL_CTX_free(p); }
+        void operator()(EVP_PKEY* p) const noexcept { ::EVP_PKEY_free(p); }
+        void operator()(X509* p) const noexcept { ::X509_free(p); }
+    };
+
+    template<class T>
+    using Owned = std::unique_ptr<T, SslFree>;
+
+    TlsOptions offline()
+    {
+        TlsOptions o;
+        o.platform_store = false; // nothing here needs the OS bundle
+        return o;
+    }
+
+    // A server for "localhost" whose certificate the factory's store trusts.
+    struct Server
+    {
+        explicit Server(TlsContextFactory& factory) :
+            key{ ::EVP_EC_gen("P-256") }, cert{ ::X509_new() }, ctx{ ::SSL_CTX_new(::TLS_server_method()) }
+        {
+            ::X509_set_version(cert.get(), 2);
+            ::ASN1_INTEGER_set(::X509_get_serialNumber(cert.get()), 1);
+            ::X509_gmtime_adj(::X509_getm_notBefore(cert.get()), -60);
+            ::X509_gmtime_adj(::X509_getm_notAfter(cert.get()), 3600);
+            X509_NAME* name = ::X509_get_subject_name(cert.get());
+            ::X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+            ::X509_set_issuer_name(cert.get(), name);
+            X509_EXTENSION* san = ::X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name, "DNS:localhost");
+            ::X509_add_ext(cert.get(), san, -1);
+            ::X509_EXTENSION_free(san);
+            ::X509_set_pubkey(cert.get(), key.get());
+            ::X509_sign(cert.get(), key.get(), ::EVP_sha256());
+
+            ::SSL_CTX_use_certificate(ctx.get(), cert.get());
+            ::SSL_CTX_use_PrivateKey(ctx.get(), key.get());
+            ::X509_STORE_add_cert(::SSL_CTX_get_cert_store(factory.context().native_handle()), cert.get());
+        }
+
+        Owned<EVP_PKEY> key;
+        Owned<X509> cert;
+        Owned<SSL_CTX> ctx;
+    };
+
+    // One client connection to server over a BIO pair. Returns the client once the handshake is done
+    // and a byte of application data has been read, by which time any TLS 1.3 ticket has arrived.
+    Owned<SSL> connect(TlsContextFactory& factory, Server& server, bool& offered)
+    {
+        Owned<SSL> client{ ::SSL_new(factory.context().native_handle()) };
+        Owned<SSL> peer{ ::SSL_new(server.ctx.get()) };
+        BIO* client_bio = nullptr;
+        BIO* server_bio = nullptr;
+        ::BIO_new_bio_pair(&client_bio, 0, &server_bio, 0);
+        ::SSL_set_bio(client.get(), client_bio, client_bio);
+        ::SSL_set_bio(peer.get(), server_bio, server_bio);
+        ::SSL_set_connect_state(client.get());
+        ::SSL_set_accept_state(peer.get());
+
+        offered = factory.prepare(client.get(), "localhost");
+
+        bool client_done = false;
+        bool server_done = false;
+        for (int i = 0; i < 100 && !(client_done && server_done); ++i)
+        {
+            client_done = client_done || ::SSL_do_handshake(client.get()) == 1;
+            server_done = server_done || ::SSL_do_handshake(peer.get()) == 1;
+        }
+        EXPECT_TRUE(client_done && server_done) << "verify result " << ::SSL_get_verify_result(client.get());
+
+        char byte = 'x';
+        EXPECT_EQ(::SSL_write(peer.get(), &byte, 1), 1);
+        int read = 0;
+        for (int i = 0; i < 100 && read <= 0; ++i)
+        {
+            read = ::SSL_read(client.get(), &byte, 1);
+        }
+        EXPECT_EQ(read, 1);
+        return client;
+    }
+
+    TEST(TlsContextFactory, FirstConfigureWinsAndLaterOnesAreNoOps)
+    {
+        auto first = offline();
+        first.tls13_only = true;
+        EXPECT_TRUE(TlsContextFactory::configure(first));
+        EXPECT_FALSE(TlsContextFactory::configure(offline())); // tls13_only stays set
+
+        auto& process = TlsContextFactory::process();
+        EXPECT_EQ(&process, &TlsContextFactory::process());
+        EXPECT_EQ(::SSL_CTX_get_min_proto_version(process.context().native_handle()), TLS1_3_VERSION);
+        EXPECT_FALSE(TlsContextFactory::configure(first)); // too late once built
+    }
+
+    TEST(TlsContextFactory, MadeContextsShareOneTrustStoreAndThePolicy)
+    {
+        TlsContextFactory factory{ offline() };
+        const auto a = factory.make_context();
+        const auto b = factory.make_context();
+
+        X509_STORE* shared = ::SSL_CTX_get_cert_store(factory.context().native_handle());
+        ASSERT_NE(shared, nullptr);
+        EXPECT_EQ(::SSL_CTX_get_cert_store(a->native_handle()), shared);
+        EXPECT_EQ(::SSL_CTX_get_cert_store(b->native_handle()), shared);
+        EXPECT_EQ(::SSL_CTX_get_min_proto_version(a->native_handle()), TLS1_2_VERSION);
+        EXPECT_EQ(::SSL_CTX_get_verify_mode(a->native_handle()), SSL_VERIFY_PEER);
+    }
+
+    TEST(TlsContextFactory, SessionCacheStoresAndOffersTheHostSession)
+    {
+        TlsContextFactory factory{ offline() };
+        Server server{ factory };
+
+        bool offered = true;
+        const auto first = connect(factory, server, offered);
+        EXPECT_FALSE(offered); // nothing cached yet
+        EXPECT_EQ(::SSL_session_reused(first.get()), 0);
+
+        const auto second = connect(factory, server, offered);
+        EXPECT_TRUE(offered);
+        EXPECT_EQ(::SSL_session_reused(second.get()), 1);
+
+        factory.forget_session("localhost");
+        const auto third = connect(factory, server, offered);
+        EXPECT_FALSE(offered);
+    }
+} // namespace
@@ -0,0 +1,461 @@
+/*
+Module Name:
+- command_dispatcher_test.cpp
+
+Abstract:
+- twitch_bot::CommandDispatcher handler budgets on a one-thread runtime: a handler that never finishes
+  is cancelled at its timeout, a run past max_concurrency is dropped without touching the handler, and
+  command_stats() reports in-flight, error and timeout counts with aliases folded into one row.
+- Lanes on a four-thread pool: interleaved lines for several channels start their handlers in each
+  channel's arrival order, and a channel held up on one lane does not hold up a channel on another.
+- Listener policies: sample_every passes 1 line in N, an inline listener is shed while its lane is
+  backlogged past shed_above_depth, and a worker-pool listener drops lines once its queue is full.
+  Each drop is counted under tb_chat_listener_dropped_total with its reason.
+- Metrics are process-wide and keyed by command or listener name, so every test uses names of its own.
+*/
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/command_dispatcher.hpp>
+#include <tb/twitch/runtime.hpp>
+#include <tb/utils/metrics.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using boost::asio::awaitable;
+    using twitch_bot::CommandDispatcher;
+    using twitch_bot::CommandStats;
+    using twitch_bot::HandlerBudget;
+    using twitch_bot::IrcMessage;
+    using twitch_bot::ListenerExecution;
+
+    // Polls pred for up to five seconds; handlers finish on the runtime's thread.
+    template<class Pred>
+    bool eventually(Pred pred)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!pred())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(2ms);
+        }
+        return true;
+    }
+
+    std::optional<CommandStats> stats_for(const CommandDispatcher& d, std::string_view name)
+    {
+        for (auto& s : d.command_stats())
+        {
+            if (s.name == name)
+            {
+                return s;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::uint64_t dropped(std::string_view listener, std::string_view reason)
+    {
+        return tb::metrics::registry().counter("tb_chat_listener_dropped_total", "", { { "listener", listener }, { "reason", reason } }).value();
+    }
+
+    std::int64_t lane_depth(std::size_t lane)
+    {
+        return tb::metrics::registry().gauge("tb_dispatch_queue_depth", "", { { "lane", std::to_string(lane) } }).value();
+    }
+
+    // Sleeps in short steps until release is set, so a test can hold a run open.
+    auto held_until(std::atomic<bool>& release, std::atomic<int>& started)
+    {
+        return [&release, &started](IrcMessage) -> awaitable<void> {
+            started.fetch_add(1);
+            boost::asio::steady_timer t{ co_await boost::asio::this_coro::executor };
+            while (!release.load())
+            {
+                t.expires_after(2ms);
+                co_await t.async_wait(boost::asio::use_awaitable);
+            }
+        };
+    }
+
+    class CommandDispatcherTest : public testing::Test
+    {
+    protected:
+        CommandDispatcherTest() :
+            driver_{ [this] { runtime.run(); } }
+        {
+        }
+
+        // The dispatcher must outlive every line in flight, so the runtime stops first.
+        ~CommandDispatcherTest() override
+        {
+            runtime.stop();
+            driver_.join();
+        }
+
+        twitch_bot::Runtime runtime{ { .threads = 1 } };
+        CommandDispatcher dispatcher{ runtime };
+
+    private:
+        std::thread driver_;
+    };
+
+    // Four pool threads behind four strand lanes, so lines for different channels really overlap.
+    // Pool threads run from construction; run() only joins them, so it is the last step here.
+    class CommandDispatcherLanesTest : public testing::Test
+    {
+    protected:
+        static constexpr std::size_t k_lanes = 4;
+
+        ~CommandDispatcherLanesTest() override
+        {
+            runtime.stop();
+            runtime.run();
+        }
+
+        // Mirrors CommandDispatcher::lane_for.
+        static std::size_t lane_of(std::string_view channel)
+        {
+            return std::hash<std::string_view>{}(channel) % k_lanes;
+        }
+
+        twitch_bot::Runtime runtime{ { .mode = twitch_bot::ExecutionMode::shared_pool, .threads = k_lanes } };
+        CommandDispatcher dispatcher{ runtime, k_lanes };
+    };
+
+    TEST_F(CommandDispatcherTest, HandlerPastItsTimeoutIsCancelled)
+    {
+        std::promise<bool> cancelled;
+        dispatcher.register_command(
+            "budget_timeout",
+            [&cancelled](IrcMessage) -> awaitable<void> {
+                boost::asio::steady_timer never{ co_await boost::asio::this_coro::executor, 1h };
+                try
+                {
+                    co_await never.async_wait(boost::asio::use_awaitable);
+                }
+                catch (const boost::system::system_error&)
+                {
+                    cancelled.set_value(true);
+                    throw;
+                }
+                cancelled.set_value(false);
+            },
+            {},
+            {},
+            HandlerBudget{ .timeout = 50ms });
+        dispatcher.freeze();
+
+        const auto t0 = std::chrono::steady_clock::now();
+        dispatcher.dispatch_text("chan", "user", "!budget_timeout");
+        auto result = cancelled.get_future();
+        ASSERT_EQ(result.wait_for(5s), std::future_status::ready);
+        EXPECT_TRUE(result.get());
+        EXPECT_GE(std::chrono::steady_clock::now() - t0, 45ms);
+
+        ASSERT_TRUE(eventually([&] { return stats_for(dispatcher, "budget_timeout")->in_flight == 0; }));
+        const auto s = *stats_for(dispatcher, "budget_timeout");
+        EXPECT_EQ(s.invocations, 1u);
+        EXPECT_EQ(s.timeouts, 1u);
+        EXPECT_EQ(s.errors, 0u); // the cancellation surfacing is not an error
+    }
+
+    TEST_F(CommandDispatcherTest, RunPastMaxConcurrencyIsRejected)
+    {
+        std::atomic<bool> release{ false };
+        std::atomic<int> started{ 0 };
+        dispatcher.register_command("budget_busy", held_until(release, started), {}, {}, HandlerBudget{ .timeout = 0ms, .max_concurrency = 1 });
+        dispatcher.freeze();
+
+        // Same channel, so the second line is routed after the first has taken the only slot.
+        dispatcher.dispatch_text("chan", "user", "!budget_busy");
+        dispatcher.dispatch_text("chan", "user", "!budget_busy");
+        ASSERT_TRUE(eventually([&] { return stats_for(dispatcher, "budget_busy")->busy_rejects == 1; }));
+        EXPECT_EQ(started.load(), 1);
+        EXPECT_EQ(stats_for(dispatcher, "budget_busy")->in_flight, 1);
+
+        // Once the slot frees, the next run is admitted.
+        release.store(true);
+        ASSERT_TRUE(eventually([&] { return stats_for(dispatcher, "budget_busy")->in_flight == 0; }));
+        dispatcher.dispatch_text("other", "user", "!budget_busy");
+        ASSERT_TRUE(eventually([&] { return started.load() == 2; }));
+
+        ASSERT_TRUE(eventually([&] { return stats_for(dispatcher, "budget_busy")->in_flight == 0; }));
+        const auto s = *stats_for(dispatcher, "budget_busy");
+        EXPECT_EQ(s.invocations, 2u);
+        EXPECT_EQ(s.busy_rejects, 1u);
+    }
+
+    TEST_F(CommandDispatcherTest, StatsReportInFlightErrorsAndTimeouts)
+    {
+        std::atomic<bool> release{ false };
+        std::atomic<int> started{ 0 };
+        dispatcher.register_command("stats_hold", held_until(release, started));
+        dispatcher.register_command(
+            "stats_boom", [](IrcMessage) -> awaitable<void> {
+                throw std::runtime_error{ "handler failed" };
+                co_return;
+            },
+            { "stats_b" });
+        dispatcher.register_command(
+            "stats_slow", [](IrcMessage) -> awaitable<void> {
+                boost::asio::steady_timer never{ co_await boost::asio::this_coro::executor, 1h };
+                co_await never.async_wait(boost::asio::use_awaitable);
+            },
+            {},
+            {},
+            HandlerBudget{ .timeout = 20ms });
+        dispatcher.freeze();
+
+        dispatcher.dispatch_text("chan", "user", "!stats_hold");
+        dispatcher.dispatch_text("chan", "user", "!stats_boom");
+        dispatcher.dispatch_text("chan", "user", "!stats_b now");
+        dispatcher.dispatch_text("chan", "user", "!stats_slow");
+
+        ASSERT_TRUE(eventually([&] {
+            const auto boom = stats_for(dispatcher, "stats_boom");
+            const auto slow = stats_for(dispatcher, "stats_slow");
+            return boom->errors == 2 && slow->timeouts == 1 && slow->in_flight == 0;
+        }));
+
+        auto hold = *stats_for(dispatcher, "stats_hold");
+        EXPECT_EQ(hold.invocations, 1u);
+        EXPECT_EQ(hold.in_flight, 1);
+
+        const auto boom = *stats_for(dispatcher, "stats_boom");
+        EXPECT_EQ(boom.invocations, 2u); // the alias shares the row
+        EXPECT_EQ(boom.errors, 2u);
+        EXPECT_EQ(boom.timeouts, 0u);
+        EXPECT_EQ(boom.in_flight, 0);
+        EXPECT_FALSE(stats_for(dispatcher, "stats_b").has_value());
+
+        const auto slow = *stats_for(dispatcher, "stats_slow");
+        EXPECT_EQ(slow.timeouts, 1u);
+        EXPECT_EQ(slow.errors, 0u);
+        EXPECT_GE(slow.max, 15ms);
+
+        release.store(true);
+        ASSERT_TRUE(eventually([&] { return stats_for(dispatcher, "stats_hold")->in_flight == 0; }));
+
+        // Rows come back sorted by name.
+        std::vector<std::string> names;
+        for (const auto& s : dispatcher.command_stats())
+        {
+            names.push_back(s.name);
+        }
+        EXPECT_EQ(names, (std::vector<std::string>{ "stats_boom", "stats_hold", "stats_slow" }));
+    }
+
+    TEST_F(CommandDispatcherLanesTest, EachChannelStartsHandlersInArrivalOrder)
+    {
+        constexpr int k_per_channel = 200;
+        const std::vector<std::string> channels{ "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel" };
+
+        std::mutex m;
+        std::map<std::string, std::vector<int>, std::less<>> started;
+        std::atomic<int> total{ 0 };
+        dispatcher.register_command("lane_seq", [&](IrcMessage msg) -> awaitable<void> {
+            {
+                std::lock_guard lk(m);
+                started[std::string{ msg.param(0) }].push_back(std::stoi(std::string{ msg.trailing() }));
+            }
+            total.fetch_add(1);
+            co_return;
+        });
+        dispatcher.freeze();
+
+        // Round-robin over the channels, so every lane has lines for several channels interleaved.
+        for (int i = 0; i < k_per_channel; ++i)
+        {
+            for (const auto& ch : channels)
+            {
+                dispatcher.dispatch_text(ch, "user", "!lane_seq " + std::to_string(i));
+            }
+        }
+        ASSERT_TRUE(eventually([&] { return total.load() == k_per_channel * static_cast<int>(channels.size()); }));
+
+        std::vector<int> want(k_per_channel);
+        for (int i = 0; i < k_per_channel; ++i)
+        {
+            want[i] = i;
+        }
+        std::lock_guard lk(m);
+        ASSERT_EQ(started.size(), channels.size());
+        for (const auto& ch : channels)
+        {
+            EXPECT_EQ(started[ch], want) << ch;
+        }
+    }
+
+    TEST_F(CommandDispatcherLanesTest, ChannelsOnOtherLanesRunWhileOneIsHeld)
+    {
+        const std::string held = "held";
+        std::string other;
+        for (int i = 0; other.empty() || lane_of(other) == lane_of(held); ++i)
+        {
+            other = "other" + std::to_string(i);
+        }
+
+        // The held channel's listener waits, on its own lane, for the other channel's line to arrive.
+        std::atomic<bool> other_seen{ false };
+        std::atomic<int> held_result{ -1 };
+        dispatcher.register_chat_listener(
+            [&](std::string_view channel, std::string_view, std::string_view) {
+                if (channel == other)
+                {
+                    other_seen.store(true);
+                    return;
+                }
+                held_result.store(eventually([&] { return other_seen.load(); }) ? 1 : 0);
+            },
+            { .name = "lane_parallel", .shed_above_depth = 0 });
+
+        dispatcher.dispatch_text(held, "user", "first");
+        dispatcher.dispatch_text(other, "user", "second");
+        ASSERT_TRUE(eventually([&] { return held_result.load() != -1; }));
+        EXPECT_EQ(held_result.load(), 1);
+    }
+
+    TEST_F(CommandDispatcherTest, SampledListenerSeesOneLineInN)
+    {
+        std::mutex m;
+        std::vector<std::string> sampled;
+        std::atomic<int> all{ 0 };
+        dispatcher.register_chat_listener([&](std::string_view, std::string_view, std::string_view) { all.fetch_add(1); },
+                                          { .name = "sample_all", .shed_above_depth = 0 });
+        dispatcher.register_chat_listener(
+            [&](std::string_view, std::string_view, std::string_view text) {
+                std::lock_guard lk(m);
+                sampled.emplace_back(text);
+            },
+            { .name = "sample_third", .sample_every = 3, .shed_above_depth = 0 });
+
+        for (int i = 0; i < 10; ++i)
+        {
+            dispatcher.dispatch_text("chan", "user", std::to_string(i));
+        }
+        ASSERT_TRUE(eventually([&] { return all.load() == 10; }));
+
+        std::lock_guard lk(m);
+        EXPECT_EQ(sampled, (std::vector<std::string>{ "0", "3", "6", "9" }));
+        EXPECT_EQ(dropped("sample_third", "shed"), 0u); // sampling is not load shedding
+    }
+
+    TEST_F(CommandDispatcherTest, InlineListenerIsShedWhileTheLaneIsBacklogged)
+    {
+        ASSERT_EQ(lane_depth(0), 0); // earlier tests leave the shared lane gauge drained
+
+        // The gate holds the only lane on the first line, so the rest queue up behind it.
+        std::atomic<bool> release{ false };
+        std::atomic<bool> held{ false };
+        dispatcher.register_chat_listener(
+            [&](std::string_view, std::string_view, std::string_view text) {
+                if (text == "0")
+                {
+                    held.store(true);
+                    (void)eventually([&] { return release.load(); });
+                }
+            },
+            { .name = "shed_gate", .shed_above_depth = 0 });
+
+        std::mutex m;
+        std::vector<std::string> seen;
+        dispatcher.register_chat_listener(
+            [&](std::string_view, std::string_view, std::string_view text) {
+                std::lock_guard lk(m);
+                seen.emplace_back(text);
+            },
+            { .name = "shed_inline", .shed_above_depth = 3 });
+
+        dispatcher.dispatch_text("chan", "user", "0");
+        ASSERT_TRUE(eventually([&] { return held.load(); }));
+        for (int i = 1; i <= 10; ++i)
+        {
+            dispatcher.dispatch_text("chan", "user", std::to_string(i));
+        }
+        EXPECT_EQ(lane_depth(0), 10);
+        release.store(true);
+
+        // Line k is routed with 10 - k lines still behind it; above 3 the listener gives way.
+        ASSERT_TRUE(eventually([&] {
+            std::lock_guard lk(m);
+            return lane_depth(0) == 0 && dropped("shed_inline", "shed") + seen.size() == 11;
+        }));
+        std::lock_guard lk(m);
+        EXPECT_EQ(seen, (std::vector<std::string>{ "0", "7", "8", "9", "10" }));
+        EXPECT_EQ(dropped("shed_inline", "shed"), 6u);
+        EXPECT_EQ(dropped("shed_gate", "shed"), 0u); // 0 never sheds
+    }
+
+    TEST_F(CommandDispatcherTest, PooledListenerDropsLinesPastItsQueue)
+    {
+        std::atomic<bool> release{ false };
+        std::mutex m;
+        std::vector<std::string> seen;
+        dispatcher.register_chat_listener(
+            [&](std::string_view, std::string_view, std::string_view text) {
+                {
+                    std::lock_guard lk(m);
+                    seen.emplace_back(text);
+                }
+                if (text == "0")
+                {
+                    (void)eventually([&] { return release.load(); });
+                }
+            },
+            { .name = "pool_full", .execution = ListenerExecution::worker_pool, .queue_capacity = 2 });
+
+        // The first line is taken off the queue and held, so the lane itself stays free.
+        dispatcher.dispatch_text("chan", "user", "0");
+        ASSERT_TRUE(eventually([&] {
+            std::lock_guard lk(m);
+            return seen.size() == 1;
+        }));
+        for (int i = 1; i <= 5; ++i)
+        {
+            dispatcher.dispatch_text("chan", "user", std::to_string(i));
+        }
+
+        // Two fit; the other three are dropped on the lane without waiting for the listener.
+        ASSERT_TRUE(eventually([&] { return dropped("pool_full", "queue_full") == 3; }));
+        release.store(true);
+        ASSERT_TRUE(eventually([&] {
+            std::lock_guard lk(m);
+            return seen.size() == 3;
+        }));
+
+        // Nothing else arrives late.
+        std::this_thread::sleep_for(20ms);
+        std::lock_guard lk(m);
+        EXPECT_EQ(seen, (std::vector<std::string>{ "0", "1", "2" }));
+        EXPECT_EQ(dropped("pool_full", "queue_full"), 3u);
+    }
+} // namespace
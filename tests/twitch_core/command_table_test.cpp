@@ -0,0 +1,219 @@
+/*
+Module Name:
+- command_table_test.cpp
+
+Abstract:
+- twitch_bot::CommandTable lookups: exact and case-insensitive matching, misses, duplicate names, and
+  a perfect hash over a large name set whose index grows linearly with the names.
+- Through CommandDispatcher: of two names that fold to the same key, the first registered wins.
+  Commands route before freeze(), through a table the first command line builds for the whole batch,
+  and after it, when each registration takes effect at once.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/command_dispatcher.hpp>
+#include <tb/twitch/command_table.hpp>
+#include <tb/twitch/runtime.hpp>
+
+namespace
+{
+    using twitch_bot::CommandDispatcher;
+    using twitch_bot::CommandEntry;
+    using twitch_bot::CommandMatch;
+    using twitch_bot::CommandTable;
+
+    std::shared_ptr<const CommandEntry> entry(std::string name)
+    {
+        auto e = std::make_shared<CommandEntry>();
+        e->name = std::move(name);
+        return e;
+    }
+
+    TEST(CommandTable, ExactMatchIsCaseSensitive)
+    {
+        const auto join = entry("join");
+        const auto part = entry("part");
+        const auto table = CommandTable::build({ { "join", join }, { "j", join }, { "part", part } }, CommandMatch::exact);
+
+        ASSERT_NE(table->find("join"), nullptr);
+        EXPECT_EQ(*table->find("join"), join);
+        EXPECT_EQ(*table->find("j"), join);
+        EXPECT_EQ(*table->find("part"), part);
+        EXPECT_EQ(table->find("JOIN"), nullptr);
+        EXPECT_EQ(table->find("joi"), nullptr);
+        EXPECT_EQ(table->find("joinx"), nullptr);
+        EXPECT_EQ(table->find(""), nullptr);
+        EXPECT_EQ(table->size(), 3u);
+    }
+
+    TEST(CommandTable, CaseInsensitiveFoldsAscii)
+    {
+        const auto join = entry("join");
+        const auto table = CommandTable::build({ { "Join", join } }, CommandMatch::ascii_case_insensitive);
+
+        for (const auto* name : { "join", "JOIN", "jOiN", "Join" })
+        {
+            ASSERT_NE(table->find(name), nullptr) << name;
+            EXPECT_EQ(*table->find(name), join);
+        }
+        EXPECT_EQ(table->find("j0in"), nullptr);
+    }
+
+    TEST(CommandTable, LaterDuplicateIsDropped)
+    {
+        const auto first = entry("first");
+        const auto second = entry("second");
+        const auto table = CommandTable::build({ { "Join", first }, { "join", second } }, CommandMatch::ascii_case_insensitive);
+
+        EXPECT_EQ(table->size(), 1u);
+        EXPECT_EQ(*table->find("join"), first);
+    }
+
+    TEST(CommandTable, ManyNamesAllResolve)
+    {
+        std::vector<std::shared_ptr<const CommandEntry>> entries;
+        std::vector<CommandTable::Key> keys;
+        for (int i = 0; i < 2'000; ++i)
+        {
+            entries.push_back(entry("cmd" + std::to_string(i)));
+            keys.push_back({ entries.back()->name, entries.back() });
+        }
+        const auto table = CommandTable::build(std::move(keys), CommandMatch::ascii_case_insensitive);
+
+        for (const auto& e : entries)
+        {
+            const auto* hit = table->find(e->name);
+            ASSERT_NE(hit, nullptr) << e->name;
+            EXPECT_EQ(*hit, e);
+        }
+        EXPECT_EQ(table->find("cmd2000"), nullptr);
+        EXPECT_LE(table->slot_count(), 5'000u);
+    }
+
+    TEST(CommandTable, IndexStaysLinearInTheNameCount)
+    {
+        std::vector<std::shared_ptr<const CommandEntry>> entries;
+        for (std::size_t n = 1; n <= 300; ++n)
+        {
+            entries.push_back(entry("c" + std::to_string(n) + "_alias"));
+            std::vector<CommandTable::Key> keys;
+            for (const auto& e : entries)
+            {
+                keys.push_back({ e->name, e });
+            }
+            const auto table = CommandTable::build(std::move(keys), CommandMatch::ascii_case_insensitive);
+
+            EXPECT_LE(table->slot_count(), std::max<std::size_t>(8, n * 5 / 2)) << n;
+            for (const auto& e : entries)
+            {
+                const auto* hit = table->find(e->name);
+                ASSERT_NE(hit, nullptr) << n << " " << e->name;
+                EXPECT_EQ(*hit, e);
+            }
+            EXPECT_EQ(table->find("c0_alias"), nullptr);
+        }
+    }
+
+    TEST(CommandDispatcher, FirstRegistrationOfAFoldedNameWins)
+    {
+        twitch_bot::Runtime runtime{ { .threads = 1 } };
+        std::thread driver([&] { runtime.run(); });
+
+        std::promise<std::string> ran;
+        auto handler = [&ran](std::string label) {
+            return [&ran, label](twitch_bot::IrcMessage) -> boost::asio::awaitable<void> {
+                ran.set_value(label);
+                co_return;
+            };
+        };
+
+        {
+            CommandDispatcher dispatcher{ runtime };
+            dispatcher.register_command("join", handler("lower")); // registered first; sorts after "Join"
+            dispatcher.register_command("Join", handler("upper"));
+            dispatcher.freeze(CommandMatch::ascii_case_insensitive);
+
+            dispatcher.dispatch_text("chan", "user", "!JOIN");
+            auto result = ran.get_future();
+            ASSERT_EQ(result.wait_for(std::chrono::seconds{ 5 }), std::future_status::ready);
+            EXPECT_EQ(result.get(), "lower");
+
+            runtime.stop();
+            driver.join();
+        }
+    }
+
+    TEST(CommandDispatcher, CommandsRouteBeforeAndAfterFreeze)
+    {
+        twitch_bot::Runtime runtime{ { .threads = 1 } };
+        std::thread driver([&] { runtime.run(); });
+
+        // Lines for one channel are handled in order, so each result arrives before the next line routes.
+        std::mutex m;
+        std::condition_variable cv;
+        std::vector<std::string> seen;
+        auto record = [&](std::string what) {
+            std::lock_guard lk(m);
+            seen.push_back(std::move(what));
+            cv.notify_all();
+        };
+        auto wait_for = [&](std::size_t n) {
+            std::unique_lock lk(m);
+            return cv.wait_for(lk, std::chrono::seconds{ 5 }, [&] { return seen.size() >= n; });
+        };
+
+        {
+            CommandDispatcher dispatcher{ runtime };
+            dispatcher.register_chat_listener([&](std::string_view, std::string_view, std::string_view text) { record("chat " + std::string{ text }); });
+            auto handler = [&](std::string label) {
+                return [&record, label](twitch_bot::IrcMessage) -> boost::asio::awaitable<void> {
+                    record(label);
+                    co_return;
+                };
+            };
+
+            dispatcher.register_command("early", handler("early"));
+            dispatcher.register_command("other", handler("other"), { "alias" });
+            EXPECT_EQ(dispatcher.command_stats().size(), 2u);
+            dispatcher.dispatch_text("chan", "user", "!early"); // builds the table for both
+            ASSERT_TRUE(wait_for(1));
+            dispatcher.dispatch_text("chan", "user", "!alias");
+            ASSERT_TRUE(wait_for(2));
+
+            dispatcher.freeze();
+            dispatcher.dispatch_text("chan", "user", "!early");
+            ASSERT_TRUE(wait_for(3));
+
+            dispatcher.register_command("late", handler("late"));
+            dispatcher.dispatch_text("chan", "user", "!late");
+            ASSERT_TRUE(wait_for(4));
+
+            EXPECT_TRUE(dispatcher.unregister_command("early"));
+            dispatcher.dispatch_text("chan", "user", "!early");
+            ASSERT_TRUE(wait_for(5));
+
+            runtime.stop();
+            driver.join();
+        }
+        EXPECT_EQ(seen, (std::vector<std::string>{ "early", "other", "early", "late", "chat !early" }));
+    }
+} // namespace
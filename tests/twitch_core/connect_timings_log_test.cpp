@@ -0,0 +1,52 @@
+/*
+Module Name:
+- connect_timings_log_test.cpp
+
+Abstract:
+- log_connect_timings renders every phase of a connect as plain integers, with the cached and
+  resumed markers, and without a truncation marker.
+*/
+
+// C++ Standard Library
+#include <chrono>
+#include <string>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/irc_client.hpp>
+#include <tb/utils/log.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using twitch_bot::ConnectTimings;
+
+    std::string capture(const ConnectTimings& t)
+    {
+        tb::log::set_level(tb::log::Level::info);
+        tb::log::flush();
+        testing::internal::CaptureStdout();
+        twitch_bot::log_connect_timings(3, "server-reconnect", 2500us, t, 40us);
+        tb::log::flush();
+        return testing::internal::GetCapturedStdout();
+    }
+
+    TEST(ConnectTimingsLog, EveryPhaseIsReadable)
+    {
+        const ConnectTimings t{ .resolve = 1us, .tcp = 250us, .tls = 1200us, .ws = 900us, .login = 15000us, .dns_cached = true, .tls_resumed = true };
+        const auto out = capture(t);
+
+        EXPECT_NE(out.find("[irc_pool] shard#3 up reason=server-reconnect gap=2500us token_wait=40us login=15000us\n"), std::string::npos) << out;
+        EXPECT_NE(out.find("[irc_pool] shard#3 phases dns=1us (cached) tcp=250us tls=1200us (resumed) ws=900us\n"), std::string::npos) << out;
+        EXPECT_EQ(out.find('{'), std::string::npos) << out;
+        EXPECT_EQ(out.find("[truncated]"), std::string::npos) << out;
+    }
+
+    TEST(ConnectTimingsLog, ColdConnectHasNoMarkers)
+    {
+        const auto out = capture(ConnectTimings{ .resolve = 30us, .tcp = 1us, .tls = 2us, .ws = 3us, .login = 4us });
+        EXPECT_NE(out.find("phases dns=30us tcp=1us tls=2us ws=3us\n"), std::string::npos) << out;
+    }
+} // namespace
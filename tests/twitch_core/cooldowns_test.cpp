@@ -0,0 +1,117 @@
+/*
+Module Name:
+- cooldowns_test.cpp
+
+Abstract:
+- GCRA admission in twitch_bot::CooldownTable: each scope's verdict, the per-user burst, that a
+  reject spends nothing, and that the wheel drops keys once their deadline has passed.
+*/
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/cooldowns.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using twitch_bot::CooldownPolicy;
+    using twitch_bot::CooldownTable;
+    using twitch_bot::CooldownVerdict;
+
+    constexpr std::int64_t k_t0 = 1'000'000; // steady_clock is far from zero in practice
+
+    TEST(Cooldowns, GlobalIsSharedAcrossChannels)
+    {
+        CooldownTable table;
+        std::atomic<std::int64_t> global{ 0 };
+        const CooldownPolicy policy{ .global = 1'000ms };
+
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0), CooldownVerdict::allowed);
+        EXPECT_EQ(table.check(1, policy, global, "b", "v", k_t0 + 999), CooldownVerdict::global);
+        EXPECT_EQ(table.check(1, policy, global, "b", "v", k_t0 + 1'000), CooldownVerdict::allowed);
+    }
+
+    TEST(Cooldowns, PerChannelAndPerCommand)
+    {
+        CooldownTable table;
+        std::atomic<std::int64_t> global{ 0 };
+        const CooldownPolicy policy{ .per_channel = 500ms };
+
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0), CooldownVerdict::allowed);
+        EXPECT_EQ(table.check(1, policy, global, "a", "v", k_t0 + 100), CooldownVerdict::channel);
+        EXPECT_EQ(table.check(1, policy, global, "b", "v", k_t0 + 100), CooldownVerdict::allowed);
+        EXPECT_EQ(table.check(2, policy, global, "a", "v", k_t0 + 100), CooldownVerdict::allowed);
+        EXPECT_EQ(table.check(1, policy, global, "a", "v", k_t0 + 500), CooldownVerdict::allowed);
+    }
+
+    TEST(Cooldowns, UserBurstThenSpacing)
+    {
+        CooldownTable table;
+        std::atomic<std::int64_t> global{ 0 };
+        const CooldownPolicy policy{ .per_user = 1'000ms, .user_burst = 3 };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0), CooldownVerdict::allowed) << i;
+        }
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0), CooldownVerdict::user);
+        EXPECT_EQ(table.check(1, policy, global, "a", "other", k_t0), CooldownVerdict::allowed);
+
+        // One run earns back one slot of the burst per period.
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0 + 999), CooldownVerdict::user);
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0 + 1'000), CooldownVerdict::allowed);
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0 + 1'000), CooldownVerdict::user);
+    }
+
+    TEST(Cooldowns, RejectSpendsNoOtherScope)
+    {
+        CooldownTable table;
+        std::atomic<std::int64_t> global{ 0 };
+        const CooldownPolicy policy{ .per_channel = 1'000ms, .per_user = 1'000ms };
+
+        EXPECT_EQ(table.check(1, policy, global, "a", "u", k_t0), CooldownVerdict::allowed);
+        // Rejected by the channel: v's user allowance must be untouched.
+        EXPECT_EQ(table.check(1, policy, global, "a", "v", k_t0 + 10), CooldownVerdict::channel);
+        EXPECT_EQ(table.check(1, policy, global, "b", "v", k_t0 + 10), CooldownVerdict::allowed);
+    }
+
+    TEST(Cooldowns, ExpiredKeysLeaveTheTable)
+    {
+        CooldownTable table;
+        std::atomic<std::int64_t> global{ 0 };
+        const CooldownPolicy policy{ .per_channel = 200ms, .per_user = 300ms };
+
+        for (int i = 0; i < 50; ++i)
+        {
+            const auto user = "u" + std::to_string(i);
+            EXPECT_EQ(table.check(1, policy, global, user, user, k_t0), CooldownVerdict::allowed);
+        }
+        EXPECT_EQ(table.size(), 100u);
+
+        // Any later check drives the wheel; an hour-long gap must still empty it.
+        EXPECT_EQ(table.check(1, policy, global, "x", "x", k_t0 + 3'600'000), CooldownVerdict::allowed);
+        EXPECT_EQ(table.size(), 2u);
+    }
+
+    TEST(Cooldowns, FullTableAdmitsUntracked)
+    {
+        CooldownTable table{ 64 };
+        std::atomic<std::int64_t> global{ 0 };
+        const CooldownPolicy policy{ .per_user = 60'000ms };
+
+        for (int i = 0; i < 200; ++i)
+        {
+            EXPECT_EQ(table.check(1, policy, global, "a", "u" + std::to_string(i), k_t0), CooldownVerdict::allowed);
+        }
+        EXPECT_EQ(table.size(), 56u); // 7/8 of 64
+        EXPECT_EQ(table.check(1, policy, global, "a", "u0", k_t0 + 1), CooldownVerdict::user);
+    }
+} // namespace
@@ -0,0 +1,295 @@
+/*
+Module Name:
+- helix_client_test.cpp
+
+Abstract:
+- twitch_bot::HelixClient stream lookups against a fake transport on a single-threaded io_context.
+  Concurrent single lookups are deduplicated into one request after the coalescing window, a full
+  batch goes out without waiting for it, and every caller gets the answer for its own login. A failed
+  batch fails every waiter and caches nothing. A batched poll keeps the pages that succeeded and
+  leaves only the failed page's logins uncached. Only a 401 status, not a "401" in the error text,
+  drops the token for a refresh.
+*/
+
+// C++ Standard Library
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+
+// Glaze
+#include <glaze/json.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/net/http/http_client.hpp>
+#include <tb/net/tls/tls_context.hpp>
+#include <tb/twitch/helix_client.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using boost::asio::awaitable;
+    using clock_type = std::chrono::steady_clock;
+    using twitch_bot::HelixClient;
+    using twitch_bot::StreamStatus;
+
+    constexpr auto k_window = 25ms; // HelixClient::k_coalesce_window
+    constexpr std::string_view k_started_at = "2024-01-02T03:04:05Z";
+
+    // Answers /helix/streams from a set of live logins and records every request.
+    struct FakeHelix
+    {
+        struct Request
+        {
+            std::vector<std::string> logins; // as listed in the target
+            clock_type::time_point at;
+        };
+
+        std::unordered_set<std::string> live;
+        std::unordered_set<std::string> fail_pages_with; // a page listing any of these answers 500
+        bool fail_all = false;
+        int fail_status = 500;
+        std::vector<Request> requests;
+
+        static std::vector<std::string> logins_of(std::string_view target)
+        {
+            constexpr std::string_view key = "&user_login=";
+            std::vector<std::string> out;
+            for (auto pos = target.find(key); pos != std::string_view::npos;)
+            {
+                const auto from = pos + key.size();
+                const auto next = target.find(key, from);
+                out.emplace_back(target.substr(from, next == std::string_view::npos ? std::string_view::npos : next - from));
+                pos = next;
+            }
+            return out;
+        }
+
+        HelixClient::transport_t transport()
+        {
+            return [this](std::string_view, std::string_view, std::string_view target, http_client::http_headers, http_client::client::ResponseMeta& meta)
+                       -> awaitable<http_client::result> {
+                auto& req = requests.emplace_back(Request{ logins_of(target), clock_type::now() });
+
+                bool fail = fail_all;
+                for (const auto& login : req.logins)
+                {
+                    fail = fail || fail_pages_with.contains(login);
+                }
+                if (fail)
+                {
+                    meta.status = fail_status;
+                    throw std::runtime_error{ "HTTP " + std::to_string(fail_status) + " for " + std::string{ target } };
+                }
+
+                std::string body = R"({"data":[)";
+                bool first = true;
+                for (const auto& login : req.logins)
+                {
+                    if (!live.contains(login))
+                    {
+                        continue;
+                    }
+                    body += first ? "" : ",";
+                    body += R"({"user_login":")" + login + R"(","started_at":")" + std::string{ k_started_at } + R"("})";
+                    first = false;
+                }
+                body += "]}";
+
+                meta.status = 200;
+                co_return glz::read_json<glz::json_t>(body);
+            };
+        }
+    };
+
+    struct Fixture
+    {
+        Fixture() :
+            tls{ make_tls() }, helix{ io.get_executor(), tls, "client-id", "secret", "" }
+        {
+            helix.set_access_token("token", std::chrono::hours{ 1 });
+            helix.set_transport(fake.transport());
+        }
+
+        static tb::net::TlsOptions make_tls()
+        {
+            tb::net::TlsOptions o;
+            o.platform_store = false;
+            return o;
+        }
+
+        // Runs every lookup to completion, started together.
+        std::vector<std::optional<StreamStatus>> lookup(const std::vector<std::string>& logins)
+        {
+            std::vector<std::optional<StreamStatus>> out(logins.size());
+            for (std::size_t i = 0; i < logins.size(); ++i)
+            {
+                boost::asio::co_spawn(io, [&, i]() -> awaitable<void> { out[i] = co_await helix.get_stream_status(logins[i]); }, boost::asio::detached);
+            }
+            io.run();
+            io.restart();
+            return out;
+        }
+
+        std::vector<std::optional<StreamStatus>> poll(std::vector<std::string> logins)
+        {
+            std::vector<std::optional<StreamStatus>> out;
+            boost::asio::co_spawn(io, [&]() -> awaitable<void> { out = co_await helix.get_stream_statuses(std::move(logins)); }, [](std::exception_ptr e) {
+                if (e)
+                {
+                    std::rethrow_exception(e);
+                }
+            });
+            io.run();
+            io.restart();
+            return out;
+        }
+
+        boost::asio::io_context io;
+        tb::net::TlsContextFactory tls;
+        FakeHelix fake;
+        HelixClient helix;
+    };
+
+    std::vector<std::string> numbered(std::size_t n)
+    {
+        std::vector<std::string> out;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::string id = std::to_string(i);
+            out.push_back("u" + std::string(3 - id.size(), '0') + id); // sorts like the batch order
+        }
+        return out;
+    }
+
+    TEST(HelixClient, ConcurrentLookupsShareOneRequest)
+    {
+        Fixture f;
+        f.fake.live = { "alpha", "gamma" };
+
+        const auto start = clock_type::now();
+        const auto got = f.lookup({ "alpha", "Beta", "#alpha", "gamma", "beta", "ALPHA", "delta", "#Gamma" });
+
+        ASSERT_EQ(f.fake.requests.size(), 1u);
+        const auto& req = f.fake.requests.front();
+        EXPECT_EQ(std::set<std::string>(req.logins.begin(), req.logins.end()), (std::set<std::string>{ "alpha", "beta", "delta", "gamma" }));
+        EXPECT_EQ(req.logins.size(), 4u); // each login asked once
+        EXPECT_GE(req.at - start, k_window); // held for company, not sent on the first call
+
+        const std::vector<bool> want_live{ true, false, true, true, false, true, false, true };
+        ASSERT_EQ(got.size(), want_live.size());
+        for (std::size_t i = 0; i < got.size(); ++i)
+        {
+            EXPECT_EQ(got[i].has_value(), want_live[i]) << i;
+            if (got[i])
+            {
+                EXPECT_TRUE(got[i]->is_live);
+                EXPECT_EQ(got[i]->start_time, 1704164645000ms);
+            }
+        }
+
+        // Answered from the cache now.
+        EXPECT_TRUE(f.lookup({ "alpha" }).front().has_value());
+        EXPECT_FALSE(f.lookup({ "delta" }).front().has_value());
+        EXPECT_EQ(f.fake.requests.size(), 1u);
+    }
+
+    TEST(HelixClient, FullBatchDoesNotWaitForTheWindow)
+    {
+        Fixture f;
+        const auto logins = numbered(100);
+        f.fake.live = { "u007" };
+
+        const auto start = clock_type::now();
+        const auto got = f.lookup(logins);
+
+        ASSERT_EQ(f.fake.requests.size(), 1u);
+        EXPECT_EQ(f.fake.requests.front().logins.size(), 100u);
+        EXPECT_LT(f.fake.requests.front().at - start, k_window);
+        for (std::size_t i = 0; i < got.size(); ++i)
+        {
+            EXPECT_EQ(got[i].has_value(), logins[i] == "u007") << logins[i];
+        }
+    }
+
+    TEST(HelixClient, FailedBatchFailsEveryWaiterAndCachesNothing)
+    {
+        Fixture f;
+        f.fake.live = { "alpha" };
+        f.fake.fail_all = true;
+
+        for (const auto& v : f.lookup({ "alpha", "beta", "alpha" }))
+        {
+            EXPECT_FALSE(v.has_value()); // no answer reads as "no live stream"
+        }
+        EXPECT_EQ(f.fake.requests.size(), 1u);
+
+        // Nothing was cached, as offline or otherwise: the next lookup asks again.
+        f.fake.fail_all = false;
+        EXPECT_TRUE(f.lookup({ "alpha" }).front().has_value());
+        EXPECT_FALSE(f.lookup({ "beta" }).front().has_value());
+        EXPECT_EQ(f.fake.requests.size(), 3u);
+
+        // A real offline answer is cached.
+        EXPECT_FALSE(f.lookup({ "beta" }).front().has_value());
+        EXPECT_EQ(f.fake.requests.size(), 3u);
+    }
+
+    TEST(HelixClient, PollKeepsPagesAroundAFailedOne)
+    {
+        Fixture f;
+        const auto logins = numbered(250); // pages u000-u099, u100-u199, u200-u249
+        f.fake.live = { "u010", "u120", "u220" };
+        f.fake.fail_pages_with = { "u150" };
+
+        const auto got = f.poll(logins);
+        ASSERT_EQ(f.fake.requests.size(), 3u);
+        ASSERT_EQ(got.size(), logins.size());
+        EXPECT_TRUE(got[10].has_value());
+        EXPECT_FALSE(got[120].has_value()); // its page failed
+        EXPECT_TRUE(got[220].has_value());
+
+        // The good pages were cached, live and offline alike; the failed page was not.
+        f.fake.fail_pages_with.clear();
+        EXPECT_TRUE(f.lookup({ "u010" }).front().has_value());
+        EXPECT_FALSE(f.lookup({ "u050" }).front().has_value());
+        EXPECT_TRUE(f.lookup({ "u220" }).front().has_value());
+        EXPECT_EQ(f.fake.requests.size(), 3u);
+
+        EXPECT_TRUE(f.lookup({ "u120" }).front().has_value());
+        EXPECT_EQ(f.fake.requests.size(), 4u);
+    }
+
+    TEST(HelixClient, OnlyA401StatusDropsTheToken)
+    {
+        Fixture f;
+        f.fake.fail_all = true;
+
+        // A 500 whose error text happens to contain "401".
+        EXPECT_FALSE(f.lookup({ "team401" }).front().has_value());
+        EXPECT_EQ(f.helix.current_token(), "token");
+        EXPECT_EQ(f.fake.requests.size(), 1u);
+
+        // Rejected. With no refresh token there is nothing to retry with, and nothing is cached.
+        f.fake.fail_status = 401;
+        EXPECT_FALSE(f.lookup({ "alpha" }).front().has_value());
+        EXPECT_TRUE(f.helix.current_token().empty());
+        EXPECT_EQ(f.fake.requests.size(), 2u);
+    }
+} // namespace
@@ -0,0 +1,151 @@
+/*
+Module Name:
+- helix_rate_limiter_test.cpp
+
+Abstract:
+- twitch_bot::HelixRateLimiter on a single-threaded io_context: acquire() returns at once while points
+  are plentiful, Ratelimit-* headers correct the estimate, a 429 holds requests until the reset, and
+  interactive requests go ahead of background ones and may spend the reserve.
+*/
+
+// C++ Standard Library
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/helix_rate_limiter.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using boost::asio::awaitable;
+    using twitch_bot::HelixPriority;
+    using twitch_bot::HelixRateLimiter;
+    using Meta = http_client::client::ResponseMeta;
+    using clock_type = std::chrono::steady_clock;
+
+    template<class F>
+    void run(boost::asio::io_context& io, F f)
+    {
+        boost::asio::co_spawn(io, std::move(f), boost::asio::detached);
+        io.run_for(5s);
+        io.restart();
+    }
+
+    TEST(HelixRateLimiter, AcquireIsImmediateWhilePointsArePlentiful)
+    {
+        boost::asio::io_context io;
+        HelixRateLimiter limiter{ io.get_executor() };
+        int granted = 0;
+
+        const auto t0 = clock_type::now();
+        run(io, [&]() -> awaitable<void> {
+            for (int i = 0; i < 50; ++i)
+            {
+                co_await limiter.acquire(HelixPriority::background);
+                ++granted;
+            }
+        });
+
+        EXPECT_EQ(granted, 50);
+        EXPECT_LT(clock_type::now() - t0, 100ms);
+        const auto s = limiter.state();
+        EXPECT_EQ(s.in_flight, 50u);
+        EXPECT_EQ(s.queued, 0u);
+        EXPECT_NEAR(s.remaining, 750.0, 1.0);
+    }
+
+    TEST(HelixRateLimiter, HeadersCorrectTheEstimate)
+    {
+        boost::asio::io_context io;
+        HelixRateLimiter limiter{ io.get_executor() };
+        run(io, [&]() -> awaitable<void> {
+            co_await limiter.acquire(HelixPriority::background);
+            co_await limiter.acquire(HelixPriority::background);
+        });
+
+        // The first response reports 40 left; the other request is still in flight and counts against them.
+        limiter.on_response(Meta{ 200, { { "ratelimit-limit", "100" }, { "Ratelimit-Remaining", "40" } } });
+        auto s = limiter.state();
+        EXPECT_EQ(s.limit, 100u);
+        EXPECT_EQ(s.in_flight, 1u);
+        EXPECT_NEAR(s.remaining, 39.0, 0.5);
+
+        // No response keeps the point spent; malformed values are ignored.
+        limiter.on_response(Meta{ 0, {} });
+        s = limiter.state();
+        EXPECT_EQ(s.in_flight, 0u);
+        EXPECT_NEAR(s.remaining, 39.0, 0.5);
+
+        limiter.on_response(Meta{ 200, { { "Ratelimit-Remaining", "12x" } } });
+        EXPECT_NEAR(limiter.state().remaining, 39.0, 0.5);
+    }
+
+    TEST(HelixRateLimiter, TooManyRequestsHoldsUntilTheReset)
+    {
+        boost::asio::io_context io;
+        HelixRateLimiter limiter{ io.get_executor(), { .backoff_429 = 200ms } };
+        run(io, [&]() -> awaitable<void> { co_await limiter.acquire(HelixPriority::interactive); });
+
+        // Without Ratelimit-Reset the hold is backoff_429.
+        limiter.on_response(Meta{ 429, { { "Ratelimit-Limit", "800" }, { "Ratelimit-Remaining", "0" } } });
+        EXPECT_LE(limiter.state().remaining, 0.0);
+
+        const auto t0 = clock_type::now();
+        clock_type::duration waited{};
+        run(io, [&]() -> awaitable<void> {
+            co_await limiter.acquire(HelixPriority::interactive);
+            waited = clock_type::now() - t0;
+        });
+        EXPECT_GE(waited, 190ms);
+        EXPECT_LT(waited, 2s);
+
+        // The bucket is full again after the hold, less the point just granted.
+        EXPECT_NEAR(limiter.state().remaining, 799.0, 1.0);
+    }
+
+    TEST(HelixRateLimiter, InteractiveGoesFirstAndMaySpendTheReserve)
+    {
+        boost::asio::io_context io;
+        HelixRateLimiter limiter{ io.get_executor(), { .limit = 10, .window = 1s, .reserve = 5 } };
+
+        // Background stops at the reserve: 10 points, 5 held back.
+        run(io, [&]() -> awaitable<void> {
+            for (int i = 0; i < 5; ++i)
+            {
+                co_await limiter.acquire(HelixPriority::background);
+            }
+        });
+        EXPECT_EQ(limiter.state().in_flight, 5u);
+
+        std::vector<std::string> order;
+        boost::asio::co_spawn(io, [&]() -> awaitable<void> {
+            co_await limiter.acquire(HelixPriority::background);
+            order.push_back("background");
+        }, boost::asio::detached);
+        boost::asio::co_spawn(io, [&]() -> awaitable<void> {
+            co_await limiter.acquire(HelixPriority::interactive);
+            order.push_back("interactive");
+        }, boost::asio::detached);
+
+        io.run_for(20ms);
+        EXPECT_EQ(order, std::vector<std::string>{ "interactive" });
+        EXPECT_EQ(limiter.state().queued, 1u);
+
+        // The background request goes once the bucket refills past the reserve (0.2s at 10 points/s).
+        io.run_for(2s);
+        EXPECT_EQ(order, (std::vector<std::string>{ "interactive", "background" }));
+        EXPECT_EQ(limiter.state().queued, 0u);
+    }
+} // namespace
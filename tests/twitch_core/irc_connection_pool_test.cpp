@@ -0,0 +1,547 @@
+/*
+Module Name:
+- irc_connection_pool_test.cpp
+
+Abstract:
+- twitch_bot::IrcConnectionPool placement without sockets: the pool is never started, so set_channels,
+  join and add_shard only move channels on the ring. Placement does not depend on insertion order or on
+  the pool instance, the pool grows to channels_per_shard, and adding a shard moves only the channels
+  the new shard now owns, each queued for one re-join.
+- The make-before-break handover driven through handle_line on unconnected sessions: a ROOMSTATE on the
+  old connection never confirms a join routed to the standby, and a handover that times out re-queues
+  every channel the replacement has not joined. The deadline covers the account's whole join backlog, and
+  moves on while the replacement still gains channels.
+- Shutdown with the runtime still running: stop() cuts a supervisor's backoff short, and the destructor
+  returns only once that supervisor has left the pool.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/net/tls/tls_context.hpp>
+#include <tb/twitch/irc_connection_pool.hpp>
+#include <tb/twitch/runtime.hpp>
+
+namespace twitch_bot
+{
+    // Reaches the pool's shard state so a handover can be driven line by line, with no socket behind either session.
+    struct IrcConnectionPoolInternals
+    {
+        using Shard = IrcConnectionPool::Shard;
+        using Session = IrcConnectionPool::Session;
+
+        static Shard& shard(IrcConnectionPool& pool, std::size_t index)
+        {
+            std::lock_guard lk(pool.mutex_);
+            return *pool.shards_[index];
+        }
+
+        static std::shared_ptr<Session> session(IrcConnectionPool& pool, Shard& shard)
+        {
+            return std::make_shared<Session>(shard.home.executor, pool.tls_, std::string_view{}, pool.nick_, pool.connect_cache_);
+        }
+
+        static JoinScheduler& joins(IrcConnectionPool& pool)
+        {
+            return pool.joins_;
+        }
+
+        // run_shard after a connect: publish the session and queue the shard's channels.
+        static void connected(IrcConnectionPool& pool, Shard& shard, const std::shared_ptr<Session>& session)
+        {
+            {
+                std::lock_guard lk(pool.mutex_);
+                shard.session = session;
+            }
+            pool.enqueue_joins(shard);
+        }
+
+        static std::shared_ptr<Session> current(IrcConnectionPool& pool, Shard& shard)
+        {
+            std::lock_guard lk(pool.mutex_);
+            return shard.session;
+        }
+
+        // Drop the session before the context goes away.
+        static void disconnect(IrcConnectionPool& pool, Shard& shard)
+        {
+            std::lock_guard lk(pool.mutex_);
+            shard.session.reset();
+        }
+
+        static void line(IrcConnectionPool& pool, Shard& shard, Session& session, std::string_view raw)
+        {
+            pool.handle_line(shard, session, raw);
+        }
+
+        static bool joined(const Session& session, std::string_view channel)
+        {
+            return session.joined.contains(channel);
+        }
+
+        // hand_over without the connect and the read loop.
+        static void begin_handover(IrcConnectionPool& pool, Shard& shard, const std::shared_ptr<Session>& next, std::chrono::steady_clock::time_point started)
+        {
+            pool.begin_handover(shard, next, started);
+            pool.enqueue_joins(shard);
+        }
+
+        // run_shard's backoff and exit, without the connect in between.
+        static void supervising(IrcConnectionPool& pool, Shard& shard)
+        {
+            std::lock_guard lk(pool.mutex_);
+            shard.running = true;
+        }
+
+        static boost::asio::awaitable<void> backoff(IrcConnectionPool& pool, Shard& shard, std::chrono::milliseconds delay)
+        {
+            return pool.sleep_backoff(shard, delay);
+        }
+
+        static void exited(IrcConnectionPool& pool, Shard& shard)
+        {
+            pool.supervisor_exited(shard);
+        }
+
+        static boost::asio::awaitable<std::shared_ptr<Session>>
+        finish_handover(IrcConnectionPool& pool, Shard& shard, std::shared_ptr<Session> old, std::shared_ptr<Session> next, std::chrono::steady_clock::time_point started)
+        {
+            return pool.finish_handover(shard, std::move(old), std::move(next), started);
+        }
+    };
+} // namespace twitch_bot
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using boost::asio::awaitable;
+    using twitch_bot::IrcConnectionPool;
+    using twitch_bot::IrcPoolOptions;
+
+    // A pool that is never started; nothing dials out.
+    struct Offline
+    {
+        explicit Offline(IrcPoolOptions options) :
+            tls{ make_tls() }, pool{ runtime, tls, "bot", [](bool) -> awaitable<std::string> { co_return "oauth:x"; }, [](twitch_bot::IrcMessage) {}, std::move(options) }
+        {
+        }
+
+        static tb::net::TlsOptions make_tls()
+        {
+            tb::net::TlsOptions o;
+            o.platform_store = false;
+            return o;
+        }
+
+        twitch_bot::Runtime runtime{ twitch_bot::RuntimeOptions{ .mode = twitch_bot::ExecutionMode::shared_pool, .threads = 1, .pin_threads = false } };
+        tb::net::TlsContextFactory tls;
+        IrcConnectionPool pool;
+    };
+
+    IrcPoolOptions options(std::string name)
+    {
+        IrcPoolOptions o;
+        o.channels_per_shard = 100;
+        o.max_shards = 16;
+        o.name = std::move(name);
+        return o;
+    }
+
+    // A join rate under which the handover deadline is short enough to sit out in a test.
+    twitch_bot::JoinSchedulerOptions fast_joins(std::size_t limit = 20)
+    {
+        return { .join_limit = limit, .window = 100ms, .window_slack = 0ms, .confirm_timeout = 200ms };
+    }
+
+    std::vector<std::string> channels(std::size_t n)
+    {
+        std::vector<std::string> out;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            out.push_back("chan" + std::to_string(i));
+        }
+        return out;
+    }
+
+    // Membership changes only co_await send_part, which returns at once on a disconnected shard.
+    template<class F>
+    void run(F f)
+    {
+        boost::asio::io_context io;
+        boost::asio::co_spawn(io, std::move(f), [](std::exception_ptr e) {
+            if (e)
+            {
+                std::rethrow_exception(e);
+            }
+        });
+        io.run();
+    }
+
+    // Runs f on the (single) home the pool's shards live on, then stops the runtime.
+    template<class F>
+    void on_shard(Offline& o, F f)
+    {
+        boost::asio::co_spawn(o.runtime.serial_executor(0).executor, std::move(f), [&o](std::exception_ptr e) {
+            o.runtime.stop();
+            if (e)
+            {
+                std::rethrow_exception(e);
+            }
+        });
+        o.runtime.run();
+    }
+
+    std::string join_echo(std::string_view channel)
+    {
+        return ":bot!bot@bot.tmi.twitch.tv JOIN #" + std::string{ channel };
+    }
+
+    std::string roomstate(std::string_view channel)
+    {
+        return "@room-id=1;slow=30 :tmi.twitch.tv ROOMSTATE #" + std::string{ channel };
+    }
+
+    std::unordered_map<std::string, std::size_t> placement(const IrcConnectionPool& pool, const std::vector<std::string>& names)
+    {
+        std::unordered_map<std::string, std::size_t> out;
+        for (const auto& ch : names)
+        {
+            const auto s = pool.shard_of(ch);
+            EXPECT_TRUE(s.has_value()) << ch;
+            out.emplace(ch, s.value_or(0));
+        }
+        return out;
+    }
+
+    TEST(IrcConnectionPool, GrowsToChannelsPerShardAndSpreadsEvenly)
+    {
+        Offline o{ options("test_grow") };
+        o.pool.set_channels(channels(1000));
+
+        EXPECT_EQ(o.pool.shard_count(), 10u);
+        EXPECT_EQ(o.pool.channel_count(), 1000u);
+        EXPECT_EQ(o.pool.shard_of("not-joined"), std::nullopt);
+
+        std::vector<std::size_t> load(o.pool.shard_count(), 0);
+        for (const auto& [ch, s] : placement(o.pool, channels(1000)))
+        {
+            ASSERT_LT(s, load.size());
+            ++load[s];
+        }
+        for (auto n : load)
+        {
+            EXPECT_GT(n, 40u); // 64 ring points per shard keep every shard well above empty
+            EXPECT_LT(n, 200u);
+        }
+    }
+
+    TEST(IrcConnectionPool, PlacementIsStable)
+    {
+        const auto names = channels(500);
+        auto reversed = names;
+        std::reverse(reversed.begin(), reversed.end());
+
+        Offline a{ options("test_stable_a") };
+        Offline b{ options("test_stable_b") };
+        a.pool.set_channels(names);
+        b.pool.set_channels(reversed);
+        ASSERT_EQ(a.pool.shard_count(), b.pool.shard_count());
+        EXPECT_EQ(placement(a.pool, names), placement(b.pool, names));
+
+        // Re-loading the same set, or a rebalance with no ring change, moves nothing.
+        const auto before = placement(a.pool, names);
+        a.pool.set_channels(reversed);
+        run([&]() -> awaitable<void> { co_await a.pool.rebalance(); });
+        EXPECT_EQ(placement(a.pool, names), before);
+        EXPECT_EQ(a.pool.join_progress().pending, 0u);
+    }
+
+    TEST(IrcConnectionPool, AddShardMovesOnlyChannelsTheNewShardOwns)
+    {
+        const auto names = channels(400);
+        Offline o{ options("test_add_shard") };
+        o.pool.set_channels(names);
+        ASSERT_EQ(o.pool.shard_count(), 4u);
+        const auto before = placement(o.pool, names);
+
+        run([&]() -> awaitable<void> { co_await o.pool.add_shard(); });
+        ASSERT_EQ(o.pool.shard_count(), 5u);
+        const auto after = placement(o.pool, names);
+
+        std::size_t moved = 0;
+        for (const auto& ch : names)
+        {
+            if (after.at(ch) != before.at(ch))
+            {
+                EXPECT_EQ(after.at(ch), 4u) << ch; // never between two old shards
+                ++moved;
+            }
+        }
+        // Roughly a fifth of the channels; every one queued for exactly one re-join.
+        EXPECT_GT(moved, 40u);
+        EXPECT_LT(moved, 160u);
+        EXPECT_EQ(o.pool.join_progress().pending, moved);
+
+        // A pool built with five shards from the start places the channels the same way.
+        auto five = options("test_add_shard_five");
+        five.channels_per_shard = 80;
+        Offline fresh{ five };
+        fresh.pool.set_channels(names);
+        ASSERT_EQ(fresh.pool.shard_count(), 5u);
+        EXPECT_EQ(placement(fresh.pool, names), after);
+    }
+
+    TEST(IrcConnectionPool, JoinPastCapacityGrowsAndRebalances)
+    {
+        auto names = channels(100);
+        Offline o{ options("test_join_grow") };
+        o.pool.set_channels(names);
+        ASSERT_EQ(o.pool.shard_count(), 1u);
+
+        run([&]() -> awaitable<void> { co_await o.pool.join("one-more"); });
+        names.push_back("one-more");
+        EXPECT_EQ(o.pool.shard_count(), 2u);
+
+        std::size_t on_new = 0;
+        for (const auto& [ch, s] : placement(o.pool, names))
+        {
+            on_new += s == 1 ? 1 : 0;
+        }
+        EXPECT_GT(on_new, 0u);
+
+        run([&]() -> awaitable<void> { co_await o.pool.part("one-more"); });
+        EXPECT_EQ(o.pool.shard_of("one-more"), std::nullopt);
+        EXPECT_EQ(o.pool.channel_count(), 100u);
+    }
+
+    TEST(IrcConnectionPool, HandoverIgnoresConfirmsFromTheOldConnection)
+    {
+        using In = twitch_bot::IrcConnectionPoolInternals;
+        const std::vector<std::string> names{ "a", "b", "c" };
+        Offline o{ options("test_handover_confirm") };
+        o.pool.set_channels(names);
+
+        on_shard(o, [&]() -> awaitable<void> {
+            auto& shard = In::shard(o.pool, 0);
+            auto old = In::session(o.pool, shard);
+            In::connected(o.pool, shard, old);
+            for (const auto& ch : names)
+            {
+                In::line(o.pool, shard, *old, join_echo(ch));
+            }
+            EXPECT_EQ(o.pool.join_progress().confirmed, 3u);
+
+            const auto started = std::chrono::steady_clock::now();
+            auto next = In::session(o.pool, shard);
+            In::begin_handover(o.pool, shard, next, started);
+            EXPECT_EQ(o.pool.join_progress().pending, 3u);
+
+            // A mod toggles slow mode: the old connection is still joined and sees the ROOMSTATE.
+            In::line(o.pool, shard, *old, roomstate("a"));
+            EXPECT_EQ(o.pool.join_progress().pending, 3u);
+            EXPECT_EQ(o.pool.join_progress().confirmed, 0u);
+            EXPECT_FALSE(In::joined(*next, "a"));
+
+            for (const auto& ch : names)
+            {
+                In::line(o.pool, shard, *next, roomstate(ch));
+            }
+            EXPECT_EQ(o.pool.join_progress().confirmed, 3u);
+
+            // The last confirm wakes the handover; it does not sit out handover_timeout.
+            auto swapped = co_await In::finish_handover(o.pool, shard, old, next, started);
+            EXPECT_EQ(swapped, next);
+            EXPECT_EQ(In::current(o.pool, shard), next);
+            EXPECT_LT(std::chrono::steady_clock::now() - started, 5s);
+            EXPECT_EQ(o.pool.join_progress().pending, 0u);
+
+            // Lines still draining from the old socket no longer confirm anything either.
+            In::joins(o.pool).enqueue("a");
+            In::line(o.pool, shard, *old, roomstate("a"));
+            EXPECT_EQ(o.pool.join_progress().pending, 1u);
+            In::line(o.pool, shard, *next, roomstate("a"));
+            EXPECT_EQ(o.pool.join_progress().pending, 0u);
+
+            In::disconnect(o.pool, shard);
+        });
+    }
+
+    TEST(IrcConnectionPool, HandoverTimeoutRequeuesChannelsTheReplacementLacks)
+    {
+        using In = twitch_bot::IrcConnectionPoolInternals;
+        const std::vector<std::string> names{ "a", "b", "c" };
+        auto opts = options("test_handover_timeout");
+        opts.handover_timeout = 1s;
+        opts.join = fast_joins(); // the one join still queued drains well inside handover_timeout
+        Offline o{ opts };
+        o.pool.set_channels(names);
+
+        on_shard(o, [&]() -> awaitable<void> {
+            auto& shard = In::shard(o.pool, 0);
+            auto old = In::session(o.pool, shard);
+            In::connected(o.pool, shard, old);
+            for (const auto& ch : names)
+            {
+                In::line(o.pool, shard, *old, join_echo(ch));
+            }
+
+            const auto started = std::chrono::steady_clock::now();
+            auto next = In::session(o.pool, shard);
+            In::begin_handover(o.pool, shard, next, started);
+            In::line(o.pool, shard, *old, roomstate("c"));
+            In::line(o.pool, shard, *next, join_echo("b"));
+
+            // Whatever the scheduler believes about a channel, the swap goes by what the replacement joined.
+            In::joins(o.pool).confirm("a");
+            EXPECT_EQ(o.pool.join_progress().confirmed, 2u);
+
+            auto swapped = co_await In::finish_handover(o.pool, shard, old, next, started);
+            EXPECT_GE(std::chrono::steady_clock::now() - started, 1s);
+            EXPECT_EQ(swapped, next);
+            EXPECT_EQ(In::current(o.pool, shard), next);
+
+            const auto progress = o.pool.join_progress();
+            EXPECT_EQ(progress.confirmed, 1u); // b
+            EXPECT_EQ(progress.pending, 2u); // a and c, queued for the new connection
+
+            In::disconnect(o.pool, shard);
+        });
+    }
+
+    TEST(IrcConnectionPool, HandoverWaitsOutTheAccountJoinBacklog)
+    {
+        using In = twitch_bot::IrcConnectionPoolInternals;
+        const std::vector<std::string> names{ "a", "b", "c" };
+        auto opts = options("test_handover_backlog");
+        opts.handover_timeout = 0s;
+        opts.join = fast_joins(1); // one join per 100ms window
+        Offline o{ opts };
+        o.pool.set_channels(names);
+
+        on_shard(o, [&]() -> awaitable<void> {
+            auto& shard = In::shard(o.pool, 0);
+            auto old = In::session(o.pool, shard);
+            In::connected(o.pool, shard, old);
+            for (const auto& ch : names)
+            {
+                In::line(o.pool, shard, *old, join_echo(ch));
+            }
+
+            // Other shards reconnecting at the same time: their joins are queued ahead of this one's.
+            for (int i = 0; i < 12; ++i)
+            {
+                In::joins(o.pool).enqueue("other" + std::to_string(i));
+            }
+
+            const auto started = std::chrono::steady_clock::now();
+            auto next = In::session(o.pool, shard);
+            In::begin_handover(o.pool, shard, next, started);
+            auto swapped = co_await In::finish_handover(o.pool, shard, old, next, started);
+
+            // 15 joins at one per window, plus a confirm timeout, not the zero handover_timeout.
+            EXPECT_GE(std::chrono::steady_clock::now() - started, 1600ms);
+            EXPECT_EQ(swapped, next);
+
+            In::disconnect(o.pool, shard);
+        });
+    }
+
+    TEST(IrcConnectionPool, HandoverDeadlineMovesWhileTheReplacementKeepsJoining)
+    {
+        using In = twitch_bot::IrcConnectionPoolInternals;
+        const std::vector<std::string> names{ "a", "b", "c", "d" };
+        auto opts = options("test_handover_progress");
+        opts.handover_timeout = 1s;
+        opts.join = fast_joins();
+        Offline o{ opts };
+        o.pool.set_channels(names);
+
+        on_shard(o, [&]() -> awaitable<void> {
+            auto& shard = In::shard(o.pool, 0);
+            auto old = In::session(o.pool, shard);
+            In::connected(o.pool, shard, old);
+            for (const auto& ch : names)
+            {
+                In::line(o.pool, shard, *old, join_echo(ch));
+            }
+
+            const auto started = std::chrono::steady_clock::now();
+            auto next = In::session(o.pool, shard);
+            In::begin_handover(o.pool, shard, next, started);
+
+            // One more channel lands on the replacement just before the first deadline.
+            boost::asio::steady_timer late{ shard.home.executor };
+            late.expires_at(started + 900ms);
+            late.async_wait([&](boost::system::error_code) { In::line(o.pool, shard, *next, join_echo("c")); });
+
+            auto swapped = co_await In::finish_handover(o.pool, shard, old, next, started);
+            EXPECT_GE(std::chrono::steady_clock::now() - started, 1100ms); // extended past handover_timeout
+            EXPECT_EQ(swapped, next);
+
+            const auto progress = o.pool.join_progress();
+            EXPECT_EQ(progress.confirmed, 1u); // c
+            EXPECT_EQ(progress.pending, 3u); // a, b and d, queued again once nothing more arrived
+
+            In::disconnect(o.pool, shard);
+        });
+    }
+
+    TEST(IrcConnectionPool, DestructorWaitsForASupervisorInBackoff)
+    {
+        using In = twitch_bot::IrcConnectionPoolInternals;
+        twitch_bot::Runtime runtime{ twitch_bot::RuntimeOptions{ .mode = twitch_bot::ExecutionMode::shared_pool, .threads = 1, .pin_threads = false } };
+        tb::net::TlsContextFactory tls{ Offline::make_tls() };
+        std::optional<IrcConnectionPool> pool;
+        pool.emplace(runtime, tls, "bot", [](bool) -> awaitable<std::string> { co_return "oauth:x"; }, [](twitch_bot::IrcMessage) {}, options("test_shutdown_backoff"));
+        pool->set_channels(channels(3));
+
+        auto& shard = In::shard(*pool, 0);
+        In::supervising(*pool, shard);
+        std::atomic<bool> sleeping{ false };
+        std::atomic<bool> left{ false };
+        boost::asio::co_spawn(shard.home.executor, [&]() -> awaitable<void> {
+            sleeping.store(true);
+            co_await In::backoff(*pool, shard, 30s); // k_backoff_cap
+            std::this_thread::sleep_for(50ms); // still using the pool after the wake
+            left.store(true);
+            In::exited(*pool, shard);
+        }, boost::asio::detached);
+        std::thread driver{ [&runtime] { runtime.run(); } };
+
+        while (!sleeping.load())
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        const auto started = std::chrono::steady_clock::now();
+        pool.reset();
+        EXPECT_TRUE(left.load());
+        EXPECT_LT(std::chrono::steady_clock::now() - started, 5s);
+
+        runtime.stop();
+        driver.join();
+    }
+} // namespace
@@ -0,0 +1,125 @@
+/*
+Module Name:
+- irc_message_parser_test.cpp
+
+Abstract:
+- parse_irc_line and the offset-based IrcMessage: every field of tagged and untagged lines, early ends,
+  the param cap, the line-length cap, tag lookup, and role flags found by the SIMD tag scan.
+*/
+
+// C++ Standard Library
+#include <string>
+#include <string_view>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/parser/irc_message_parser.hpp>
+
+namespace
+{
+    using twitch_bot::IrcMessage;
+    using twitch_bot::parse_irc_line;
+
+    static_assert(sizeof(IrcMessage) <= 128, "IrcMessage should stay within two cache lines");
+
+    TEST(IrcMessageParser, TaggedPrivmsg)
+    {
+        const std::string line = "@badge-info=;badges=moderator/1;color=#FF0000;display-name=Alice;mod=1;user-id=42 "
+                                 ":alice!alice@alice.tmi.twitch.tv PRIVMSG #chan :hello there :)";
+        const auto m = parse_irc_line(line);
+
+        EXPECT_EQ(m.command(), "PRIVMSG");
+        EXPECT_EQ(m.prefix(), "alice!alice@alice.tmi.twitch.tv");
+        ASSERT_EQ(m.param_count(), 1u);
+        EXPECT_EQ(m.param(0), "#chan");
+        EXPECT_EQ(m.trailing(), "hello there :)");
+        EXPECT_EQ(m.get_tag("display-name"), "Alice");
+        EXPECT_EQ(m.get_tag("user-id"), "42");
+        EXPECT_EQ(m.get_tag("badge-info"), "");
+        EXPECT_EQ(m.get_tag("missing"), "");
+        EXPECT_TRUE(m.is_moderator);
+        EXPECT_FALSE(m.is_broadcaster);
+
+        // Views point into the line itself.
+        EXPECT_EQ(m.trailing().data(), line.data() + line.find("hello"));
+    }
+
+    TEST(IrcMessageParser, BroadcasterBadgeAfterTheFirst64Bytes)
+    {
+        const std::string line = "@badge-info=subscriber/12;client-nonce=0123456789abcdef0123456789abcdef;badges=broadcaster/1,subscriber/3000 "
+                                 ":b!b@b PRIVMSG #b :hi";
+        const auto m = parse_irc_line(line);
+        EXPECT_TRUE(m.is_broadcaster);
+        EXPECT_FALSE(m.is_moderator);
+        EXPECT_EQ(m.trailing(), "hi");
+    }
+
+    TEST(IrcMessageParser, UntaggedServerLines)
+    {
+        const auto ping = parse_irc_line("PING :tmi.twitch.tv");
+        EXPECT_EQ(ping.command(), "PING");
+        EXPECT_EQ(ping.prefix(), "");
+        EXPECT_EQ(ping.param_count(), 0u);
+        EXPECT_EQ(ping.trailing(), "tmi.twitch.tv");
+
+        const auto welcome = parse_irc_line(":tmi.twitch.tv 001 bot :Welcome, GLHF!");
+        EXPECT_EQ(welcome.command(), "001");
+        ASSERT_EQ(welcome.param_count(), 1u);
+        EXPECT_EQ(welcome.param(0), "bot");
+        EXPECT_EQ(welcome.trailing(), "Welcome, GLHF!");
+
+        const auto join = parse_irc_line(":bot!bot@bot.tmi.twitch.tv JOIN #chan");
+        EXPECT_EQ(join.command(), "JOIN");
+        ASSERT_EQ(join.param_count(), 1u);
+        EXPECT_EQ(join.param(0), "#chan");
+        EXPECT_EQ(join.trailing(), "");
+    }
+
+    TEST(IrcMessageParser, EarlyEnds)
+    {
+        EXPECT_EQ(parse_irc_line("").command(), "");
+        EXPECT_EQ(parse_irc_line("@a=b").raw_tags(), "a=b");
+        EXPECT_EQ(parse_irc_line("@a=b :only.prefix").prefix(), "only.prefix");
+        EXPECT_EQ(parse_irc_line("RECONNECT").command(), "RECONNECT");
+    }
+
+    TEST(IrcMessageParser, ParamsStopAtTheCap)
+    {
+        std::string line = "CMD";
+        for (int i = 0; i < 20; ++i)
+        {
+            line += " p" + std::to_string(i);
+        }
+        line += " :tail";
+        const auto m = parse_irc_line(line);
+        ASSERT_EQ(m.param_count(), IrcMessage::max_params);
+        EXPECT_EQ(m.param(0), "p0");
+        EXPECT_EQ(m.param(IrcMessage::max_params - 1), "p15");
+    }
+
+    TEST(IrcMessageParser, OffsetsReachTheEndOfTheLongestLine)
+    {
+        std::string line = ":n!n@n PRIVMSG #c :";
+        line.append(IrcMessage::max_line - line.size(), 'x');
+        ASSERT_EQ(line.size(), IrcMessage::max_line);
+
+        const auto m = parse_irc_line(line);
+        EXPECT_EQ(m.trailing().size(), IrcMessage::max_line - line.find(" :") - 2);
+        EXPECT_EQ(m.trailing().data() + m.trailing().size(), line.data() + line.size());
+
+        line.push_back('x');
+        EXPECT_EQ(parse_irc_line(line).command(), ""); // over the cap: empty message
+    }
+
+    TEST(IrcMessageParser, CopiesKeepPointingAtTheLine)
+    {
+        const std::string line = "@id=7 :u!u@u PRIVMSG #c :copy me";
+        const auto original = parse_irc_line(line);
+        const IrcMessage copy = original; // what a handler frame receives
+        EXPECT_EQ(copy.trailing(), "copy me");
+        EXPECT_EQ(copy.get_tag("id"), "7");
+        EXPECT_EQ(copy.param(0).data(), original.param(0).data());
+    }
+} // namespace
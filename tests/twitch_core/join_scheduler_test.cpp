@@ -0,0 +1,172 @@
+/*
+Module Name:
+- join_scheduler_test.cpp
+
+Abstract:
+- twitch_bot::JoinScheduler on a single-threaded io_context with a short window: sends never exceed
+  join_limit per window, confirmed joins settle, unconfirmed ones are retried and then fail, urgent
+  joins jump the backlog, and a refused send parks the channel outside the rate-limited backlog.
+*/
+
+// C++ Standard Library
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/join_scheduler.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using twitch_bot::JoinScheduler;
+    using twitch_bot::JoinSchedulerOptions;
+    using clock_type = std::chrono::steady_clock;
+
+    struct Sent
+    {
+        std::string channel;
+        clock_type::time_point at;
+    };
+
+    constexpr JoinSchedulerOptions k_fast{
+        .join_limit = 5,
+        .window = 200ms,
+        .window_slack = 20ms,
+        .confirm_timeout = 100ms,
+        .max_attempts = 2,
+    };
+
+    // Runs the context until done() or the time limit, then stops the scheduler and drains.
+    template<class Done>
+    void run_until(boost::asio::io_context& io, JoinScheduler& joins, Done done, std::chrono::milliseconds limit = 3s)
+    {
+        const auto until = clock_type::now() + limit;
+        while (!done() && clock_type::now() < until)
+        {
+            io.run_for(5ms);
+        }
+        joins.stop();
+        io.restart();
+        io.run_for(100ms);
+    }
+
+    TEST(JoinScheduler, NeverExceedsTheLimitPerWindow)
+    {
+        boost::asio::io_context io;
+        std::vector<Sent> sent;
+        JoinScheduler* self = nullptr;
+        JoinScheduler joins{ io.get_executor(), [&](std::string channel) -> boost::asio::awaitable<bool> {
+                                sent.push_back({ channel, clock_type::now() });
+                                self->confirm(channel);
+                                co_return true;
+                            },
+                             k_fast };
+        self = &joins;
+
+        for (int i = 0; i < 15; ++i)
+        {
+            joins.enqueue("c" + std::to_string(i));
+        }
+        joins.start();
+        run_until(io, joins, [&] { return joins.progress().confirmed == 15; });
+
+        ASSERT_EQ(sent.size(), 15u);
+        for (std::size_t i = k_fast.join_limit; i < sent.size(); ++i)
+        {
+            EXPECT_GE(sent[i].at - sent[i - k_fast.join_limit].at, k_fast.window) << "send " << i;
+        }
+        // Three windows' worth: the burst settles after two full waits.
+        const auto p = joins.progress();
+        EXPECT_EQ(p.pending, 0u);
+        EXPECT_EQ(p.failed, 0u);
+        EXPECT_GE(p.last_settle, 2 * k_fast.window);
+    }
+
+    TEST(JoinScheduler, UnconfirmedJoinsRetryThenFail)
+    {
+        boost::asio::io_context io;
+        std::vector<std::string> sent;
+        JoinScheduler joins{ io.get_executor(), [&](std::string channel) -> boost::asio::awaitable<bool> {
+                                sent.push_back(std::move(channel));
+                                co_return true; // the server never echoes
+                            },
+                             k_fast };
+        joins.enqueue("silent");
+        joins.start();
+        run_until(io, joins, [&] { return joins.progress().failed == 1; });
+
+        EXPECT_EQ(sent, (std::vector<std::string>{ "silent", "silent" }));
+        const auto p = joins.progress();
+        EXPECT_EQ(p.failed, 1u);
+        EXPECT_EQ(p.pending, 0u);
+    }
+
+    TEST(JoinScheduler, UrgentJoinsGoFirst)
+    {
+        boost::asio::io_context io;
+        std::vector<std::string> sent;
+        JoinScheduler* self = nullptr;
+        JoinScheduler joins{ io.get_executor(), [&](std::string channel) -> boost::asio::awaitable<bool> {
+                                self->confirm(channel);
+                                sent.push_back(std::move(channel));
+                                co_return true;
+                            },
+                             k_fast };
+        self = &joins;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            joins.enqueue("backlog" + std::to_string(i));
+        }
+        joins.enqueue("urgent", true);
+        joins.start();
+        run_until(io, joins, [&] { return joins.progress().confirmed == 9; });
+
+        ASSERT_FALSE(sent.empty());
+        EXPECT_EQ(sent.front(), "urgent");
+    }
+
+    TEST(JoinScheduler, RefusedSendParksUntilEnqueuedAgain)
+    {
+        boost::asio::io_context io;
+        bool connected = false;
+        int attempts = 0;
+        JoinScheduler* self = nullptr;
+        JoinScheduler joins{ io.get_executor(), [&](std::string channel) -> boost::asio::awaitable<bool> {
+                                ++attempts;
+                                if (connected)
+                                {
+                                    self->confirm(channel);
+                                }
+                                co_return connected;
+                            },
+                             k_fast };
+        self = &joins;
+
+        joins.enqueue("chan");
+        EXPECT_EQ(joins.backlog(), 1u);
+        joins.start();
+        const auto until = clock_type::now() + 300ms;
+        while (clock_type::now() < until)
+        {
+            io.run_for(5ms);
+        }
+        EXPECT_EQ(attempts, 1); // parked, not retried on its own
+        EXPECT_EQ(joins.progress().pending, 1u);
+        EXPECT_EQ(joins.backlog(), 0u); // waits for a connection, not for the rate limit
+
+        connected = true;
+        joins.enqueue("chan"); // reconnect
+        run_until(io, joins, [&] { return joins.progress().confirmed == 1; });
+        EXPECT_EQ(attempts, 2);
+        EXPECT_EQ(joins.progress().pending, 0u);
+    }
+} // namespace
@@ -0,0 +1,75 @@
+/*
+Module Name:
+- recent_ids_test.cpp
+
+Abstract:
+- twitch_bot::RecentIds: a repeated id is rejected while held, the oldest id is evicted once the set is
+  full and then reads as new, and clear() forgets everything.
+*/
+
+// C++ Standard Library
+#include <string>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/recent_ids.hpp>
+
+namespace
+{
+    using twitch_bot::RecentIds;
+
+    TEST(RecentIds, RepeatsAreRejected)
+    {
+        RecentIds ids;
+        EXPECT_TRUE(ids.insert("a"));
+        EXPECT_TRUE(ids.insert("b"));
+        EXPECT_FALSE(ids.insert("a"));
+        EXPECT_FALSE(ids.insert(std::string{ "b" }));
+        EXPECT_EQ(ids.size(), 2u);
+    }
+
+    TEST(RecentIds, EvictedIdsAreAcceptedAgain)
+    {
+        RecentIds ids{ 3 };
+        EXPECT_TRUE(ids.insert("1"));
+        EXPECT_TRUE(ids.insert("2"));
+        EXPECT_TRUE(ids.insert("3"));
+        EXPECT_FALSE(ids.insert("1")); // a repeat does not refresh its age
+
+        EXPECT_TRUE(ids.insert("4")); // evicts "1"
+        EXPECT_EQ(ids.size(), 3u);
+        EXPECT_FALSE(ids.insert("2"));
+        EXPECT_TRUE(ids.insert("1")); // evicts "2"
+        EXPECT_TRUE(ids.insert("2")); // evicts "3"
+        EXPECT_FALSE(ids.insert("4"));
+        EXPECT_EQ(ids.size(), 3u);
+    }
+
+    TEST(RecentIds, ManyEvictionsKeepTheNewestWindow)
+    {
+        RecentIds ids{ 100 };
+        for (int i = 0; i < 10'000; ++i)
+        {
+            ASSERT_TRUE(ids.insert(std::to_string(i)));
+        }
+        EXPECT_EQ(ids.size(), 100u);
+        EXPECT_FALSE(ids.insert("9999"));
+        EXPECT_FALSE(ids.insert("9900"));
+        EXPECT_TRUE(ids.insert("9899"));
+    }
+
+    TEST(RecentIds, ClearForgetsEverything)
+    {
+        RecentIds ids{ 0 }; // treated as 1
+        EXPECT_TRUE(ids.insert("x"));
+        EXPECT_FALSE(ids.insert("x"));
+        EXPECT_TRUE(ids.insert("y"));
+        EXPECT_TRUE(ids.insert("x"));
+
+        ids.clear();
+        EXPECT_EQ(ids.size(), 0u);
+        EXPECT_TRUE(ids.insert("x"));
+    }
+} // namespace
@@ -0,0 +1,118 @@
+/*
+Module Name:
+- runtime_test.cpp
+
+Abstract:
+- twitch_bot::Runtime::post through the per-core MPSC inbox and through shared-pool strands: several
+  producer threads, each task runs exactly once, one at a time on its home, in each producer's order.
+*/
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/runtime.hpp>
+
+namespace
+{
+    using twitch_bot::ExecutionMode;
+    using twitch_bot::Runtime;
+    using twitch_bot::RuntimeOptions;
+
+    constexpr std::size_t k_producers = 4;
+    constexpr std::size_t k_per_producer = 20'000;
+
+    // Posts from k_producers threads to one serial executor and checks what ran there.
+    void check_posts(const RuntimeOptions& options, std::size_t home)
+    {
+        Runtime runtime{ options };
+        // Per-core homes drain while producers push. run() on a shared pool joins it, which lets it
+        // finish once idle, so there the driver starts after the posts (pool threads run them anyway).
+        const bool drive_first = options.mode == ExecutionMode::per_core;
+        std::thread driver;
+        if (drive_first)
+        {
+            driver = std::thread([&] { runtime.run(); });
+        }
+        const auto target = runtime.serial_executor(home);
+
+        std::vector<std::size_t> next(k_producers, 0); // only touched by tasks on target
+        std::atomic<bool> inside{ false };
+        std::atomic<std::size_t> done{ 0 };
+        std::atomic<std::size_t> out_of_order{ 0 };
+        std::atomic<std::size_t> overlapped{ 0 };
+
+        std::vector<std::thread> producers;
+        for (std::size_t p = 0; p < k_producers; ++p)
+        {
+            producers.emplace_back([&, p] {
+                for (std::size_t i = 0; i < k_per_producer; ++i)
+                {
+                    runtime.post(target, [&, p, i] {
+                        if (inside.exchange(true, std::memory_order_acquire))
+                        {
+                            overlapped.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        if (next[p] != i)
+                        {
+                            out_of_order.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        next[p] = i + 1;
+                        inside.store(false, std::memory_order_release);
+                        done.fetch_add(1, std::memory_order_release);
+                    });
+                }
+            });
+        }
+        for (auto& t : producers)
+        {
+            t.join();
+        }
+        if (!drive_first)
+        {
+            driver = std::thread([&] { runtime.run(); });
+        }
+
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds{ 20 };
+        while (done.load(std::memory_order_acquire) < k_producers * k_per_producer && std::chrono::steady_clock::now() < until)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        }
+        runtime.stop();
+        driver.join();
+
+        EXPECT_EQ(done.load(), k_producers * k_per_producer);
+        EXPECT_EQ(out_of_order.load(), 0u);
+        EXPECT_EQ(overlapped.load(), 0u);
+    }
+
+    TEST(Runtime, PerCoreInboxKeepsProducerOrder)
+    {
+        check_posts({ .mode = ExecutionMode::per_core, .threads = 3, .pin_threads = false }, 1);
+    }
+
+    TEST(Runtime, PerCoreInboxOnTheCallersHome)
+    {
+        check_posts({ .mode = ExecutionMode::per_core, .threads = 2, .pin_threads = false }, 0);
+    }
+
+    TEST(Runtime, SharedPoolStrandKeepsProducerOrder)
+    {
+        check_posts({ .mode = ExecutionMode::shared_pool, .threads = 4 }, 0);
+    }
+
+    TEST(Runtime, SingleThreadHasOneSerialHome)
+    {
+        Runtime runtime{ { .mode = ExecutionMode::shared_pool, .threads = 1 } };
+        EXPECT_TRUE(runtime.homes_are_serial());
+        EXPECT_EQ(runtime.homes(), 1u);
+        check_posts({ .mode = ExecutionMode::shared_pool, .threads = 1 }, 0);
+    }
+} // namespace
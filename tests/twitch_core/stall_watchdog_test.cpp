@@ -0,0 +1,100 @@
+/*
+Module Name:
+- stall_watchdog_test.cpp
+
+Abstract:
+- twitch_bot::StallWatchdog on a one-thread runtime: a task that blocks the home past the threshold is
+  counted as one stall however long it lasts, its probe's lag is recorded once it runs, and an idle home
+  is never reported. Stack sampling stays on, so the report signals the blocked thread through the
+  activity registry.
+- Metrics are process-wide and keyed by target name, so every test watches a name of its own.
+*/
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/runtime.hpp>
+#include <tb/twitch/stall_watchdog.hpp>
+#include <tb/utils/activity.hpp>
+#include <tb/utils/metrics.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using twitch_bot::StallWatchdog;
+
+    std::uint64_t stalls(std::string_view target)
+    {
+        return tb::metrics::registry().counter("tb_loop_stalls_total", "", { { "target", target } }).value();
+    }
+
+    std::uint64_t probes(std::string_view target)
+    {
+        return tb::metrics::registry().histogram("tb_loop_lag_seconds", "", { { "target", target } }).count();
+    }
+
+    class StallWatchdogTest : public testing::Test
+    {
+    protected:
+        StallWatchdogTest() :
+            driver_{ [this] { runtime.run(); } }
+        {
+        }
+
+        ~StallWatchdogTest() override
+        {
+            watchdog.stop();
+            runtime.stop();
+            driver_.join();
+        }
+
+        twitch_bot::Runtime runtime{ { .threads = 1 } };
+        StallWatchdog watchdog{ runtime, { .interval = 10ms, .threshold = 100ms, .stack_samples = true } };
+
+    private:
+        std::thread driver_;
+    };
+
+    TEST_F(StallWatchdogTest, BlockedHomeIsOneStall)
+    {
+        watchdog.watch("stall_blocked", runtime.serial_executor(0));
+        watchdog.start();
+
+        std::atomic<bool> done{ false };
+        runtime.post(runtime.serial_executor(0), [&done] {
+            const tb::activity::Scope scope{ "test.blocking" };
+            std::this_thread::sleep_for(400ms);
+            done.store(true);
+        });
+
+        const auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!done.load() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(5ms);
+        }
+        ASSERT_TRUE(done.load());
+        std::this_thread::sleep_for(100ms); // the queued probe runs, then a few clean ones
+
+        EXPECT_EQ(stalls("stall_blocked"), 1u);
+        const auto& lag = tb::metrics::registry().histogram("tb_loop_lag_seconds", "", { { "target", "stall_blocked" } });
+        EXPECT_GE(lag.quantile(1.0), 250ms); // the stalled probe waited out most of the block
+    }
+
+    TEST_F(StallWatchdogTest, IdleHomeIsNeverReported)
+    {
+        watchdog.watch("stall_idle", runtime.serial_executor(0));
+        watchdog.start();
+
+        std::this_thread::sleep_for(300ms);
+        EXPECT_EQ(stalls("stall_idle"), 0u);
+        EXPECT_GE(probes("stall_idle"), 5u);
+    }
+} // namespace
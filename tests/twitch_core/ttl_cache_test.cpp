@@ -0,0 +1,193 @@
+/*
+Module Name:
+- ttl_cache_test.cpp
+
+Abstract:
+- twitch_bot::TtlCache on a single-threaded io_context with short TTLs: concurrent misses share one
+  load, fresh hits skip it, stale values are served while a refresh runs, negative results expire
+  sooner, throwing loads cache nothing, put/invalidate, and trim keeps the key count at max_entries.
+*/
+
+// C++ Standard Library
+#include <chrono>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/ttl_cache.hpp>
+#include <tb/utils/metrics.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using boost::asio::awaitable;
+    using boost::asio::use_awaitable;
+    using twitch_bot::TtlCache;
+
+    // Spawns f on io and runs until it and every refresh it started are done.
+    template<class F>
+    void run(boost::asio::io_context& io, F f)
+    {
+        boost::asio::co_spawn(io, std::move(f), [](std::exception_ptr e) {
+            if (e)
+            {
+                std::rethrow_exception(e);
+            }
+        });
+        io.run();
+        io.restart();
+    }
+
+    // A load that takes 10ms and returns how many times it has been called.
+    auto counting_load(int& calls)
+    {
+        return [&calls]() -> awaitable<std::optional<int>> {
+            const int n = ++calls;
+            boost::asio::steady_timer t{ co_await boost::asio::this_coro::executor, 10ms };
+            co_await t.async_wait(use_awaitable);
+            co_return n;
+        };
+    }
+
+    TEST(TtlCache, ConcurrentMissesShareOneLoad)
+    {
+        boost::asio::io_context io;
+        TtlCache<int> cache{ io.get_executor(), "test_single_flight" };
+        int calls = 0;
+        std::vector<std::optional<int>> got;
+
+        for (int i = 0; i < 5; ++i)
+        {
+            boost::asio::co_spawn(io, [&]() -> awaitable<void> { got.push_back(co_await cache.get("k", counting_load(calls))); }, boost::asio::detached);
+        }
+        io.run();
+        io.restart();
+
+        EXPECT_EQ(calls, 1);
+        ASSERT_EQ(got.size(), 5u);
+        for (const auto& v : got)
+        {
+            EXPECT_EQ(v, 1);
+        }
+
+        // Fresh: no second load.
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("k", counting_load(calls)), 1); });
+        EXPECT_EQ(calls, 1);
+    }
+
+    TEST(TtlCache, StaleValueIsServedWhileRefreshing)
+    {
+        boost::asio::io_context io;
+        TtlCache<int> cache{ io.get_executor(), "test_stale", { .ttl = 30ms, .stale_for = 10s } };
+        int calls = 0;
+
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("k", counting_load(calls)), 1); });
+        std::this_thread::sleep_for(50ms);
+
+        run(io, [&]() -> awaitable<void> {
+            EXPECT_EQ(co_await cache.get("k", counting_load(calls)), 1); // old value, without waiting
+            EXPECT_EQ(calls, 1); // the refresh runs after
+        });
+        EXPECT_EQ(calls, 2);
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("k", counting_load(calls)), 2); });
+        EXPECT_EQ(calls, 2);
+    }
+
+    TEST(TtlCache, NegativeResultsUseTheShorterTtl)
+    {
+        boost::asio::io_context io;
+        TtlCache<int> cache{ io.get_executor(), "test_negative", { .ttl = 10s, .stale_for = 10s, .negative_ttl = 30ms } };
+        int calls = 0;
+        const auto none = [&calls]() -> awaitable<std::optional<int>> {
+            ++calls;
+            co_return std::nullopt;
+        };
+
+        run(io, [&]() -> awaitable<void> {
+            EXPECT_EQ(co_await cache.get("gone", none), std::nullopt);
+            EXPECT_EQ(co_await cache.get("gone", none), std::nullopt);
+        });
+        EXPECT_EQ(calls, 1);
+
+        std::this_thread::sleep_for(50ms);
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("gone", none), std::nullopt); });
+        EXPECT_EQ(calls, 2); // not served stale
+    }
+
+    TEST(TtlCache, ThrowingLoadCachesNothing)
+    {
+        boost::asio::io_context io;
+        TtlCache<int> cache{ io.get_executor(), "test_errors", { .ttl = 30ms, .stale_for = 10s } };
+        int calls = 0;
+        const auto fail = [&calls]() -> awaitable<std::optional<int>> {
+            ++calls;
+            throw std::runtime_error{ "remote down" };
+            co_return std::nullopt;
+        };
+
+        run(io, [&]() -> awaitable<void> {
+            EXPECT_THROW(co_await cache.get("k", fail), std::runtime_error);
+            EXPECT_THROW(co_await cache.get("k", fail), std::runtime_error);
+        });
+        EXPECT_EQ(calls, 2);
+
+        // A failed refresh leaves the stale value in place.
+        run(io, [&]() -> awaitable<void> { co_await cache.put("k", 7); });
+        std::this_thread::sleep_for(50ms);
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("k", fail), 7); });
+        EXPECT_EQ(calls, 3);
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("k", fail), 7); });
+    }
+
+    TEST(TtlCache, PutAndInvalidate)
+    {
+        boost::asio::io_context io;
+        TtlCache<int> cache{ io.get_executor(), "test_put" };
+        int calls = 0;
+
+        run(io, [&]() -> awaitable<void> {
+            co_await cache.put("k", 5);
+            EXPECT_EQ(co_await cache.get("k", counting_load(calls)), 5);
+            co_await cache.invalidate("k");
+            EXPECT_EQ(co_await cache.get("k", counting_load(calls)), 1);
+        });
+        EXPECT_EQ(calls, 1);
+    }
+
+    TEST(TtlCache, TrimKeepsMaxEntries)
+    {
+        boost::asio::io_context io;
+        TtlCache<int> cache{ io.get_executor(), "test_trim", { .max_entries = 3 } };
+        const auto& entries = tb::metrics::registry().gauge("tb_cache_entries", "Keys held by a cache", { { "cache", "test_trim" } });
+
+        run(io, [&]() -> awaitable<void> {
+            for (int i = 0; i < 10; ++i)
+            {
+                co_await cache.put("k" + std::to_string(i), i);
+                EXPECT_LE(entries.value(), 3);
+            }
+        });
+        EXPECT_EQ(entries.value(), 3);
+
+        // The newest key always survives its own insert.
+        int calls = 0;
+        run(io, [&]() -> awaitable<void> { EXPECT_EQ(co_await cache.get("k9", counting_load(calls)), 9); });
+        EXPECT_EQ(calls, 0);
+    }
+} // namespace
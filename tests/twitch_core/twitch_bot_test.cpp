@@ -0,0 +1,113 @@
+/*
+Module Name:
+- twitch_bot_test.cpp
+
+Abstract:
+- twitch_bot::TwitchBot read/write split, without sockets: the bot is never run, so every write is
+  dropped, and tb_irc_writes_dropped_total{pool,reason} shows which pool it reached.
+- With anonymous ingest, say and reply go to the authenticated "writer" pool, which joins none of the
+  bot's channels, and the anonymous ingest pool drops any write sent to it directly.
+- With an authenticated ingest pool there is no writer pool; writes go to the ingest pool itself.
+*/
+
+// C++ Standard Library
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Boost.Asio
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/twitch/twitch_bot.hpp>
+#include <tb/utils/metrics.hpp>
+
+namespace
+{
+    using boost::asio::awaitable;
+    using twitch_bot::IrcPoolOptions;
+    using twitch_bot::TwitchBot;
+
+    std::uint64_t dropped(std::string_view pool, std::string_view reason)
+    {
+        return tb::metrics::registry().counter("tb_irc_writes_dropped_total", "", { { "pool", pool }, { "reason", reason } }).value();
+    }
+
+    IrcPoolOptions ingest(std::string name, bool anonymous)
+    {
+        IrcPoolOptions o;
+        o.anonymous = anonymous;
+        o.name = std::move(name);
+        return o;
+    }
+
+    TwitchBot make_bot(IrcPoolOptions options)
+    {
+        return TwitchBot{ "access", "refresh", "client", "secret", "control", std::move(options), { .threads = 1, .pin_threads = false } };
+    }
+
+    // Writes and joins on a bot that never ran return without touching its runtime.
+    template<class F>
+    void run(F f)
+    {
+        boost::asio::io_context io;
+        boost::asio::co_spawn(io, std::move(f), [](std::exception_ptr e) {
+            if (e)
+            {
+                std::rethrow_exception(e);
+            }
+        });
+        io.run();
+    }
+
+    TEST(TwitchBot, AnonymousIngestWritesThroughTheWriterPool)
+    {
+        auto bot = make_bot(ingest("test_split_anon", true));
+        ASSERT_NE(&bot.irc_writer(), &bot.irc());
+
+        bot.set_initial_channels({ "a", "b" });
+        run([&]() -> awaitable<void> { co_await bot.join_channel("c"); });
+        EXPECT_EQ(bot.irc().channel_count(), 4u); // a, b, c and the control channel
+        EXPECT_EQ(bot.irc_writer().channel_count(), 0u);
+
+        const auto writer_before = dropped("writer", "disconnected");
+        run([&]() -> awaitable<void> {
+            co_await bot.say("a", "hello");
+            co_await bot.reply("b", "parent-id", "hello");
+        });
+        EXPECT_EQ(dropped("writer", "disconnected") - writer_before, 2u);
+        EXPECT_EQ(dropped("test_split_anon", "anonymous"), 0u);
+        EXPECT_EQ(dropped("test_split_anon", "disconnected"), 0u);
+    }
+
+    TEST(TwitchBot, AnonymousIngestPoolDropsWrites)
+    {
+        auto bot = make_bot(ingest("test_split_drop", true));
+        bot.set_initial_channels({ "a" });
+
+        run([&]() -> awaitable<void> {
+            co_await bot.irc().say("a", "hello");
+            co_await bot.irc().reply("a", "parent-id", "hello");
+        });
+        EXPECT_EQ(dropped("test_split_drop", "anonymous"), 2u);
+    }
+
+    TEST(TwitchBot, AuthenticatedIngestWritesItself)
+    {
+        auto bot = make_bot(ingest("test_split_auth", false));
+        EXPECT_EQ(&bot.irc_writer(), &bot.irc());
+        bot.set_initial_channels({ "a" });
+
+        const auto writer_before = dropped("writer", "disconnected");
+        run([&]() -> awaitable<void> { co_await bot.say("a", "hello"); });
+        EXPECT_EQ(dropped("test_split_auth", "disconnected"), 1u);
+        EXPECT_EQ(dropped("writer", "disconnected"), writer_before);
+    }
+} // namespace
@@ -0,0 +1,129 @@
+/*
+Module Name:
+- activity_test.cpp
+
+Abstract:
+- tb::activity scopes name the innermost open section and restore the outer one on exit, and each entry
+  is counted.
+- A thread registers on its first scope and leaves the registry when it exits.
+- signal_thread reaches a live registered thread, and refuses a state from an earlier snapshot once its
+  thread has exited rather than signalling a stale handle.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <thread>
+
+// Platform
+#include <csignal>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/activity.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using tb::activity::Scope;
+    using tb::activity::ThreadState;
+
+    std::atomic<int> g_signalled{ 0 };
+
+    bool registered(const ThreadState* s)
+    {
+        const auto all = tb::activity::threads();
+        return std::any_of(all.begin(), all.end(), [s](const auto& p) { return p.get() == s; });
+    }
+
+    TEST(Activity, ScopesNestAndRestoreTheOuterName)
+    {
+        tb::activity::register_this_thread();
+        ThreadState& self = tb::activity::this_thread();
+        ASSERT_EQ(tb::activity::current_or_null(), &self);
+        const auto before = self.entered.load();
+
+        {
+            const Scope outer{ "test.outer" };
+            EXPECT_EQ(std::string_view{ self.name.load() }, "test.outer");
+            {
+                const Scope inner{ "test.inner" };
+                EXPECT_EQ(std::string_view{ self.name.load() }, "test.inner");
+            }
+            EXPECT_EQ(std::string_view{ self.name.load() }, "test.outer");
+        }
+        EXPECT_EQ(self.name.load(), nullptr);
+        EXPECT_EQ(self.entered.load() - before, 2u);
+    }
+
+    TEST(Activity, ThreadRegistersOnFirstScopeAndLeavesOnExit)
+    {
+        const ThreadState* state = nullptr;
+        bool registered_before = true;
+        bool registered_inside = false;
+        std::thread([&] {
+            registered_before = tb::activity::current_or_null() != nullptr;
+            const Scope scope{ "test.worker" };
+            state = tb::activity::current_or_null();
+            registered_inside = registered(state);
+        }).join();
+
+        EXPECT_FALSE(registered_before);
+        ASSERT_NE(state, nullptr);
+        EXPECT_TRUE(registered_inside);
+        EXPECT_FALSE(registered(state));
+    }
+
+    TEST(Activity, SignalReachesOnlyALiveThread)
+    {
+        struct sigaction sa{};
+        sa.sa_handler = [](int) { g_signalled.fetch_add(1); };
+        sigemptyset(&sa.sa_mask);
+        ASSERT_EQ(::sigaction(SIGUSR2, &sa, nullptr), 0);
+
+        std::atomic<bool> ready{ false };
+        std::atomic<bool> leave{ false };
+        std::thread worker([&] {
+            tb::activity::register_this_thread();
+            ready.store(true);
+            while (!leave.load())
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        while (!ready.load())
+        {
+            std::this_thread::yield();
+        }
+
+        // A state held from a snapshot, the way the watchdog holds one while it reports.
+        std::shared_ptr<ThreadState> held;
+        for (const auto& s : tb::activity::threads())
+        {
+            if (s.get() != tb::activity::current_or_null())
+            {
+                held = s;
+            }
+        }
+        ASSERT_NE(held, nullptr);
+
+        EXPECT_TRUE(tb::activity::signal_thread(*held, SIGUSR2));
+        const auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (g_signalled.load() == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        EXPECT_EQ(g_signalled.load(), 1);
+
+        leave.store(true);
+        worker.join();
+        EXPECT_FALSE(tb::activity::signal_thread(*held, SIGUSR2));
+        std::this_thread::sleep_for(20ms);
+        EXPECT_EQ(g_signalled.load(), 1);
+    }
+} // namespace
@@ -0,0 +1,143 @@
+/*
+Module Name:
+- bounded_mpsc_queue_test.cpp
+
+Abstract:
+- tb::concurrent::BoundedMpscQueue: capacity rounding, FIFO order, try_push failing when full and
+  leaving the value in place, wrap-around, leftovers destroyed with the queue, and several producers
+  against one consumer with every item delivered once and in each producer's order.
+*/
+
+// C++ Standard Library
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/bounded_mpsc_queue.hpp>
+
+namespace
+{
+    using tb::concurrent::BoundedMpscQueue;
+
+    TEST(BoundedMpscQueue, CapacityIsRoundedUpToAPowerOfTwo)
+    {
+        EXPECT_EQ(BoundedMpscQueue<int>{ 0 }.capacity(), 2u);
+        EXPECT_EQ(BoundedMpscQueue<int>{ 5 }.capacity(), 8u);
+        EXPECT_EQ(BoundedMpscQueue<int>{ 64 }.capacity(), 64u);
+    }
+
+    TEST(BoundedMpscQueue, FullQueueRefusesAndKeepsTheValue)
+    {
+        BoundedMpscQueue<std::unique_ptr<int>> q{ 4 };
+        EXPECT_TRUE(q.empty());
+        for (int i = 0; i < 4; ++i)
+        {
+            auto v = std::make_unique<int>(i);
+            ASSERT_TRUE(q.try_push(v));
+            EXPECT_EQ(v, nullptr); // moved in
+        }
+
+        auto extra = std::make_unique<int>(99);
+        EXPECT_FALSE(q.try_push(extra));
+        ASSERT_NE(extra, nullptr);
+        EXPECT_EQ(*extra, 99);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            auto v = q.try_pop();
+            ASSERT_TRUE(v);
+            EXPECT_EQ(**v, i);
+        }
+        EXPECT_FALSE(q.try_pop());
+        EXPECT_TRUE(q.empty());
+    }
+
+    TEST(BoundedMpscQueue, WrapsAroundManyTimes)
+    {
+        BoundedMpscQueue<int> q{ 4 };
+        for (int i = 0; i < 1000; ++i)
+        {
+            int a = 2 * i;
+            int b = 2 * i + 1;
+            ASSERT_TRUE(q.try_push(a));
+            ASSERT_TRUE(q.try_push(b));
+            EXPECT_EQ(q.try_pop(), 2 * i);
+            EXPECT_EQ(q.try_pop(), 2 * i + 1);
+        }
+        EXPECT_TRUE(q.empty());
+    }
+
+    TEST(BoundedMpscQueue, LeftoversAreDestroyed)
+    {
+        auto tracked = std::make_shared<int>(0);
+        {
+            BoundedMpscQueue<std::shared_ptr<int>> q{ 8 };
+            for (int i = 0; i < 3; ++i)
+            {
+                auto copy = tracked;
+                ASSERT_TRUE(q.try_push(copy));
+            }
+            EXPECT_EQ(tracked.use_count(), 4);
+        }
+        EXPECT_EQ(tracked.use_count(), 1);
+    }
+
+    TEST(BoundedMpscQueue, ProducersAgainstOneConsumer)
+    {
+        constexpr std::size_t producers = 4;
+        constexpr std::size_t per_producer = 50'000;
+        BoundedMpscQueue<std::size_t> q{ 64 }; // small, so producers hit full often
+
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p] {
+                for (std::size_t i = 0; i < per_producer; ++i)
+                {
+                    auto v = p * per_producer + i;
+                    while (!q.try_push(v))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::vector<std::size_t> next(producers, 0);
+        std::size_t received = 0;
+        std::size_t out_of_order = 0;
+        while (received < producers * per_producer)
+        {
+            if (auto v = q.try_pop())
+            {
+                const auto p = *v / per_producer;
+                if (*v % per_producer != next[p])
+                {
+                    ++out_of_order;
+                }
+                next[p] = *v % per_producer + 1;
+                ++received;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        EXPECT_EQ(out_of_order, 0u);
+        EXPECT_FALSE(q.try_pop());
+        for (auto n : next)
+        {
+            EXPECT_EQ(n, per_producer);
+        }
+    }
+} // namespace
@@ -0,0 +1,98 @@
+/*
+Module Name:
+- log_test.cpp
+
+Abstract:
+- tb::log rendering and capture: "{}" substitution in order, the "{{" and "}}" escapes, string
+  arguments copied at the call so later changes do not show, and truncation past Record::k_max_args
+  or Record::k_bytes. The compile-time format check is exercised through count_placeholders.
+*/
+
+// C++ Standard Library
+#include <string>
+#include <string_view>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/log.hpp>
+
+namespace
+{
+    using tb::log::Level;
+    using tb::log::detail::count_placeholders;
+    using tb::log::detail::Record;
+
+    // What TB_LOG_* accepts; anything -1 or off by one from the argument count fails the build.
+    static_assert(count_placeholders("plain") == 0);
+    static_assert(count_placeholders("shard#{} up in {}ms") == 2);
+    static_assert(count_placeholders("{{literal}} {}") == 1);
+    static_assert(count_placeholders("{}{}") == 2);
+    static_assert(count_placeholders("gap={:.1f}ms") == -1);
+    static_assert(count_placeholders("{0}") == -1);
+    static_assert(count_placeholders("open { brace") == -1);
+    static_assert(count_placeholders("close } brace") == -1);
+    static_assert(count_placeholders("trailing {") == -1);
+
+    template<typename... Args>
+    std::string message(const char* fmt, Args&&... args)
+    {
+        Record r{};
+        tb::log::detail::fill(r, Level::info, "test", fmt, std::forward<Args>(args)...);
+        std::string out;
+        tb::log::detail::render_message(out, r);
+        return out;
+    }
+
+    TEST(Log, SubstitutesInOrder)
+    {
+        EXPECT_EQ(message("shard#{} up in {}ms", 3, 1250u), "shard#3 up in 1250ms");
+        EXPECT_EQ(message("{} {} {} {}", true, 'x', -7, 0.5), "true x -7 0.5");
+        EXPECT_EQ(message("no args"), "no args");
+    }
+
+    TEST(Log, Escapes)
+    {
+        EXPECT_EQ(message("{{}} {{{}}}", 42), "{} {42}");
+    }
+
+    TEST(Log, StringsAreCopiedAtTheCall)
+    {
+        std::string name = "alice";
+        Record r{};
+        tb::log::detail::fill(r, Level::info, "test", "user={} view={}", name, std::string_view{ name });
+        name.assign("mallory-overwrites-the-buffer");
+
+        std::string out;
+        tb::log::detail::render_message(out, r);
+        EXPECT_EQ(out, "user=alice view=alice");
+    }
+
+    TEST(Log, ArgumentsPastTheCapAreDroppedAndFlagged)
+    {
+        static_assert(Record::k_max_args == 8);
+        EXPECT_EQ(message("{} {} {} {} {} {} {} {}", 1, 2, 3, 4, 5, 6, 7, 8), "1 2 3 4 5 6 7 8");
+        // write() refuses this at compile time; fill() is the runtime backstop.
+        EXPECT_EQ(message("{} {} {} {} {} {} {} {} {}", 1, 2, 3, 4, 5, 6, 7, 8, 9), "1 2 3 4 5 6 7 8  [truncated]");
+    }
+
+    TEST(Log, LongStringsAreCutAtTheByteBudget)
+    {
+        const std::string big(Record::k_bytes + 50, 'a');
+        const auto out = message("{}|{}", big, std::string_view{ "tail" });
+        EXPECT_EQ(out, std::string(Record::k_bytes, 'a') + "| [truncated]");
+    }
+
+    TEST(Log, MacroWritesTheRenderedLine)
+    {
+        tb::log::set_level(Level::info);
+        testing::internal::CaptureStdout();
+        TB_LOG_INFO("test", "shard#{} up gap={}us dns={}us", 2, 1500, 12);
+        TB_LOG_DEBUG("test", "hidden {}", 1);
+        tb::log::flush();
+        const auto out = testing::internal::GetCapturedStdout();
+        EXPECT_NE(out.find("INFO  [test] shard#2 up gap=1500us dns=12us\n"), std::string::npos) << out;
+        EXPECT_EQ(out.find("hidden"), std::string::npos);
+    }
+} // namespace
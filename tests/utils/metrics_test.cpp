@@ -0,0 +1,123 @@
+/*
+Module Name:
+- metrics_test.cpp
+
+Abstract:
+- tb::metrics::Registry::render against the Prometheus text exposition format 0.0.4, the contract the
+  metrics endpoint is scraped by: HELP and TYPE per family, families in name order, escaped label
+  values, cumulative _bucket lines ending in +Inf, and _sum in seconds with _count equal to +Inf.
+- Lookup: the same name and labels give the same metric, and a name reused with another type throws.
+- Every test renders a registry of its own, so nothing registered elsewhere in the process shows up.
+*/
+
+// C++ Standard Library
+#include <array>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/metrics.hpp>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using tb::metrics::Registry;
+
+    std::string render(const Registry& r)
+    {
+        std::string out;
+        r.render(out);
+        return out;
+    }
+
+    TEST(Metrics, CountersAndGaugesRenderOneLinePerSeries)
+    {
+        Registry r;
+        r.counter("tb_lines_total", "Lines read", { { "direction", "in" } }).inc(3);
+        r.counter("tb_lines_total", "Lines read", { { "direction", "out" } }).inc();
+        r.gauge("tb_depth", "Queued lines").set(-2);
+
+        EXPECT_EQ(render(r),
+                  "# HELP tb_depth Queued lines\n"
+                  "# TYPE tb_depth gauge\n"
+                  "tb_depth -2\n"
+                  "# HELP tb_lines_total Lines read\n"
+                  "# TYPE tb_lines_total counter\n"
+                  "tb_lines_total{direction=\"in\"} 3\n"
+                  "tb_lines_total{direction=\"out\"} 1\n");
+    }
+
+    TEST(Metrics, LabelValuesAreEscaped)
+    {
+        Registry r;
+        r.counter("tb_escaped_total", "Escaping", { { "path", "C:\\bot" }, { "quote", "say \"hi\"" }, { "text", "two\nlines" } }).inc();
+
+        EXPECT_EQ(render(r),
+                  "# HELP tb_escaped_total Escaping\n"
+                  "# TYPE tb_escaped_total counter\n"
+                  "tb_escaped_total{path=\"C:\\\\bot\",quote=\"say \\\"hi\\\"\",text=\"two\\nlines\"} 1\n");
+    }
+
+    TEST(Metrics, HistogramBucketsAreCumulativeWithInfSumAndCount)
+    {
+        constexpr std::array<double, 2> bounds{ 0.001, 0.01 };
+        Registry r;
+        auto& h = r.histogram("tb_latency_seconds", "Latency", { { "op", "parse" } }, bounds);
+        h.observe(500us);
+        h.observe(2ms);
+        h.observe(10ms); // a bound is inclusive
+        h.observe(1s);
+
+        EXPECT_EQ(render(r),
+                  "# HELP tb_latency_seconds Latency\n"
+                  "# TYPE tb_latency_seconds histogram\n"
+                  "tb_latency_seconds_bucket{op=\"parse\",le=\"0.001\"} 1\n"
+                  "tb_latency_seconds_bucket{op=\"parse\",le=\"0.01\"} 3\n"
+                  "tb_latency_seconds_bucket{op=\"parse\",le=\"+Inf\"} 4\n"
+                  "tb_latency_seconds_sum{op=\"parse\"} 1.0125\n"
+                  "tb_latency_seconds_count{op=\"parse\"} 4\n");
+    }
+
+    TEST(Metrics, UnlabelledHistogramStillLabelsItsBuckets)
+    {
+        constexpr std::array<double, 1> bounds{ 0.5 };
+        Registry r;
+        r.histogram("tb_wait_seconds", "Wait", {}, bounds);
+
+        EXPECT_EQ(render(r),
+                  "# HELP tb_wait_seconds Wait\n"
+                  "# TYPE tb_wait_seconds histogram\n"
+                  "tb_wait_seconds_bucket{le=\"0.5\"} 0\n"
+                  "tb_wait_seconds_bucket{le=\"+Inf\"} 0\n"
+                  "tb_wait_seconds_sum 0\n"
+                  "tb_wait_seconds_count 0\n");
+    }
+
+    TEST(Metrics, SameNameAndLabelsGiveTheSameMetric)
+    {
+        Registry r;
+        auto& a = r.counter("tb_same_total", "Same", { { "k", "v" } });
+        auto& b = r.counter("tb_same_total", "Ignored once registered", { { "k", "v" } });
+        auto& c = r.counter("tb_same_total", "Same", { { "k", "w" } });
+        EXPECT_EQ(&a, &b);
+        EXPECT_NE(&a, &c);
+    }
+
+    TEST(Metrics, NameReusedWithAnotherTypeThrows)
+    {
+        Registry r;
+        r.counter("tb_clash", "First as a counter").inc();
+        EXPECT_THROW(r.gauge("tb_clash", "Now a gauge"), std::logic_error);
+        EXPECT_THROW(r.histogram("tb_clash", "Now a histogram", { { "k", "v" } }), std::logic_error);
+
+        // The family is left as it was.
+        EXPECT_EQ(render(r),
+                  "# HELP tb_clash First as a counter\n"
+                  "# TYPE tb_clash counter\n"
+                  "tb_clash 1\n");
+    }
+} // namespace
@@ -0,0 +1,118 @@
+/*
+Module Name:
+- pattern_matcher_test.cpp
+
+Abstract:
+- tb::match::Matcher against a naive find() per pattern, with and without the SIMD prefilter, plus
+  case folding, whole-word boundaries and match offsets.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/pattern_matcher.hpp>
+
+namespace
+{
+    using tb::match::Match;
+    using tb::match::PatternSet;
+
+    std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> all_matches(const tb::match::Matcher& m, std::string_view text)
+    {
+        std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> out;
+        m.for_each(text, [&out](const Match& hit) {
+            out.emplace_back(hit.id, hit.start, hit.end);
+            return true;
+        });
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    TEST(PatternMatcher, ReportsOffsetsAndIds)
+    {
+        PatternSet set;
+        set.add("he", 1);
+        set.add("she", 2);
+        set.add("hers", 3);
+        const auto m = set.compile(false);
+
+        const auto hits = all_matches(*m, "ushers");
+        const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> expected{ { 1, 2, 4 }, { 2, 1, 4 }, { 3, 2, 6 } };
+        EXPECT_EQ(hits, expected);
+    }
+
+    TEST(PatternMatcher, CaseFoldingIsPerSet)
+    {
+        PatternSet set;
+        set.add("Kappa", 1);
+        EXPECT_TRUE(set.compile(true)->any("lol KAPPA lol"));
+        EXPECT_FALSE(set.compile(false)->any("lol KAPPA lol"));
+        EXPECT_TRUE(set.compile(false)->any("lol Kappa lol"));
+    }
+
+    TEST(PatternMatcher, WholeWordNeedsBoundaries)
+    {
+        PatternSet set;
+        set.add("ass", 1, { .whole_word = true });
+        const auto m = set.compile();
+        EXPECT_FALSE(m->any("a classic pass"));
+        EXPECT_TRUE(m->any("ass"));
+        EXPECT_TRUE(m->any("you ass!"));
+        EXPECT_FALSE(m->any("ass_"));
+    }
+
+    TEST(PatternMatcher, AgreesWithFindAcrossSetSizes)
+    {
+        std::mt19937 rng{ 3 };
+        std::uniform_int_distribution<int> letter{ 'a', 'f' }; // small alphabet: plenty of overlaps
+        std::uniform_int_distribution<std::size_t> plen{ 1, 6 };
+        std::uniform_int_distribution<std::size_t> tlen{ 0, 200 };
+
+        for (const std::size_t count : { 1u, 5u, 64u, 65u, 200u })
+        {
+            std::vector<std::string> patterns;
+            PatternSet set;
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                std::string p(plen(rng), 'a');
+                for (auto& c : p)
+                {
+                    c = static_cast<char>(letter(rng));
+                }
+                set.add(p, i);
+                patterns.push_back(std::move(p));
+            }
+            const auto m = set.compile(false);
+            EXPECT_EQ(m->prefiltered(), count <= 64) << count;
+
+            for (int round = 0; round < 200; ++round)
+            {
+                std::string text(tlen(rng), 'a');
+                for (auto& c : text)
+                {
+                    c = static_cast<char>(letter(rng));
+                }
+
+                std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> expected;
+                for (std::uint32_t i = 0; i < patterns.size(); ++i)
+                {
+                    for (auto at = text.find(patterns[i]); at != std::string::npos; at = text.find(patterns[i], at + 1))
+                    {
+                        expected.emplace_back(i, static_cast<std::uint32_t>(at), static_cast<std::uint32_t>(at + patterns[i].size()));
+                    }
+                }
+                std::sort(expected.begin(), expected.end());
+                ASSERT_EQ(all_matches(*m, text), expected) << count << " patterns, text " << text;
+            }
+        }
+    }
+} // namespace
@@ -0,0 +1,200 @@
+/*
+Module Name:
+- recycling_resource_test.cpp
+
+Abstract:
+- Counts calls to the global operator new while blocks cycle through tb::memory::recycling_resource(),
+  on one thread and between a producer and a consumer thread, the way a shard reader hands slabs to lanes.
+*/
+
+// C++ Standard Library
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/recycling_resource.hpp>
+#include <tb/utils/slab.hpp>
+
+namespace
+{
+    std::atomic<std::uint64_t> g_news{ 0 };
+} // namespace
+
+// GCC pairs the inlined free() below with the `new` expression it replaced and calls it a mismatch.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t n)
+{
+    g_news.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    using tb::memory::recycling_resource;
+    using tb::memory::Slab;
+
+    // Single producer, single consumer; fixed storage so the queue itself never allocates.
+    template<std::size_t N>
+    class SpscRing
+    {
+    public:
+        bool push(Slab& s) noexcept
+        {
+            const auto t = tail_.load(std::memory_order_relaxed);
+            if (t - head_.load(std::memory_order_acquire) == N)
+            {
+                return false;
+            }
+            slots_[t % N] = std::move(s);
+            tail_.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(Slab& out) noexcept
+        {
+            const auto h = head_.load(std::memory_order_relaxed);
+            if (h == tail_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            out = std::move(slots_[h % N]);
+            head_.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::array<Slab, N> slots_{};
+        std::atomic<std::size_t> head_{ 0 };
+        std::atomic<std::size_t> tail_{ 0 };
+    };
+
+    TEST(RecyclingResource, SameThreadReuseDoesNotAllocate)
+    {
+        auto& r = recycling_resource();
+        constexpr std::array<std::size_t, 5> sizes{ 24, 200, 1000, 3000, 60'000 };
+        for (int warm = 0; warm < 2; ++warm)
+        {
+            for (auto n : sizes)
+            {
+                r.deallocate(r.allocate(n), n);
+            }
+        }
+
+        const auto before = g_news.load();
+        for (int i = 0; i < 10'000; ++i)
+        {
+            for (auto n : sizes)
+            {
+                r.deallocate(r.allocate(n), n);
+            }
+        }
+        EXPECT_EQ(g_news.load() - before, 0u);
+    }
+
+    TEST(RecyclingResource, BlocksFreedOnAnotherThreadReturnToTheAllocator)
+    {
+        constexpr int k_warm = 1'000;
+        constexpr int k_lines = 200'000;
+        const std::string line(300, 'x'); // a typical tagged PRIVMSG
+
+        SpscRing<32> ring;
+        std::atomic<bool> done{ false };
+
+        std::thread consumer([&] {
+            Slab s;
+            for (;;)
+            {
+                if (ring.pop(s))
+                {
+                    s = Slab{}; // released on this thread, like a lane finishing with a line
+                }
+                else if (done.load(std::memory_order_acquire))
+                {
+                    while (ring.pop(s))
+                    {
+                        s = Slab{};
+                    }
+                    return;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        std::uint64_t before = 0;
+        for (int i = 0; i < k_warm + k_lines; ++i)
+        {
+            if (i == k_warm)
+            {
+                before = g_news.load();
+            }
+            auto s = Slab::copy_of({ line });
+            while (!ring.push(s))
+            {
+                std::this_thread::yield();
+            }
+        }
+        const auto during = g_news.load() - before;
+        done.store(true, std::memory_order_release);
+        consumer.join();
+
+        // The producer's list refills from its remote stack; only ring-depth worth of blocks is
+        // ever outstanding, so after warm-up nothing reaches operator new.
+        EXPECT_EQ(during, 0u);
+    }
+
+    TEST(RecyclingResource, BlockOutlivesTheThreadThatAllocatedIt)
+    {
+        auto& r = recycling_resource();
+        void* p = nullptr;
+        std::thread([&] { p = r.allocate(128); }).join();
+        ASSERT_NE(p, nullptr);
+        r.deallocate(p, 128); // owner is parked; goes to its remote stack
+
+        // The next thread adopts the parked cache and drains the block.
+        void* q = nullptr;
+        std::thread([&] {
+            q = r.allocate(128);
+            r.deallocate(q, 128);
+        }).join();
+        EXPECT_EQ(q, p);
+    }
+
+    TEST(RecyclingResource, OversizedAndOveralignedBypassTheCache)
+    {
+        auto& r = recycling_resource();
+        void* big = r.allocate(std::size_t{ 1 } << 20);
+        void* aligned = r.allocate(64, 64);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0u);
+        r.deallocate(aligned, 64, 64);
+        r.deallocate(big, std::size_t{ 1 } << 20);
+    }
+} // namespace
@@ -0,0 +1,142 @@
+/*
+Module Name:
+- slab_test.cpp
+
+Abstract:
+- tb::memory::Slab sharing: copy_of concatenates its parts, copies share one block and count it, and a
+  move hands the block over without touching the count.
+- Copies spread over several threads and dropped there, the way a routed ChatLine reaches a handler and
+  worker-pool listeners, hand the block back to the pool exactly once: the allocating thread gets it
+  again, and never twice, when it next runs its free list dry.
+*/
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/slab.hpp>
+
+namespace
+{
+    using tb::memory::Slab;
+
+    // More than a size class ever caches, so taking this many drains the owner's remote stack.
+    constexpr std::size_t k_past_cache = 200;
+
+    // How many of n fresh slabs of the given size land on block; the slabs stay alive while counting,
+    // so a block handed back twice would show up twice.
+    std::size_t reissues_of(const char* block, std::size_t size, std::size_t n = k_past_cache)
+    {
+        const std::string filler(size, 'y');
+        std::vector<Slab> held;
+        held.reserve(n);
+        std::vector<const char*> seen;
+        seen.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            seen.push_back(held.emplace_back(Slab::copy_of({ filler })).data());
+        }
+        std::sort(seen.begin(), seen.end());
+        EXPECT_EQ(std::adjacent_find(seen.begin(), seen.end()), seen.end()) << "a block was handed out twice";
+        return static_cast<std::size_t>(std::count(seen.begin(), seen.end(), block));
+    }
+
+    TEST(Slab, CopiesShareOneCountedBlock)
+    {
+        Slab empty;
+        EXPECT_EQ(empty.size(), 0u);
+        EXPECT_EQ(empty.use_count(), 0u);
+        EXPECT_TRUE(empty.view().empty());
+
+        auto a = Slab::copy_of({ "chan", "", "user", "hello" });
+        EXPECT_EQ(a.view(), "chanuserhello");
+        EXPECT_EQ(a.use_count(), 1u);
+
+        {
+            const Slab b = a;
+            EXPECT_EQ(b.data(), a.data());
+            EXPECT_EQ(a.use_count(), 2u);
+
+            Slab c;
+            c = b;
+            EXPECT_EQ(a.use_count(), 3u);
+
+            const Slab d = std::move(c);
+            EXPECT_EQ(c.use_count(), 0u);
+            EXPECT_EQ(d.data(), a.data());
+            EXPECT_EQ(a.use_count(), 3u);
+        }
+        EXPECT_EQ(a.use_count(), 1u);
+
+        a = Slab{};
+        EXPECT_EQ(a.use_count(), 0u);
+    }
+
+    TEST(Slab, LastCopyOnAnyThreadReturnsTheBlockOnce)
+    {
+        constexpr std::size_t k_size = 700; // a class nothing else here uses
+        constexpr int k_threads = 8;
+        constexpr int k_rounds = 20'000;
+        const std::string text(k_size, 'x');
+
+        for (int trial = 0; trial < 20; ++trial)
+        {
+            auto line = Slab::copy_of({ text });
+            const char* block = line.data();
+
+            std::atomic<bool> go{ false };
+            std::atomic<int> torn{ 0 };
+            std::vector<std::thread> consumers;
+            for (int t = 0; t < k_threads; ++t)
+            {
+                consumers.emplace_back([&go, &torn, copy = line, &text]() mutable {
+                    while (!go.load(std::memory_order_acquire))
+                    {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < k_rounds; ++i)
+                    {
+                        const Slab again = copy;
+                        if (again.view() != text)
+                        {
+                            torn.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    copy = Slab{}; // the last of these, or the main thread, frees the block
+                });
+            }
+            EXPECT_EQ(line.use_count(), static_cast<std::uint32_t>(k_threads + 1));
+
+            go.store(true, std::memory_order_release);
+            line = Slab{};
+            for (auto& c : consumers)
+            {
+                c.join();
+            }
+
+            EXPECT_EQ(torn.load(), 0);
+            EXPECT_EQ(reissues_of(block, k_size), 1u) << "trial " << trial;
+        }
+    }
+
+    TEST(Slab, BlockFreedOnAnotherThreadGoesBackToItsOwner)
+    {
+        constexpr std::size_t k_size = 900;
+        auto line = Slab::copy_of({ std::string(k_size, 'z') });
+        const char* block = line.data();
+
+        std::thread([moved = std::move(line)]() mutable { moved = Slab{}; }).join();
+        EXPECT_EQ(reissues_of(block, k_size), 1u);
+    }
+} // namespace
@@ -0,0 +1,159 @@
+/*
+Module Name:
+- timing_wheel_test.cpp
+
+Abstract:
+- Checks tb::timing::TimingWheel against a brute-force model: every key fires on exactly its due tick,
+  including ticks that land on a cascade boundary, across long idle gaps, and when on_due reschedules.
+*/
+
+// C++ Standard Library
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/timing_wheel.hpp>
+
+namespace
+{
+    using tb::timing::TimingWheel;
+
+    constexpr std::uint64_t k_level1 = TimingWheel::k_slots;
+    constexpr std::uint64_t k_level2 = TimingWheel::k_slots * TimingWheel::k_slots;
+
+    // key -> the tick it fired on
+    std::map<std::uint64_t, std::uint64_t> run_to(TimingWheel& wheel, std::uint64_t now)
+    {
+        std::map<std::uint64_t, std::uint64_t> fired;
+        wheel.advance(now, [&](std::uint64_t key) noexcept -> std::uint64_t {
+            fired[key] = wheel.now();
+            return 0;
+        });
+        return fired;
+    }
+
+    TEST(TimingWheel, FiresOnTheDueTick)
+    {
+        const std::vector<std::uint64_t> dues{ 1, 2, 63, 64, 65, 127, 128, 4'095, 4'096, 4'097, 8'192, 12'288 + 64, 200'000 };
+        TimingWheel wheel{ 64 };
+        for (auto due : dues)
+        {
+            ASSERT_TRUE(wheel.schedule(due, due));
+        }
+
+        std::map<std::uint64_t, std::uint64_t> fired;
+        for (std::uint64_t t = 1; t <= 200'000; ++t)
+        {
+            fired.merge(run_to(wheel, t));
+        }
+        ASSERT_EQ(fired.size(), dues.size());
+        for (auto [key, at] : fired)
+        {
+            EXPECT_EQ(at, key) << "due " << key;
+        }
+        EXPECT_EQ(wheel.size(), 0u);
+    }
+
+    TEST(TimingWheel, CascadeTickFiresInOneLongAdvance)
+    {
+        TimingWheel wheel{ 8 };
+        ASSERT_TRUE(wheel.schedule(1, k_level1));
+        ASSERT_TRUE(wheel.schedule(2, k_level2));
+        ASSERT_TRUE(wheel.schedule(3, 5 * k_level2 + 3 * k_level1));
+
+        const auto fired = run_to(wheel, k_level2 * 63);
+        ASSERT_EQ(fired.size(), 3u);
+        EXPECT_EQ(fired.at(1), k_level1);
+        EXPECT_EQ(fired.at(2), k_level2);
+        EXPECT_EQ(fired.at(3), 5 * k_level2 + 3 * k_level1);
+        EXPECT_EQ(wheel.now(), k_level2 * 63);
+    }
+
+    TEST(TimingWheel, OverdueFiresOnTheNextTick)
+    {
+        TimingWheel wheel{ 4 };
+        (void)run_to(wheel, 1'000);
+        ASSERT_TRUE(wheel.schedule(7, 10));
+        const auto fired = run_to(wheel, 1'001);
+        ASSERT_EQ(fired.size(), 1u);
+        EXPECT_EQ(fired.at(7), 1'001u);
+    }
+
+    TEST(TimingWheel, PastTheHorizonComesBackEarly)
+    {
+        TimingWheel wheel{ 4 };
+        const auto due = TimingWheel::k_horizon * 3;
+        ASSERT_TRUE(wheel.schedule(9, due));
+
+        std::vector<std::uint64_t> visits;
+        wheel.advance(due, [&](std::uint64_t) noexcept -> std::uint64_t {
+            visits.push_back(wheel.now());
+            return wheel.now() < due ? due : 0;
+        });
+        ASSERT_FALSE(visits.empty());
+        EXPECT_EQ(visits.back(), due);
+        EXPECT_LE(visits.size(), 4u);
+        EXPECT_EQ(wheel.size(), 0u);
+    }
+
+    TEST(TimingWheel, RescheduleFromOnDue)
+    {
+        TimingWheel wheel{ 4 };
+        ASSERT_TRUE(wheel.schedule(1, 100));
+
+        std::vector<std::uint64_t> visits;
+        wheel.advance(10'000, [&](std::uint64_t) noexcept -> std::uint64_t {
+            visits.push_back(wheel.now());
+            return visits.size() < 3 ? wheel.now() + 1'000 : 0;
+        });
+        EXPECT_EQ(visits, (std::vector<std::uint64_t>{ 100, 1'100, 2'100 }));
+    }
+
+    TEST(TimingWheel, ScheduleFailsWhenThePoolIsFull)
+    {
+        TimingWheel wheel{ 2 };
+        EXPECT_TRUE(wheel.schedule(1, 5));
+        EXPECT_TRUE(wheel.schedule(2, 5));
+        EXPECT_FALSE(wheel.schedule(3, 5));
+        (void)run_to(wheel, 5);
+        EXPECT_TRUE(wheel.schedule(3, 6));
+    }
+
+    TEST(TimingWheel, MatchesModelUnderRandomSchedules)
+    {
+        std::mt19937_64 rng{ 42 };
+        std::uniform_int_distribution<std::uint64_t> ahead{ 0, TimingWheel::k_horizon - 1 };
+        std::uniform_int_distribution<std::uint64_t> step{ 1, 20'000 };
+
+        TimingWheel wheel{ 4'096 };
+        std::map<std::uint64_t, std::uint64_t> expected; // key -> due
+        std::uint64_t next_key = 1;
+        std::uint64_t now = 0;
+        for (int round = 0; round < 500; ++round)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                const auto due = now + 1 + ahead(rng) % (i % 2 ? 300 : TimingWheel::k_horizon - 1);
+                ASSERT_TRUE(wheel.schedule(next_key, due));
+                expected[next_key++] = due;
+            }
+            now += step(rng);
+            for (auto [key, at] : run_to(wheel, now))
+            {
+                ASSERT_TRUE(expected.contains(key));
+                EXPECT_EQ(at, expected[key]) << "key " << key;
+                expected.erase(key);
+            }
+            for (auto [key, due] : expected)
+            {
+                ASSERT_GT(due, now) << "key " << key << " missed";
+            }
+        }
+        EXPECT_EQ(wheel.size(), expected.size());
+    }
+} // namespace
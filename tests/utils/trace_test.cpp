@@ -0,0 +1,281 @@
+/*
+Module Name:
+- trace_test.cpp
+
+Abstract:
+- tb::trace::detail::Ring keeps the newest k_capacity spans in record order once it wraps, and a
+  snapshot skips a slot the writer is caught halfway through instead of returning a torn span.
+- render_chrome_trace emits well-formed trace-event JSON: a traceEvents array of "X" events with
+  escaped names, one tid per ring, including the ring of a thread that has already exited.
+*/
+
+// C++ Standard Library
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// GoogleTest
+#include <gtest/gtest.h>
+
+// Core
+#include <tb/utils/trace.hpp>
+
+namespace tb::trace::detail
+{
+    // Stages the first half of Ring::record: the slot is marked as being written, head not yet moved.
+    struct RingInternals
+    {
+        static void begin_record(Ring& ring, const char* name)
+        {
+            const auto h = ring.head_.load();
+            auto& s = ring.slots_[h & (Ring::k_capacity - 1)];
+            s.seq.store(2 * h + 1);
+            s.name.store(name);
+        }
+    };
+} // namespace tb::trace::detail
+
+namespace
+{
+    using tb::trace::detail::Event;
+    using tb::trace::detail::Ring;
+    using tb::trace::detail::RingInternals;
+
+    std::vector<Event> snapshot(const Ring& ring)
+    {
+        std::vector<Event> out;
+        ring.snapshot(out);
+        return out;
+    }
+
+    // Minimal JSON grammar check; enough to catch a bad escape, a stray comma or an unclosed array.
+    class JsonChecker
+    {
+    public:
+        explicit JsonChecker(std::string_view text) :
+            text_{ text }
+        {
+        }
+
+        bool valid()
+        {
+            skip_space();
+            if (!value())
+            {
+                return false;
+            }
+            skip_space();
+            return pos_ == text_.size();
+        }
+
+    private:
+        bool value()
+        {
+            skip_space();
+            if (pos_ >= text_.size())
+            {
+                return false;
+            }
+            switch (text_[pos_])
+            {
+            case '{':
+                return sequence('}', true);
+            case '[':
+                return sequence(']', false);
+            case '"':
+                return string();
+            default:
+                return number();
+            }
+        }
+
+        bool sequence(char close, bool members)
+        {
+            ++pos_;
+            skip_space();
+            if (peek(close))
+            {
+                ++pos_;
+                return true;
+            }
+            for (;;)
+            {
+                if (members)
+                {
+                    skip_space();
+                    if (!string())
+                    {
+                        return false;
+                    }
+                    skip_space();
+                    if (!peek(':'))
+                    {
+                        return false;
+                    }
+                    ++pos_;
+                }
+                if (!value())
+                {
+                    return false;
+                }
+                skip_space();
+                if (peek(','))
+                {
+                    ++pos_;
+                    continue;
+                }
+                if (peek(close))
+                {
+                    ++pos_;
+                    return true;
+                }
+                return false;
+            }
+        }
+
+        bool string()
+        {
+            if (!peek('"'))
+            {
+                return false;
+            }
+            for (++pos_; pos_ < text_.size(); ++pos_)
+            {
+                const auto c = static_cast<unsigned char>(text_[pos_]);
+                if (c == '"')
+                {
+                    ++pos_;
+                    return true;
+                }
+                if (c < 0x20)
+                {
+                    return false;
+                }
+                if (c != '\\')
+                {
+                    continue;
+                }
+                if (++pos_ >= text_.size())
+                {
+                    return false;
+                }
+                const char e = text_[pos_];
+                if (e == 'u')
+                {
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        if (++pos_ >= text_.size() || !std::isxdigit(static_cast<unsigned char>(text_[pos_])))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                else if (std::string_view{ "\"\\/bfnrt" }.find(e) == std::string_view::npos)
+                {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool number()
+        {
+            const auto start = pos_;
+            while (pos_ < text_.size() && std::string_view{ "0123456789+-.eE" }.find(text_[pos_]) != std::string_view::npos)
+            {
+                ++pos_;
+            }
+            return pos_ > start;
+        }
+
+        bool peek(char c) const
+        {
+            return pos_ < text_.size() && text_[pos_] == c;
+        }
+
+        void skip_space()
+        {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+            {
+                ++pos_;
+            }
+        }
+
+        std::string_view text_;
+        std::size_t pos_ = 0;
+    };
+
+    TEST(TraceRing, KeepsTheNewestSpansInOrderAfterWrapping)
+    {
+        constexpr std::size_t k_extra = 10;
+        auto ring = std::make_unique<Ring>(1);
+        for (std::size_t i = 0; i < Ring::k_capacity + k_extra; ++i)
+        {
+            ring->record("span", i, 1);
+        }
+
+        const auto events = snapshot(*ring);
+        ASSERT_EQ(events.size(), Ring::k_capacity);
+        for (std::size_t i = 0; i < events.size(); ++i)
+        {
+            ASSERT_EQ(events[i].start_ns, k_extra + i) << "slot " << i;
+        }
+    }
+
+    TEST(TraceRing, SnapshotSkipsASlotCaughtMidWrite)
+    {
+        auto ring = std::make_unique<Ring>(1);
+        for (std::size_t i = 0; i < Ring::k_capacity; ++i)
+        {
+            ring->record("old", i, 1);
+        }
+
+        // The next record reuses the oldest slot; stop the writer halfway through it.
+        RingInternals::begin_record(*ring, "torn");
+        auto events = snapshot(*ring);
+        ASSERT_EQ(events.size(), Ring::k_capacity - 1);
+        EXPECT_EQ(events.front().start_ns, 1u);
+        EXPECT_EQ(events.back().start_ns, Ring::k_capacity - 1);
+        for (const auto& e : events)
+        {
+            ASSERT_EQ(std::string_view{ e.name }, "old");
+        }
+
+        // Once the write completes the span is the newest one.
+        ring->record("new", Ring::k_capacity, 1);
+        events = snapshot(*ring);
+        ASSERT_EQ(events.size(), Ring::k_capacity);
+        EXPECT_EQ(events.front().start_ns, 1u);
+        EXPECT_EQ(std::string_view{ events.back().name }, "new");
+    }
+
+    TEST(TraceRing, UnwrittenRingSnapshotsNothing)
+    {
+        const auto ring = std::make_unique<Ring>(1);
+        EXPECT_TRUE(snapshot(*ring).empty());
+    }
+
+    TEST(ChromeTrace, RendersWellFormedEventsWithEscapedNames)
+    {
+        {
+            const tb::trace::Span span{ "say \"hi\" from C:\\bot\tnow" };
+        }
+        std::thread([] { const tb::trace::Span span{ "worker.exited" }; }).join();
+
+        std::string json;
+        tb::trace::render_chrome_trace(json);
+
+        EXPECT_TRUE(JsonChecker{ json }.valid()) << json;
+        EXPECT_TRUE(json.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[{")) << json;
+        EXPECT_TRUE(json.ends_with("]}\n"));
+        EXPECT_NE(json.find("{\"name\":\"say \\\"hi\\\" from C:\\\\bot\\u0009now\",\"ph\":\"X\",\"pid\":1,\"tid\":"), std::string::npos) << json;
+        EXPECT_NE(json.find("{\"name\":\"worker.exited\",\"ph\":\"X\",\"pid\":1,\"tid\":"), std::string::npos) << json;
+        EXPECT_NE(json.find("\"tid\":1,"), std::string::npos);
+        EXPECT_NE(json.find("\"tid\":2,"), std::string::npos); // the exited thread's ring is still dumped
+    }
+} // namespace